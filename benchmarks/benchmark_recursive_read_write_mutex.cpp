@@ -0,0 +1,199 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/recursive_read_write_mutex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/// The previous implementation: a mutex, and a list of reading threads searched on every lock
+class CentralisedRecursiveReadWriteMutex
+{
+public:
+    void read_lock()
+    {
+        auto const my_id = std::this_thread::get_id();
+
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        cv.wait(lock, [&]{
+            return !write_locking_thread.count ||
+                write_locking_thread.id == my_id; });
+
+        auto const my_count = std::find_if(
+            read_locking_threads.begin(),
+            read_locking_threads.end(),
+            [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+
+        if (my_count == read_locking_threads.end())
+            read_locking_threads.push_back(ThreadLockCount(my_id, 1U));
+        else
+            ++(my_count->count);
+    }
+
+    void read_unlock()
+    {
+        auto const my_id = std::this_thread::get_id();
+
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        auto const my_count = std::find_if(
+            read_locking_threads.begin(),
+            read_locking_threads.end(),
+            [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+
+        --(my_count->count);
+
+        cv.notify_all();
+    }
+
+    void write_lock()
+    {
+        auto const my_id = std::this_thread::get_id();
+
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        cv.wait(lock, [&]
+            {
+                if (write_locking_thread.count &&
+                    write_locking_thread.id != my_id) return false;
+                for (auto const& candidate : read_locking_threads)
+                {
+                    if (candidate.id != my_id && candidate.count != 0) return false;
+                }
+                return true;
+            });
+
+        ++write_locking_thread.count;
+        write_locking_thread.id = my_id;
+    }
+
+    void write_unlock()
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        --write_locking_thread.count;
+        cv.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    struct ThreadLockCount
+    {
+        ThreadLockCount() : id(), count(0) {}
+        ThreadLockCount(std::thread::id id, unsigned int count) : id(id), count(count) {}
+        std::thread::id id;
+        unsigned int count;
+    };
+    std::vector<ThreadLockCount> read_locking_threads;
+    ThreadLockCount write_locking_thread;
+};
+
+/**
+ * Each thread takes (nested) read locks as fast as it can, with every
+ * \a write_interval'th lock on the first thread being a write lock instead.
+ */
+template<typename Mutex>
+std::chrono::nanoseconds time_locking(int thread_count, int locks_per_thread, int write_interval)
+{
+    Mutex mutex;
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    uint64_t shared_value{0};
+    std::atomic<uint64_t> total_read{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            ++ready;
+            while (!go)
+                std::this_thread::yield();
+
+            uint64_t sum{0};
+            for (int i = 0; i < locks_per_thread; ++i)
+            {
+                if (t == 0 && write_interval && i % write_interval == 0)
+                {
+                    mutex.write_lock();
+                    ++shared_value;
+                    mutex.write_unlock();
+                }
+                else
+                {
+                    mutex.read_lock();
+                    mutex.read_lock();
+                    sum += shared_value;
+                    mutex.read_unlock();
+                    mutex.read_unlock();
+                }
+            }
+
+            total_read += sum;
+        });
+    }
+
+    while (ready != thread_count)
+        std::this_thread::yield();
+
+    auto const start = std::chrono::steady_clock::now();
+    go = true;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    return std::chrono::steady_clock::now() - start;
+}
+
+template<typename Mutex>
+void report(char const* name, int thread_count, int locks_per_thread, int write_interval)
+{
+    auto const duration = time_locking<Mutex>(thread_count, locks_per_thread, write_interval);
+    auto const ns_per_lock = double(duration.count()) / locks_per_thread;
+
+    std::cout << name << ": " << thread_count << " threads took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << "ms ("
+              << ns_per_lock << "ns per lock per thread)" << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <max number of threads> <locks per thread> [<locks per write lock>]"<<std::endl;
+        exit(1);
+    }
+
+    int const max_threads = std::atoi(argv[1]);
+    int const locks_per_thread = std::atoi(argv[2]);
+    int const write_interval = argc == 4 ? std::atoi(argv[3]) : 0;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        report<CentralisedRecursiveReadWriteMutex>("centralised", threads, locks_per_thread, write_interval);
+        report<mir::RecursiveReadWriteMutex>("per-thread  ", threads, locks_per_thread, write_interval);
+    }
+
+    exit(0);
+}
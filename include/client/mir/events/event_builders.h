@@ -77,6 +77,9 @@ void set_modifier(MirEvent& event, MirInputEventModifiers modifiers);
 void set_cursor_position(MirEvent& event, mir::geometry::Point const& pos);
 void set_cursor_position(MirEvent& event, float x, float y);
 void set_button_state(MirEvent& event, MirPointerButtons button_state);
+void set_relative_motion(MirEvent& event, float dx, float dy);
+void set_scroll(MirEvent& event, float hscroll, float vscroll);
+void set_event_time(MirEvent& event, std::chrono::nanoseconds timestamp);
 
 // Deprecated version with uint64_t mac
 EventUPtr make_event(MirInputDeviceId device_id, std::chrono::nanoseconds timestamp,
@@ -103,6 +106,7 @@ EventUPtr make_event(MirInputDeviceId device_id, std::chrono::nanoseconds timest
 void add_touch(MirEvent &event, MirTouchId touch_id, MirTouchAction action,
     MirTouchTooltype tooltype, float x_axis_value, float y_axis_value,
     float pressure_value, float touch_major_value, float touch_minor_value, float size_value);
+void set_touch_position(MirEvent& event, size_t touch_index, float x, float y);
 
 // Pointer event
 // Deprecated version without relative axis
@@ -22,31 +22,123 @@
 #include "mir/fd.h"
 #include "mir/dispatch/dispatchable.h"
 
-#include <list>
-#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace mir
 {
 namespace dispatch
 {
 
+/**
+ * Runs actions queued from any thread when dispatched.
+ *
+ * Queueing takes no lock, and only the first action queued since the last
+ * dispatch wakes the watch fd. A dispatch runs every action queued by then,
+ * in the order they were queued.
+ *
+ * Actions are kept in blocks that dispatch hands back for reuse, so once
+ * the queue has grown to its usual depth queueing allocates nothing. Only
+ * an action too big for a block, or one queued when the pool is at its
+ * limit, is allocated on its own. (Copying a std::function may allocate
+ * within the std::function; queue the callable itself to avoid that.)
+ */
 class ActionQueue : public Dispatchable
 {
 public:
     ActionQueue();
+    ~ActionQueue();
     Fd watch_fd() const override;
 
     void enqueue(std::function<void()> const& action);
 
+    /// Queues any callable, including move-only ones, without wrapping it in a std::function
+    template<typename Action>
+    void enqueue(Action&& action)
+    {
+        push(make_node<ActionNode<typename std::decay<Action>::type>>(std::forward<Action>(action)));
+    }
+
     bool dispatch(FdEvents events) override;
     FdEvents relevant_events() const override;
 private:
+    struct Node
+    {
+        virtual ~Node() = default;
+        virtual void run() = 0;
+
+        Node* next{nullptr};
+        bool pooled{false};
+    };
+
+    template<typename Action>
+    struct ActionNode : Node
+    {
+        template<typename Arg>
+        explicit ActionNode(Arg&& action) : action(std::forward<Arg>(action)) {}
+        void run() override { action(); }
+
+        Action action;
+    };
+
+    /// Room for an ActionNode holding a std::function or a lambda capturing a few pointers
+    static std::size_t const block_size = 96;
+    static std::size_t const blocks_per_chunk = 64;
+    static std::size_t const max_chunks = 64;
+    struct Block;
+
+    template<typename Queued, typename Action>
+    Node* make_node(Action&& action)
+    {
+        if (sizeof(Queued) <= block_size && alignof(Queued) <= alignof(std::max_align_t))
+        {
+            if (auto const storage = take_block())
+            {
+                try
+                {
+                    auto const node = new (storage) Queued{std::forward<Action>(action)};
+                    node->pooled = true;
+                    return node;
+                }
+                catch (...)
+                {
+                    give_back(storage);
+                    throw;
+                }
+            }
+        }
+
+        return new Queued{std::forward<Action>(action)};
+    }
+
+    /// A free block's storage, or null if the pool can't grow any more
+    void* take_block();
+    void give_back(void* storage);
+    void release(Node* node);
+
+    void push(Node* node);
     bool consume();
     void wake();
     mir::Fd event_fd;
-    std::mutex list_lock;
-    std::list<std::function<void()>> actions;
+    /// Most recently queued first
+    std::atomic<Node*> newest{nullptr};
+    std::mutex leftovers_mutex;
+    /// Taken but not run because an action before them threw; oldest first
+    Node* leftovers{nullptr};
+
+    /// The pool's blocks, a chunk at a time; chunks never move or shrink
+    std::atomic<Block*> chunks[max_chunks] = {};
+    std::atomic<std::size_t> chunk_count{0};
+    std::mutex growth_mutex;
+    /// A stack of free blocks: a count of pops, to tell reuse apart, over the top's index + 1
+    std::atomic<uint64_t> free_blocks{0};
 };
 }
 }
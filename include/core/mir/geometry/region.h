@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <iosfwd>
+#include <vector>
+
+namespace mir
+{
+namespace geometry
+{
+
+/**
+ * An arbitrary set of points, held as non-overlapping rectangles.
+ *
+ * The rectangles are kept in horizontal bands sorted top to bottom, each
+ * band holding spans sorted left to right. Vertically adjacent bands with
+ * identical spans are merged, so equal sets of points always have the same
+ * representation.
+ */
+class Region
+{
+public:
+    Region();
+    explicit Region(Rectangle const& rect);
+    /* We want to keep implicit copy and move methods */
+
+    void add(Rectangle const& rect);
+    void add(Region const& other);
+    void subtract(Rectangle const& rect);
+    void subtract(Region const& other);
+    void intersect(Rectangle const& rect);
+    void intersect(Region const& other);
+    void clear();
+
+    bool empty() const;
+    bool contains(Rectangle const& rect) const;
+    bool overlaps(Rectangle const& rect) const;
+    Rectangle bounding_rectangle() const;
+
+    /// The region's rectangles in band order (top to bottom, then left to right)
+    std::vector<Rectangle> rectangles() const;
+
+    bool operator==(Region const& other) const;
+    bool operator!=(Region const& other) const;
+
+private:
+    struct Span
+    {
+        int left;
+        int right;
+    };
+
+    struct Band
+    {
+        int top;
+        int bottom;
+        std::vector<Span> spans;
+    };
+
+    static std::vector<Band> combine(
+        std::vector<Band> const& a,
+        std::vector<Band> const& b,
+        bool (*keep)(bool in_a, bool in_b));
+
+    static std::vector<Span> combine(
+        std::vector<Span> const& a,
+        std::vector<Span> const& b,
+        bool (*keep)(bool in_a, bool in_b));
+
+    std::vector<Band> bands;
+};
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
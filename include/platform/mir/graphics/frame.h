@@ -40,6 +40,8 @@ struct Frame
 
     int64_t msc = 0;   /**< Media Stream Counter */
     Timestamp ust;     /**< Unadjusted System Time */
+    bool hardware_timestamp = false; /**< ust came from the display's own
+                                          completion event, not an estimate */
 };
 
 }} // namespace mir::graphics
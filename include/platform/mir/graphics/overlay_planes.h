@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MIR_GRAPHICS_OVERLAY_PLANES_H_
+#define MIR_GRAPHICS_OVERLAY_PLANES_H_
+
+#include "mir/graphics/renderable.h"
+
+namespace mir
+{
+namespace graphics
+{
+
+/**
+ * Optionally implemented by a DisplayBuffer that can show some renderables
+ * on hardware planes above a frame composited from the rest, for when
+ * DisplayBuffer::overlay() can't take the whole list.
+ */
+class OverlayPlanes
+{
+public:
+    virtual ~OverlayPlanes() = default;
+
+    /**
+     * Puts what renderables it can on overlay planes for the next post().
+     * \returns The renderables left for the caller to composite, in their
+     *          original order; all of \a renderlist if none were taken.
+     */
+    virtual RenderableList assign_overlay_planes(RenderableList const& renderlist) = 0;
+
+protected:
+    OverlayPlanes() = default;
+    OverlayPlanes(OverlayPlanes const&) = delete;
+    OverlayPlanes& operator=(OverlayPlanes const&) = delete;
+};
+
+}
+}
+
+#endif /* MIR_GRAPHICS_OVERLAY_PLANES_H_ */
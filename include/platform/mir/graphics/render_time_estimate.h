@@ -0,0 +1,52 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MIR_GRAPHICS_RENDER_TIME_ESTIMATE_H_
+#define MIR_GRAPHICS_RENDER_TIME_ESTIMATE_H_
+
+#include <chrono>
+
+namespace mir
+{
+namespace graphics
+{
+
+/**
+ * Optionally implemented by a DisplaySyncGroup that measures how long its
+ * composited frames take, so the compositor can report it.
+ */
+class RenderTimeEstimate
+{
+public:
+    virtual ~RenderTimeEstimate() = default;
+
+    /// How long the most recent composited frame took, or zero if unmeasured
+    virtual std::chrono::microseconds last_render_time() const = 0;
+
+    /// The time set aside for rendering the next frame
+    virtual std::chrono::microseconds predicted_render_time() const = 0;
+
+protected:
+    RenderTimeEstimate() = default;
+    RenderTimeEstimate(RenderTimeEstimate const&) = delete;
+    RenderTimeEstimate& operator=(RenderTimeEstimate const&) = delete;
+};
+
+}
+}
+
+#endif /* MIR_GRAPHICS_RENDER_TIME_ESTIMATE_H_ */
@@ -71,6 +71,13 @@ public:
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
     virtual unsigned int swap_interval() const = 0;
+
+    /**
+     * The parts of screen_position() that are known to be fully opaque even
+     * though the renderable is shaped(), in screen coordinates. Empty when
+     * nothing is known to be opaque, which is the default.
+     */
+    virtual std::vector<geometry::Rectangle> opaque_region() const { return {}; }
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_INCREMENTAL_TEXTURE_SOURCE_H_
+#define MIR_RENDERER_GL_INCREMENTAL_TEXTURE_SOURCE_H_
+
+#include "mir/graphics/buffer_id.h"
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+
+/**
+ * Optionally implemented alongside TextureSource by buffers that know which
+ * parts of them differ from earlier buffers of the same stream, so that a
+ * texture already holding an earlier buffer need only be partially updated.
+ */
+class IncrementalTextureSource
+{
+public:
+    virtual ~IncrementalTextureSource() = default;
+
+    /**
+     * Uploads texture, given that the bound texture currently holds the
+     * contents of buffer \a previous. Implementations fall back to a full
+     * upload (as TextureSource::bind()) if they don't know how \a previous
+     * differs.
+     */
+    virtual void bind_changes_since(graphics::BufferID previous) = 0;
+
+protected:
+    IncrementalTextureSource() = default;
+    IncrementalTextureSource(IncrementalTextureSource const&) = delete;
+    IncrementalTextureSource& operator=(IncrementalTextureSource const&) = delete;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_STREAMING_TEXTURE_SOURCE_H_
+#define MIR_RENDERER_GL_STREAMING_TEXTURE_SOURCE_H_
+
+#include "mir/geometry/size.h"
+#include "mir_toolkit/common.h"
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+
+/**
+ * Optionally implemented alongside TextureSource by buffers whose pixels
+ * live in CPU memory, so that the texture cache can hand them to the GPU
+ * through pixel buffer objects rather than waiting on TextureSource::bind().
+ */
+class StreamingTextureSource
+{
+public:
+    virtual ~StreamingTextureSource() = default;
+
+    /// False if the buffer has a cheaper way to reach the GPU than a copy
+    virtual bool prefers_streaming() = 0;
+
+    virtual geometry::Size size() const = 0;
+    virtual MirPixelFormat pixel_format() const = 0;
+
+    /**
+     * Copies the pixels to \a destination, rows packed with no padding
+     * between them.
+     */
+    virtual void copy_packed_pixels(unsigned char* destination) = 0;
+
+protected:
+    StreamingTextureSource() = default;
+    StreamingTextureSource(StreamingTextureSource const&) = delete;
+    StreamingTextureSource& operator=(StreamingTextureSource const&) = delete;
+};
+
+}
+}
+}
+
+#endif
@@ -22,8 +22,10 @@
 #include <mir_toolkit/common.h>
 #include "mir/graphics/buffer_id.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangle.h"
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace mir
 {
@@ -60,6 +62,13 @@ public:
     //      side once we only support the NBS system.
     virtual void allow_framedropping(bool) = 0;
     virtual void set_scale(float scale) = 0;
+
+    /**
+     * The parts of buffers submitted from now on that the client promises
+     * are opaque, in buffer coordinates. Replaces any previously set region,
+     * but not that of buffers already submitted.
+     */
+    virtual void set_opaque_region(std::vector<geometry::Rectangle> const& region) = 0;
 protected:
     BufferStream() = default;
     BufferStream(BufferStream const&) = delete;
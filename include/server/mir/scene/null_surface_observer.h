@@ -48,6 +48,7 @@ public:
     void placed_relative(geometry::Rectangle const& placement) override;
     void input_consumed(MirEvent const* event) override;
     void start_drag_and_drop(std::vector<uint8_t> const& handle) override;
+    void input_region_set_to(std::vector<geometry::Rectangle> const& region) override;
 
 protected:
     NullSurfaceObserver(NullSurfaceObserver const&) = delete;
@@ -40,6 +40,8 @@ public:
     virtual pid_t process_id() const = 0;
 
     virtual void take_snapshot(SnapshotCallback const& snapshot_taken) = 0;
+    /// Takes a snapshot scaled down (keeping its aspect ratio) to fit within \a max_size
+    virtual void take_snapshot(geometry::Size const& max_size, SnapshotCallback const& snapshot_taken) = 0;
     virtual std::shared_ptr<Surface> default_surface() const = 0;
     virtual void set_lifecycle_state(MirLifecycleState state) = 0;
 
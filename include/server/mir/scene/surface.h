@@ -85,6 +85,8 @@ public:
      * set_input_region({Rectangle{}}).
      */
     virtual void set_input_region(std::vector<geometry::Rectangle> const& region) = 0;
+    /// The input region last set by set_input_region(), relative to the surface
+    virtual std::vector<geometry::Rectangle> input_region() const = 0;
     virtual void resize(geometry::Size const& size) = 0;
     virtual void set_transformation(glm::mat4 const& t) = 0;
     virtual void set_alpha(float alpha) = 0;
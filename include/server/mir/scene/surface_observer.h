@@ -64,6 +64,7 @@ public:
     virtual void placed_relative(geometry::Rectangle const& placement) = 0;
     virtual void input_consumed(MirEvent const* event) = 0;
     virtual void start_drag_and_drop(std::vector<uint8_t> const& handle) = 0;
+    virtual void input_region_set_to(std::vector<geometry::Rectangle> const& region) = 0;
 
 protected:
     SurfaceObserver() = default;
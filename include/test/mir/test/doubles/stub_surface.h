@@ -39,6 +39,7 @@ struct StubSurface : scene::Surface
     input::InputReceptionMode reception_mode() const override;
     void set_reception_mode(input::InputReceptionMode mode) override;
     void set_input_region(std::vector<geometry::Rectangle> const& input_rectangles) override;
+    std::vector<geometry::Rectangle> input_region() const override;
     void resize(geometry::Size const& size) override;
     geometry::Point top_left() const override;
     geometry::Rectangle input_bounds() const override;
@@ -216,6 +216,34 @@ void mev::set_button_state(MirEvent& event, MirPointerButtons button_state)
     event.to_input()->to_pointer()->set_buttons(button_state);
 }
 
+void mev::set_relative_motion(MirEvent& event, float dx, float dy)
+{
+    if (event.type() != mir_event_type_input ||
+        event.to_input()->input_type() != mir_input_event_type_pointer)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Relative motion is only valid for pointer events."));
+
+    event.to_input()->to_pointer()->set_dx(dx);
+    event.to_input()->to_pointer()->set_dy(dy);
+}
+
+void mev::set_scroll(MirEvent& event, float hscroll, float vscroll)
+{
+    if (event.type() != mir_event_type_input ||
+        event.to_input()->input_type() != mir_input_event_type_pointer)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Scrolling is only valid for pointer events."));
+
+    event.to_input()->to_pointer()->set_hscroll(hscroll);
+    event.to_input()->to_pointer()->set_vscroll(vscroll);
+}
+
+void mev::set_event_time(MirEvent& event, std::chrono::nanoseconds timestamp)
+{
+    if (event.type() != mir_event_type_input)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Event time is only valid for input events."));
+
+    event.to_input()->set_event_time(timestamp);
+}
+
 // Deprecated version with uint64_t mac
 mir::EventUPtr mev::make_event(MirInputDeviceId device_id, std::chrono::nanoseconds timestamp,
     uint64_t /*mac*/, MirKeyboardAction action, xkb_keysym_t key_code,
@@ -277,6 +305,17 @@ void mev::add_touch(MirEvent &event, MirTouchId touch_id, MirTouchAction action,
     tev->set_action(current_index, action);
 }
 
+void mev::set_touch_position(MirEvent& event, size_t touch_index, float x, float y)
+{
+    if (event.type() != mir_event_type_input ||
+        event.to_input()->input_type() != mir_input_event_type_touch)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Touch position is only valid for touch events."));
+
+    auto const tev = event.to_input()->to_touch();
+    tev->set_x(touch_index, x);
+    tev->set_y(touch_index, y);
+}
+
 mir::EventUPtr mev::make_event(MirInputDeviceId device_id, std::chrono::nanoseconds timestamp,
     std::vector<uint8_t> const& cookie, MirInputEventModifiers modifiers, MirPointerAction action,
     MirPointerButtons buttons_pressed,
@@ -22,6 +22,7 @@
 #include "mir/event_printer.h"
 
 #include "mir_protobuf_wire.pb.h"
+#include "mir/protobuf/method_ids.h"
 
 #include <boost/exception/diagnostic_information.hpp>
 #include <sstream>
@@ -44,7 +45,7 @@ void mcll::RpcReport::invocation_requested(
 {
     std::stringstream ss;
     ss << "Invocation request: id: " << invocation.id()
-       << " method_name: " << invocation.method_name();
+       << " method_name: " << mir::protobuf::method_name_of(invocation);
 
     logger->log(ml::Severity::debug, ss.str(), component);
 }
@@ -54,7 +55,7 @@ void mcll::RpcReport::invocation_succeeded(
 {
     std::stringstream ss;
     ss << "Invocation succeeded: id: " << invocation.id()
-       << " method_name: " << invocation.method_name();
+       << " method_name: " << mir::protobuf::method_name_of(invocation);
 
     logger->log(ml::Severity::debug, ss.str(), component);
 }
@@ -65,7 +66,7 @@ void mcll::RpcReport::invocation_failed(
 {
     std::stringstream ss;
     ss << "Invocation failed: id: " << invocation.id()
-       << " method_name: " << invocation.method_name()
+       << " method_name: " << mir::protobuf::method_name_of(invocation)
        << " error: " << boost::diagnostic_information(ex);
 
     logger->log(ml::Severity::error, ss.str(), component);
@@ -20,6 +20,7 @@
 #include "mir/report/lttng/mir_tracepoint.h"
 
 #include "mir_protobuf_wire.pb.h"
+#include "mir/protobuf/method_ids.h"
 
 #define TRACEPOINT_DEFINE
 #define TRACEPOINT_PROBE_DYNAMIC_LINKAGE
@@ -31,14 +32,14 @@ void mcl::lttng::RpcReport::invocation_requested(
     mir::protobuf::wire::Invocation const& invocation)
 {
     mir_tracepoint(mir_client_rpc, invocation_requested,
-                   invocation.id(), invocation.method_name().c_str());
+                   invocation.id(), mir::protobuf::method_name_of(invocation).c_str());
 }
 
 void mcl::lttng::RpcReport::invocation_succeeded(
     mir::protobuf::wire::Invocation const& invocation)
 {
     mir_tracepoint(mir_client_rpc, invocation_succeeded,
-                   invocation.id(), invocation.method_name().c_str());
+                   invocation.id(), mir::protobuf::method_name_of(invocation).c_str());
 }
 
 void mcl::lttng::RpcReport::invocation_failed(
@@ -24,6 +24,7 @@
 #include "mir/frontend/client_constants.h"
 #include "mir/variable_length_array.h"
 #include "mir/protobuf/protocol_version.h"
+#include "mir/protobuf/method_ids.h"
 #include "mir/log.h"
 
 #include <sstream>
@@ -138,7 +139,8 @@ void mclrd::PendingCallCache::wait_till_complete() const
 
 mclr::MirBasicRpcChannel::MirBasicRpcChannel() :
     next_message_id(0),
-    protocol_version{get_protocol_version()}
+    protocol_version{get_protocol_version()},
+    method_ids_accepted{false}
 {
 }
 
@@ -157,7 +159,12 @@ mir::protobuf::wire::Invocation mclr::MirBasicRpcChannel::invocation_for(
     mir::protobuf::wire::Invocation invoke;
 
     invoke.set_id(next_id());
-    invoke.set_method_name(method_name);
+    auto const method_id = method_ids_accepted ?
+        mir::protobuf::method_id_for(method_name) : mir::protobuf::MethodId::none;
+    if (method_id != mir::protobuf::MethodId::none)
+        invoke.set_method_id(static_cast<uint32_t>(method_id));
+    else
+        invoke.set_method_name(method_name);
     invoke.set_parameters(buffer.data(), buffer.size());
     invoke.set_protocol_version(protocol_version);
     invoke.set_side_channel_fds(num_side_channel_fds);
@@ -169,3 +176,8 @@ int mclr::MirBasicRpcChannel::next_id()
 {
     return next_message_id.fetch_add(1);
 }
+
+void mclr::MirBasicRpcChannel::use_method_ids()
+{
+    method_ids_accepted = true;
+}
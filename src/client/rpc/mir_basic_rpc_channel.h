@@ -126,10 +126,13 @@ protected:
         google::protobuf::MessageLite const* request,
         size_t num_side_channel_fds);
     int next_id();
+    /// Further invocations identify their method by number, not name
+    void use_method_ids();
 
 private:
     std::atomic<int> next_message_id;
     int const protocol_version;
+    std::atomic<bool> method_ids_accepted;
 };
 
 }
@@ -176,6 +176,8 @@ void mclr::MirProtobufRpcChannel::receive_file_descriptors(google::protobuf::Mes
         auto connection = static_cast<mir::protobuf::Connection*>(response);
         if (connection && connection->has_platform())
             platform = connection->mutable_platform();
+        if (connection && connection->accepts_method_ids())
+            use_method_ids();
     }
     else if (message_type == "mir.protobuf.SocketFD")
     {
@@ -526,10 +528,7 @@ void mclr::MirProtobufRpcChannel::on_data_available()
                 }
                 else
                 {
-                    // It's too difficult to convince C++ to move this lambda everywhere, so
-                    // just give up and let it pretend its a shared_ptr.
-                    std::shared_ptr<mp::wire::Result> appeaser{std::move(result)};
-                    delayed_processor->enqueue([delayed_result = std::move(appeaser), this]() mutable
+                    delayed_processor->enqueue([delayed_result = std::move(result), this]() mutable
                     {
                         pending_calls.complete_response(*delayed_result);
                     });
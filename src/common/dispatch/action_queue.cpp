@@ -20,9 +20,34 @@
 
 #include <boost/throw_exception.hpp>
 #include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <system_error>
+
+namespace
+{
+template<typename Node>
+Node** last_of(Node** list)
+{
+    while (*list)
+        list = &(*list)->next;
+    return list;
+}
+
+uint64_t const index_mask{0xffffffff};
+}
+
+// Storage first, so a node's address is its block's
+struct mir::dispatch::ActionQueue::Block
+{
+    alignas(std::max_align_t) unsigned char storage[block_size];
+    /// While free, the index + 1 of the next free block (0 for none)
+    std::atomic<uint32_t> next_free{0};
+    uint32_t index{0};
+};
 
 mir::dispatch::ActionQueue::ActionQueue()
-    : event_fd{eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK|EFD_SEMAPHORE)}
+    : event_fd{eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK)}
 {
     if (event_fd < 0)
         BOOST_THROW_EXCEPTION((std::system_error{errno,
@@ -30,6 +55,22 @@ mir::dispatch::ActionQueue::ActionQueue()
                                                  "Failed to create event fd for action queue"}));
 }
 
+mir::dispatch::ActionQueue::~ActionQueue()
+{
+    for (auto list : {newest.load(), leftovers})
+    {
+        for (auto node = list; node;)
+        {
+            auto const done = node;
+            node = node->next;
+            release(done);
+        }
+    }
+
+    for (auto& chunk : chunks)
+        delete[] chunk.load();
+}
+
 mir::Fd mir::dispatch::ActionQueue::watch_fd() const
 {
     return event_fd;
@@ -37,9 +78,86 @@ mir::Fd mir::dispatch::ActionQueue::watch_fd() const
 
 void mir::dispatch::ActionQueue::enqueue(std::function<void()> const& action)
 {
-    std::unique_lock<std::mutex> lock(list_lock);
-    actions.push_back(action);
-    wake();
+    push(make_node<ActionNode<std::function<void()>>>(action));
+}
+
+void* mir::dispatch::ActionQueue::take_block()
+{
+    while (true)
+    {
+        auto head = free_blocks.load();
+        while (auto const top = head & index_mask)
+        {
+            auto const index = top - 1;
+            auto& block = chunks[index / blocks_per_chunk].load()[index % blocks_per_chunk];
+
+            // Counting pops means a block popped and pushed back meanwhile
+            // doesn't look like the one we read next_free from
+            auto const popped = ((head & ~index_mask) + (index_mask + 1)) | block.next_free.load();
+            if (free_blocks.compare_exchange_weak(head, popped))
+                return block.storage;
+        }
+
+        std::lock_guard<std::mutex> lock{growth_mutex};
+
+        // Another thread may have grown the pool while we waited
+        if (free_blocks.load() & index_mask)
+            continue;
+
+        auto const chunk_index = chunk_count.load();
+        if (chunk_index == max_chunks)
+            return nullptr;
+
+        auto const chunk = new Block[blocks_per_chunk];
+        for (size_t i = 0; i != blocks_per_chunk; ++i)
+            chunk[i].index = static_cast<uint32_t>(chunk_index * blocks_per_chunk + i);
+        chunks[chunk_index].store(chunk);
+        chunk_count.store(chunk_index + 1);
+
+        // Keep the first block, and make the rest free
+        for (size_t i = 1; i != blocks_per_chunk; ++i)
+            give_back(chunk[i].storage);
+        return chunk[0].storage;
+    }
+}
+
+void mir::dispatch::ActionQueue::give_back(void* storage)
+{
+    auto& block = *reinterpret_cast<Block*>(storage);
+
+    auto head = free_blocks.load();
+    do
+        block.next_free.store(static_cast<uint32_t>(head & index_mask));
+    while (!free_blocks.compare_exchange_weak(head, (head & ~index_mask) | (block.index + 1)));
+}
+
+void mir::dispatch::ActionQueue::release(Node* node)
+{
+    if (node->pooled)
+    {
+        // The block holds the whole ActionNode, which starts where it does
+        auto const storage = dynamic_cast<void*>(node);
+        node->~Node();
+        give_back(storage);
+    }
+    else
+    {
+        delete node;
+    }
+}
+
+void mir::dispatch::ActionQueue::push(Node* pushed)
+{
+    auto previous = newest.load(std::memory_order_relaxed);
+
+    // Once pushed, the node may be taken (and run) at any moment, so don't touch it after
+    do
+        pushed->next = previous;
+    while (!newest.compare_exchange_weak(previous, pushed, std::memory_order_release, std::memory_order_relaxed));
+
+    // Otherwise whoever takes the queue once it is awake takes this too
+    if (!previous)
+        wake();
 }
 
 bool mir::dispatch::ActionQueue::dispatch(FdEvents events)
@@ -54,15 +172,52 @@ bool mir::dispatch::ActionQueue::dispatch(FdEvents events)
         return true;
     }
 
-    std::function<void()> action_to_process;
+    // Whatever an action that threw left goes before anything queued since
+    Node* oldest{nullptr};
+    {
+        std::lock_guard<std::mutex> lock{leftovers_mutex};
+        std::swap(oldest, leftovers);
+    }
 
+    // Anything queued after this wakes us again
+    Node* taken{nullptr};
+    for (auto node = newest.exchange(nullptr, std::memory_order_acquire); node;)
     {
-        std::unique_lock<std::mutex> lock(list_lock);
-        action_to_process = actions.front();
-        actions.pop_front();
+        auto const next = node->next;
+        node->next = taken;
+        taken = node;
+        node = next;
     }
+    *last_of(&oldest) = taken;
+
+    while (oldest)
+    {
+        auto const node = oldest;
+        oldest = node->next;
 
-    action_to_process();
+        try
+        {
+            node->run();
+        }
+        catch (...)
+        {
+            release(node);
+
+            // Don't lose the rest: they'll be run first by a later dispatch
+            if (oldest)
+            {
+                {
+                    std::lock_guard<std::mutex> lock{leftovers_mutex};
+                    *last_of(&oldest) = leftovers;
+                    leftovers = oldest;
+                }
+                wake();
+            }
+            throw;
+        }
+
+        release(node);
+    }
 
     return true;
 }
@@ -74,8 +229,8 @@ mir::dispatch::FdEvents mir::dispatch::ActionQueue::relevant_events() const
 
 bool mir::dispatch::ActionQueue::consume()
 {
-    uint64_t num_actions;
-    if (read(event_fd, &num_actions, sizeof num_actions) != sizeof num_actions)
+    uint64_t num_wakes;
+    if (read(event_fd, &num_wakes, sizeof num_wakes) != sizeof num_wakes)
     {
         if (errno == EAGAIN)
         {
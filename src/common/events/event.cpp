@@ -35,10 +35,84 @@
 #include "mir/events/surface_placement_event.h"
 
 #include <capnp/serialize.h>
+#include <kj/io.h>
 
+#include <mutex>
+#include <vector>
 
 namespace ml = mir::logging;
 
+namespace
+{
+// Keeps freed event storage to hand back out, up to a limit
+class EventStorage
+{
+public:
+    EventStorage()
+    {
+        free_blocks.reserve(max_free_blocks);
+    }
+
+    void* allocate()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!free_blocks.empty())
+            {
+                auto const block = free_blocks.back();
+                free_blocks.pop_back();
+                return block;
+            }
+        }
+
+        return ::operator new(sizeof(MirEvent));
+    }
+
+    void release(void* block)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (free_blocks.size() < max_free_blocks)
+            {
+                free_blocks.push_back(block);
+                return;
+            }
+        }
+
+        ::operator delete(block);
+    }
+
+private:
+    static std::size_t const max_free_blocks = 64;
+
+    std::mutex mutex;
+    std::vector<void*> free_blocks;
+};
+
+EventStorage& event_storage()
+{
+    // Deliberately never destroyed: events may be freed during static destruction
+    static auto const storage = new EventStorage;
+    return *storage;
+}
+}
+
+void* MirEvent::operator new(std::size_t size)
+{
+    if (size != sizeof(MirEvent))
+        return ::operator new(size);
+
+    return event_storage().allocate();
+}
+
+void MirEvent::operator delete(void* storage, std::size_t size)
+{
+    if (size != sizeof(MirEvent))
+        ::operator delete(storage);
+    else
+        event_storage().release(storage);
+}
+
 MirEvent::MirEvent(MirEvent const& e)
 {
     auto reader = e.event.asReader();
@@ -70,9 +144,18 @@ mir::EventUPtr MirEvent::deserialize(std::string const& bytes)
 std::string MirEvent::serialize(MirEvent const* event)
 {
     std::string output;
-    auto flat_event = ::capnp::messageToFlatArray(const_cast<MirEvent*>(event)->message);
+    serialize(event, output);
+    return output;
+}
+
+void MirEvent::serialize(MirEvent const* event, std::string& output)
+{
+    auto& message = const_cast<MirEvent*>(event)->message;
 
-    return {reinterpret_cast<char*>(flat_event.asBytes().begin()), flat_event.asBytes().size()};
+    // Segments are written straight into output, without an intermediate flat array
+    output.resize(::capnp::computeSerializedSizeInWords(message) * sizeof(::capnp::word));
+    kj::ArrayOutputStream stream{kj::arrayPtr(reinterpret_cast<kj::byte*>(&output[0]), output.size())};
+    ::capnp::writeMessage(stream, message);
 }
 
 MirEventType MirEvent::type() const
@@ -0,0 +1,41 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/extension_list.h"
+#include <cstring>
+
+bool mir::graphics::has_extension(char const* extensions, char const* extension)
+{
+    if (!extensions || !extension)
+        return false;
+
+    size_t const len = strlen(extension);
+    if (len == 0)
+        return false;
+
+    // A match only counts when it is a whole name, not part of a longer one
+    for (char const* found = strstr(extensions, extension);
+         found;
+         found = strstr(found + len, extension))
+    {
+        bool const starts_name = found == extensions || found[-1] == ' ';
+        bool const ends_name = found[len] == ' ' || found[len] == '\0';
+        if (starts_name && ends_name)
+            return true;
+    }
+
+    return false;
+}
@@ -19,69 +19,233 @@
 #include "mir/recursive_read_write_mutex.h"
 
 #include <algorithm>
+#include <vector>
 
-void mir::RecursiveReadWriteMutex::read_lock()
+namespace
 {
-    auto const my_id = std::this_thread::get_id();
+/// A read lock count; only ever changed by the thread it belongs to
+struct ReadLockCount
+{
+    // Mutexes are told apart by id, as a destroyed one's address may be reused
+    std::atomic<uint64_t> mutex{0};
+    std::atomic<unsigned int> count{0};
+};
 
-    std::unique_lock<decltype(mutex)> lock{mutex};
-    cv.wait(lock, [&]{
-        return !write_locking_thread.count ||
-            write_locking_thread.id == my_id; });
+std::atomic<uint64_t> next_mutex_id{1};
+
+/**
+ * The read locks held by one thread. It grows a chunk at a time, and chunks
+ * never move, so a writer can look through them while the thread carries on.
+ */
+class ThreadReadLocks
+{
+public:
+    ThreadReadLocks();
+    ~ThreadReadLocks();
+
+    /// The count for \a mutex, or a free one, which the caller is to claim
+    ReadLockCount& count_for(uint64_t mutex);
+
+    bool read_locked(uint64_t mutex) const;
+
+private:
+    static size_t const chunk_size = 8;
+
+    struct Chunk
+    {
+        ReadLockCount counts[chunk_size];
+        std::atomic<Chunk*> next{nullptr};
+    };
+
+    Chunk first;
+};
+
+/// Every thread's read locks, for writers to look through
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<ThreadReadLocks const*> threads;
+};
+
+Registry& registry()
+{
+    static Registry* const instance = new Registry; // Outlives threads exiting during shutdown
+    return *instance;
+}
+
+ThreadReadLocks& this_thread_read_locks()
+{
+    thread_local ThreadReadLocks locks;
+    return locks;
+}
 
-    auto const my_count = std::find_if(
-        read_locking_threads.begin(),
-        read_locking_threads.end(),
-        [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+ThreadReadLocks::ThreadReadLocks()
+{
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock{r.mutex};
+    r.threads.push_back(this);
+}
 
-    if (my_count == read_locking_threads.end())
+ThreadReadLocks::~ThreadReadLocks()
+{
     {
-        read_locking_threads.push_back(ThreadLockCount(my_id, 1U));
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock{r.mutex};
+        r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
     }
-    else
+
+    for (auto chunk = first.next.load(); chunk;)
     {
-        ++(my_count->count);
+        auto const next = chunk->next.load();
+        delete chunk;
+        chunk = next;
     }
 }
 
-void mir::RecursiveReadWriteMutex::read_unlock()
+ReadLockCount& ThreadReadLocks::count_for(uint64_t mutex)
 {
-    auto const my_id = std::this_thread::get_id();
+    ReadLockCount* unused{nullptr};
 
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    auto const my_count = std::find_if(
-        read_locking_threads.begin(),
-        read_locking_threads.end(),
-        [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+    for (auto chunk = &first; chunk; chunk = chunk->next.load(std::memory_order_relaxed))
+    {
+        for (auto& count : chunk->counts)
+        {
+            if (count.mutex.load(std::memory_order_relaxed) == mutex)
+                return count;
 
-    --(my_count->count);
+            if (!unused && count.count.load(std::memory_order_relaxed) == 0)
+                unused = &count;
+        }
 
-    cv.notify_all();
+        if (!chunk->next.load(std::memory_order_relaxed) && !unused)
+            chunk->next.store(new Chunk, std::memory_order_release);
+    }
+
+    return *unused;
+}
+
+bool ThreadReadLocks::read_locked(uint64_t mutex) const
+{
+    for (auto chunk = &first; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+    {
+        for (auto const& count : chunk->counts)
+        {
+            // The count may be reclaimed for another mutex between these loads, so check
+            // the mutex again: if it is still ours, a reader is still bound to wake us.
+            if (count.mutex.load() == mutex && count.count.load() != 0 && count.mutex.load() == mutex)
+                return true;
+        }
+    }
+
+    return false;
+}
+}
+
+mir::RecursiveReadWriteMutex::RecursiveReadWriteMutex()
+    : id{next_mutex_id++},
+      writer{false},
+      write_locking_thread{std::thread::id{}},
+      write_count{0},
+      waiting_writers{0}
+{
+}
+
+void mir::RecursiveReadWriteMutex::read_lock()
+{
+    auto& count = this_thread_read_locks().count_for(id);
+    auto const held = count.mutex.load(std::memory_order_relaxed) == id ?
+        count.count.load(std::memory_order_relaxed) : 0;
+
+    // Recursive, or under our own write lock: no one can be waiting on us
+    if (held || write_locking_thread.load(std::memory_order_relaxed) == std::this_thread::get_id())
+    {
+        count.mutex.store(id, std::memory_order_relaxed);
+        count.count.store(held + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    count.mutex.store(id);
+    while (true)
+    {
+        count.count.store(1);
+
+        if (!writer.load())
+            return;
+
+        // Give way to the writer...
+        count.count.store(0);
+
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        cv.notify_all();
+        cv.wait(lock, [this] { return !writer.load(); });
+    }
+}
+
+void mir::RecursiveReadWriteMutex::read_unlock()
+{
+    auto& count = this_thread_read_locks().count_for(id);
+    auto const remaining = count.count.load(std::memory_order_relaxed) - 1;
+
+    count.count.store(remaining);
+
+    if (remaining == 0 && writer.load())
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        cv.notify_all();
+    }
 }
 
 void mir::RecursiveReadWriteMutex::write_lock()
 {
     auto const my_id = std::this_thread::get_id();
 
+    if (write_locking_thread.load(std::memory_order_relaxed) == my_id)
+    {
+        ++write_count;
+        return;
+    }
+
     std::unique_lock<decltype(mutex)> lock{mutex};
-    cv.wait(lock, [&]
+
+    // From here on, new readers wait for us. One already holding a read lock
+    // doesn't: another writer waiting could be waiting on them, so as when
+    // taking a read lock recursively, they go ahead of it.
+    ++waiting_writers;
+    writer.store(true);
+
+    cv.wait(lock, [this]
         {
-            if (write_locking_thread.count &&
-                write_locking_thread.id != my_id) return false;
-            for (auto const& candidate : read_locking_threads)
-            {
-                if (candidate.id != my_id && candidate.count != 0) return false;
-            }
-            return true;
+            return write_locking_thread.load() == std::thread::id{} &&
+                !other_threads_read_locked();
         });
 
-    ++write_locking_thread.count;
-    write_locking_thread.id = my_id;
+    --waiting_writers;
+    write_locking_thread.store(my_id);
+    write_count = 1;
 }
 
 void mir::RecursiveReadWriteMutex::write_unlock()
 {
+    if (--write_count)
+        return;
+
     std::lock_guard<decltype(mutex)> lock{mutex};
-    --write_locking_thread.count;
+    write_locking_thread.store(std::thread::id{});
+    writer.store(waiting_writers != 0);
     cv.notify_all();
 }
+
+bool mir::RecursiveReadWriteMutex::other_threads_read_locked() const
+{
+    auto const& mine = this_thread_read_locks();
+    auto& r = registry();
+
+    std::lock_guard<std::mutex> lock{r.mutex};
+    for (auto const locks : r.threads)
+    {
+        if (locks != &mine && locks->read_locked(id))
+            return true;
+    }
+
+    return false;
+}
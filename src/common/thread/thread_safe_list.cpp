@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/thread_safe_list.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+
+using Readers = mir::detail::ThreadSafeListReaders;
+
+namespace
+{
+// 0 means "not reading"
+std::atomic<uint64_t> current_epoch{1};
+
+/// Every thread's record, for writers to look through
+struct Registry
+{
+    std::mutex mutex;
+    std::condition_variable not_called;
+    std::vector<Readers::Reader const*> readers;
+};
+
+Registry& registry()
+{
+    static Registry* const instance = new Registry; // Outlives threads exiting during shutdown
+    return *instance;
+}
+
+struct RegisteredReader : Readers::Reader
+{
+    RegisteredReader()
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock{r.mutex};
+        r.readers.push_back(this);
+    }
+
+    ~RegisteredReader()
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock{r.mutex};
+        r.readers.erase(std::find(r.readers.begin(), r.readers.end(), this));
+    }
+};
+
+Readers::Reader& this_thread_reader()
+{
+    thread_local RegisteredReader reader;
+    return reader;
+}
+
+bool is_calling(Readers::Reader const& reader, void const* element)
+{
+    // Too deep to have a slot, so it might be calling anything
+    if (reader.depth.load() > Readers::max_depth)
+        return true;
+
+    for (auto const& calling : reader.calling)
+    {
+        if (calling.load() == element)
+            return true;
+    }
+
+    return false;
+}
+}
+
+std::atomic<unsigned int> Readers::waiting_writers{0};
+
+auto Readers::enter() -> Reader&
+{
+    auto& reader = this_thread_reader();
+    auto const depth = reader.depth.load(std::memory_order_relaxed);
+
+    // Anything read from now on was published no earlier than this
+    if (depth == 0)
+        reader.epoch.store(current_epoch.load());
+
+    reader.depth.store(depth + 1);
+    return reader;
+}
+
+void Readers::leave(Reader& reader)
+{
+    auto const depth = reader.depth.load(std::memory_order_relaxed);
+
+    if (depth <= max_depth)
+        reader.calling[depth - 1].store(nullptr);
+
+    if (depth == 1)
+        reader.epoch.store(0);
+
+    reader.depth.store(depth - 1);
+
+    if (waiting_writers.load())
+        wake_writers();
+}
+
+void Readers::wake_writers()
+{
+    auto& r = registry();
+    {
+        // Writers check under the lock before waiting, so this can't fall in between
+        std::lock_guard<std::mutex> lock{r.mutex};
+    }
+    r.not_called.notify_all();
+}
+
+uint64_t Readers::end_epoch()
+{
+    return current_epoch.fetch_add(1);
+}
+
+uint64_t Readers::oldest_epoch_read()
+{
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock{r.mutex};
+
+    auto oldest = std::numeric_limits<uint64_t>::max();
+    for (auto const reader : r.readers)
+    {
+        auto const epoch = reader->epoch.load();
+        if (epoch != 0)
+            oldest = std::min(oldest, epoch);
+    }
+
+    return oldest;
+}
+
+void Readers::wait_until_not_called(void const* element)
+{
+    // A call on this thread is what's removing it, so must be let carry on
+    auto const self = &this_thread_reader();
+
+    auto& r = registry();
+    std::unique_lock<std::mutex> lock{r.mutex};
+
+    ++waiting_writers;
+    r.not_called.wait(lock, [&]
+        {
+            return std::none_of(r.readers.begin(), r.readers.end(),
+                [&](Reader const* reader) { return reader != self && is_calling(*reader, element); });
+        });
+    --waiting_writers;
+}
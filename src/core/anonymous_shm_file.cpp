@@ -28,7 +28,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <fcntl.h>
+#include <linux/memfd.h>
 
 namespace
 {
@@ -43,8 +46,40 @@ bool error_indicates_tmpfile_not_supported(int error)
                             // that incorrectly returns EINVAL. Yay.
 }
 
+/*
+ * A memfd that can't shrink can be turned into a dma-buf (by udmabuf), so
+ * the GPU can read it without a copy. Returns an invalid Fd where memfds
+ * aren't supported.
+ */
+mir::Fd create_sealed_memfd(size_t size)
+{
+#if defined(__NR_memfd_create) && defined(F_ADD_SEALS)
+    mir::Fd fd{static_cast<int>(syscall(__NR_memfd_create, "mir-buffer", MFD_CLOEXEC | MFD_ALLOW_SEALING))};
+    if (fd == mir::Fd::invalid)
+        return fd;
+
+    if (ftruncate(fd, size) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to resize temporary file"));
+    }
+
+    // Without the seal the file is still usable, just not shareable
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL);
+
+    return fd;
+#else
+    (void)size;
+    return mir::Fd{};
+#endif
+}
+
 mir::Fd create_anonymous_file(size_t size)
 {
+    auto memfd = create_sealed_memfd(size);
+    if (memfd != mir::Fd::invalid)
+        return memfd;
+
     auto raw_fd = open("/dev/shm", O_TMPFILE | O_RDWR | O_EXCL | O_CLOEXEC, S_IRWXU);
 
     // Workaround for filesystems that don't support O_TMPFILE
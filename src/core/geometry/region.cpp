@@ -0,0 +1,254 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <algorithm>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+bool in_either(bool in_a, bool in_b) { return in_a || in_b; }
+bool in_first_only(bool in_a, bool in_b) { return in_a && !in_b; }
+bool in_both(bool in_a, bool in_b) { return in_a && in_b; }
+
+template<typename Interval>
+std::vector<int> edges_of(
+    std::vector<Interval> const& a,
+    std::vector<Interval> const& b,
+    int Interval::* first,
+    int Interval::* last)
+{
+    std::vector<int> edges;
+    edges.reserve(2 * (a.size() + b.size()));
+
+    for (auto const& intervals : {&a, &b})
+    {
+        for (auto const& interval : *intervals)
+        {
+            edges.push_back(interval.*first);
+            edges.push_back(interval.*last);
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    return edges;
+}
+
+template<typename Span>
+bool same_spans(std::vector<Span> const& a, std::vector<Span> const& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+        [](Span const& lhs, Span const& rhs)
+        {
+            return lhs.left == rhs.left && lhs.right == rhs.right;
+        });
+}
+}
+
+geom::Region::Region()
+{
+}
+
+geom::Region::Region(Rectangle const& rect)
+{
+    if (rect.size.width > Width{0} && rect.size.height > Height{0})
+    {
+        bands.push_back({
+            rect.top().as_int(),
+            rect.bottom().as_int(),
+            {{rect.left().as_int(), rect.right().as_int()}}});
+    }
+}
+
+void geom::Region::add(Rectangle const& rect)
+{
+    add(Region{rect});
+}
+
+void geom::Region::add(Region const& other)
+{
+    if (bands.empty())
+        bands = other.bands;
+    else if (!other.bands.empty())
+        bands = combine(bands, other.bands, &in_either);
+}
+
+void geom::Region::subtract(Rectangle const& rect)
+{
+    subtract(Region{rect});
+}
+
+void geom::Region::subtract(Region const& other)
+{
+    if (!bands.empty() && !other.bands.empty())
+        bands = combine(bands, other.bands, &in_first_only);
+}
+
+void geom::Region::intersect(Rectangle const& rect)
+{
+    intersect(Region{rect});
+}
+
+void geom::Region::intersect(Region const& other)
+{
+    bands = combine(bands, other.bands, &in_both);
+}
+
+void geom::Region::clear()
+{
+    bands.clear();
+}
+
+bool geom::Region::empty() const
+{
+    return bands.empty();
+}
+
+bool geom::Region::contains(Rectangle const& rect) const
+{
+    Region outside{rect};
+    outside.subtract(*this);
+    return outside.empty();
+}
+
+bool geom::Region::overlaps(Rectangle const& rect) const
+{
+    Region inside{rect};
+    inside.intersect(*this);
+    return !inside.empty();
+}
+
+geom::Rectangle geom::Region::bounding_rectangle() const
+{
+    if (bands.empty())
+        return Rectangle();
+
+    auto left = bands.front().spans.front().left;
+    auto right = bands.front().spans.back().right;
+    for (auto const& band : bands)
+    {
+        left = std::min(left, band.spans.front().left);
+        right = std::max(right, band.spans.back().right);
+    }
+
+    auto const top = bands.front().top;
+    auto const bottom = bands.back().bottom;
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+std::vector<geom::Rectangle> geom::Region::rectangles() const
+{
+    std::vector<Rectangle> result;
+
+    for (auto const& band : bands)
+    {
+        for (auto const& span : band.spans)
+            result.push_back({{span.left, band.top}, {span.right - span.left, band.bottom - band.top}});
+    }
+
+    return result;
+}
+
+bool geom::Region::operator==(Region const& other) const
+{
+    return std::equal(bands.begin(), bands.end(), other.bands.begin(), other.bands.end(),
+        [](Band const& lhs, Band const& rhs)
+        {
+            return lhs.top == rhs.top && lhs.bottom == rhs.bottom && same_spans(lhs.spans, rhs.spans);
+        });
+}
+
+bool geom::Region::operator!=(Region const& other) const
+{
+    return !(*this == other);
+}
+
+/*
+ * Both operands are cut at every edge either of them has. Between two
+ * neighbouring edges neither operand changes, so whether that interval is
+ * in the result depends only on whether it is in each operand.
+ */
+std::vector<geom::Region::Band> geom::Region::combine(
+    std::vector<Band> const& a,
+    std::vector<Band> const& b,
+    bool (*keep)(bool in_a, bool in_b))
+{
+    static std::vector<Span> const no_spans;
+    auto const edges = edges_of(a, b, &Band::top, &Band::bottom);
+
+    std::vector<Band> result;
+    auto band_a = a.begin();
+    auto band_b = b.begin();
+    for (size_t i = 0; i + 1 < edges.size(); ++i)
+    {
+        auto const top = edges[i];
+        auto const bottom = edges[i + 1];
+
+        while (band_a != a.end() && band_a->bottom <= top) ++band_a;
+        while (band_b != b.end() && band_b->bottom <= top) ++band_b;
+
+        auto const& spans_a = band_a != a.end() && band_a->top <= top ? band_a->spans : no_spans;
+        auto const& spans_b = band_b != b.end() && band_b->top <= top ? band_b->spans : no_spans;
+
+        auto spans = combine(spans_a, spans_b, keep);
+        if (spans.empty())
+            continue;
+
+        // Merging matching neighbours keeps the representation canonical
+        if (!result.empty() && result.back().bottom == top && same_spans(result.back().spans, spans))
+            result.back().bottom = bottom;
+        else
+            result.push_back({top, bottom, std::move(spans)});
+    }
+
+    return result;
+}
+
+std::vector<geom::Region::Span> geom::Region::combine(
+    std::vector<Span> const& a,
+    std::vector<Span> const& b,
+    bool (*keep)(bool in_a, bool in_b))
+{
+    auto const edges = edges_of(a, b, &Span::left, &Span::right);
+
+    std::vector<Span> result;
+    auto span_a = a.begin();
+    auto span_b = b.begin();
+    for (size_t i = 0; i + 1 < edges.size(); ++i)
+    {
+        auto const left = edges[i];
+        auto const right = edges[i + 1];
+
+        while (span_a != a.end() && span_a->right <= left) ++span_a;
+        while (span_b != b.end() && span_b->right <= left) ++span_b;
+
+        bool const in_a = span_a != a.end() && span_a->left <= left;
+        bool const in_b = span_b != b.end() && span_b->left <= left;
+
+        if (!keep(in_a, in_b))
+            continue;
+
+        if (!result.empty() && result.back().right == left)
+            result.back().right = right;
+        else
+            result.push_back({left, right});
+    }
+
+    return result;
+}
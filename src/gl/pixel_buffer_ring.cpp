@@ -0,0 +1,231 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pixel_buffer_ring.h"
+#include "mir/graphics/extension_list.h"
+#include "mir/graphics/gl_format.h"
+#include "mir/renderer/gl/streaming_texture_source.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace mgl = mir::gl;
+namespace mg = mir::graphics;
+namespace mrgl = mir::renderer::gl;
+
+// GLES 3 and GL_EXT_buffer_storage values, not in the GLES2 headers
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace
+{
+int gl_major_version()
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    if (!version)
+        return 0;
+
+    // "OpenGL ES 3.2 Mesa ..." on GLES, "4.5 (Compatibility Profile) ..." on GL
+    static char const es_prefix[] = "OpenGL ES ";
+    if (strncmp(version, es_prefix, sizeof es_prefix - 1) == 0)
+        return atoi(version + sizeof es_prefix - 1);
+    return atoi(version);
+}
+
+template<typename Function>
+void lookup(Function& function, char const* name)
+{
+    function = reinterpret_cast<Function>(eglGetProcAddress(name));
+}
+}
+
+std::shared_ptr<mgl::PixelBufferFunctions const> mgl::PixelBufferFunctions::for_current_context()
+{
+    auto const display = eglGetCurrentDisplay();
+    if (display == EGL_NO_DISPLAY || gl_major_version() < 3 ||
+        !mg::has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_fence_sync"))
+    {
+        return nullptr;
+    }
+
+    auto const functions = std::make_shared<PixelBufferFunctions>();
+    functions->display = display;
+    lookup(functions->map_buffer_range, "glMapBufferRange");
+    lookup(functions->unmap_buffer, "glUnmapBuffer");
+    lookup(functions->create_sync, "eglCreateSyncKHR");
+    lookup(functions->destroy_sync, "eglDestroySyncKHR");
+    lookup(functions->client_wait_sync, "eglClientWaitSyncKHR");
+
+    auto const gl_extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    if (mg::has_extension(gl_extensions, "GL_EXT_buffer_storage"))
+        lookup(functions->buffer_storage, "glBufferStorageEXT");
+    else if (mg::has_extension(gl_extensions, "GL_ARB_buffer_storage"))
+        lookup(functions->buffer_storage, "glBufferStorage");
+    else
+        functions->buffer_storage = nullptr;
+
+    if (!functions->map_buffer_range || !functions->unmap_buffer || !functions->create_sync ||
+        !functions->destroy_sync || !functions->client_wait_sync)
+    {
+        return nullptr;
+    }
+
+    return functions;
+}
+
+mgl::PixelBufferRing::PixelBufferRing(std::shared_ptr<PixelBufferFunctions const> const& functions)
+    : functions{functions}
+{
+}
+
+mgl::PixelBufferRing::~PixelBufferRing()
+{
+    for (auto& slot : slots)
+    {
+        if (slot.fence != EGL_NO_SYNC_KHR)
+            functions->destroy_sync(functions->display, slot.fence);
+        release(slot);
+    }
+}
+
+bool mgl::PixelBufferRing::upload(mrgl::StreamingTextureSource& source)
+{
+    auto const format = source.pixel_format();
+    GLenum gl_format, gl_type;
+    if (!mg::get_gl_pixel_format(format, gl_format, gl_type))
+        return false;
+
+    auto const size = source.size();
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+    auto const bytes = static_cast<GLsizeiptr>(MIR_BYTES_PER_PIXEL(format)) * width * height;
+
+    auto& slot = slots[next_slot];
+    auto const pixels = map(slot, bytes);
+    if (!pixels)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    next_slot = (next_slot + 1) % slots.size();
+
+    source.copy_packed_pixels(static_cast<unsigned char*>(pixels));
+    if (!slot.persistent_mapping)
+        functions->unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // With a buffer bound, the pixels "pointer" is an offset into the buffer
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (size == texture_size && format == texture_format)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, gl_format, gl_type, nullptr);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, gl_format, width, height, 0, gl_format, gl_type, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    texture_size = size;
+    texture_format = format;
+    slot.fence = functions->create_sync(functions->display, EGL_SYNC_FENCE_KHR, nullptr);
+
+    return true;
+}
+
+void mgl::PixelBufferRing::texture_replaced()
+{
+    texture_format = mir_pixel_format_invalid;
+}
+
+void* mgl::PixelBufferRing::map(Slot& slot, GLsizeiptr bytes)
+{
+    if (!finished_with(slot))
+        return nullptr;
+
+    if (slot.capacity < bytes)
+    {
+        release(slot);
+
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        if (functions->buffer_storage)
+        {
+            GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            functions->buffer_storage(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, flags);
+            slot.persistent_mapping = functions->map_buffer_range(GL_PIXEL_UNPACK_BUFFER, 0, bytes, flags);
+        }
+        else
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        }
+        slot.capacity = bytes;
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    }
+
+    if (slot.persistent_mapping)
+        return slot.persistent_mapping;
+
+    return functions->map_buffer_range(
+        GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+bool mgl::PixelBufferRing::finished_with(Slot& slot)
+{
+    if (slot.fence == EGL_NO_SYNC_KHR)
+        return true;
+
+    // Blocking here would stall the compositor for longer than the
+    // synchronous upload the caller can fall back to
+    if (functions->client_wait_sync(
+            functions->display, slot.fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, 0) != EGL_CONDITION_SATISFIED_KHR)
+    {
+        return false;
+    }
+
+    functions->destroy_sync(functions->display, slot.fence);
+    slot.fence = EGL_NO_SYNC_KHR;
+    return true;
+}
+
+void mgl::PixelBufferRing::release(Slot& slot)
+{
+    if (!slot.buffer)
+        return;
+
+    if (slot.persistent_mapping)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        functions->unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &slot.buffer);
+
+    slot.buffer = 0;
+    slot.capacity = 0;
+    slot.persistent_mapping = nullptr;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GL_PIXEL_BUFFER_RING_H_
+#define MIR_GL_PIXEL_BUFFER_RING_H_
+
+#include "mir/geometry/size.h"
+#include "mir_toolkit/common.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include MIR_SERVER_GL_H
+
+#include <array>
+#include <memory>
+
+namespace mir
+{
+namespace renderer { namespace gl { class StreamingTextureSource; } }
+namespace gl
+{
+/// The entry points pixel buffer streaming needs beyond GLES2
+struct PixelBufferFunctions
+{
+    /// Null if the current context lacks mappable pixel buffers or EGL fences
+    static std::shared_ptr<PixelBufferFunctions const> for_current_context();
+
+    EGLDisplay display;
+    void* (*map_buffer_range)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    GLboolean (*unmap_buffer)(GLenum target);
+    /// Null when buffers can't stay mapped, so are mapped for each upload instead
+    void (*buffer_storage)(GLenum target, GLsizeiptr size, void const* data, GLbitfield flags);
+    PFNEGLCREATESYNCKHRPROC create_sync;
+    PFNEGLDESTROYSYNCKHRPROC destroy_sync;
+    PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync;
+};
+
+/**
+ * Uploads one texture's pixels through two pixel buffer objects used in
+ * turn. The CPU copy into a pixel buffer is still made on the calling
+ * thread; what this saves is the driver copying (or stalling) inside
+ * glTexImage2D, as the GPU transfers out of the pixel buffer by itself.
+ * A fence stops a buffer being rewritten before that transfer is done.
+ */
+class PixelBufferRing
+{
+public:
+    explicit PixelBufferRing(std::shared_ptr<PixelBufferFunctions const> const& functions);
+    ~PixelBufferRing();
+
+    /**
+     * Uploads \a source to the bound texture. Returns false, having uploaded
+     * nothing, if GL can't take its pixels as they are or if the GPU is still
+     * reading the pixel buffer that would be used. It never waits on the GPU.
+     */
+    bool upload(renderer::gl::StreamingTextureSource& source);
+
+    /// Notes that the texture has been uploaded to by other means
+    void texture_replaced();
+
+private:
+    PixelBufferRing(PixelBufferRing const&) = delete;
+    PixelBufferRing& operator=(PixelBufferRing const&) = delete;
+
+    struct Slot
+    {
+        GLuint buffer{0};
+        GLsizeiptr capacity{0};
+        void* persistent_mapping{nullptr};
+        EGLSyncKHR fence{EGL_NO_SYNC_KHR};
+    };
+
+    void* map(Slot& slot, GLsizeiptr bytes);
+    bool finished_with(Slot& slot);
+    void release(Slot& slot);
+
+    std::shared_ptr<PixelBufferFunctions const> const functions;
+    std::array<Slot, 2> slots;
+    size_t next_slot{0};
+    geometry::Size texture_size;
+    MirPixelFormat texture_format{mir_pixel_format_invalid};
+};
+}
+}
+
+#endif /* MIR_GL_PIXEL_BUFFER_RING_H_ */
@@ -20,6 +20,8 @@
 #include "recently_used_cache.h"
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/texture_source.h"
+#include "mir/renderer/gl/incremental_texture_source.h"
+#include "mir/renderer/gl/streaming_texture_source.h"
 
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
@@ -42,7 +44,22 @@ std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const&
 
     if ((texture.last_bound_buffer != buffer_id) || (!texture.valid_binding))
     {
-        texture_source->bind();
+        auto const streaming_source =
+            dynamic_cast<mrgl::StreamingTextureSource*>(buffer->native_buffer_base());
+        auto const incremental_source =
+            dynamic_cast<mrgl::IncrementalTextureSource*>(buffer->native_buffer_base());
+
+        if (!streaming_source || !stream(texture, *streaming_source))
+        {
+            if (texture.pixel_buffers)
+                texture.pixel_buffers->texture_replaced();
+
+            if (incremental_source && texture.valid_binding)
+                incremental_source->bind_changes_since(texture.last_bound_buffer);
+            else
+                texture_source->bind();
+        }
+
         texture.resource = buffer;
         texture.last_bound_buffer = buffer_id;
     }
@@ -54,6 +71,26 @@ std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const&
     return texture.texture;
 }
 
+bool mgl::RecentlyUsedCache::stream(Entry& entry, mrgl::StreamingTextureSource& source)
+{
+    if (!source.prefers_streaming())
+        return false;
+
+    if (!pixel_buffers_probed)
+    {
+        pixel_buffer_functions = PixelBufferFunctions::for_current_context();
+        pixel_buffers_probed = true;
+    }
+
+    if (!pixel_buffer_functions)
+        return false;
+
+    if (!entry.pixel_buffers)
+        entry.pixel_buffers = std::make_unique<PixelBufferRing>(pixel_buffer_functions);
+
+    return entry.pixel_buffers->upload(source);
+}
+
 void mgl::RecentlyUsedCache::invalidate()
 {
     for (auto &t : textures)
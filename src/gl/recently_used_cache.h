@@ -24,11 +24,13 @@
 #include "mir/gl/texture.h"
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/renderable.h"
+#include "pixel_buffer_ring.h"
 #include <unordered_map>
 
 namespace mir
 {
 namespace graphics { class Buffer; }
+namespace renderer { namespace gl { class StreamingTextureSource; } }
 namespace gl
 {
 class RecentlyUsedCache : public TextureCache
@@ -49,9 +51,14 @@ private:
         bool used{true};
         bool valid_binding{false};
         std::shared_ptr<graphics::Buffer> resource;
+        std::unique_ptr<PixelBufferRing> pixel_buffers;
     };
 
+    bool stream(Entry& entry, renderer::gl::StreamingTextureSource& source);
+
     std::unordered_map<graphics::Renderable::ID, Entry> textures;
+    bool pixel_buffers_probed{false};
+    std::shared_ptr<PixelBufferFunctions const> pixel_buffer_functions;
 };
 }
 }
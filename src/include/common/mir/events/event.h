@@ -25,6 +25,7 @@
 
 #include <capnp/message.h>
 
+#include <cstddef>
 #include <cstring>
 
 struct MirEvent
@@ -72,11 +73,24 @@ struct MirEvent
 
     static mir::EventUPtr deserialize(std::string const& bytes);
     static std::string serialize(MirEvent const* event);
+    /// As above, but writing into (and reusing the storage of) \a output
+    static void serialize(MirEvent const* event, std::string& output);
+
+    /// Events are created at input device rates, so their storage is recycled
+    static void* operator new(std::size_t size);
+    static void operator delete(void* storage, std::size_t size);
 
 protected:
     MirEvent() = default;
 
-    ::capnp::MallocMessageBuilder message;
+    /*
+     * Input events fit in the first message segment, so building one needs
+     * no allocation beyond the MirEvent itself. capnp needs it zeroed.
+     */
+    static std::size_t const first_segment_words = 128;
+    ::capnp::word first_segment[first_segment_words]{};
+
+    ::capnp::MallocMessageBuilder message{kj::arrayPtr(first_segment, first_segment_words)};
     mir::capnp::Event::Builder event{message.initRoot<mir::capnp::Event>()};
 };
 
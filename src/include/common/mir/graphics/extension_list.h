@@ -0,0 +1,31 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_EXTENSION_LIST_H_
+#define MIR_GRAPHICS_EXTENSION_LIST_H_
+
+namespace mir { namespace graphics {
+
+/**
+ * Whether \a extension is one of the space separated names in \a extensions,
+ * as returned by eglQueryString(..., EGL_EXTENSIONS) or
+ * glGetString(GL_EXTENSIONS). A null \a extensions contains nothing.
+ */
+bool has_extension(char const* extensions, char const* extension);
+
+}}
+
+#endif /* MIR_GRAPHICS_EXTENSION_LIST_H_ */
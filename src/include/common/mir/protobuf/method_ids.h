@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_PROTOBUF_METHOD_IDS_H
+#define MIR_PROTOBUF_METHOD_IDS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace mir
+{
+namespace protobuf
+{
+/**
+ * Numbers a client may send in place of method names once the server has
+ * said it accepts them (Connection.accepts_method_ids). The numbers are part
+ * of the protocol: new methods go immediately before "end" and existing ones
+ * are never renumbered.
+ */
+enum class MethodId : uint32_t
+{
+    none,
+    connect,
+    create_surface,
+    submit_buffer,
+    allocate_buffers,
+    release_buffers,
+    release_surface,
+    platform_operation,
+    configure_display,
+    remove_session_configuration,
+    set_base_display_configuration,
+    configure_surface,
+    modify_surface,
+    create_screencast,
+    screencast_buffer,
+    screencast_to_buffer,
+    release_screencast,
+    create_buffer_stream,
+    release_buffer_stream,
+    configure_cursor,
+    new_fds_for_prompt_providers,
+    start_prompt_session,
+    stop_prompt_session,
+    request_operation,
+    disconnect,
+    pong,
+    configure_buffer_stream,
+    translate_surface_to_screen,
+    request_persistent_surface_id,
+    preview_base_display_configuration,
+    confirm_base_display_configuration,
+    cancel_base_display_configuration_preview,
+    apply_input_configuration,
+    set_base_input_configuration,
+    end
+};
+
+/// The method's name, or an empty string if \a id isn't a method
+inline std::string const& method_name_for(MethodId id)
+{
+    static std::string const names[] =
+    {
+        "",
+        "connect",
+        "create_surface",
+        "submit_buffer",
+        "allocate_buffers",
+        "release_buffers",
+        "release_surface",
+        "platform_operation",
+        "configure_display",
+        "remove_session_configuration",
+        "set_base_display_configuration",
+        "configure_surface",
+        "modify_surface",
+        "create_screencast",
+        "screencast_buffer",
+        "screencast_to_buffer",
+        "release_screencast",
+        "create_buffer_stream",
+        "release_buffer_stream",
+        "configure_cursor",
+        "new_fds_for_prompt_providers",
+        "start_prompt_session",
+        "stop_prompt_session",
+        "request_operation",
+        "disconnect",
+        "pong",
+        "configure_buffer_stream",
+        "translate_surface_to_screen",
+        "request_persistent_surface_id",
+        "preview_base_display_configuration",
+        "confirm_base_display_configuration",
+        "cancel_base_display_configuration_preview",
+        "apply_input_configuration",
+        "set_base_input_configuration"
+    };
+    static_assert(sizeof names / sizeof names[0] == static_cast<size_t>(MethodId::end),
+                  "Every MethodId needs a name");
+
+    auto const index = static_cast<uint32_t>(id);
+    return index < static_cast<uint32_t>(MethodId::end) ? names[index] : names[0];
+}
+
+/// The method's number, or MethodId::none if it isn't a method
+inline MethodId method_id_for(std::string const& name)
+{
+    static auto const ids = []
+        {
+            std::unordered_map<std::string, MethodId> ids;
+            for (uint32_t i = 1; i != static_cast<uint32_t>(MethodId::end); ++i)
+                ids.emplace(method_name_for(static_cast<MethodId>(i)), static_cast<MethodId>(i));
+            return ids;
+        }();
+
+    auto const id = ids.find(name);
+    return id != ids.end() ? id->second : MethodId::none;
+}
+
+/// The name of the method a wire::Invocation calls, however it was given
+template<typename Invocation>
+std::string const& method_name_of(Invocation const& invocation)
+{
+    if (invocation.has_method_id())
+        return method_name_for(static_cast<MethodId>(invocation.method_id()));
+    return invocation.method_name();
+}
+}
+}
+
+#endif //MIR_PROTOBUF_METHOD_IDS_H
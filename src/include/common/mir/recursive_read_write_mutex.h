@@ -19,18 +19,29 @@
 #ifndef MIR_RECURSIVE_READ_WRITE_MUTEX_H_
 #define MIR_RECURSIVE_READ_WRITE_MUTEX_H_
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <thread>
-#include <vector>
 
 namespace mir
 {
 /** a recursive read-write mutex.
  * Note that a write lock can be acquired if no other threads have a read lock.
+ *
+ * Each thread records the read locks it holds in a table of its own, so
+ * taking or releasing a read lock writes nothing shared between threads:
+ * a writer raises a flag (which turns new readers away) and then looks
+ * through every thread's table for readers to wait for. Threads that
+ * already hold a read lock are never turned away, whether taking another
+ * read lock or a write lock.
  */
 class RecursiveReadWriteMutex
 {
 public:
+    RecursiveReadWriteMutex();
+
     void read_lock();
 
     void read_unlock();
@@ -40,17 +51,20 @@ public:
     void write_unlock();
 
 private:
+    RecursiveReadWriteMutex(RecursiveReadWriteMutex const&) = delete;
+    RecursiveReadWriteMutex& operator=(RecursiveReadWriteMutex const&) = delete;
+
+    bool other_threads_read_locked() const;
+
+    uint64_t const id;
+
+    // Only taken when a writer is involved
     std::mutex mutex;
     std::condition_variable cv;
-    struct ThreadLockCount
-    {
-        ThreadLockCount() : id(), count(0) {}
-        ThreadLockCount(std::thread::id id, unsigned int count) : id(id), count(count) {}
-        std::thread::id id;
-        unsigned int count;
-    };
-    std::vector<ThreadLockCount> read_locking_threads;
-    ThreadLockCount write_locking_thread;
+    std::atomic<bool> writer;   // Writers are waiting or one holds the lock
+    std::atomic<std::thread::id> write_locking_thread;
+    unsigned int write_count;
+    unsigned int waiting_writers;
 };
 
 class RecursiveReadLock
@@ -20,166 +20,337 @@
 #ifndef MIR_THREAD_SAFE_LIST_H_
 #define MIR_THREAD_SAFE_LIST_H_
 
-#include "mir/recursive_read_write_mutex.h"
-
 #include <atomic>
-#include <functional>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace mir
 {
+namespace detail
+{
+/**
+ * Keeps track of what threads inside ThreadSafeList::for_each() may be
+ * reading, so that writers know when they can free what they replaced and
+ * when an element they removed is no longer being called. A reader only
+ * writes to its own thread's record, which writers look through.
+ */
+class ThreadSafeListReaders
+{
+public:
+    static unsigned int const max_depth = 8;
+
+    /// One thread's record
+    struct Reader
+    {
+        /// The epoch this thread started reading in, or 0 if it isn't
+        std::atomic<uint64_t> epoch{0};
+        /// How many for_each() calls this thread is in
+        std::atomic<unsigned int> depth{0};
+        /// The element each of them is calling, if any
+        std::atomic<void const*> calling[max_depth] = {};
+    };
+
+    /// Marks this thread as reading while it lives
+    class Reading
+    {
+    public:
+        Reading() : reader(enter()), slot{reader.depth.load(std::memory_order_relaxed) - 1} {}
+        ~Reading() { leave(reader); }
+
+        /// Marks \a element as being called, unless it has been \a removed
+        bool start_calling(void const* element, std::atomic<bool> const& removed)
+        {
+            // Deeper than that, writers wait for the thread to come back up instead
+            if (slot < max_depth)
+                reader.calling[slot].store(element);
+
+            if (!removed.load())
+                return true;
+
+            stop_calling();
+            return false;
+        }
+
+        void stop_calling()
+        {
+            if (slot < max_depth)
+                reader.calling[slot].store(nullptr);
+
+            if (waiting_writers.load())
+                wake_writers();
+        }
+
+    private:
+        Reading(Reading const&) = delete;
+        Reading& operator=(Reading const&) = delete;
+
+        Reader& reader;
+        unsigned int const slot;
+    };
+
+    /// Ends the current epoch, returning it
+    static uint64_t end_epoch();
+    /// The oldest epoch any thread is still reading in
+    static uint64_t oldest_epoch_read();
+
+    /// Waits until no other thread is calling \a element
+    static void wait_until_not_called(void const* element);
+
+private:
+    static Reader& enter();
+    static void leave(Reader& reader);
+    static void wake_writers();
+
+    static std::atomic<unsigned int> waiting_writers;
+};
+}
 
 /*
+ * A list that can be iterated while other threads change it, without
+ * either waiting for the other.
+ *
+ * Changes copy the list and publish the copy, so for_each() only has to
+ * load it and call each element in turn. What a change replaces is freed
+ * once no thread can still be reading it. An element removed during
+ * for_each() is not called from then on, and remove() waits for calls to
+ * it already under way on other threads to return, so it is safe to
+ * destroy what it refers to afterwards. remove() then drops the list's
+ * copy of the element itself, so it doesn't outlive its removal.
+ *
  * Requirements for type 'Element'
  *  - for_each():
- *    - copy-assignable
+ *    - copy-constructible
  *  - add():
- *    - copy-assignable
+ *    - copy-constructible
  *    - conversion to bool: indicates whether this is a valid element
- *  - remove(), remove_all():
- *    - copy-assignable
- *    - Element{}: default construction should create an invalid element
- *    - bool operator==: equality of elements
- *    - bool operator!=: inequality of elements
- *  - clear():
+ *  - remove(), remove_all(), clear():
  *    - copy-assignable
  *    - Element{}: value initialization should create an invalid element
+ *    - bool operator==: equality of elements
  */
 
 template<class Element>
 class ThreadSafeList
 {
 public:
+    ThreadSafeList();
+    ~ThreadSafeList();
+
     void add(Element const& element);
     void remove(Element const& element);
     unsigned int remove_all(Element const& element);
     void clear();
-    void for_each(std::function<void(Element const& element)> const& f);
+
+    template<typename Function>
+    void for_each(Function const& f);
 
 private:
-    struct ListItem
+    ThreadSafeList(ThreadSafeList const&) = delete;
+    ThreadSafeList& operator=(ThreadSafeList const&) = delete;
+
+    struct Item
     {
-        ListItem() {}
-        RecursiveReadWriteMutex mutex;
-        Element element{};
-        std::atomic<ListItem*> next{nullptr};
+        Item(Element const& element) : element(element) {}
+
+        Element element;
+        std::atomic<bool> removed{false};
+    };
+
+    using Items = std::vector<Item*>;
 
-        ~ListItem() { delete next.load(); }
-    } head;
+    /// What a change replaced, to be freed after \a epoch
+    struct Retired
+    {
+        uint64_t epoch;
+        Items const* items;
+        Items removed;
+    };
+
+    template<typename Predicate>
+    unsigned int remove_if(Predicate const& matches, unsigned int limit);
+
+    /// Publishes \a updated, returning what no thread can be reading any more
+    std::vector<Retired> publish(std::lock_guard<std::mutex> const&, std::unique_ptr<Items> updated);
+    /// Frees \a replaced and \a removed once no thread can be reading them,
+    /// returning what already can be
+    std::vector<Retired> retire(
+        std::lock_guard<std::mutex> const&, Items const* replaced, Items removed);
+    static void free(std::vector<Retired> const& reclaimed);
+
+    std::mutex mutex;
+    std::atomic<Items const*> items;
+    std::vector<Retired> retired;
 };
 
 template<class Element>
-void ThreadSafeList<Element>::for_each(
-    std::function<void(Element const& element)> const& f)
+ThreadSafeList<Element>::ThreadSafeList()
+    : items{new Items}
+{
+}
+
+template<class Element>
+ThreadSafeList<Element>::~ThreadSafeList()
 {
-    ListItem* current_item = &head;
+    free(retired);
+
+    for (auto const item : *items.load())
+        delete item;
+    delete items.load();
+}
 
-    while (current_item)
+template<class Element>
+template<typename Function>
+void ThreadSafeList<Element>::for_each(Function const& f)
+{
+    detail::ThreadSafeListReaders::Reading reading;
+
+    for (auto const item : *items.load())
     {
-        RecursiveReadLock lock{current_item->mutex};
+        if (!reading.start_calling(item, item->removed))
+            continue;
 
-        // We need to take a copy in case we recursively remove during call
-        if (auto const copy_of_element = current_item->element) f(copy_of_element);
+        // Removing it from within the call drops the list's copy
+        auto const element = item->element;
+        f(element);
 
-        current_item = current_item->next;
+        reading.stop_calling();
     }
 }
 
 template<class Element>
 void ThreadSafeList<Element>::add(Element const& element)
 {
-    ListItem* current_item = &head;
+    if (!element)
+        return;
+
+    std::vector<Retired> reclaimed;
 
-    do
     {
-        // Note: we release the read lock to avoid two threads calling add at
-        // the same time mutually blocking the other's upgrade to write lock.
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element) continue;
-        }
+        std::lock_guard<std::mutex> lock{mutex};
 
-        RecursiveWriteLock lock{current_item->mutex};
+        std::unique_ptr<Items> updated{new Items(*items.load())};
+        std::unique_ptr<Item> item{new Item{element}};
+        updated->push_back(item.get());
+        item.release();
 
-        if (!current_item->element)
-        {
-            current_item->element = element;
-            return;
-        }
+        reclaimed = publish(lock, std::move(updated));
     }
-    while (current_item->next && (current_item = current_item->next));
-
-    // No empty Items so append a new one
-    auto new_item = new ListItem;
-    new_item->element = element;
 
-    for (ListItem* expected{nullptr};
-        !current_item->next.compare_exchange_weak(expected, new_item);
-        expected = nullptr)
-    {
-        if (expected) current_item = expected;
-    }
+    free(reclaimed);
 }
 
 template<class Element>
 void ThreadSafeList<Element>::remove(Element const& element)
 {
-    ListItem* current_item = &head;
-
-    do
-    {
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
+    remove_if([&element](Element const& e) { return e == element; }, 1);
+}
 
-        RecursiveWriteLock lock{current_item->mutex};
+template<class Element>
+unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
+{
+    return remove_if([&element](Element const& e) { return e == element; }, ~0u);
+}
 
-        if (current_item->element == element)
-        {
-            current_item->element = Element{};
-            return;
-        }
-    }
-    while ((current_item = current_item->next));
+template<class Element>
+void ThreadSafeList<Element>::clear()
+{
+    remove_if([](Element const&) { return true; }, ~0u);
 }
 
 template<class Element>
-unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
+template<typename Predicate>
+unsigned int ThreadSafeList<Element>::remove_if(Predicate const& matches, unsigned int limit)
 {
-    ListItem* current_item = &head;
-    auto removed = 0u;
+    Items removed;
+    std::vector<Retired> reclaimed;
 
-    do
     {
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
+        std::lock_guard<std::mutex> lock{mutex};
 
-        RecursiveWriteLock lock{current_item->mutex};
+        auto const current = items.load();
+        std::unique_ptr<Items> updated{new Items};
+        updated->reserve(current->size());
 
-        if (current_item->element == element)
+        for (auto const item : *current)
         {
-            current_item->element = Element{};
-            ++removed;
+            if (removed.size() < limit && matches(item->element))
+                removed.push_back(item);
+            else
+                updated->push_back(item);
         }
+
+        if (removed.empty())
+            return 0;
+
+        for (auto const item : removed)
+            item->removed = true;
+
+        reclaimed = publish(lock, std::move(updated));
     }
-    while ((current_item = current_item->next));
 
-    return removed;
+    // Don't hold the lock meanwhile: the calls, and destroying the elements,
+    // may well change the list
+    free(reclaimed);
+
+    for (auto const item : removed)
+    {
+        detail::ThreadSafeListReaders::wait_until_not_called(item);
+
+        // Nothing calls it any more, though readers may still look at the Item
+        item->element = Element{};
+    }
+
+    auto const count = removed.size();
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        reclaimed = retire(lock, nullptr, std::move(removed));
+    }
+
+    free(reclaimed);
+
+    return count;
 }
 
 template<class Element>
-void ThreadSafeList<Element>::clear()
+auto ThreadSafeList<Element>::publish(
+    std::lock_guard<std::mutex> const& lock,
+    std::unique_ptr<Items> updated) -> std::vector<Retired>
+{
+    retired.reserve(retired.size() + 1);
+    return retire(lock, items.exchange(updated.release()), {});
+}
+
+template<class Element>
+auto ThreadSafeList<Element>::retire(
+    std::lock_guard<std::mutex> const&,
+    Items const* replaced,
+    Items removed) -> std::vector<Retired>
 {
-    ListItem* current_item = &head;
+    retired.push_back({detail::ThreadSafeListReaders::end_epoch(), replaced, std::move(removed)});
+
+    // Epochs only go up, so whatever can be freed is at the front
+    auto const oldest_read = detail::ThreadSafeListReaders::oldest_epoch_read();
+    auto over = retired.begin();
+    while (over != retired.end() && over->epoch < oldest_read)
+        ++over;
+
+    std::vector<Retired> reclaimed{retired.begin(), over};
+    retired.erase(retired.begin(), over);
+    return reclaimed;
+}
 
-    do
+template<class Element>
+void ThreadSafeList<Element>::free(std::vector<Retired> const& reclaimed)
+{
+    for (auto const& r : reclaimed)
     {
-        RecursiveWriteLock lock{current_item->mutex};
-        current_item->element = Element{};
+        for (auto const item : r.removed)
+            delete item;
+        delete r.items;
     }
-    while ((current_item = current_item->next));
 }
 
 }
@@ -25,6 +25,7 @@
 #include "mir_toolkit/common.h"
 #include "mir/graphics/buffer_id.h"
 
+#include <cstdint>
 #include <memory>
 
 namespace mir
@@ -48,7 +49,11 @@ public:
     virtual int buffers_ready_for_compositor(void const* user_id) const = 0;
     virtual void drop_old_buffers() = 0;
     virtual bool has_submitted_buffer() const = 0;
+    /// How many buffers have been submitted, so consumers can tell when the content has changed
+    virtual uint64_t frames_submitted() const = 0;
     virtual bool framedropping() const = 0;
+    /// The opaque region set when \a buffer was submitted (empty if unknown)
+    virtual std::vector<geometry::Rectangle> opaque_region(graphics::Buffer const& buffer) const = 0;
 };
 
 }
@@ -114,6 +114,7 @@ class Platform;
 class Display;
 class DisplayReport;
 class DisplayConfigurationObserver;
+class FrameObserver;
 class GraphicBufferAllocator;
 class Cursor;
 class CursorImage;
@@ -354,6 +355,8 @@ protected:
     std::shared_ptr<graphics::nested::MirClientHostConnection>  the_mir_client_host_connection();
     std::shared_ptr<input::DefaultInputDeviceHub>  the_default_input_device_hub();
     std::shared_ptr<graphics::DisplayConfigurationObserver> the_display_configuration_observer();
+    std::shared_ptr<ObserverRegistrar<graphics::FrameObserver>> the_frame_observer_registrar();
+    std::shared_ptr<graphics::FrameObserver> the_frame_observer();
     std::shared_ptr<input::SeatObserver> the_seat_observer();
     std::shared_ptr<frontend::SessionMediatorObserver> the_session_mediator_observer();
 
@@ -450,6 +453,8 @@ private:
     std::shared_ptr<input::EventFilter> const default_filter;
     CachedPtr<ObserverMultiplexer<graphics::DisplayConfigurationObserver>>
         display_configuration_observer_multiplexer;
+    CachedPtr<ObserverMultiplexer<graphics::FrameObserver>>
+        frame_observer_multiplexer;
     CachedPtr<ObserverMultiplexer<input::SeatObserver>>
         seat_observer_multiplexer;
     CachedPtr<ObserverMultiplexer<frontend::SessionMediatorObserver>>
@@ -22,12 +22,14 @@
 #include <google/protobuf/stubs/common.h>
 
 #include <mir/fd.h>
+#include <cstdint>
 #include <vector>
 
 namespace mir
 {
 namespace protobuf
 {
+enum class MethodId : uint32_t;
 namespace wire
 {
 class Invocation;
@@ -44,6 +46,8 @@ public:
         invocation(invocation) {}
 
     const ::std::string& method_name() const;
+    /// The method called, whether the client gave its name or number
+    protobuf::MethodId method_id() const;
     const ::std::string& parameters() const;
     google::protobuf::uint32 id() const;
 private:
@@ -0,0 +1,49 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_GRAPHICS_FRAME_OBSERVER_H_
+#define MIR_GRAPHICS_FRAME_OBSERVER_H_
+
+namespace mir
+{
+namespace graphics
+{
+struct Frame;
+
+class FrameObserver
+{
+public:
+    virtual ~FrameObserver() = default;
+
+    /**
+     * Notification that an output has started showing a new frame.
+     *
+     * \param [in] output_id  The output's DisplayConfigurationOutputId
+     * \param [in] frame      The frame's sequence number and the time it
+     *                        reached the screen
+     */
+    virtual void frame_shown(unsigned int output_id, Frame const& frame) = 0;
+
+protected:
+    FrameObserver() = default;
+    FrameObserver(FrameObserver const&) = delete;
+    FrameObserver& operator=(FrameObserver const&) = delete;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_FRAME_OBSERVER_H_ */
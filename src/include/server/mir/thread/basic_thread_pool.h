@@ -19,11 +19,13 @@
 #ifndef MIR_THREAD_BASIC_THREAD_POOL_H_
 #define MIR_THREAD_BASIC_THREAD_POOL_H_
 
-#include <functional>
 #include <future>
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 namespace mir
 {
@@ -31,16 +33,36 @@ namespace thread
 {
 
 class WorkerThread;
+
+/**
+ * Runs tasks on a pool of threads that grows whenever no thread is idle.
+ *
+ * Each thread has its own queue. A task run from one of the pool's threads
+ * goes on that thread's queue and an idle thread is woken to steal it, so a
+ * task waiting on the tasks it runs doesn't hold them up. Tasks run with a
+ * TaskId are never stolen: each runs after the last one run with the same
+ * id, on the same thread.
+ */
 class BasicThreadPool
 {
 public:
     BasicThreadPool(int min_threads);
     ~BasicThreadPool();
 
-    std::future<void> run(std::function<void()> const& task);
-
     typedef void const* TaskId;
-    std::future<void> run(std::function<void()> const& task, TaskId id);
+
+    template<typename Task>
+    std::future<void> run(Task&& task)
+    {
+        return schedule(make_task(std::forward<Task>(task), false, nullptr));
+    }
+
+    /// Also chains tasks: one run with the id of another runs once that is done
+    template<typename Task>
+    std::future<void> run(Task&& task, TaskId id)
+    {
+        return schedule(make_task(std::forward<Task>(task), true, id));
+    }
 
     void shrink();
 
@@ -48,13 +70,75 @@ private:
     BasicThreadPool(BasicThreadPool const&) = delete;
     BasicThreadPool& operator=(BasicThreadPool const&) = delete;
 
-    std::future<void> run(WorkerThread* t, std::function<void()> const& task, TaskId id);
-    WorkerThread *find_thread_by(TaskId id);
-    WorkerThread *find_idle_thread();
+    friend class WorkerThread;
+
+    class QueuedTask
+    {
+    public:
+        QueuedTask(bool has_id, TaskId id) : has_id{has_id}, id{id} {}
+        virtual ~QueuedTask() = default;
+
+        void execute() noexcept;
+        void notify_done();
+
+        std::promise<void> done;
+        bool const has_id;
+        TaskId const id;
+        /// Whether another thread may take it from the queue it is on
+        bool may_be_stolen{false};
+
+    private:
+        virtual void call() = 0;
+
+        std::exception_ptr exception;
+    };
+
+    /// The task itself is kept in the queue entry, so running one needs no other allocation
+    template<typename Function>
+    class QueuedFunction : public QueuedTask
+    {
+    public:
+        template<typename Arg>
+        QueuedFunction(Arg&& function, bool has_id, TaskId id)
+            : QueuedTask{has_id, id},
+              function(std::forward<Arg>(function))
+        {
+        }
+
+    private:
+        void call() override { function(); }
+
+        Function function;
+    };
+
+    template<typename Task>
+    static std::unique_ptr<QueuedTask> make_task(Task&& task, bool has_id, TaskId id)
+    {
+        return std::make_unique<QueuedFunction<typename std::decay<Task>::type>>(
+            std::forward<Task>(task), has_id, id);
+    }
+
+    /// The thread queuing tasks with an id, and how many it has yet to finish
+    struct Owner
+    {
+        WorkerThread* thread;
+        unsigned int outstanding;
+    };
+
+    std::future<void> schedule(std::unique_ptr<QueuedTask> task);
+    void work(WorkerThread& self);
+    std::unique_ptr<QueuedTask> wait_for_work(WorkerThread& self);
+    std::unique_ptr<QueuedTask> finish(WorkerThread& self, QueuedTask const& task);
+    std::unique_ptr<QueuedTask> find_work(std::lock_guard<std::mutex> const&, WorkerThread& self);
+    WorkerThread* claim_idle_thread(std::lock_guard<std::mutex> const&, QueuedTask const& task);
+    WorkerThread* start_thread(std::lock_guard<std::mutex> const&);
 
     std::mutex mutex;
     int const min_threads;
     std::vector<std::unique_ptr<WorkerThread>> threads;
+    /// Threads with nothing to do, the most recently busy last
+    std::vector<WorkerThread*> idle;
+    std::unordered_map<TaskId, Owner> owners;
 };
 
 }
@@ -37,6 +37,7 @@ void AtomicFrame::increment_now()
 {
     std::lock_guard<decltype(mutex)> lock(mutex);
     frame.ust = Frame::Timestamp::now(frame.ust.clock_id);
+    frame.hardware_timestamp = false;
     frame.msc++;
 }
 
@@ -44,6 +45,7 @@ void AtomicFrame::increment_with_timestamp(Frame::Timestamp t)
 {
     std::lock_guard<decltype(mutex)> lock(mutex);
     frame.ust = t;
+    frame.hardware_timestamp = false;
     frame.msc++;
 }
 
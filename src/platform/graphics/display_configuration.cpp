@@ -132,6 +132,9 @@ std::ostream& mg::operator<<(std::ostream& out, mg::DisplayConfigurationOutput c
     }
     out << std::endl;
 
+    out << "\tvariable refresh: " << (val.variable_refresh_supported ?
+        (val.variable_refresh ? "on" : "off") : "unsupported") << std::endl;
+
     out << "\torientation: " << val.orientation << '\n';
     out << "}" << std::endl;
 
@@ -187,6 +190,8 @@ bool mg::operator==(mg::DisplayConfigurationOutput const& val1,
                (val1.current_mode_index == val2.current_mode_index) &&
                (val1.modes.size() == val2.modes.size()) &&
                (val1.custom_logical_size == val2.custom_logical_size) &&
+               (val1.variable_refresh_supported == val2.variable_refresh_supported) &&
+               (val1.variable_refresh == val2.variable_refresh) &&
                (val1.scale == val2.scale) &&
                (val1.form_factor == val2.form_factor)};
 
@@ -326,7 +331,9 @@ mg::UserDisplayConfigurationOutput::UserDisplayConfigurationOutput(
         gamma(master.gamma),
         gamma_supported(master.gamma_supported),
         edid(*reinterpret_cast<std::vector<uint8_t const>*>(&master.edid)),
-        custom_logical_size(master.custom_logical_size)
+        custom_logical_size(master.custom_logical_size),
+        variable_refresh_supported(master.variable_refresh_supported),
+        variable_refresh(master.variable_refresh)
 {
 }
 
@@ -55,6 +55,7 @@ char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
+char const* const mo::input_motion_batching_opt   = "input-motion-batching";
 
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
@@ -149,6 +150,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (no_server_socket_opt, "Do not provide a socket filename for client connections")
         (arw_server_socket_opt, "Make socket filename globally rw (equivalent to chmod a=rw)")
         (prompt_socket_opt, "Provide a \"..._trusted\" filename for prompt helper connections")
+        (frontend_threads_opt, po::value<int>()->default_value(0),
+            "Threads to share client connections between. "
+            "Default: 0 means one per CPU core, up to 4.")
         (platform_graphics_lib, po::value<std::string>(),
             "Library to use for platform graphics support (default: autodetect)")
         (platform_input_lib, po::value<std::string>(),
@@ -198,6 +202,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Cursor (mouse pointer) to use [{auto,software}]")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
              "Enable server generated key repeat")
+        (input_motion_batching_opt, po::value<std::string>()->default_value(off_opt_value),
+            "Hold pointer and touch motion until the next frame, then deliver it merged into "
+            "one event or all together. [{off,coalesce,history}]")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
@@ -18,7 +18,10 @@
  */
 
 #include "mir/graphics/gl_format.h"
+#include "mir/graphics/egl_extensions.h"
+#include "mir/graphics/extension_list.h"
 #include "mir/shm_file.h"
+#include "mir/fd.h"
 #include "shm_buffer.h"
 #include "buffer_texture_binder.h"
 
@@ -31,6 +34,30 @@
 
 #include <string.h>
 #include <endian.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/types.h>
+
+#ifdef __has_include
+#if __has_include(<linux/udmabuf.h>)
+#include <linux/udmabuf.h>
+#endif
+#endif
+
+#ifndef UDMABUF_CREATE
+// The kernel's stable uapi, for building against headers that predate it
+#define UDMABUF_FLAGS_CLOEXEC 0x01
+struct udmabuf_create
+{
+    __u32 memfd;
+    __u32 flags;
+    __u64 offset;
+    __u64 size;
+};
+#define UDMABUF_CREATE _IOW('u', 0x42, struct udmabuf_create)
+#endif
 
 namespace mg=mir::graphics;
 namespace mgc = mir::graphics::common;
@@ -84,6 +111,63 @@ bool mg::get_gl_pixel_format(MirPixelFormat mir_format,
     return gl_format != GL_INVALID_ENUM && gl_type != GL_INVALID_ENUM;
 }
 
+namespace
+{
+constexpr uint32_t fourcc(char a, char b, char c, char d)
+{
+    return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+           (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+/// The DRM format with the same memory layout, or 0 if we don't share it
+uint32_t drm_format_for(MirPixelFormat format)
+{
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888: return fourcc('A', 'R', '2', '4');
+    case mir_pixel_format_xrgb_8888: return fourcc('X', 'R', '2', '4');
+    case mir_pixel_format_abgr_8888: return fourcc('A', 'B', '2', '4');
+    case mir_pixel_format_xbgr_8888: return fourcc('X', 'B', '2', '4');
+    default: return 0;
+    }
+}
+}
+
+class mgc::ShmBuffer::ImportedImage
+{
+public:
+    ImportedImage(
+        std::unique_ptr<mg::EGLExtensions> extensions,
+        EGLDisplay display,
+        EGLImageKHR image)
+        : extensions{std::move(extensions)},
+          display{display},
+          image{image}
+    {
+    }
+
+    ~ImportedImage()
+    {
+        extensions->eglDestroyImageKHR(display, image);
+    }
+
+    bool is_current() const
+    {
+        // The image only exists on the display it was created for
+        return eglGetCurrentDisplay() == display;
+    }
+
+    void bind()
+    {
+        extensions->glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
+    }
+
+private:
+    std::unique_ptr<mg::EGLExtensions> const extensions;
+    EGLDisplay const display;
+    EGLImageKHR const image;
+};
+
 bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 {
     GLenum gl_format, gl_type;
@@ -123,6 +207,12 @@ MirPixelFormat mgc::ShmBuffer::pixel_format() const
 
 void mgc::ShmBuffer::gl_bind_to_texture()
 {
+    if (auto const image = imported_image_for_current_display())
+    {
+        image->bind();
+        return;
+    }
+
     GLenum format, type;
 
     if (mg::get_gl_pixel_format(pixel_format_, format, type))
@@ -142,6 +232,97 @@ void mgc::ShmBuffer::gl_bind_to_texture()
     }
 }
 
+auto mgc::ShmBuffer::imported_image_for_current_display() -> ImportedImage*
+{
+    std::lock_guard<std::mutex> lock{import_mutex};
+    if (!import_attempted)
+    {
+        import_attempted = true;
+        imported_image = import_as_dma_buf();
+    }
+
+    return imported_image && imported_image->is_current() ? imported_image.get() : nullptr;
+}
+
+/*
+ * udmabuf can only wrap whole pages of a memfd that is sealed against
+ * shrinking, which is how AnonymousShmFile creates its files where it can.
+ * Anything else, or a driver that can't import the result, falls back to
+ * uploading on every bind.
+ */
+auto mgc::ShmBuffer::import_as_dma_buf() const -> std::unique_ptr<ImportedImage>
+{
+    auto const drm_format = drm_format_for(pixel_format_);
+    if (!drm_format)
+        return nullptr;
+
+    int const fd = shm_file->fd();
+    struct stat file_stat;
+    auto const page_size = sysconf(_SC_PAGESIZE);
+    auto const bytes_used = static_cast<off_t>(stride_.as_uint32_t()) * size_.height.as_int();
+    if (fstat(fd, &file_stat) == -1 || page_size <= 0 ||
+        file_stat.st_size % page_size != 0 || file_stat.st_size < bytes_used)
+    {
+        return nullptr;
+    }
+
+#ifdef F_GET_SEALS
+    auto const seals = fcntl(fd, F_GET_SEALS);
+    if (seals == -1 || !(seals & F_SEAL_SHRINK) || (seals & F_SEAL_WRITE))
+        return nullptr;
+#else
+    return nullptr;
+#endif
+
+    auto const display = eglGetCurrentDisplay();
+    if (display == EGL_NO_DISPLAY ||
+        !mg::has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_EXT_image_dma_buf_import"))
+        return nullptr;
+
+    mir::Fd const udmabuf_device{open("/dev/udmabuf", O_RDWR | O_CLOEXEC)};
+    if (udmabuf_device == mir::Fd::invalid)
+        return nullptr;
+
+    udmabuf_create create{};
+    create.memfd = fd;
+    create.flags = UDMABUF_FLAGS_CLOEXEC;
+    create.offset = 0;
+    create.size = file_stat.st_size;
+
+    mir::Fd const dma_buf{ioctl(udmabuf_device, UDMABUF_CREATE, &create)};
+    if (dma_buf == mir::Fd::invalid)
+        return nullptr;
+
+    std::unique_ptr<mg::EGLExtensions> extensions;
+    try
+    {
+        extensions = std::make_unique<mg::EGLExtensions>();
+    }
+    catch (std::runtime_error const&)
+    {
+        return nullptr;
+    }
+
+    EGLint const image_attrs[] =
+    {
+        EGL_WIDTH, size_.width.as_int(),
+        EGL_HEIGHT, size_.height.as_int(),
+        EGL_LINUX_DRM_FOURCC_EXT, static_cast<EGLint>(drm_format),
+        EGL_DMA_BUF_PLANE0_FD_EXT, dma_buf,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, stride_.as_int(),
+        EGL_NONE
+    };
+
+    // EGL keeps its own reference to the dma-buf, so ours can go
+    auto const image = extensions->eglCreateImageKHR(
+        display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, static_cast<EGLClientBuffer>(nullptr), image_attrs);
+    if (image == EGL_NO_IMAGE_KHR)
+        return nullptr;
+
+    return std::make_unique<ImportedImage>(std::move(extensions), display, image);
+}
+
 std::shared_ptr<MirBufferPackage> mgc::ShmBuffer::to_mir_buffer_package() const
 {
     auto native_buffer = std::make_shared<MirNativeBuffer>();
@@ -184,6 +365,27 @@ void mgc::ShmBuffer::secure_for_render()
 {
 }
 
+bool mgc::ShmBuffer::prefers_streaming()
+{
+    return !imported_image_for_current_display();
+}
+
+void mgc::ShmBuffer::copy_packed_pixels(unsigned char* destination)
+{
+    auto const row_size = MIR_BYTES_PER_PIXEL(pixel_format_) * size_.width.as_uint32_t();
+    auto const rows = size_.height.as_uint32_t();
+    auto const source = static_cast<unsigned char const*>(pixels);
+
+    if (row_size == stride_.as_uint32_t())
+    {
+        memcpy(destination, source, row_size * rows);
+        return;
+    }
+
+    for (uint32_t row = 0; row < rows; ++row)
+        memcpy(destination + row * row_size, source + row * stride_.as_uint32_t(), row_size);
+}
+
 void mir::graphics::common::ShmBuffer::bind_for_write()
 {
     gl_bind_to_texture();
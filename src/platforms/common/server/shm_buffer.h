@@ -25,10 +25,14 @@
 #include "mir/geometry/size.h"
 #include "mir_toolkit/common.h"
 #include "mir/renderer/gl/texture_source.h"
+#include "mir/renderer/gl/streaming_texture_source.h"
 #include "mir/renderer/gl/texture_target.h"
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 
+#include <memory>
+#include <mutex>
+
 namespace mir
 {
 class ShmFile;
@@ -41,6 +45,7 @@ namespace common
 
 class ShmBuffer : public BufferBasic, public NativeBufferBase,
                   public renderer::gl::TextureSource,
+                  public renderer::gl::StreamingTextureSource,
                   public renderer::gl::TextureTarget,
                   public renderer::software::PixelSource
 {
@@ -55,6 +60,8 @@ public:
     void gl_bind_to_texture() override;
     void bind() override;
     void secure_for_render() override;
+    bool prefers_streaming() override;
+    void copy_packed_pixels(unsigned char* destination) override;
     void write(unsigned char const* data, size_t size) override;
     void read(std::function<void(unsigned char const*)> const& do_with_pixels) override;
     NativeBufferBase* native_buffer_base() override;
@@ -76,11 +83,21 @@ private:
     ShmBuffer(ShmBuffer const&) = delete;
     ShmBuffer& operator=(ShmBuffer const&) = delete;
 
+    /// The pixels shared with the GPU as a dma-buf, so binding needs no copy
+    class ImportedImage;
+    std::unique_ptr<ImportedImage> import_as_dma_buf() const;
+    /// The imported image if there is one usable in the current context
+    ImportedImage* imported_image_for_current_display();
+
     std::unique_ptr<ShmFile> const shm_file;
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
     geometry::Stride const stride_;
     void* const pixels;
+
+    std::mutex import_mutex;
+    bool import_attempted = false;
+    std::unique_ptr<ImportedImage> imported_image;
 };
 
 }
@@ -151,6 +151,8 @@ std::vector<std::shared_ptr<mge::kms::EGLOutput>> create_outputs(int drm_fd, EGL
         output->scale = 1.0f;
         output->form_factor = mir_form_factor_monitor;
         output->used = false;
+        output->variable_refresh_supported = false;
+        output->variable_refresh = false;
     }
 
     return outputs;
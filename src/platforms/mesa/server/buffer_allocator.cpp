@@ -43,6 +43,7 @@
 #include <gbm.h>
 #include <cassert>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include <wayland-server.h>
 
@@ -293,7 +294,11 @@ std::shared_ptr<mg::Buffer> mgm::BufferAllocator::alloc_software_buffer(
     }
 
     auto const stride = geom::Stride{MIR_BYTES_PER_PIXEL(format) * size.width.as_uint32_t()};
-    size_t const size_in_bytes = stride.as_int() * size.height.as_int();
+
+    // Whole pages can be shared with the GPU instead of copied to it
+    size_t const page_size = sysconf(_SC_PAGESIZE);
+    size_t const size_in_bytes =
+        (stride.as_int() * size.height.as_int() + page_size - 1) / page_size * page_size;
     return std::make_shared<mgm::SoftwareBuffer>(
         std::make_unique<mir::AnonymousShmFile>(size_in_bytes), size, format);
 }
@@ -0,0 +1,247 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_planes.h"
+#include "kms-utils/drm_mode_resources.h"
+#include "mir/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <utility>
+
+namespace mgm = mir::graphics::mesa;
+namespace mgk = mir::graphics::kms;
+
+namespace
+{
+// Planes claimed by some CRTC, keyed by DRM fd and plane id
+std::mutex claimed_mutex;
+std::set<std::pair<int, uint32_t>> claimed_planes;
+
+int crtc_index_of(int drm_fd, uint32_t crtc_id)
+{
+    mgk::DRMModeResources resources{drm_fd};
+
+    int index = 0;
+    for (auto& crtc : resources.crtcs())
+    {
+        if (crtc->crtc_id == crtc_id)
+            return index;
+        ++index;
+    }
+    return -1;
+}
+}
+
+std::unique_ptr<mgm::AtomicPlanes> mgm::AtomicPlanes::for_crtc(int drm_fd, uint32_t crtc_id)
+{
+    // Asking for atomic modesetting also exposes the primary and cursor planes
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0)
+        return nullptr;
+
+    try
+    {
+        auto const crtc_index = crtc_index_of(drm_fd, crtc_id);
+        if (crtc_index < 0)
+            return nullptr;
+
+        std::unique_ptr<Plane> primary;
+        std::vector<std::pair<uint64_t, Plane>> overlays;
+
+        std::lock_guard<std::mutex> lock{claimed_mutex};
+
+        mgk::PlaneResources plane_resources{drm_fd};
+        for (auto& plane : plane_resources.planes())
+        {
+            if (!(plane->possible_crtcs & (1u << crtc_index)))
+                continue;
+
+            mgk::ObjectProperties props{drm_fd, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+            auto const type = props["type"];
+
+            if (type == DRM_PLANE_TYPE_PRIMARY && (!primary || plane->crtc_id == crtc_id))
+            {
+                primary = std::make_unique<Plane>(describe(plane->plane_id, props));
+            }
+            else if (type == DRM_PLANE_TYPE_OVERLAY &&
+                     (plane->crtc_id == 0 || plane->crtc_id == crtc_id) &&
+                     !claimed_planes.count({drm_fd, plane->plane_id}))
+            {
+                // Without a zpos property planes stack in the order the driver lists them
+                auto const zpos = props.has_property("zpos") ? props["zpos"] : overlays.size();
+                overlays.emplace_back(zpos, describe(plane->plane_id, props));
+            }
+        }
+
+        if (!primary || overlays.empty())
+            return nullptr;
+
+        std::stable_sort(overlays.begin(), overlays.end(),
+            [](auto const& a, auto const& b) { return a.first < b.first; });
+
+        std::vector<Plane> overlay_planes;
+        for (auto const& overlay : overlays)
+        {
+            claimed_planes.insert({drm_fd, overlay.second.id});
+            overlay_planes.push_back(overlay.second);
+        }
+
+        return std::unique_ptr<AtomicPlanes>{
+            new AtomicPlanes{drm_fd, crtc_id, *primary, std::move(overlay_planes)}};
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_info("Not using overlay planes on CRTC %u: %s", crtc_id, error.what());
+        return nullptr;
+    }
+}
+
+mgm::AtomicPlanes::AtomicPlanes(
+    int drm_fd,
+    uint32_t crtc_id,
+    Plane const& primary,
+    std::vector<Plane>&& overlays)
+    : drm_fd{drm_fd},
+      crtc_id{crtc_id},
+      primary{primary},
+      overlays{std::move(overlays)}
+{
+}
+
+auto mgm::AtomicPlanes::describe(uint32_t plane_id, kms::ObjectProperties const& props) -> Plane
+{
+    return Plane{
+        plane_id,
+        props.id_for("FB_ID"),
+        props.id_for("CRTC_ID"),
+        props.id_for("SRC_X"), props.id_for("SRC_Y"), props.id_for("SRC_W"), props.id_for("SRC_H"),
+        props.id_for("CRTC_X"), props.id_for("CRTC_Y"), props.id_for("CRTC_W"), props.id_for("CRTC_H")};
+}
+
+mgm::AtomicPlanes::~AtomicPlanes()
+{
+    std::lock_guard<std::mutex> lock{claimed_mutex};
+    for (auto const& overlay : overlays)
+        claimed_planes.erase({drm_fd, overlay.id});
+}
+
+size_t mgm::AtomicPlanes::overlay_count() const
+{
+    return overlays.size();
+}
+
+bool mgm::AtomicPlanes::test(std::vector<Placement> const& placements) const
+{
+    if (placements.size() > overlays.size())
+        return false;
+
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)>
+        request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+
+    add_overlays_to(request.get(), placements);
+
+    return drmModeAtomicCommit(drm_fd, request.get(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+void mgm::AtomicPlanes::add_to(
+    drmModeAtomicReq* request,
+    uint32_t primary_fb,
+    std::vector<Placement> const& placements) const
+{
+    drmModeAtomicAddProperty(request, primary.id, primary.fb_id, primary_fb);
+    add_overlays_to(request, placements);
+}
+
+void mgm::AtomicPlanes::add_overlays_to(
+    drmModeAtomicReq* request,
+    std::vector<Placement> const& placements) const
+{
+    for (size_t i = 0; i != placements.size(); ++i)
+    {
+        auto const& plane = overlays[i];
+        auto const& placement = placements[i];
+
+        /* Source viewport. Coordinates are 16.16 fixed point format */
+        drmModeAtomicAddProperty(request, plane.id, plane.src_x, 0);
+        drmModeAtomicAddProperty(request, plane.id, plane.src_y, 0);
+        drmModeAtomicAddProperty(request, plane.id, plane.src_w, placement.source_size.width.as_uint32_t() << 16);
+        drmModeAtomicAddProperty(request, plane.id, plane.src_h, placement.source_size.height.as_uint32_t() << 16);
+
+        /* Destination viewport. Coordinates are *not* 16.16 */
+        auto const& destination = placement.destination;
+        drmModeAtomicAddProperty(request, plane.id, plane.crtc_x, destination.top_left.x.as_int());
+        drmModeAtomicAddProperty(request, plane.id, plane.crtc_y, destination.top_left.y.as_int());
+        drmModeAtomicAddProperty(request, plane.id, plane.crtc_w, destination.size.width.as_uint32_t());
+        drmModeAtomicAddProperty(request, plane.id, plane.crtc_h, destination.size.height.as_uint32_t());
+
+        drmModeAtomicAddProperty(request, plane.id, plane.fb_id, placement.fb_id);
+        drmModeAtomicAddProperty(request, plane.id, plane.crtc_id, crtc_id);
+    }
+
+    for (auto i = placements.size(); i < overlays_in_use; ++i)
+    {
+        drmModeAtomicAddProperty(request, overlays[i].id, overlays[i].fb_id, 0);
+        drmModeAtomicAddProperty(request, overlays[i].id, overlays[i].crtc_id, 0);
+    }
+}
+
+void mgm::AtomicPlanes::committed(std::vector<Placement> const& placements)
+{
+    overlays_in_use = placements.size();
+}
+
+bool mgm::AtomicPlanes::overlays_enabled() const
+{
+    return overlays_in_use > 0;
+}
+
+void mgm::AtomicPlanes::disable_overlays()
+{
+    if (!overlays_in_use)
+        return;
+
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)>
+        request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+
+    add_overlays_to(request.get(), {});
+
+    if (auto const error = drmModeAtomicCommit(drm_fd, request.get(), 0, nullptr))
+        mir::log_warning("Failed to switch off overlay planes on CRTC %u (%s)", crtc_id, strerror(-error));
+
+    overlays_in_use = 0;
+}
+
+bool mgm::AtomicPlanes::show_overlays(std::vector<Placement> const& placements)
+{
+    if (placements.size() > overlays.size())
+        return false;
+
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)>
+        request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+
+    add_overlays_to(request.get(), placements);
+
+    if (auto const error = drmModeAtomicCommit(drm_fd, request.get(), 0, nullptr))
+    {
+        mir::log_warning("Failed to update overlay planes on CRTC %u (%s)", crtc_id, strerror(-error));
+        return false;
+    }
+
+    overlays_in_use = placements.size();
+    return true;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_ATOMIC_PLANES_H_
+#define MIR_GRAPHICS_MESA_ATOMIC_PLANES_H_
+
+#include "mir/geometry/rectangle.h"
+#include "kms-utils/drm_mode_resources.h"
+
+#include <xf86drmMode.h>
+
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+
+/**
+ * The primary and overlay planes of one CRTC, driven through atomic
+ * modesetting. Overlay planes are claimed for the lifetime of this object
+ * so that outputs sharing a device never fight over them.
+ */
+class AtomicPlanes
+{
+public:
+    /// A framebuffer to show on an overlay plane
+    struct Placement
+    {
+        uint32_t fb_id;
+        geometry::Size source_size;         ///< Shown from the framebuffer's top-left corner
+        geometry::Rectangle destination;    ///< Relative to the CRTC
+    };
+
+    /// Null if the device lacks atomic modesetting or the CRTC has no overlay planes
+    static std::unique_ptr<AtomicPlanes> for_crtc(int drm_fd, uint32_t crtc_id);
+
+    ~AtomicPlanes();
+
+    /// The overlay planes available, lowest first
+    size_t overlay_count() const;
+
+    /**
+     * Whether \a overlays could be shown above the primary plane's current
+     * contents, checked with a test-only commit.
+     */
+    bool test(std::vector<Placement> const& overlays) const;
+
+    /**
+     * Adds to \a request the properties that show \a primary_fb with
+     * \a overlays above it, and that switch off overlays no longer used.
+     */
+    void add_to(drmModeAtomicReq* request, uint32_t primary_fb, std::vector<Placement> const& overlays) const;
+
+    /// Notes that a request built by add_to() has been committed
+    void committed(std::vector<Placement> const& overlays);
+
+    /// Whether the last commit left any overlay plane showing a buffer
+    bool overlays_enabled() const;
+
+    /// Switches off the overlay planes straight away, rather than with a flip
+    void disable_overlays();
+
+    /**
+     * Shows \a overlays straight away, rather than with a flip, switching
+     * off any others. False, changing nothing, if the commit fails.
+     */
+    bool show_overlays(std::vector<Placement> const& overlays);
+
+private:
+    /// A plane and the IDs of the properties needed to place a buffer on it
+    struct Plane
+    {
+        uint32_t id;
+        uint32_t fb_id;
+        uint32_t crtc_id;
+        uint32_t src_x, src_y, src_w, src_h;
+        uint32_t crtc_x, crtc_y, crtc_w, crtc_h;
+    };
+
+    AtomicPlanes(int drm_fd, uint32_t crtc_id, Plane const& primary, std::vector<Plane>&& overlays);
+    AtomicPlanes(AtomicPlanes const&) = delete;
+    static Plane describe(uint32_t plane_id, kms::ObjectProperties const& props);
+    AtomicPlanes& operator=(AtomicPlanes const&) = delete;
+
+    void add_overlays_to(drmModeAtomicReq* request, std::vector<Placement> const& overlays) const;
+
+    int const drm_fd;
+    uint32_t const crtc_id;
+    Plane const primary;
+    std::vector<Plane> const overlays;
+    size_t overlays_in_use{0};
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_ATOMIC_PLANES_H_ */
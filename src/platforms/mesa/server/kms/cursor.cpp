@@ -28,9 +28,12 @@
 
 #include <boost/exception/errinfo_errno.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 
+#include <string.h>
+
 namespace mg = mir::graphics;
 namespace mgm = mg::mesa;
 namespace geom = mir::geometry;
@@ -88,6 +91,22 @@ int get_drm_cursor_width(int fd)
     return int(width);
 }
 
+// Enough for the frames of any reasonable animated cursor
+size_t const max_cached_images = 64;
+
+size_t hash_of(uint8_t const* data, size_t count)
+{
+    // FNV-1a: quick, and only needs to tell images apart well enough
+    // to spare most of them a full comparison
+    uint64_t hash = 14695981039346656037ull;
+    for (auto p = data; p != data + count; ++p)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
 gbm_device* gbm_create_device_checked(int fd)
 {
     auto device = gbm_create_device(fd);
@@ -99,16 +118,14 @@ gbm_device* gbm_create_device_checked(int fd)
 }
 }
 
-mgm::Cursor::GBMBOWrapper::GBMBOWrapper(int fd, MirOrientation orientation) :
-    device{gbm_create_device_checked(fd)},
+mgm::Cursor::GBMBOWrapper::GBMBOWrapper(Device const& device) :
     buffer{
         gbm_bo_create(
-            device,
-            get_drm_cursor_width(fd),
-            get_drm_cursor_height(fd),
+            device.device.get(),
+            device.width,
+            device.height,
             GBM_FORMAT_ARGB8888,
-            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)},
-    current_orientation{orientation}
+            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)}
 {
     if (!buffer) BOOST_THROW_EXCEPTION(std::runtime_error("failed to create gbm buffer"));
 }
@@ -120,28 +137,30 @@ inline mgm::Cursor::GBMBOWrapper::operator gbm_bo*()
 
 inline mgm::Cursor::GBMBOWrapper::~GBMBOWrapper()
 {
-    if (device)
-        gbm_device_destroy(device);
     if (buffer)
         gbm_bo_destroy(buffer);
 }
 
 mgm::Cursor::GBMBOWrapper::GBMBOWrapper(GBMBOWrapper&& from)
-    : device{from.device},
-      buffer{from.buffer},
-      current_orientation{from.current_orientation}
+    : buffer{from.buffer}
 {
     from.buffer = nullptr;
-    from.device = nullptr;
 }
 
-auto mir::graphics::mesa::Cursor::GBMBOWrapper::change_orientation(MirOrientation new_orientation) -> bool
+mgm::Cursor::Device::Device(int drm_fd) :
+    drm_fd{drm_fd},
+    device{gbm_create_device_checked(drm_fd), &gbm_device_destroy},
+    width(get_drm_cursor_width(drm_fd)),
+    height(get_drm_cursor_height(drm_fd)),
+    blank{*this}
 {
-    if (current_orientation == new_orientation)
-        return false;
+}
 
-    current_orientation = new_orientation;
-    return true;
+mgm::Cursor::CachedImage::CachedImage(geom::Size size, size_t hash, std::vector<uint8_t>&& argb8888) :
+    size{size},
+    hash{hash},
+    argb8888{std::move(argb8888)}
+{
 }
 
 mgm::Cursor::Cursor(
@@ -150,6 +169,8 @@ mgm::Cursor::Cursor(
         output_container(output_container),
         current_position(),
         last_set_failed(false),
+        move_pending(false),
+        current_image(nullptr),
         min_buffer_width{std::numeric_limits<uint32_t>::max()},
         min_buffer_height{std::numeric_limits<uint32_t>::max()},
         current_configuration(current_configuration)
@@ -162,7 +183,7 @@ mgm::Cursor::Cursor(
                 [this, &kms_conf](auto const& output)
                 {
                     // I'm not sure why g++ needs the explicit "this->" but it does - alan_g
-                    this->buffer_for_output(*kms_conf.get_output_for(output.id));
+                    this->device_for_output(*kms_conf.get_output_for(output.id));
                 });
         });
 
@@ -192,9 +213,11 @@ void mgm::Cursor::write_buffer_data_locked(
 
 void mgm::Cursor::pad_and_write_image_data_locked(
     std::lock_guard<std::mutex> const& lg,
-    GBMBOWrapper& buffer)
+    CachedImage const& image,
+    MirOrientation orientation,
+    gbm_bo* buffer)
 {
-    auto const orientation = buffer.orientation();
+    auto const& size = image.size;
     bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
 
     auto const min_width  = sideways ? min_buffer_width : min_buffer_height;
@@ -212,7 +235,7 @@ void mgm::Cursor::pad_and_write_image_data_locked(
     size_t rhs_padding = buffer_stride - 4*image_width;
 
     auto const filler = 0; // 0x3f; is useful to make buffer visible for debugging
-    uint8_t const* src = argb8888.data();
+    uint8_t const* src = image.argb8888.data();
     uint8_t* dest = &padded[0];
 
     switch (orientation)
@@ -277,53 +300,105 @@ void mgm::Cursor::pad_and_write_image_data_locked(
 
 void mgm::Cursor::show()
 {
-    std::lock_guard<std::mutex> lg(guard);
-
-    if (!visible)
     {
-        visible = true;
-        place_cursor_at_locked(lg, current_position, ForceState);
+        std::lock_guard<std::mutex> lg(guard);
+
+        if (!visible)
+        {
+            visible = true;
+            place_cursor_at_locked(lg, current_position, ForceState);
+        }
     }
+    apply_pending_move();
 }
 
 void mgm::Cursor::show(CursorImage const& cursor_image)
 {
-    std::lock_guard<std::mutex> lg(guard);
+    {
+        std::lock_guard<std::mutex> lg(guard);
 
-    size = cursor_image.size();
+        current_image = cached_image_locked(lg, cursor_image);
+        size = cursor_image.size();
+        hotspot = cursor_image.hotspot();
 
-    argb8888.resize(size.width.as_uint32_t() * size.height.as_uint32_t() * 4);
-    memcpy(argb8888.data(), cursor_image.as_argb_8888(), argb8888.size());
+        // The image is only padded and rotated (and written) for the
+        // outputs the cursor is on, as it gets there.
+        visible = true;
+        place_cursor_at_locked(lg, current_position, ForceState);
+    }
+    apply_pending_move();
+}
+
+void mgm::Cursor::move_to(geometry::Point position)
+{
+    {
+        std::lock_guard<std::mutex> lock{pending_guard};
+        pending_position = position;
+        move_pending = true;
+    }
+    apply_pending_move();
+}
 
-    hotspot = cursor_image.hotspot();
+void mgm::Cursor::apply_pending_move()
+{
+    // Whoever holds the guard (writing a new image, say, or in a driver
+    // that waits for vblank to move the cursor) applies the moves made
+    // meanwhile once it lets go. So moving never waits, and however many
+    // moves arrive in the meantime, only the latest reaches the hardware.
+    geometry::Point position;
+    while (true)
     {
-        auto locked_buffers = buffers.lock();
-        for (auto& pair : *locked_buffers)
         {
-            pad_and_write_image_data_locked(lg, pair.second);
+            std::unique_lock<std::mutex> lock{guard, std::try_to_lock};
+            if (!lock.owns_lock())
+                return;
+
+            if (take_pending_move(position))
+            {
+                std::lock_guard<std::mutex> lg{*lock.release(), std::adopt_lock};
+                place_cursor_at_locked(lg, position, UpdateState);
+                continue;
+            }
         }
+
+        // A move made after we found nothing pending, but before we let go
+        // of the guard, saw the guard taken and left itself to us.
+        if (!move_is_pending())
+            return;
     }
+}
 
-    // Writing the data could throw an exception so lets
-    // hold off on setting visible until after we have succeeded.
-    visible = true;
-    place_cursor_at_locked(lg, current_position, ForceState);
+bool mgm::Cursor::move_is_pending()
+{
+    std::lock_guard<std::mutex> lock{pending_guard};
+    return move_pending;
 }
 
-void mgm::Cursor::move_to(geometry::Point position)
+bool mgm::Cursor::take_pending_move(geometry::Point& position)
 {
-    place_cursor_at(position, UpdateState);
+    std::lock_guard<std::mutex> lock{pending_guard};
+
+    if (!move_pending)
+        return false;
+
+    move_pending = false;
+    position = pending_position;
+    return true;
 }
 
 void mir::graphics::mesa::Cursor::suspend()
 {
-    std::lock_guard<std::mutex> lg(guard);
-    clear(lg);
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        clear(lg);
+    }
+    apply_pending_move();
 }
 
 void mir::graphics::mesa::Cursor::clear(std::lock_guard<std::mutex> const&)
 {
     last_set_failed = false;
+    output_state.clear();
     output_container.for_each_output([&](std::shared_ptr<KMSOutput> const& output)
         {
             if (!output->clear_cursor())
@@ -334,13 +409,17 @@ void mir::graphics::mesa::Cursor::clear(std::lock_guard<std::mutex> const&)
 void mgm::Cursor::resume()
 {
     place_cursor_at(current_position, ForceState);
+    apply_pending_move();
 }
 
 void mgm::Cursor::hide()
 {
-    std::lock_guard<std::mutex> lg(guard);
-    visible = false;
-    clear(lg);
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        visible = false;
+        clear(lg);
+    }
+    apply_pending_move();
 }
 
 void mgm::Cursor::for_each_used_output(
@@ -384,6 +463,8 @@ void mgm::Cursor::place_cursor_at_locked(
 
     for_each_used_output([&](KMSOutput& output, geom::Rectangle const& output_rect, MirOrientation orientation)
     {
+        auto& state = output_state[&output];
+
         if (output_rect.contains(position))
         {
             auto dp = transform(output_rect, position - output_rect.top_left, orientation);
@@ -393,16 +474,21 @@ void mgm::Cursor::place_cursor_at_locked(
             // drmModeSetCursor2 with hotspot support. However it appears to not actually
             // work on radeon and intel. There also seems to be precedent in weston for
             // implementing hotspot in this fashion.
-            output.move_cursor(geom::Point{} + dp - hs);
-            auto& buffer = buffer_for_output(output);
+            auto const destination = geom::Point{} + dp - hs;
 
-            auto const changed_orientation = buffer.change_orientation(orientation);
+            // A move that leaves the cursor where it was needn't cost an ioctl
+            if (force_state || !state.placed || state.position != destination)
+            {
+                output.move_cursor(destination);
+                state.placed = true;
+                state.position = destination;
+            }
 
-            if (changed_orientation)
-                pad_and_write_image_data_locked(lg, buffer);
+            auto const buffer = buffer_for_locked(lg, output, orientation);
 
-            if (force_state || !output.has_cursor() || changed_orientation)
+            if (force_state || !output.has_cursor() || buffer != state.buffer)
             {
+                state.buffer = buffer;
                 if (!output.set_cursor(buffer) || !output.has_cursor())
                     set_on_all_outputs = false;
             }
@@ -413,32 +499,92 @@ void mgm::Cursor::place_cursor_at_locked(
             {
                 output.clear_cursor();
             }
+            state = OutputState{};
         }
     });
 
     last_set_failed = !set_on_all_outputs;
 }
 
-mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& output)
+auto mgm::Cursor::cached_image_locked(std::lock_guard<std::mutex> const&, CursorImage const& cursor_image)
+    -> CachedImage*
+{
+    auto const image_size = cursor_image.size();
+    auto const data = static_cast<uint8_t const*>(cursor_image.as_argb_8888());
+    size_t const count = image_size.width.as_uint32_t() * image_size.height.as_uint32_t() * 4;
+    auto const hash = hash_of(data, count);
+
+    // Animated cursors cycle through the same few images, so after the
+    // first loop every frame is found here, already in its buffers
+    auto const cached = std::find_if(
+        image_cache.begin(),
+        image_cache.end(),
+        [&](CachedImage const& candidate)
+            {
+                return candidate.hash == hash &&
+                       candidate.size == image_size &&
+                       memcmp(candidate.argb8888.data(), data, count) == 0;
+            });
+
+    if (cached != image_cache.end())
+    {
+        image_cache.splice(image_cache.begin(), image_cache, cached);
+    }
+    else
+    {
+        image_cache.emplace_front(image_size, hash, std::vector<uint8_t>(data, data + count));
+
+        // The image being replaced is second, so is never dropped while it may be on screen
+        if (image_cache.size() > max_cached_images)
+            image_cache.pop_back();
+    }
+
+    return &image_cache.front();
+}
+
+auto mgm::Cursor::buffer_for_locked(
+    std::lock_guard<std::mutex> const& lg,
+    KMSOutput const& output,
+    MirOrientation orientation) -> gbm_bo*
+{
+    auto& device = device_for_output(output);
+
+    if (!current_image)
+        return device.blank;
+
+    for (auto& rotated : current_image->buffers)
+    {
+        if (rotated.drm_fd == device.drm_fd && rotated.orientation == orientation)
+            return rotated.buffer;
+    }
+
+    GBMBOWrapper buffer{device};
+    pad_and_write_image_data_locked(lg, *current_image, orientation, buffer);
+    current_image->buffers.push_back(RotatedBuffer{device.drm_fd, orientation, std::move(buffer)});
+
+    return current_image->buffers.back().buffer;
+}
+
+mgm::Cursor::Device& mgm::Cursor::device_for_output(KMSOutput const& output)
 {
-    auto locked_buffers = buffers.lock();
+    auto locked_devices = devices.lock();
 
-    auto buffer_it = std::find_if(
-        locked_buffers->begin(),
-        locked_buffers->end(),
+    auto device_it = std::find_if(
+        locked_devices->begin(),
+        locked_devices->end(),
         [&output](auto const& candidate)
             {
-                return candidate.first == output.drm_fd();
+                return candidate->drm_fd == output.drm_fd();
             });
 
-    if (buffer_it != locked_buffers->end())
+    if (device_it != locked_devices->end())
     {
-        return buffer_it->second;
+        return **device_it;
     }
 
-    locked_buffers->push_back(std::make_pair(output.drm_fd(), GBMBOWrapper(output.drm_fd(), mir_orientation_normal)));
+    locked_devices->push_back(std::make_unique<Device>(output.drm_fd()));
 
-    GBMBOWrapper& bo = locked_buffers->back().second;
+    GBMBOWrapper& bo = locked_devices->back()->blank;
     if (gbm_bo_get_width(bo) < min_buffer_width)
     {
         min_buffer_width = gbm_bo_get_width(bo);
@@ -448,5 +594,5 @@ mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& outpu
         min_buffer_height = gbm_bo_get_height(bo);
     }
 
-    return bo;
+    return *locked_devices->back();
 }
@@ -30,8 +30,10 @@
 #include <gbm.h>
 
 #include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace mir
@@ -86,9 +88,14 @@ public:
 private:
     enum ForceCursorState { UpdateState, ForceState };
     struct GBMBOWrapper;
+    struct Device;
+    struct CachedImage;
     void for_each_used_output(std::function<void(KMSOutput&, geometry::Rectangle const&, MirOrientation orientation)> const& f);
     void place_cursor_at(geometry::Point position, ForceCursorState force_state);
     void place_cursor_at_locked(std::lock_guard<std::mutex> const&, geometry::Point position, ForceCursorState force_state);
+    void apply_pending_move();
+    bool take_pending_move(geometry::Point& position);
+    bool move_is_pending();
     void write_buffer_data_locked(
         std::lock_guard<std::mutex> const&,
         gbm_bo* buffer,
@@ -96,10 +103,15 @@ private:
         size_t count);
     void pad_and_write_image_data_locked(
         std::lock_guard<std::mutex> const&,
-        GBMBOWrapper& buffer);
+        CachedImage const& image,
+        MirOrientation orientation,
+        gbm_bo* buffer);
     void clear(std::lock_guard<std::mutex> const&);
 
-    GBMBOWrapper& buffer_for_output(KMSOutput const& output);
+    auto cached_image_locked(std::lock_guard<std::mutex> const&, CursorImage const& cursor_image) -> CachedImage*;
+    auto buffer_for_locked(std::lock_guard<std::mutex> const&, KMSOutput const& output, MirOrientation orientation)
+        -> gbm_bo*;
+    Device& device_for_output(KMSOutput const& output);
     
     std::mutex guard;
 
@@ -107,30 +119,71 @@ private:
     geometry::Point current_position;
     geometry::Displacement hotspot;
     geometry::Size size;
-    std::vector<uint8_t> argb8888;
 
     bool visible;
     bool last_set_failed;
 
+    /// Moves waiting for whoever holds the guard to apply them
+    std::mutex pending_guard;
+    bool move_pending;
+    geometry::Point pending_position;
+
     struct GBMBOWrapper
     {
-        GBMBOWrapper(int fd, MirOrientation orientation);
+        GBMBOWrapper(Device const& device);
         operator gbm_bo*();
 
-        auto orientation() const -> MirOrientation { return current_orientation; }
-        auto change_orientation(MirOrientation new_orientation) -> bool;
-
         ~GBMBOWrapper();
 
         GBMBOWrapper(GBMBOWrapper&& from);
     private:
-        gbm_device* device;
         gbm_bo* buffer;
-        MirOrientation current_orientation;
         GBMBOWrapper(GBMBOWrapper const&) = delete;
         GBMBOWrapper& operator=(GBMBOWrapper const&) = delete;
     };
-    Mutex<std::vector<std::pair<int, GBMBOWrapper>>> buffers;
+
+    struct Device
+    {
+        Device(int drm_fd);
+
+        int const drm_fd;
+        std::unique_ptr<gbm_device, void(*)(gbm_device*)> const device;
+        uint32_t const width;
+        uint32_t const height;
+        /// Shown until there is an image to show
+        GBMBOWrapper blank;
+    };
+    Mutex<std::vector<std::unique_ptr<Device>>> devices;
+
+    struct RotatedBuffer
+    {
+        int drm_fd;
+        MirOrientation orientation;
+        GBMBOWrapper buffer;
+    };
+
+    /// An image already padded and rotated into buffers for the outputs it has been shown on
+    struct CachedImage
+    {
+        CachedImage(geometry::Size size, size_t hash, std::vector<uint8_t>&& argb8888);
+
+        geometry::Size const size;
+        size_t const hash;
+        std::vector<uint8_t> const argb8888;
+        std::vector<RotatedBuffer> buffers;
+    };
+    // Declared after the devices, so the buffers go before the devices they came from
+    std::list<CachedImage> image_cache;    ///< Most recently shown first
+    CachedImage* current_image;
+
+    /// Where each output's cursor was last put, so as not to put it there again
+    struct OutputState
+    {
+        gbm_bo* buffer{nullptr};
+        bool placed{false};
+        geometry::Point position;
+    };
+    std::unordered_map<KMSOutput const*, OutputState> output_state;
 
     uint32_t min_buffer_width;
     uint32_t min_buffer_height;
@@ -526,6 +526,8 @@ void mgm::Display::configure_locked(
                     auto const mode_index = kms_conf.get_kms_mode_index(conf_output.id,
                                                                   conf_output.current_mode_index);
                     kms_output->configure(conf_output.top_left - bounding_rect.top_left, mode_index);
+                    kms_output->report_frames_as(conf_output.id.as_value());
+                    kms_output->allow_variable_refresh(conf_output.variable_refresh);
                     if (!comp)
                     {
                         kms_output->set_power_mode(conf_output.power_mode);
@@ -34,6 +34,7 @@
 #include <GLES2/gl2ext.h>
 #include <drm_fourcc.h>
 
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
 #include <chrono>
@@ -497,11 +498,24 @@ mgm::DisplayBuffer::DisplayBuffer(
       area(area),
       transform{transformation},
       needs_set_crtc{false},
-      page_flips_pending{false}
+      page_flips_pending{false},
+      render_time_predictor{std::chrono::milliseconds{50}},
+      predicted_render{render_time_predictor.prediction()}
 {
     listener->report_successful_setup_of_native_resources();
 
-    make_current();
+    surface.make_current();
+
+    auto const egl_display = eglGetCurrentDisplay();
+    char const* const egl_extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    if (egl_extensions && strstr(egl_extensions, "EGL_KHR_fence_sync"))
+    {
+        create_sync = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"));
+        destroy_sync = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"));
+        client_wait_sync = reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR"));
+        if (create_sync && destroy_sync && client_wait_sync)
+            fence_display = egl_display;
+    }
 
     listener->report_successful_egl_make_current_on_construction();
 
@@ -561,6 +575,8 @@ mgm::DisplayBuffer::DisplayBuffer(
 
 mgm::DisplayBuffer::~DisplayBuffer()
 {
+    if (render_fence != EGL_NO_SYNC_KHR)
+        destroy_sync(fence_display, render_fence);
 }
 
 geom::Rectangle mgm::DisplayBuffer::view_area() const
@@ -581,6 +597,8 @@ void mgm::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectan
 
 bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    overlay_bufs.clear();
+
     glm::mat2 static const no_transformation;
     if (transform == no_transformation &&
        (bypass_option == mgm::BypassOption::allowed))
@@ -610,6 +628,105 @@ bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
     return false;
 }
 
+mg::RenderableList mgm::DisplayBuffer::assign_overlay_planes(RenderableList const& renderable_list)
+{
+    /*
+     * Without a working page flip the frame is shown by set_crtc(), which
+     * only keeps overlay planes in step on a best-effort basis. Composite
+     * everything until a flip works again.
+     */
+    glm::mat2 static const no_transformation;
+    if (outputs.size() != 1 || transform != no_transformation ||
+        bypass_option != mgm::BypassOption::allowed ||
+        needs_set_crtc || page_flip_failed)
+    {
+        return renderable_list;
+    }
+
+    auto const& output = outputs.front();
+    auto const max_overlays = output->overlay_plane_count();
+    if (max_overlays == 0)
+        return renderable_list;
+
+    /*
+     * Overlay planes stack above the composited frame, so working down from
+     * the top a renderable can only go on one if nothing over it is left to
+     * be composited.
+     */
+    std::vector<geom::Rectangle> composited_above;
+    std::vector<OverlayPlacement> placements;
+    std::vector<std::shared_ptr<Renderable>> placed;
+    for (auto it = renderable_list.rbegin(); it != renderable_list.rend(); ++it)
+    {
+        auto const& renderable = *it;
+        auto const position = renderable->screen_position();
+        bool const covered = std::any_of(composited_above.begin(), composited_above.end(),
+            [&position](geom::Rectangle const& above) { return above.overlaps(position); });
+
+        OverlayPlacement placement;
+        if (placements.size() < max_overlays && !covered && can_overlay(*renderable, placement))
+        {
+            placements.push_back(placement);
+            placed.push_back(renderable);
+        }
+        else
+        {
+            composited_above.push_back(position);
+        }
+    }
+
+    // Planes are given lowest first; if the hardware refuses, composite the lowest instead
+    std::reverse(placements.begin(), placements.end());
+    std::reverse(placed.begin(), placed.end());
+    while (!placements.empty() && !output->set_overlays(placements))
+    {
+        placements.erase(placements.begin());
+        placed.erase(placed.begin());
+    }
+
+    if (placed.empty())
+        return renderable_list;
+
+    RenderableList composited;
+    for (auto const& renderable : renderable_list)
+    {
+        if (std::find(placed.begin(), placed.end(), renderable) == placed.end())
+            composited.push_back(renderable);
+    }
+
+    for (auto const& renderable : placed)
+        overlay_bufs.push_back(renderable->buffer());
+
+    return composited;
+}
+
+bool mgm::DisplayBuffer::can_overlay(Renderable const& renderable, OverlayPlacement& placement) const
+{
+    glm::mat4 static const identity;
+
+    auto const position = renderable.screen_position();
+    auto const is_opaque = renderable.alpha() == 1.0f && !renderable.shaped();
+    if (!is_opaque || renderable.transformation() != identity || !area.contains(position))
+        return false;
+
+    auto const buffer = renderable.buffer();
+    auto const native = std::dynamic_pointer_cast<mgm::NativeBuffer>(buffer->native_buffer_handle());
+    if (!native || !(native->flags & mir_buffer_flag_can_scanout) ||
+        needs_bounce_buffer(*outputs.front(), native->bo))
+    {
+        return false;
+    }
+
+    auto const fb = outputs.front()->fb_for(native->bo);
+    if (!fb)
+        return false;
+
+    placement.fb = fb;
+    placement.source_size = buffer->size();
+    placement.destination = {geom::Point{} + (position.top_left - area.top_left), position.size};
+    return true;
+}
+
 void mgm::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -618,6 +735,9 @@ void mgm::DisplayBuffer::for_each_display_buffer(
 
 void mgm::DisplayBuffer::swap_buffers()
 {
+    if (fence_display != EGL_NO_DISPLAY && render_fence == EGL_NO_SYNC_KHR)
+        render_fence = create_sync(fence_display, EGL_SYNC_FENCE_KHR, nullptr);
+
     surface.swap_buffers();
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
@@ -664,18 +784,35 @@ void mgm::DisplayBuffer::post()
             fatal_error("Failed to get front buffer object");
     }
 
+    // Overlays set up by assign_overlay_planes() stay until told otherwise
+    if (overlays_shown && overlay_bufs.empty())
+        outputs.front()->set_overlays({});
+    overlays_shown = !overlay_bufs.empty();
+    scheduled_overlay_frame = std::move(overlay_bufs);
+    overlay_bufs.clear();
+
+    /*
+     * A bypassed client can set the pace on outputs that support variable
+     * refresh, its frames being shown as they arrive instead of waiting for
+     * the next fixed vblank.
+     */
+    bool const variable_refresh =
+        outputs.front()->set_variable_refresh(bypass_buf && outputs.size() == 1);
+
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*bufobj))
-        needs_set_crtc = true;
+    if (!needs_set_crtc)
+        page_flip_failed = !schedule_page_flip(*bufobj);
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
      * to need to do this on every frame. [will complete in this thread]
+     * The outputs update their overlay planes too, or switch them off, so
+     * once this returns the previous overlay buffers are off screen.
      */
-    if (needs_set_crtc)
+    if (needs_set_crtc || page_flip_failed)
     {
         set_crtc(*bufobj);
         needs_set_crtc = false;
@@ -684,7 +821,7 @@ void mgm::DisplayBuffer::post()
     using namespace std;  // For operator""ms()
 
     // Predicted worst case render time for the next frame...
-    auto predicted_render_time = 50ms;
+    chrono::microseconds predicted_render_time = render_time_predictor.prediction();
 
     if (bypass_buf)
     {
@@ -712,31 +849,62 @@ void mgm::DisplayBuffer::post()
          * buffering that clone mode requires).
          */
         if (outputs.size() == 1)
+        {
+            // The GPU finishes before the flip can, so this costs no extra time
+            measure_render_time();
+            predicted_render_time = render_time_predictor.prediction();
             wait_for_page_flip();
+        }
+    }
 
-        /*
-         * TODO: If you're optimistic about your GPU performance and/or
-         *       measure it carefully you may wish to set predicted_render_time
-         *       to a lower value here for lower latency.
-         *
-         *predicted_render_time = 9ms; // e.g. about the same as Weston
-         */
+    if (render_fence != EGL_NO_SYNC_KHR)
+    {
+        destroy_sync(fence_display, render_fence);
+        render_fence = EGL_NO_SYNC_KHR;
     }
+    render_start = decltype(render_start){};
+    predicted_render = predicted_render_time;
 
     // Buffer lifetimes are managed exclusively by scheduled*/visible* now
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
 
+    // With variable refresh there's no vblank to sleep until
     recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+    if (outputs.size() == 1 && !variable_refresh)
     {
         auto const& output = outputs.front();
-        auto const min_frame_interval = 1000ms / output->max_refresh_rate();
+        chrono::microseconds const min_frame_interval = 1000000us / output->max_refresh_rate();
         if (predicted_render_time < min_frame_interval)
-            recommend_sleep = min_frame_interval - predicted_render_time;
+            recommend_sleep = chrono::duration_cast<chrono::milliseconds>(min_frame_interval - predicted_render_time);
     }
 }
 
+void mgm::DisplayBuffer::measure_render_time()
+{
+    if (render_fence == EGL_NO_SYNC_KHR || !render_start)
+        return;
+
+    auto const result = client_wait_sync(
+        fence_display, render_fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+    if (result != EGL_CONDITION_SATISFIED_KHR)
+        return;
+
+    last_render = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - render_start.value());
+    render_time_predictor.add_sample(last_render);
+}
+
+std::chrono::microseconds mgm::DisplayBuffer::last_render_time() const
+{
+    return last_render;
+}
+
+std::chrono::microseconds mgm::DisplayBuffer::predicted_render_time() const
+{
+    return predicted_render;
+}
+
 std::chrono::milliseconds mgm::DisplayBuffer::recommended_sleep() const
 {
     return recommend_sleep;
@@ -777,11 +945,17 @@ void mgm::DisplayBuffer::wait_for_page_flip()
 
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+
+        visible_overlay_frame = std::move(scheduled_overlay_frame);
+        scheduled_overlay_frame.clear();
     }
 }
 
 void mgm::DisplayBuffer::make_current()
 {
+    if (!render_start)
+        render_start = std::chrono::steady_clock::now();
+
     surface.make_current();
 }
 
@@ -21,14 +21,22 @@
 
 #include "mir/graphics/display_buffer.h"
 #include "mir/graphics/display.h"
+#include "mir/graphics/overlay_planes.h"
+#include "mir/graphics/render_time_estimate.h"
 #include "mir/renderer/gl/render_target.h"
+#include "mir/optional_value.h"
 #include "display_helpers.h"
 #include "egl_helper.h"
 #include "platform_common.h"
+#include "render_time_predictor.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <chrono>
 
 namespace mir
 {
@@ -44,6 +52,7 @@ namespace mesa
 class Platform;
 class FBHandle;
 class KMSOutput;
+struct OverlayPlacement;
 class NativeBuffer;
 
 class GBMOutputSurface : public renderer::gl::RenderTarget
@@ -96,6 +105,8 @@ private:
 class DisplayBuffer : public graphics::DisplayBuffer,
                       public graphics::DisplaySyncGroup,
                       public graphics::NativeDisplayBuffer,
+                      public graphics::OverlayPlanes,
+                      public graphics::RenderTimeEstimate,
                       public renderer::gl::RenderTarget
 {
 public:
@@ -112,6 +123,7 @@ public:
     void release_current() override;
     void swap_buffers() override;
     bool overlay(RenderableList const& renderlist) override;
+    RenderableList assign_overlay_planes(RenderableList const& renderlist) override;
     void bind() override;
 
     void for_each_display_buffer(
@@ -119,6 +131,9 @@ public:
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
 
+    std::chrono::microseconds last_render_time() const override;
+    std::chrono::microseconds predicted_render_time() const override;
+
     glm::mat2 transformation() const override;
     NativeDisplayBuffer* native_display_buffer() override;
 
@@ -128,9 +143,14 @@ public:
 
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
+    bool can_overlay(Renderable const& renderable, OverlayPlacement& placement) const;
     void set_crtc(FBHandle const&);
+    void measure_render_time();
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
+    std::vector<std::shared_ptr<graphics::Buffer>> overlay_bufs;
+    std::vector<std::shared_ptr<graphics::Buffer>> visible_overlay_frame, scheduled_overlay_frame;
+    bool overlays_shown{false};
     std::shared_ptr<Buffer> bypass_buf{nullptr};
     FBHandle* bypass_bufobj{nullptr};
     std::shared_ptr<DisplayReport> const listener;
@@ -153,8 +173,23 @@ private:
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
+    bool page_flip_failed{false};   ///< The last frame fell back to set_crtc()
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
+
+    /*
+     * A composited frame is timed from the first make_current() after the
+     * previous post() until a fence inserted before its swap has signalled.
+     */
+    PFNEGLCREATESYNCKHRPROC create_sync{nullptr};
+    PFNEGLDESTROYSYNCKHRPROC destroy_sync{nullptr};
+    PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync{nullptr};
+    EGLDisplay fence_display{EGL_NO_DISPLAY};
+    EGLSyncKHR render_fence{EGL_NO_SYNC_KHR};
+    optional_value<std::chrono::steady_clock::time_point> render_start;
+    std::chrono::microseconds last_render{0};
+    RenderTimePredictor render_time_predictor;
+    std::chrono::microseconds predicted_render{0};
 };
 
 }
@@ -22,6 +22,7 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir_toolkit/common.h"
@@ -30,6 +31,8 @@
 
 #include <gbm.h>
 
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -41,6 +44,14 @@ namespace mesa
 
 class FBHandle;
 
+/// A buffer to scan out of an overlay plane, above the composited frame
+struct OverlayPlacement
+{
+    FBHandle const* fb;
+    geometry::Size source_size;         ///< Shown from the buffer's top-left corner
+    geometry::Rectangle destination;    ///< Relative to the output
+};
+
 class KMSOutput
 {
 public:
@@ -54,6 +65,13 @@ public:
     
     virtual void reset() = 0;
     virtual void configure(geometry::Displacement fb_offset, size_t kms_mode_index) = 0;
+
+    /**
+     * Sets the id that frames shown on this output are reported under.
+     * Until set, this is the connector id; the display sets it to the
+     * DisplayConfigurationOutputId so observers can tell outputs apart.
+     */
+    virtual void report_frames_as(uint32_t output_id) = 0;
     virtual geometry::Size size() const = 0;
 
     /**
@@ -64,11 +82,41 @@ public:
      */
     virtual int max_refresh_rate() const = 0;
 
+    /**
+     * Shows \a fb straight away, rather than with a flip, along with the
+     * overlays from set_overlays(). Overlays it can't show are switched off.
+     */
     virtual bool set_crtc(FBHandle const& fb) = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
     virtual void wait_for_page_flip() = 0;
 
+    /**
+     * The number of overlay planes that can be stacked above the frames
+     * this output shows. Zero without atomic modesetting.
+     */
+    virtual size_t overlay_plane_count() = 0;
+
+    /**
+     * Has each following schedule_page_flip() also show \a overlays, lowest
+     * first. Returns false, changing nothing, if a test commit finds the
+     * hardware can't show them. An empty list stops showing overlays.
+     */
+    virtual bool set_overlays(std::vector<OverlayPlacement> const& overlays) = 0;
+
+    /**
+     * Whether set_variable_refresh() may switch variable refresh on, as
+     * chosen in the display configuration.
+     */
+    virtual void allow_variable_refresh(bool allowed) = 0;
+
+    /**
+     * Lets following page flips be shown as soon as the hardware can,
+     * instead of waiting for a fixed vblank. Returns whether variable
+     * refresh is now on, which needs a vrr_capable connector and allowing.
+     */
+    virtual bool set_variable_refresh(bool enabled) = 0;
+
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
     virtual bool clear_cursor() = 0;
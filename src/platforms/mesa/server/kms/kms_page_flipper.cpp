@@ -88,6 +88,29 @@ bool mgm::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgm::KMSPageFlipper::schedule_atomic_flip(
+    uint32_t crtc_id,
+    drmModeAtomicReq* request,
+    uint32_t connector_id)
+{
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    if (pending_page_flips.find(crtc_id) != pending_page_flips.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+
+    pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this};
+
+    // The completion arrives as the same event a legacy page flip sends
+    auto ret = drmModeAtomicCommit(drm_fd, request,
+                                   DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK,
+                                   &pending_page_flips[crtc_id]);
+
+    if (ret)
+        pending_page_flips.erase(crtc_id);
+
+    return (ret == 0);
+}
+
 mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
     drmEventContext evctx;
@@ -184,6 +207,7 @@ void mgm::KMSPageFlipper::notify_page_flip(uint32_t crtc_id, int64_t msc,
         auto& frame = completed_page_flips[crtc_id];
         frame.msc = msc;
         frame.ust = {clock_id, ust};
+        frame.hardware_timestamp = true;
         report->report_vsync(pending->second.connector_id, frame);
         pending_page_flips.erase(pending);
     }
@@ -21,6 +21,7 @@
 
 #include "mir/graphics/frame.h"
 #include <cstdint>
+#include <xf86drmMode.h>
 
 namespace mir
 {
@@ -35,6 +36,8 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /// As schedule_flip(), but applying everything in an atomic \a request
+    virtual bool schedule_atomic_flip(uint32_t crtc_id, drmModeAtomicReq* request, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
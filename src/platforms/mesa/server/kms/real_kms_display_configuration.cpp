@@ -137,6 +137,7 @@ void populate_default_mir_config(mg::DisplayConfigurationOutput& to_populate)
     to_populate.pixel_formats = {mir_pixel_format_xrgb_8888, mir_pixel_format_argb_8888};
     to_populate.current_format = mir_pixel_format_xrgb_8888;
     to_populate.current_mode_index = std::numeric_limits<uint32_t>::max();
+    to_populate.variable_refresh = true;
 }
 }
 
@@ -67,6 +67,11 @@ void bo_user_data_destroy(gbm_bo* /*bo*/, void *data)
     delete bufobj;
 }
 
+bool is_vrr_capable(int drm_fd, uint32_t connector_id)
+{
+    mgk::ObjectProperties connector_props{drm_fd, connector_id, DRM_MODE_OBJECT_CONNECTOR};
+    return connector_props.has_property("vrr_capable") && connector_props["vrr_capable"];
+}
 }
 
 mgm::RealKMSOutput::RealKMSOutput(
@@ -76,6 +81,7 @@ mgm::RealKMSOutput::RealKMSOutput(
     : drm_fd_{drm_fd},
       page_flipper{page_flipper},
       connector{std::move(connector)},
+      reported_id{this->connector->connector_id},
       mode_index{0},
       current_crtc(),
       saved_crtc(),
@@ -99,6 +105,8 @@ mgm::RealKMSOutput::RealKMSOutput(
 
 mgm::RealKMSOutput::~RealKMSOutput()
 {
+    set_variable_refresh(false);
+    forget_planes();
     restore_saved_crtc();
 }
 
@@ -137,7 +145,9 @@ void mgm::RealKMSOutput::reset()
     }
 
     /* Discard previously current crtc */
+    set_variable_refresh(false);
     current_crtc = nullptr;
+    forget_planes();
 }
 
 geom::Size mgm::RealKMSOutput::size() const
@@ -158,6 +168,11 @@ void mgm::RealKMSOutput::configure(geom::Displacement offset, size_t kms_mode_in
     mode_index = kms_mode_index;
 }
 
+void mgm::RealKMSOutput::report_frames_as(uint32_t output_id)
+{
+    reported_id = output_id;
+}
+
 bool mgm::RealKMSOutput::set_crtc(FBHandle const& fb)
 {
     if (!ensure_crtc())
@@ -174,9 +189,18 @@ bool mgm::RealKMSOutput::set_crtc(FBHandle const& fb)
     if (ret)
     {
         current_crtc = nullptr;
+        variable_refresh_on = false;
+        forget_planes();
         return false;
     }
 
+    // A legacy modeset leaves the planes as they were, so bring them up to date too
+    if (planes && (!overlays.empty() || planes->overlays_enabled()) && !planes->show_overlays(overlays))
+    {
+        planes->disable_overlays();
+        overlays.clear();
+    }
+
     using_saved_crtc = false;
     return true;
 }
@@ -198,6 +222,8 @@ void mgm::RealKMSOutput::clear_crtc()
         return;
     }
 
+    set_variable_refresh(false);
+
     auto result = drmModeSetCrtc(drm_fd_, current_crtc->crtc_id,
                                  0, 0, 0, nullptr, 0, nullptr);
     if (result)
@@ -207,6 +233,8 @@ void mgm::RealKMSOutput::clear_crtc()
     }
 
     current_crtc = nullptr;
+    variable_refresh_on = false;
+    forget_planes();
 }
 
 bool mgm::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
@@ -220,10 +248,25 @@ bool mgm::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
                        mgk::connector_name(connector).c_str());
         return false;
     }
+
+    // Overlays being shown or taken down need the planes changed in the same commit
+    if (planes && (!overlays.empty() || planes->overlays_enabled()))
+    {
+        std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)>
+            request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+
+        planes->add_to(request.get(), fb.get_drm_fb_id(), overlays);
+        if (!page_flipper->schedule_atomic_flip(current_crtc->crtc_id, request.get(), reported_id))
+            return false;
+
+        planes->committed(overlays);
+        return true;
+    }
+
     return page_flipper->schedule_flip(
         current_crtc->crtc_id,
         fb.get_drm_fb_id(),
-        connector->connector_id);
+        reported_id);
 }
 
 void mgm::RealKMSOutput::wait_for_page_flip()
@@ -240,6 +283,90 @@ void mgm::RealKMSOutput::wait_for_page_flip()
     last_frame_.store(page_flipper->wait_for_flip(current_crtc->crtc_id));
 }
 
+size_t mgm::RealKMSOutput::overlay_plane_count()
+{
+    if (!planes_probed && current_crtc)
+    {
+        planes = AtomicPlanes::for_crtc(drm_fd_, current_crtc->crtc_id);
+        planes_probed = true;
+    }
+
+    return planes ? planes->overlay_count() : 0;
+}
+
+bool mgm::RealKMSOutput::set_overlays(std::vector<OverlayPlacement> const& placements)
+{
+    if (placements.empty())
+    {
+        overlays.clear();
+        return true;
+    }
+
+    if (placements.size() > overlay_plane_count())
+        return false;
+
+    std::vector<AtomicPlanes::Placement> candidates;
+    candidates.reserve(placements.size());
+    for (auto const& placement : placements)
+        candidates.push_back({placement.fb->get_drm_fb_id(), placement.source_size, placement.destination});
+
+    if (!planes->test(candidates))
+        return false;
+
+    overlays = std::move(candidates);
+    return true;
+}
+
+void mgm::RealKMSOutput::allow_variable_refresh(bool allowed)
+{
+    variable_refresh_allowed = allowed;
+}
+
+bool mgm::RealKMSOutput::set_variable_refresh(bool enabled)
+{
+    if (!current_crtc)
+    {
+        variable_refresh_on = false;
+        return false;
+    }
+
+    bool const on = enabled && variable_refresh_allowed;
+    if (on == variable_refresh_on)
+        return on;
+
+    try
+    {
+        if (on && !is_vrr_capable(drm_fd_, connector->connector_id))
+            return false;
+
+        // VRR_ENABLED is set on the CRTC, and only takes effect on a vrr_capable connector
+        mgk::ObjectProperties crtc_props{drm_fd_, current_crtc->crtc_id, DRM_MODE_OBJECT_CRTC};
+        if (!crtc_props.has_property("VRR_ENABLED"))
+            return false;
+
+        if (auto const result = drmModeObjectSetProperty(
+                drm_fd_, current_crtc->crtc_id, DRM_MODE_OBJECT_CRTC, crtc_props.id_for("VRR_ENABLED"), on))
+        {
+            mir::log_warning("Failed to switch variable refresh %s on output %s (%s)",
+                             on ? "on" : "off",
+                             mgk::connector_name(connector).c_str(),
+                             strerror(-result));
+            return variable_refresh_on;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Failed to switch variable refresh %s on output %s (%s)",
+                         on ? "on" : "off",
+                         mgk::connector_name(connector).c_str(),
+                         e.what());
+        return variable_refresh_on;
+    }
+
+    variable_refresh_on = on;
+    return on;
+}
+
 mg::Frame mgm::RealKMSOutput::last_frame() const
 {
     return last_frame_.load();
@@ -330,6 +457,16 @@ void mgm::RealKMSOutput::restore_saved_crtc()
     }
 }
 
+void mgm::RealKMSOutput::forget_planes()
+{
+    if (planes)
+        planes->disable_overlays();
+
+    planes = nullptr;
+    planes_probed = false;
+    overlays.clear();
+}
+
 void mgm::RealKMSOutput::set_power_mode(MirPowerMode mode)
 {
     std::lock_guard<std::mutex> lg(power_mutex);
@@ -378,8 +515,11 @@ void mgm::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
 
 void mgm::RealKMSOutput::refresh_hardware_state()
 {
+    set_variable_refresh(false);
     connector = kms::get_connector(drm_fd_, connector->connector_id);
     current_crtc = nullptr;
+    variable_refresh_on = false;
+    forget_planes();
 
     if (connector->encoder_id)
     {
@@ -586,6 +726,7 @@ void mgm::RealKMSOutput::update_from_hardware_state(
     output.subpixel_arrangement = kms_subpixel_to_mir_subpixel(connector->subpixel);
     output.gamma = gamma;
     output.edid = edid;
+    output.variable_refresh_supported = connected && is_vrr_capable(drm_fd_, connector->connector_id);
 }
 
 mgm::FBHandle* mgm::RealKMSOutput::fb_for(gbm_bo* bo) const
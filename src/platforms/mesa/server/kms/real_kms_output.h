@@ -21,6 +21,7 @@
 
 #include "mir/graphics/atomic_frame.h"
 #include "kms_output.h"
+#include "atomic_planes.h"
 #include "kms-utils/drm_mode_resources.h"
 
 #include <memory>
@@ -48,6 +49,7 @@ public:
 
     void reset() override;
     void configure(geometry::Displacement fb_offset, size_t kms_mode_index) override;
+    void report_frames_as(uint32_t output_id) override;
     geometry::Size size() const override;
     int max_refresh_rate() const override;
 
@@ -56,6 +58,12 @@ public:
     bool schedule_page_flip(FBHandle const& fb) override;
     void wait_for_page_flip() override;
 
+    size_t overlay_plane_count() override;
+    bool set_overlays(std::vector<OverlayPlacement> const& overlays) override;
+
+    void allow_variable_refresh(bool allowed) override;
+    bool set_variable_refresh(bool enabled) override;
+
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
     bool clear_cursor() override;
@@ -76,11 +84,13 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    void forget_planes();
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
 
     kms::DRMModeConnectorUPtr connector;
+    uint32_t reported_id;
     size_t mode_index;
     geometry::Displacement fb_offset;
     kms::DRMModeCrtcUPtr current_crtc;
@@ -94,6 +104,14 @@ private:
     std::mutex power_mutex;
 
     AtomicFrame last_frame_;
+
+    // Probed on first use, as only outputs showing overlays need atomic modesetting
+    bool planes_probed{false};
+    std::unique_ptr<AtomicPlanes> planes;
+    std::vector<AtomicPlanes::Placement> overlays;
+
+    bool variable_refresh_allowed{false};
+    bool variable_refresh_on{false};
 };
 
 }
@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_time_predictor.h"
+
+#include <algorithm>
+
+namespace mgm = mir::graphics::mesa;
+
+namespace
+{
+// Covers scheduling jitter between the prediction and the work
+auto const headroom = std::chrono::milliseconds{1};
+}
+
+mgm::RenderTimePredictor::RenderTimePredictor(std::chrono::microseconds fallback)
+    : fallback{fallback},
+      predicted{fallback}
+{
+}
+
+void mgm::RenderTimePredictor::add_sample(std::chrono::microseconds render_time)
+{
+    samples[next_sample] = render_time;
+    next_sample = (next_sample + 1) % samples.size();
+    sample_count = std::min(sample_count + 1, samples.size());
+
+    if (sample_count < min_samples)
+        return;
+
+    // The 95th percentile, so the odd slow frame is planned for
+    std::array<std::chrono::microseconds, 64> sorted;
+    auto const end = std::copy_n(samples.begin(), sample_count, sorted.begin());
+    auto const percentile = sorted.begin() + (sample_count * 95 - 1) / 100;
+    std::nth_element(sorted.begin(), percentile, end);
+
+    predicted = *percentile + headroom;
+}
+
+std::chrono::microseconds mgm::RenderTimePredictor::prediction() const
+{
+    return predicted;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_RENDER_TIME_PREDICTOR_H_
+#define MIR_GRAPHICS_MESA_RENDER_TIME_PREDICTOR_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+
+/**
+ * Predicts how long the next frame will take to render from how long
+ * recent frames took. The prediction is a high percentile of the recent
+ * samples rather than their mean, as missing a flip costs a whole frame
+ * while over-predicting only costs a little latency.
+ */
+class RenderTimePredictor
+{
+public:
+    /// \a fallback is predicted until there are enough samples to go on
+    explicit RenderTimePredictor(std::chrono::microseconds fallback);
+
+    void add_sample(std::chrono::microseconds render_time);
+    std::chrono::microseconds prediction() const;
+
+private:
+    static size_t const min_samples = 8;
+
+    std::chrono::microseconds const fallback;
+    std::array<std::chrono::microseconds, 64> samples;
+    size_t sample_count{0};
+    size_t next_sample{0};
+    std::chrono::microseconds predicted;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_RENDER_TIME_PREDICTOR_H_ */
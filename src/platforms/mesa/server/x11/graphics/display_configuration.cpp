@@ -49,7 +49,9 @@ mgx::DisplayConfiguration::DisplayConfiguration(MirPixelFormat pf, geom::Size co
             {},
             mir_output_gamma_unsupported,
             {},
-            {}},
+            {},
+            false,
+            false},
     card{mg::DisplayConfigurationCardId{0}, 1}
 {
 }
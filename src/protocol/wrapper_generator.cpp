@@ -37,14 +37,14 @@ void emit_comment_header(std::ostream& out)
     out << " */" << std::endl;
 }
 
-void emit_required_headers()
+void emit_required_headers(std::string const& protocol_header)
 {
     std::cout << "#include <experimental/optional>" << std::endl;
     std::cout << "#include <boost/throw_exception.hpp>" << std::endl;
     std::cout << "#include <boost/exception/diagnostic_information.hpp>" << std::endl;
     std::cout << std::endl;
     std::cout << "#include <wayland-server.h>" << std::endl;
-    std::cout << "#include <wayland-server-protocol.h>" << std::endl;
+    std::cout << "#include <" << protocol_header << ">" << std::endl;
     std::cout << std::endl;
     std::cout << "#include \"mir/fd.h\"" << std::endl;
     std::cout << "#include \"mir/log.h\"" << std::endl;
@@ -350,6 +350,7 @@ public:
                 {{"wl_resource_set_implementation(resource, &vtable, me, nullptr);"}});
         }
         emit_indented_lines(out, indent, {
+            {"    me->bound(client, resource);"},
             {"}"}
         });
     }
@@ -368,6 +369,13 @@ public:
         {
             method.emit_virtual_prototype(out, "    ", is_global);
         }
+        if (is_global)
+        {
+            emit_indented_lines(out, "    ", {
+                {"/// Called once a client has bound the global, to send it any initial events"},
+                {"virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}"}
+            });
+        }
         out << std::endl;
 
         if (!is_global)
@@ -480,12 +488,14 @@ private:
 
 int main(int argc, char** argv)
 {
-    if (argc != 3)
+    if (argc != 3 && argc != 4)
     {
         exit(1);
     }
 
     std::string const prefix{argv[1]};
+    // Protocols other than the core one have their own wayland-scanner output
+    std::string const protocol_header{argc == 4 ? argv[3] : "wayland-server-protocol.h"};
 
     auto name_transform = [prefix](std::string protocol_name)
     {
@@ -515,7 +525,7 @@ int main(int argc, char** argv)
 
     std::cout << std::endl;
 
-    emit_required_headers();
+    emit_required_headers(protocol_header);
 
     std::cout << std::endl;
 
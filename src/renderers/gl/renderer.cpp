@@ -24,6 +24,8 @@
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/display_buffer.h"
+#include "mir/graphics/extension_list.h"
+#include "mir/geometry/region.h"
 #include "mir/gl/tessellation_helpers.h"
 #include "mir/gl/texture_cache.h"
 #include "mir/gl/texture.h"
@@ -34,16 +36,149 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 
 namespace mg = mir::graphics;
 namespace mgl = mir::gl;
 namespace mrg = mir::renderer::gl;
 namespace geom = mir::geometry;
 
+namespace
+{
+bool opaque_throughout(mg::Renderable const& renderable)
+{
+    auto const area = renderable.screen_position();
+    for (auto const& opaque : renderable.opaque_region())
+    {
+        if (opaque.contains(area))
+            return true;
+    }
+    return false;
+}
+
+/// The pixels \a primitives cover, or \a everywhere if perspective
+/// may move them (their depth isn't zero)
+geom::Rectangle bounds_of(std::vector<mgl::Primitive> const& primitives,
+                          geom::Rectangle const& everywhere)
+{
+    bool first = true;
+    GLfloat left = 0, right = 0, top = 0, bottom = 0;
+    for (auto const& p : primitives)
+    {
+        for (auto v = p.vertices; v != p.vertices + p.nvertices; ++v)
+        {
+            if (v->position[2] != 0.0f)
+                return everywhere;
+
+            left   = first ? v->position[0] : std::min(left, v->position[0]);
+            right  = first ? v->position[0] : std::max(right, v->position[0]);
+            top    = first ? v->position[1] : std::min(top, v->position[1]);
+            bottom = first ? v->position[1] : std::max(bottom, v->position[1]);
+            first = false;
+        }
+    }
+
+    if (first)
+        return {};
+
+    // Round outwards, as vertices needn't lie on pixel edges
+    int const x = std::floor(left);
+    int const y = std::floor(top);
+    int const width = static_cast<int>(std::ceil(right)) - x;
+    int const height = static_cast<int>(std::ceil(bottom)) - y;
+    return {{x, y}, {width, height}};
+}
+
+bool same_vertex(mgl::Vertex const& a, mgl::Vertex const& b)
+{
+    return std::equal(a.position, a.position + 3, b.position) &&
+           std::equal(a.texcoord, a.texcoord + 2, b.texcoord);
+}
+
+bool same_primitive(mgl::Primitive const& a, mgl::Primitive const& b)
+{
+    return a.type == b.type && a.tex_id == b.tex_id && a.nvertices == b.nvertices &&
+           std::equal(a.vertices, a.vertices + a.nvertices, b.vertices, same_vertex);
+}
+
+/// Whether \a primitives are just the default rectangle of \a renderable's
+/// buffer, so fill exactly its screen_position() with it
+bool tessellated_as_rectangle(std::vector<mgl::Primitive> const& primitives,
+                              mg::Renderable const& renderable)
+{
+    if (primitives.size() != 1)
+        return false;
+
+    try
+    {
+        return same_primitive(
+            primitives[0],
+            mgl::tessellate_renderable_into_rectangle(renderable, geom::Displacement{0,0}));
+    }
+    catch (std::exception const&)
+    {
+        return false;
+    }
+}
+
+/// Adds the parts of the renderable that are sure to hide what is beneath
+void add_opaque_parts(geom::Region& coverage, mg::Renderable const& renderable, bool shaped,
+                      std::vector<mgl::Primitive> const& primitives)
+{
+    glm::mat4 const identity{1.0f};
+    if (renderable.alpha() != 1.0f || renderable.transformation() != identity)
+        return;
+
+    // Neither screen_position() nor the opaque region says what a custom
+    // tessellation (wobbly windows, animations) actually covers
+    if (!tessellated_as_rectangle(primitives, renderable))
+        return;
+
+    if (!shaped)
+    {
+        coverage.add(renderable.screen_position());
+    }
+    else
+    {
+        for (auto const& opaque : renderable.opaque_region())
+            coverage.add(opaque);
+    }
+}
+
+/// Whether every vertex of \a primitives lies within \a area
+bool drawn_within(std::vector<mgl::Primitive> const& primitives, geom::Rectangle const& area)
+{
+    auto const left = static_cast<GLfloat>(area.left().as_int());
+    auto const top = static_cast<GLfloat>(area.top().as_int());
+    auto const right = static_cast<GLfloat>(area.right().as_int());
+    auto const bottom = static_cast<GLfloat>(area.bottom().as_int());
+
+    for (auto const& p : primitives)
+    {
+        for (auto v = p.vertices; v != p.vertices + p.nvertices; ++v)
+        {
+            if (v->position[0] < left || v->position[0] > right ||
+                v->position[1] < top || v->position[1] > bottom)
+                return false;
+        }
+    }
+    return true;
+}
+
+void add_damage(geom::Rectangles& damage, geom::Rectangle const& rect)
+{
+    // Empty rectangles still have a position, so would skew the bounds
+    if (rect.size.width > geom::Width{0} && rect.size.height > geom::Height{0})
+        damage.add(rect);
+}
+}
+
 mrg::CurrentRenderTarget::CurrentRenderTarget(mg::DisplayBuffer* display_buffer)
     : render_target{
         dynamic_cast<renderer::gl::RenderTarget*>(display_buffer->native_display_buffer())}
@@ -153,6 +288,9 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
             auto val = eglQueryString(disp, s.id);
             mir::log_info(std::string(s.label) + ": " + (val ? val : ""));
         }
+
+        buffer_age_supported =
+            mg::has_extension(eglQueryString(disp, EGL_EXTENSIONS), "EGL_EXT_buffer_age");
     }
 
     struct {GLenum id; char const* label;} const glstrings[] =
@@ -183,6 +321,7 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
     mir::log_info("GL framebuffer bits: RGBA=%d%d%d%d, depth=%d, stencil=%d",
                   rbits, gbits, bbits, abits, dbits, sbits);
 
+    glGenBuffers(1, &vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     set_viewport(display_buffer.view_area());
@@ -191,6 +330,7 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
 mrg::Renderer::~Renderer()
 {
     render_target.ensure_current();
+    glDeleteBuffers(1, &vertex_buffer);
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -204,13 +344,101 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 {
     render_target.bind();
 
+    // What each renderable actually draws decides what it damages and hides
+    stream_vertices(renderables);
+
+    /*
+     * Only the area that differs between the back buffer's old contents and
+     * the new frame needs repainting. Clearing and drawing are scissored to
+     * it, but every buffer is still loaded so that the texture cache keeps
+     * (and releases) the same buffers it would for a full repaint.
+     */
+    auto const repaint = repaint_area(renderables);
+    bool const partial_repaint = repaint != viewport;
+    if (partial_repaint)
+    {
+        glEnable(GL_SCISSOR_TEST);
+        scissor_to(repaint);
+    }
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     glClear(GL_COLOR_BUFFER_BIT);
 
+    /*
+     * Opaque renderables hide whatever lies beneath them, so work out top
+     * down what each renderable has above it and don't draw that.
+     */
+    std::vector<geom::Region> hidden(renderables.size());
+    geom::Region coverage;
+    for (auto i = renderables.size(); i-- != 0;)
+    {
+        hidden[i] = coverage;
+        add_opaque_parts(coverage, *renderables[i], shaped_as_drawn(*renderables[i]),
+                         tessellation_of(*renderables[i]).primitives);
+    }
+
     ++frameno;
-    for (auto const& r : renderables)
-        draw(*r, r->alpha() < 1.0f ? alpha_program : default_program);
+    reset_gl_state();
+
+    glm::mat4 const identity{1.0f};
+    for (size_t i = 0; i != renderables.size(); ++i)
+    {
+        auto const& r = *renderables[i];
+        auto const& program = r.alpha() < 1.0f ? alpha_program : default_program;
+
+        // Clipping to what's visible of screen_position() is only right for
+        // a renderable drawn where it says: a transformed one, or one whose
+        // tessellation (decorations, shadows) reaches beyond, may appear
+        // anywhere, and is clipped only to the repaint area
+        if (!hidden[i].overlaps(r.screen_position()) ||
+            r.transformation() != identity ||
+            !drawn_within(tessellation_of(r).primitives, r.screen_position()))
+        {
+            draw(r, program);
+            continue;
+        }
+
+        // Only what's visible of the renderable itself needs drawing, so
+        // it's drawn once per rectangle of that, not of the whole screen
+        geom::Region visible{r.screen_position()};
+        visible.intersect(repaint);
+        visible.subtract(hidden[i]);
+        auto const visible_rects = visible.rectangles();
+
+        if (visible_rects.empty())
+        {
+            // Keep the buffer in the cache as if it had been drawn, carrying
+            // on if it can't be loaded just as draw() does (lp:1629275)
+            try
+            {
+                texture_cache->load(r);
+            }
+            catch (std::exception const&)
+            {
+                report_exception();
+            }
+            continue;
+        }
+
+        glEnable(GL_SCISSOR_TEST);
+        draw_within(r, program, &visible_rects);
+
+        if (partial_repaint)
+            scissor_to(repaint);
+        else
+            glDisable(GL_SCISSOR_TEST);
+    }
+
+    if (partial_repaint)
+        glDisable(GL_SCISSOR_TEST);
+
+    if (current_attribs.position >= 0)
+    {
+        glDisableVertexAttribArray(current_attribs.texcoord);
+        glDisableVertexAttribArray(current_attribs.position);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     render_target.swap_buffers();
 
@@ -222,13 +450,179 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
         mir::log_debug("GL error: %d", gl_error);
 }
 
+geom::Rectangle mrg::Renderer::repaint_area(mg::RenderableList const& renderables) const
+{
+    glm::mat4 const identity{1.0f};
+
+    geom::Rectangles damage;
+    std::unordered_map<mg::Renderable::ID, DrawnRenderable> now_drawn;
+    now_drawn.reserve(renderables.size());
+
+    int stacking = 0;
+    int highest_previous_stacking = -1;
+    for (auto const& r : renderables)
+    {
+        auto const& primitives = tessellation_of(*r).primitives;
+        auto const transformation = r->transformation();
+
+        // What it damages is what it draws, which tessellate() may have put
+        // beyond screen_position(). Transformed, it may be anywhere on screen.
+        DrawnRenderable drawn{
+            {}, r->screen_position(), transformation, r->alpha(), r->shaped(), stacking++,
+            transformation == identity ? bounds_of(primitives, viewport) : viewport,
+            primitives};
+
+        bool buffer_unknown = false;
+        try
+        {
+            drawn.buffer_id = r->buffer()->id();
+        }
+        catch (std::exception const&)
+        {
+            // Drawing it will fail (and report) too. Just treat it as changed.
+            buffer_unknown = true;
+        }
+
+        auto const previous = last_drawn.find(r->id());
+        if (previous == last_drawn.end())
+        {
+            add_damage(damage, drawn.bounds);
+        }
+        else
+        {
+            auto const& was = previous->second;
+
+            if (buffer_unknown ||
+                was.buffer_id != drawn.buffer_id ||
+                was.screen_position != drawn.screen_position ||
+                was.transformation != drawn.transformation ||
+                was.alpha != drawn.alpha ||
+                was.shaped != drawn.shaped ||
+                was.bounds != drawn.bounds ||
+                !std::equal(was.primitives.begin(), was.primitives.end(),
+                            drawn.primitives.begin(), drawn.primitives.end(), same_primitive))
+            {
+                add_damage(damage, was.bounds);
+                add_damage(damage, drawn.bounds);
+            }
+            else if (was.stacking < highest_previous_stacking)
+            {
+                // Restacked below something it used to be above. Any change
+                // is confined to where the two overlap, so within its bounds.
+                add_damage(damage, drawn.bounds);
+            }
+
+            highest_previous_stacking = std::max(highest_previous_stacking, was.stacking);
+            last_drawn.erase(previous);
+        }
+
+        now_drawn[r->id()] = drawn;
+    }
+
+    for (auto const& gone : last_drawn)
+        add_damage(damage, gone.second.bounds);
+
+    last_drawn = std::move(now_drawn);
+
+    auto const frame_damage = full_repaint_pending ?
+        viewport : damage.bounding_rectangle().intersection_with(viewport);
+    full_repaint_pending = false;
+
+    damage_history.push_front(frame_damage);
+    if (damage_history.size() > max_tracked_buffer_age)
+        damage_history.pop_back();
+
+    /*
+     * A back buffer of age N last held the frame from N frames ago, so is
+     * missing the damage of the last N frames (including this one).
+     */
+    auto const age = back_buffer_age();
+    if (age == 0 || age > damage_history.size())
+        return viewport;
+
+    geom::Rectangles stale;
+    for (unsigned int i = 0; i != age; ++i)
+        add_damage(stale, damage_history[i]);
+
+    return stale.bounding_rectangle();
+}
+
+bool mrg::Renderer::shaped_as_drawn(mg::Renderable const& renderable) const
+{
+    auto const found = last_drawn.find(renderable.id());
+
+    // Only missed when a subclass draws something it didn't render()
+    return found != last_drawn.end() ? found->second.shaped : renderable.shaped();
+}
+
+unsigned int mrg::Renderer::back_buffer_age() const
+{
+    if (!buffer_age_supported || !gl_viewport_valid)
+        return 0;
+
+    // An FBO is not an EGL surface, so EGL has no idea what it contains
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    if (framebuffer != 0)
+        return 0;
+
+    EGLint age = 0;
+    if (!eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW),
+                         EGL_BUFFER_AGE_EXT, &age) || age < 0)
+        return 0;
+
+    return age;
+}
+
+void mrg::Renderer::scissor_to(geom::Rectangle const& area) const
+{
+    if (area.size.width == geom::Width{0} || area.size.height == geom::Height{0})
+    {
+        glScissor(0, 0, 0, 0);
+        return;
+    }
+
+    // Map the scene area through the same transformations as the vertices...
+    auto const to_gl = display_transform * screen_to_gl_coords;
+    float left = 0, right = 0, bottom = 0, top = 0;
+    bool first = true;
+    for (auto const& corner : {area.top_left, area.top_right(),
+                               area.bottom_left(), area.bottom_right()})
+    {
+        auto const clip = to_gl * glm::vec4(corner.x.as_int(), corner.y.as_int(), 0.0f, 1.0f);
+
+        // ...then from normalized device coordinates into window coordinates
+        auto const x = gl_viewport[0] + (clip.x / clip.w + 1.0f) * gl_viewport[2] / 2.0f;
+        auto const y = gl_viewport[1] + (clip.y / clip.w + 1.0f) * gl_viewport[3] / 2.0f;
+
+        left   = first ? x : std::min(left, x);
+        right  = first ? x : std::max(right, x);
+        bottom = first ? y : std::min(bottom, y);
+        top    = first ? y : std::max(top, y);
+        first = false;
+    }
+
+    // Round outwards, as scaling may have left the edges between pixels
+    GLint const x = std::floor(left);
+    GLint const y = std::floor(bottom);
+    glScissor(x, y, std::ceil(right) - x, std::ceil(top) - y);
+}
+
 void mrg::Renderer::draw(mg::Renderable const& renderable,
                           Renderer::Program const& prog) const
 {
-    glUseProgram(prog.id);
+    draw_within(renderable, prog, nullptr);
+}
+
+void mrg::Renderer::draw_within(mg::Renderable const& renderable,
+                                Renderer::Program const& prog,
+                                std::vector<geom::Rectangle> const* scissors) const
+{
+    use_program(prog);
     if (prog.last_used_frameno != frameno)
     {   // Avoid reloading the screen-global uniforms on every renderable
         prog.last_used_frameno = frameno;
+        prog.transform_known = false;
         glUniform1i(prog.tex_uniform, 0);
         glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
                            glm::value_ptr(display_transform));
@@ -236,8 +630,6 @@ void mrg::Renderer::draw(mg::Renderable const& renderable,
                            glm::value_ptr(screen_to_gl_coords));
     }
 
-    glActiveTexture(GL_TEXTURE0);
-
     auto const& rect = renderable.screen_position();
     GLfloat centrex = rect.top_left.x.as_int() +
                       rect.size.width.as_int() / 2.0f;
@@ -245,32 +637,32 @@ void mrg::Renderer::draw(mg::Renderable const& renderable,
                       rect.size.height.as_int() / 2.0f;
     glUniform2f(prog.centre_uniform, centrex, centrey);
 
-    glUniformMatrix4fv(prog.transform_uniform, 1, GL_FALSE,
-                       glm::value_ptr(renderable.transformation()));
+    // Almost every renderable has the identity transformation
+    auto const transformation = renderable.transformation();
+    if (!prog.transform_known || prog.last_transform != transformation)
+    {
+        prog.transform_known = true;
+        prog.last_transform = transformation;
+        glUniformMatrix4fv(prog.transform_uniform, 1, GL_FALSE,
+                           glm::value_ptr(transformation));
+    }
 
     if (prog.alpha_uniform >= 0)
         glUniform1f(prog.alpha_uniform, renderable.alpha());
 
-    glEnableVertexAttribArray(prog.position_attr);
-    glEnableVertexAttribArray(prog.texcoord_attr);
-
-    primitives.clear();
-    tessellate(primitives, renderable);
+    auto const& tessellation = tessellation_of(renderable);
 
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
     {
         auto surface_tex = texture_cache->load(renderable);
 
-        typedef struct  // Represents parameters of glBlendFuncSeparate()
-        {
-            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
-        } BlendSeparate;
-
         BlendSeparate client_blend;
 
         // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped())  // Client is RGBA:
+        // A client that declares its whole RGBA surface opaque gets RGBX
+        // treatment, sparing the blend.
+        if (shaped_as_drawn(renderable) && !opaque_throughout(renderable))  // Client is RGBA:
         {
             client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
@@ -289,50 +681,163 @@ void mrg::Renderer::draw(mg::Renderable const& renderable,
             glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
         }
 
-        for (auto const& p : primitives)
+        auto const draw_primitives = [&]
+            {
+                auto first_vertex = tessellation.first_vertex;
+                for (auto const& p : tessellation.primitives)
+                {
+                    if (p.tex_id == 0)   // The client surface texture
+                    {
+                        set_blend(client_blend);
+                        surface_tex->bind();
+                    }
+                    else   // Some other texture from the shell (e.g. decorations) which
+                    {      // is always RGBA (valid SRC_ALPHA).
+                        set_blend({GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                                   GL_ONE, GL_ONE_MINUS_SRC_ALPHA});
+                        glBindTexture(GL_TEXTURE_2D, p.tex_id);
+                    }
+
+                    glDrawArrays(p.type, first_vertex, p.nvertices);
+                    first_vertex += p.nvertices;
+                }
+            };
+
+        if (!scissors)
         {
-            BlendSeparate blend;
+            draw_primitives();
+            return;
+        }
 
-            if (p.tex_id == 0)   // The client surface texture
-            {
-                blend = client_blend;
-                surface_tex->bind();
-            }
-            else   // Some other texture from the shell (e.g. decorations) which
-            {      // is always RGBA (valid SRC_ALPHA).
-                blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
-                         GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
-                glBindTexture(GL_TEXTURE_2D, p.tex_id);
-            }
+        for (auto const& rect : *scissors)
+        {
+            scissor_to(rect);
+            draw_primitives();
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        report_exception();
+    }
+}
 
-            glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].position);
-            glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].texcoord);
+void mrg::Renderer::reset_gl_state() const
+{
+    current_program = 0;
+    current_attribs = VertexAttribs{-1, -1};
+    blend_known = false;
+    glActiveTexture(GL_TEXTURE0);
+}
 
-            if (blend.dst_rgb == GL_ZERO)
-            {
-                glDisable(GL_BLEND);
-            }
-            else
-            {
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
-                                    blend.src_alpha, blend.dst_alpha);
-            }
+void mrg::Renderer::use_program(Program const& prog) const
+{
+    if (current_program != prog.id)
+    {
+        current_program = prog.id;
+        glUseProgram(prog.id);
+    }
 
-            glDrawArrays(p.type, 0, p.nvertices);
+    // Both programs read the same vertex buffer, so the attribute arrays
+    // only need pointing at it when their locations differ
+    if (current_attribs.position != prog.position_attr ||
+        current_attribs.texcoord != prog.texcoord_attr)
+    {
+        if (current_attribs.position >= 0)
+        {
+            glDisableVertexAttribArray(current_attribs.texcoord);
+            glDisableVertexAttribArray(current_attribs.position);
         }
+
+        current_attribs = VertexAttribs{prog.position_attr, prog.texcoord_attr};
+
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        glEnableVertexAttribArray(prog.position_attr);
+        glEnableVertexAttribArray(prog.texcoord_attr);
+        glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
+                              GL_FALSE, sizeof(mgl::Vertex),
+                              reinterpret_cast<GLvoid const*>(offsetof(mgl::Vertex, position)));
+        glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
+                              GL_FALSE, sizeof(mgl::Vertex),
+                              reinterpret_cast<GLvoid const*>(offsetof(mgl::Vertex, texcoord)));
     }
-    catch (std::exception const& ex)
+}
+
+void mrg::Renderer::set_blend(BlendSeparate const& blend) const
+{
+    bool const enable = blend.dst_rgb != GL_ZERO;
+
+    if (blend_known && current_blend_enabled == enable &&
+        (!enable || (current_blend.src_rgb == blend.src_rgb &&
+                     current_blend.dst_rgb == blend.dst_rgb &&
+                     current_blend.src_alpha == blend.src_alpha &&
+                     current_blend.dst_alpha == blend.dst_alpha)))
     {
-        report_exception();
+        return;
+    }
+
+    if (enable)
+    {
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
+                            blend.src_alpha, blend.dst_alpha);
+    }
+    else
+    {
+        glDisable(GL_BLEND);
     }
 
-    glDisableVertexAttribArray(prog.texcoord_attr);
-    glDisableVertexAttribArray(prog.position_attr);
+    blend_known = true;
+    current_blend_enabled = enable;
+    current_blend = blend;
+}
+
+void mrg::Renderer::stream_vertices(mg::RenderableList const& renderables) const
+{
+    tessellations.clear();
+    frame_vertices.clear();
+
+    for (auto const& r : renderables)
+        add_tessellation(*r);
+
+    upload_vertices();
+}
+
+void mrg::Renderer::add_tessellation(mg::Renderable const& renderable) const
+{
+    auto& tessellation = tessellations[&renderable];
+    tessellation.primitives.clear();
+    tessellate(tessellation.primitives, renderable);
+    tessellation.first_vertex = static_cast<GLint>(frame_vertices.size());
+
+    for (auto const& p : tessellation.primitives)
+        frame_vertices.insert(frame_vertices.end(), p.vertices, p.vertices + p.nvertices);
+}
+
+void mrg::Renderer::upload_vertices() const
+{
+    /*
+     * Respecifying the whole store each frame lets the driver hand out fresh
+     * memory instead of waiting for the GPU to finish with the old vertices.
+     */
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, frame_vertices.size() * sizeof(mgl::Vertex),
+                 frame_vertices.data(), GL_STREAM_DRAW);
+}
+
+mrg::Renderer::Tessellation const& mrg::Renderer::tessellation_of(
+    mg::Renderable const& renderable) const
+{
+    auto found = tessellations.find(&renderable);
+    if (found == tessellations.end())
+    {
+        // Only reached when a subclass draws something it didn't render().
+        // Earlier draws keep the store they were issued with.
+        add_tessellation(renderable);
+        upload_vertices();
+        found = tessellations.find(&renderable);
+    }
+
+    return found->second;
 }
 
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
@@ -411,7 +916,20 @@ void mrg::Renderer::update_gl_viewport()
         GLint offset_y = (buf_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+
+        gl_viewport[0] = offset_x;
+        gl_viewport[1] = offset_y;
+        gl_viewport[2] = reduced_width;
+        gl_viewport[3] = reduced_height;
+        gl_viewport_valid = true;
+    }
+    else
+    {
+        gl_viewport_valid = false;
     }
+
+    // Whatever is in the back buffers was drawn for a different viewport
+    full_repaint_pending = true;
 }
 
 void mrg::Renderer::set_output_transform(glm::mat2 const& t)
@@ -427,5 +945,9 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
 void mrg::Renderer::suspend()
 {
     texture_cache->invalidate();
+
+    // Something else has been scanned out. We can't know what's in the back
+    // buffers any more.
+    full_repaint_pending = true;
 }
 
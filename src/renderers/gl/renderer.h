@@ -23,12 +23,14 @@
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
 #include "mir/renderer/gl/render_target.h"
 
 #include MIR_SERVER_GL_H
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -110,6 +112,8 @@ protected:
        GLint screen_to_gl_coords_uniform = -1;
        GLint alpha_uniform = -1;
        mutable long long last_used_frameno = 0;
+       mutable bool transform_known = false;
+       mutable glm::mat4 last_transform;
 
        Program(GLuint program_id);
     };
@@ -125,11 +129,96 @@ protected:
 private:
     void update_gl_viewport();
 
+    /**
+     * Draws \a renderable as draw() does, but with its uniforms set and its
+     * texture loaded just once for however many \a scissors it's drawn in.
+     * Null \a scissors leaves the scissor test as it is and draws once.
+     */
+    void draw_within(graphics::Renderable const& renderable,
+                     Renderer::Program const& prog,
+                     std::vector<geometry::Rectangle> const* scissors) const;
+
+    /**
+     * Works out what has changed since the last frame and returns the part
+     * of the viewport that is out of date in the current back buffer.
+     */
+    geometry::Rectangle repaint_area(graphics::RenderableList const& renderables) const;
+    unsigned int back_buffer_age() const;
+    void scissor_to(geometry::Rectangle const& area) const;
+
+    struct BlendSeparate  // Represents parameters of glBlendFuncSeparate()
+    {
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+    };
+
+    /*
+     * GL state is only changed when it differs from what was last set this
+     * frame, as each change costs driver time on the compositor thread.
+     */
+    void reset_gl_state() const;
+    void use_program(Program const& prog) const;
+    void set_blend(BlendSeparate const& blend) const;
+
+    struct Tessellation
+    {
+        std::vector<mir::gl::Primitive> primitives;
+        GLint first_vertex; // of primitives[0] in vertex_buffer
+    };
+
+    /*
+     * The vertices of everything drawn in a frame are uploaded to the GPU
+     * together, so draws only refer to them rather than each passing their
+     * own client-side arrays.
+     */
+    void stream_vertices(graphics::RenderableList const& renderables) const;
+    void add_tessellation(graphics::Renderable const& renderable) const;
+    void upload_vertices() const;
+    Tessellation const& tessellation_of(graphics::Renderable const& renderable) const;
+
     std::unique_ptr<mir::gl::TextureCache> const texture_cache;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
-    std::vector<mir::gl::Primitive> mutable primitives;
+    GLuint vertex_buffer = 0;
+    std::vector<mir::gl::Vertex> mutable frame_vertices;
+    std::unordered_map<graphics::Renderable const*, Tessellation> mutable tessellations;
+
+    GLuint mutable current_program = 0;
+    struct VertexAttribs
+    {
+        GLint position;
+        GLint texcoord;
+    };
+    VertexAttribs mutable current_attribs{-1, -1};
+    bool mutable blend_known = false;
+    bool mutable current_blend_enabled = false;
+    BlendSeparate mutable current_blend;
+
+    // How each renderable was last drawn, to tell what it has damaged since
+    struct DrawnRenderable
+    {
+        graphics::BufferID buffer_id;
+        geometry::Rectangle screen_position;
+        glm::mat4 transformation;
+        float alpha;
+        bool shaped;
+        int stacking;
+        geometry::Rectangle bounds;  // of what it drew on screen
+        std::vector<mir::gl::Primitive> primitives;
+    };
+    std::unordered_map<graphics::Renderable::ID, DrawnRenderable> mutable last_drawn;
+
+    // shaped() as sampled for this frame, so every decision about it agrees
+    bool shaped_as_drawn(graphics::Renderable const& renderable) const;
+
+    // Bounding damage of recent frames, newest first
+    static unsigned int const max_tracked_buffer_age = 4;
+    std::deque<geometry::Rectangle> mutable damage_history;
+    bool mutable full_repaint_pending = true;
+
+    bool buffer_age_supported = false;
+    bool gl_viewport_valid = false;
+    GLint gl_viewport[4] = {0, 0, 0, 0};
 };
 
 }
@@ -23,6 +23,7 @@
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/display_buffer.h"
+#include "mir/graphics/overlay_planes.h"
 #include "mir/graphics/buffer.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/renderer/renderer.h"
@@ -79,9 +80,14 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     }
     else
     {
+        // Whatever goes on overlay planes needn't be composited
+        auto const overlay_planes = dynamic_cast<mg::OverlayPlanes*>(&display_buffer);
+        auto const composited = overlay_planes ?
+            overlay_planes->assign_overlay_planes(renderable_list) : renderable_list;
+
         renderer->set_output_transform(display_buffer.transformation());
         renderer->set_viewport(view_area);
-        renderer->render(renderable_list);
+        renderer->render(composited);
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
@@ -19,6 +19,7 @@
 #include "multi_threaded_compositor.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_buffer.h"
+#include "mir/graphics/render_time_estimate.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
 #include "mir/compositor/display_listener.h"
@@ -108,6 +109,8 @@ public:
                     scene->unregister_compositor(std::get<1>(compositor).get());
             });
 
+        auto const render_time_estimate = dynamic_cast<mg::RenderTimeEstimate const*>(&group);
+
         started.set_value();
 
         try
@@ -142,6 +145,17 @@ public:
                     }
                     group.post();
 
+                    if (render_time_estimate)
+                    {
+                        for (auto& compositor : compositors)
+                        {
+                            report->render_time_estimated(
+                                std::get<1>(compositor).get(),
+                                render_time_estimate->last_render_time(),
+                                render_time_estimate->predicted_render_time());
+                        }
+                    }
+
                     /*
                      * "Predictive bypass" optimization: If the last frame was
                      * bypassed/overlayed or you simply have a fast GPU, it is
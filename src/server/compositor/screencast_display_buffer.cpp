@@ -165,9 +165,11 @@ void mc::ScreencastDisplayBuffer::swap_buffers()
 {
     if (current_buffer)
     {
-        //TODO: replace this with a fence which the client could use
-        //to wait for rendering completion
-        glFinish();
+        // Only submit the rendering; don't wait for it. Buffers the GPU
+        // renders to are synchronized by the kernel against the client's
+        // use of them, and those that are read back to memory on commit()
+        // wait for the rendering as part of that.
+        glFlush();
 
         commit();
 
@@ -41,7 +41,8 @@ mc::Stream::Stream(
     arbiter(std::make_shared<mc::MultiMonitorArbiter>(schedule)),
     size(size),
     pf(pf),
-    first_frame_posted(false)
+    first_frame_posted(false),
+    frame_count{0}
 {
 }
 
@@ -55,7 +56,9 @@ void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
     {
         std::lock_guard<decltype(mutex)> lk(mutex); 
         first_frame_posted = true;
+        ++frame_count;
         pf = buffer->pixel_format();
+        latch_opaque_region(buffer, lk);
         schedule->schedule(buffer);
     }
     observers.frame_posted(1, buffer->size());
@@ -164,6 +167,43 @@ bool mc::Stream::has_submitted_buffer() const
     return first_frame_posted;
 }
 
+uint64_t mc::Stream::frames_submitted() const
+{
+    return frame_count;
+}
+
 void mc::Stream::set_scale(float)
 {
 }
+
+void mc::Stream::set_opaque_region(std::vector<geom::Rectangle> const& region)
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    opaque_region_ = region;
+}
+
+std::vector<geom::Rectangle> mc::Stream::opaque_region(mg::Buffer const& buffer) const
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+
+    auto const submitted = submitted_regions.find(buffer.id());
+    if (submitted == submitted_regions.end())
+        return {};
+
+    return submitted->second.region;
+}
+
+void mc::Stream::latch_opaque_region(
+    std::shared_ptr<mg::Buffer> const& buffer, std::lock_guard<std::mutex> const&)
+{
+    // Buffers nothing holds any more can't be shown again
+    for (auto i = submitted_regions.begin(); i != submitted_regions.end();)
+    {
+        if (i->second.buffer.expired())
+            i = submitted_regions.erase(i);
+        else
+            ++i;
+    }
+
+    submitted_regions[buffer->id()] = {buffer, opaque_region_};
+}
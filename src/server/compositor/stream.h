@@ -26,6 +26,8 @@
 #include "mir/lockable_callback.h"
 #include "mir/geometry/size.h"
 #include "multi_monitor_arbiter.h"
+#include <atomic>
+#include <map>
 #include <mutex>
 #include <memory>
 #include <set>
@@ -56,11 +58,15 @@ public:
     int buffers_ready_for_compositor(void const* user_id) const override;
     void drop_old_buffers() override;
     bool has_submitted_buffer() const override;
+    uint64_t frames_submitted() const override;
     void set_scale(float scale) override;
+    void set_opaque_region(std::vector<geometry::Rectangle> const& region) override;
+    std::vector<geometry::Rectangle> opaque_region(graphics::Buffer const& buffer) const override;
 
 private:
     enum class ScheduleMode;
     void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    void latch_opaque_region(std::shared_ptr<graphics::Buffer> const& buffer, std::lock_guard<std::mutex> const&);
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
@@ -69,6 +75,17 @@ private:
     geometry::Size size; 
     MirPixelFormat pf;
     bool first_frame_posted;
+    // Only changed under mutex, but readable without it (from with_most_recent_buffer_do())
+    std::atomic<uint64_t> frame_count;
+    std::vector<geometry::Rectangle> opaque_region_; // for buffers submitted from now on
+
+    // The region each buffer the client may still have us show was submitted with
+    struct SubmittedRegion
+    {
+        std::weak_ptr<graphics::Buffer> buffer;
+        std::vector<geometry::Rectangle> region;
+    };
+    std::map<graphics::BufferID, SubmittedRegion> submitted_regions;
 
     scene::SurfaceObservers observers;
 };
@@ -30,10 +30,28 @@
 #include "mir/options/configuration.h"
 #include "mir/options/option.h"
 
+#include <algorithm>
+
 namespace mf = mir::frontend;
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
 
+namespace
+{
+int ipc_threads(mir::options::Option const& options)
+{
+    if (options.is_set(mir::options::frontend_threads_opt))
+    {
+        auto const requested = options.get<int>(mir::options::frontend_threads_opt);
+        if (requested > 0)
+            return requested;
+    }
+
+    // Beyond a few threads, clients spend their time waiting on shared locks instead
+    return std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+}
+}
+
 std::shared_ptr<mf::ConnectionCreator>
 mir::DefaultServerConfiguration::the_connection_creator()
 {
@@ -58,6 +76,7 @@ mir::DefaultServerConfiguration::the_connector()
             {
                 return std::make_shared<mf::BasicConnector>(
                     the_connection_creator(),
+                    ipc_threads(*the_options()),
                     the_connector_report());
             }
             else
@@ -65,6 +84,7 @@ mir::DefaultServerConfiguration::the_connector()
                 auto const result = std::make_shared<mf::PublishedSocketConnector>(
                     the_socket_file(),
                     the_connection_creator(),
+                    ipc_threads(*the_options()),
                     *the_emergency_cleanup(),
                     the_connector_report());
 
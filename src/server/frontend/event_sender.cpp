@@ -56,7 +56,7 @@ void mfd::EventSender::handle_event(MirEvent const& e)
     // containing other responses, but for now we send them individually.
     mp::EventSequence seq;
     mp::Event *ev = seq.add_event();
-    ev->set_raw(MirEvent::serialize(&e));
+    MirEvent::serialize(&e, *ev->mutable_raw());
 
     send_event_sequence(seq, {});
 }
@@ -167,6 +167,7 @@ void mfd::EventSender::send_buffer(mp::EventSequence& seq, graphics::Buffer& buf
     mfd::ProtobufBufferPacker request_msg{const_cast<mir::protobuf::Buffer*>(request->mutable_buffer())};
     buffer_packer->pack_buffer(request_msg, buffer, type);
 
+    // The buffer keeps these open; the messenger dups any it has to queue
     std::vector<mir::Fd> set;
     for(auto& fd : request->buffer().fd())
         set.emplace_back(mir::Fd(IntOwnedFd{fd}));
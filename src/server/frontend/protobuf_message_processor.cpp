@@ -23,11 +23,13 @@
 #include "mir/frontend/protobuf_message_sender.h"
 #include "mir/frontend/template_protobuf_message_processor.h"
 #include <mir/protobuf/display_server_debug.h>
+#include "mir/protobuf/method_ids.h"
 #include "mir/client_visible_error.h"
 
 #include "mir_protobuf_wire.pb.h"
 
 namespace mfd = mir::frontend::detail;
+namespace mp = mir::protobuf;
 
 namespace
 {
@@ -169,7 +171,14 @@ void invoke(
 
 const std::string& mfd::Invocation::method_name() const
 {
-    return invocation.method_name();
+    return mp::method_name_of(invocation);
+}
+
+mp::MethodId mfd::Invocation::method_id() const
+{
+    if (invocation.has_method_id())
+        return static_cast<mp::MethodId>(invocation.method_id());
+    return mp::method_id_for(invocation.method_name());
 }
 
 const std::string& mfd::Invocation::parameters() const
@@ -197,37 +206,33 @@ bool mfd::ProtobufMessageProcessor::dispatch(
 
     try
     {
-        // TODO comparing strings in an if-else chain isn't efficient.
-        // It is probably possible to generate a Trie at compile time.
-        if ("connect" == invocation.method_name())
+        switch (invocation.method_id())
         {
+        case mp::MethodId::connect:
             invoke(this, display_server.get(), &DisplayServer::connect, invocation);
-        }
-        else if ("create_surface" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::create_surface:
             invoke(this, display_server.get(), &DisplayServer::create_surface, invocation);
-        }
-        else if ("submit_buffer" == invocation.method_name())
+            break;
+        case mp::MethodId::submit_buffer:
         {
             auto request = parse_parameter<mir::protobuf::BufferRequest>(invocation);
             request.mutable_buffer()->clear_fd();
             for (auto& fd : side_channel_fds)
                 request.mutable_buffer()->add_fd(fd);
             invoke(shared_from_this(), display_server.get(), &DisplayServer::submit_buffer, invocation.id(), &request);
+            break;
         }
-        else if ("allocate_buffers" == invocation.method_name())
-        {
+        case mp::MethodId::allocate_buffers:
             invoke(this, display_server.get(), &DisplayServer::allocate_buffers, invocation);
-        }
-        else if ("release_buffers" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::release_buffers:
             invoke(this, display_server.get(), &DisplayServer::release_buffers, invocation);
-        }
-        else if ("release_surface" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::release_surface:
             invoke(this, display_server.get(), &DisplayServer::release_surface, invocation);
-        }
-        else if ("platform_operation" == invocation.method_name())
+            break;
+        case mp::MethodId::platform_operation:
         {
             auto request = parse_parameter<mir::protobuf::PlatformOperationMessage>(invocation);
 
@@ -237,86 +242,67 @@ bool mfd::ProtobufMessageProcessor::dispatch(
 
             invoke(shared_from_this(), display_server.get(), &DisplayServer::platform_operation,
                    invocation.id(), &request);
+            break;
         }
-        else if ("configure_display" == invocation.method_name())
-        {
+        case mp::MethodId::configure_display:
             invoke(this, display_server.get(), &DisplayServer::configure_display, invocation);
-        }
-        else if ("remove_session_configuration" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::remove_session_configuration:
             invoke(this, display_server.get(), &DisplayServer::remove_session_configuration, invocation);
-        }
-        else if ("set_base_display_configuration" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::set_base_display_configuration:
             invoke(this, display_server.get(), &DisplayServer::set_base_display_configuration, invocation);
-        }
-        else if ("configure_surface" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::configure_surface:
             invoke(this, display_server.get(), &DisplayServer::configure_surface, invocation);
-        }
-        else if ("modify_surface" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::modify_surface:
             invoke(this, display_server.get(), &DisplayServer::modify_surface, invocation);
-        }
-        else if ("create_screencast" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::create_screencast:
             invoke(this, display_server.get(), &DisplayServer::create_screencast, invocation);
-        }
-        else if ("screencast_buffer" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::screencast_buffer:
             invoke(this, display_server.get(), &DisplayServer::screencast_buffer, invocation);
-        }
-        else if ("screencast_to_buffer" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::screencast_to_buffer:
             invoke(this, display_server.get(), &DisplayServer::screencast_to_buffer, invocation);
-        }
-        else if ("release_screencast" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::release_screencast:
             invoke(this, display_server.get(), &DisplayServer::release_screencast, invocation);
-        }
-        else if ("create_buffer_stream" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::create_buffer_stream:
             invoke(this, display_server.get(), &DisplayServer::create_buffer_stream, invocation);
-        }
-        else if ("release_buffer_stream" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::release_buffer_stream:
             invoke(this, display_server.get(), &DisplayServer::release_buffer_stream, invocation);
-        }
-        else if ("configure_cursor" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::configure_cursor:
             invoke(this, display_server.get(), &protobuf::DisplayServer::configure_cursor, invocation);
-        }
-        else if ("new_fds_for_prompt_providers" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::new_fds_for_prompt_providers:
             invoke(this, display_server.get(), &protobuf::DisplayServer::new_fds_for_prompt_providers, invocation);
-        }
-        else if ("start_prompt_session" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::start_prompt_session:
             invoke(this, display_server.get(), &protobuf::DisplayServer::start_prompt_session, invocation);
-        }
-        else if ("stop_prompt_session" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::stop_prompt_session:
             invoke(this, display_server.get(), &protobuf::DisplayServer::stop_prompt_session, invocation);
-        }
-        else if ("request_operation" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::request_operation:
             invoke(this, display_server.get(), &protobuf::DisplayServer::request_operation, invocation);
-        }
-        else if ("disconnect" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::disconnect:
             invoke(this, display_server.get(), &DisplayServer::disconnect, invocation);
             result = false;
-        }
-        else if ("pong" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::pong:
             invoke(this, display_server.get(), &DisplayServer::pong, invocation);
-        }
-        else if ("configure_buffer_stream" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::configure_buffer_stream:
             invoke(this, display_server.get(), &DisplayServer::configure_buffer_stream, invocation);
-        }
-        else if ("translate_surface_to_screen" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::translate_surface_to_screen:
             try
             {
                 auto debug_interface = dynamic_cast<mir::protobuf::DisplayServerDebug*>(display_server.get());
@@ -332,35 +318,29 @@ bool mfd::ProtobufMessageProcessor::dispatch(
                 std::runtime_error err{"Client attempted to use unavailable debug interface"};
                 report->exception_handled(display_server.get(), invocation.id(), err);
             }
-        }
-        else if ("request_persistent_surface_id" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::request_persistent_surface_id:
             invoke(this, display_server.get(), &protobuf::DisplayServer::request_persistent_surface_id, invocation);
-        }
-        else if ("preview_base_display_configuration" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::preview_base_display_configuration:
             invoke(this, display_server.get(), &protobuf::DisplayServer::preview_base_display_configuration, invocation);
-        }
-        else if ("confirm_base_display_configuration" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::confirm_base_display_configuration:
             invoke(this, display_server.get(), &protobuf::DisplayServer::confirm_base_display_configuration, invocation);
-        }
-        else if ("cancel_base_display_configuration_preview" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::cancel_base_display_configuration_preview:
             invoke(this, display_server.get(), &protobuf::DisplayServer::cancel_base_display_configuration_preview, invocation);
-        }
-        else if ("apply_input_configuration" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::apply_input_configuration:
             invoke(this, display_server.get(), &protobuf::DisplayServer::apply_input_configuration, invocation);
-        }
-        else if ("set_base_input_configuration" == invocation.method_name())
-        {
+            break;
+        case mp::MethodId::set_base_input_configuration:
             invoke(this, display_server.get(), &protobuf::DisplayServer::set_base_input_configuration, invocation);
-        }
-        else
-        {
+            break;
+        default:
             report->unknown_method(display_server.get(), invocation.id(), invocation.method_name());
             result = false;
+            break;
         }
     }
     catch (std::exception const& error)
@@ -391,6 +371,8 @@ void mfd::ProtobufMessageProcessor::send_response(::google::protobuf::uint32 id,
 
 void mfd::ProtobufMessageProcessor::send_response(::google::protobuf::uint32 id, mir::protobuf::Connection* response)
 {
+    response->set_accepts_method_ids(true);
+
     if (response->has_platform())
         sender->send_response(id, response, {extract_fds_from(response->mutable_platform())});
     else
@@ -30,6 +30,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 
@@ -119,14 +120,34 @@ std::shared_ptr<boost::asio::local::stream_protocol::socket> make_socket_self_co
         holder,
         holder->socket.get());
 }
+
+std::vector<std::shared_ptr<boost::asio::io_service>> make_io_services(int count)
+{
+    std::vector<std::shared_ptr<boost::asio::io_service>> services;
+
+    for (auto i = 0; i < std::max(count, 1); ++i)
+        services.push_back(std::make_shared<boost::asio::io_service>());
+
+    return services;
+}
+}
+
+mf::PublishedSocketConnector::PublishedSocketConnector(
+    const std::string& socket_file,
+    std::shared_ptr<ConnectionCreator> const& connection_creator,
+    EmergencyCleanupRegistry& emergency_cleanup_registry,
+    std::shared_ptr<ConnectorReport> const& report)
+:   PublishedSocketConnector(socket_file, connection_creator, 1, emergency_cleanup_registry, report)
+{
 }
 
 mf::PublishedSocketConnector::PublishedSocketConnector(
     const std::string& socket_file,
     std::shared_ptr<ConnectionCreator> const& connection_creator,
+    int threads,
     EmergencyCleanupRegistry& emergency_cleanup_registry,
     std::shared_ptr<ConnectorReport> const& report)
-:   BasicConnector(connection_creator, report),
+:   BasicConnector(connection_creator, threads, report),
     socket_file(remove_if_stale(socket_file)),
     acceptor(*io_service, socket_file)
 {
@@ -144,19 +165,22 @@ void mf::PublishedSocketConnector::start_accept()
 {
     report->listening_on(socket_file);
 
-    auto socket = std::make_shared<boost::asio::local::stream_protocol::socket>(*io_service);
+    // The new connection is served by its own share of the IPC threads
+    auto const& socket_service = next_io_service();
+    auto socket = std::make_shared<boost::asio::local::stream_protocol::socket>(*socket_service);
 
     acceptor.async_accept(
         *socket,
         [
             this,
             socket,
-            maybe_service = std::weak_ptr<boost::asio::io_service>(io_service)
+            maybe_service = std::weak_ptr<boost::asio::io_service>(socket_service)
         ](boost::system::error_code const& ec)
         {
             /*
              * This functor lives on a queue in the io_service. If we capture a strong
-             * reference to the io_service, we'll have a reference cycle.
+             * reference to the io_service (which can be the acceptor's), we'll have a
+             * reference cycle.
              *
              * Neither io_service::reset() nor acceptor.close() appear to cause the
              * destruction of the functor, so just take a weak reference to the
@@ -185,23 +209,34 @@ void mf::PublishedSocketConnector::on_new_connection(
 mf::BasicConnector::BasicConnector(
     std::shared_ptr<ConnectionCreator> const& connection_creator,
     std::shared_ptr<ConnectorReport> const& report)
-:   io_service(std::make_shared<boost::asio::io_service>()),
-    work(*io_service),
+:   BasicConnector(connection_creator, 1, report)
+{
+}
+
+mf::BasicConnector::BasicConnector(
+    std::shared_ptr<ConnectionCreator> const& connection_creator,
+    int threads,
+    std::shared_ptr<ConnectorReport> const& report)
+:   io_services(make_io_services(threads)),
+    io_service(io_services.front()),
     report(report),
-    connection_creator{connection_creator}
+    connection_creator{connection_creator},
+    next_connection{0}
 {
+    for (auto const& service : io_services)
+        work.emplace_back(*service);
 }
 
 void mf::BasicConnector::start()
 {
-    auto run_io_service = [this]
+    auto run_io_service = [this](std::shared_ptr<boost::asio::io_service> const& service)
     {
         mir::set_thread_name("Mir/IPC");
         while (true)
         try
         {
             report->thread_start();
-            io_service->run();
+            service->run();
             report->thread_end();
             return;
         }
@@ -211,20 +246,32 @@ void mf::BasicConnector::start()
         }
     };
 
-    io_service_thread = std::thread(run_io_service);
+    for (auto const& service : io_services)
+        io_service_threads.emplace_back(run_io_service, service);
 }
 
 void mf::BasicConnector::stop()
 {
     /* Stop processing new requests */
-    io_service->stop();
+    for (auto const& service : io_services)
+        service->stop();
 
-    /* Wait for io processing thread to finish */
-    if (io_service_thread.joinable())
-        io_service_thread.join();
+    /* Wait for io processing threads to finish */
+    for (auto& thread : io_service_threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    io_service_threads.clear();
 
     /* Prepare for a potential restart */
-    io_service->reset();
+    for (auto const& service : io_services)
+        service->reset();
+}
+
+std::shared_ptr<boost::asio::io_service> const& mf::BasicConnector::next_io_service() const
+{
+    return io_services[next_connection++ % io_services.size()];
 }
 
 void mf::BasicConnector::create_session_for(
@@ -258,14 +305,15 @@ int mf::BasicConnector::client_socket_fd(std::function<void(std::shared_ptr<Sess
                 std::runtime_error("Could not create socket pair")) << boost::errinfo_errno(errno));
     }
 
+    auto const& socket_service = next_io_service();
     auto const server_socket = std::make_shared<boost::asio::local::stream_protocol::socket>(
-        *io_service,
+        *socket_service,
         boost::asio::local::stream_protocol(),
         socket_fd[server]);
 
     report->creating_socket_pair(socket_fd[server], socket_fd[client]);
 
-    create_session_for(make_socket_self_contained(io_service, server_socket), connect_handler);
+    create_session_for(make_socket_self_contained(socket_service, server_socket), connect_handler);
 
     return socket_fd[client];
 }
@@ -23,9 +23,11 @@
 
 #include <boost/asio.hpp>
 
+#include <atomic>
 #include <thread>
 #include <string>
 #include <functional>
+#include <vector>
 
 namespace google
 {
@@ -44,13 +46,24 @@ namespace frontend
 class ConnectionCreator;
 class ConnectorReport;
 
-/// provides a client-side socket fd for each connection
+/**
+ * Provides a client-side socket fd for each connection.
+ *
+ * Connections are shared out between a number of IPC threads, each running
+ * an io_service of its own. Everything to do with a connection happens on
+ * the thread it was given, so its messages are still handled in order, but
+ * a slow request only holds up the clients sharing its thread.
+ */
 class BasicConnector : public Connector
 {
 public:
     explicit BasicConnector(
         std::shared_ptr<ConnectionCreator> const& connection_creator,
         std::shared_ptr<ConnectorReport> const& report);
+    BasicConnector(
+        std::shared_ptr<ConnectionCreator> const& connection_creator,
+        int threads,
+        std::shared_ptr<ConnectorReport> const& report);
     ~BasicConnector() noexcept;
     void start() override;
     void stop() override;
@@ -62,13 +75,19 @@ protected:
         std::shared_ptr<boost::asio::local::stream_protocol::socket> const& server_socket,
         std::function<void(std::shared_ptr<Session> const& session)> const& connect_handler) const;
 
-    std::shared_ptr<boost::asio::io_service> const io_service;
-    boost::asio::io_service::work work;
+    /// The io_service for the next connection to be made
+    std::shared_ptr<boost::asio::io_service> const& next_io_service() const;
+
+    std::vector<std::shared_ptr<boost::asio::io_service>> const io_services;
+    /// Where connections are accepted
+    std::shared_ptr<boost::asio::io_service> const& io_service;
+    std::vector<boost::asio::io_service::work> work;
     std::shared_ptr<ConnectorReport> const report;
 
 private:
-    std::thread io_service_thread;
+    std::vector<std::thread> io_service_threads;
     std::shared_ptr<ConnectionCreator> const connection_creator;
+    std::atomic<unsigned int> mutable next_connection;
 };
 
 /// Accept connections over a published socket
@@ -80,6 +99,12 @@ public:
         std::shared_ptr<ConnectionCreator> const& connection_creator,
         EmergencyCleanupRegistry& emergency_cleanup_registry,
         std::shared_ptr<ConnectorReport> const& report);
+    PublishedSocketConnector(
+        const std::string& socket_file,
+        std::shared_ptr<ConnectionCreator> const& connection_creator,
+        int threads,
+        EmergencyCleanupRegistry& emergency_cleanup_registry,
+        std::shared_ptr<ConnectorReport> const& report);
     ~PublishedSocketConnector() noexcept;
 
 private:
@@ -64,6 +64,34 @@ void mfd::SocketConnection::read_next_message()
 }
 
 void mfd::SocketConnection::on_read_size(const boost::system::error_code& error)
+{
+    if (read_body(error))
+        read_queued_messages();
+}
+
+void mfd::SocketConnection::on_new_message(const boost::system::error_code& error)
+{
+    if (handle_message(error))
+        read_queued_messages();
+}
+
+void mfd::SocketConnection::read_queued_messages()
+{
+    // Messages that arrived together are read straight away, rather than
+    // each waiting for another trip through the io_service
+    for (auto i = 0; i != max_queued_messages; ++i)
+    {
+        if (message_receiver->available_bytes() < header_size)
+            break;
+
+        if (!read_body(message_receiver->receive_msg(ba::buffer(header, header_size))))
+            return;
+    }
+
+    read_next_message();
+}
+
+bool mfd::SocketConnection::read_body(const boost::system::error_code& error)
 {
     if (error)
     {
@@ -79,17 +107,18 @@ void mfd::SocketConnection::on_read_size(const boost::system::error_code& error)
 
     if (message_receiver->available_bytes() >= body_size)
     {
-        on_new_message(message_receiver->receive_msg(ba::buffer(body)));
+        return handle_message(message_receiver->receive_msg(ba::buffer(body)));
     }
     else
     {
         auto callback = std::bind(&mfd::SocketConnection::on_new_message,
                                   this, std::placeholders::_1);
         message_receiver->async_receive_msg(callback, ba::buffer(body));
+        return false;
     }
 }
 
-void mfd::SocketConnection::on_new_message(const boost::system::error_code& error)
+bool mfd::SocketConnection::handle_message(const boost::system::error_code& error)
 try
 {
     if (error)
@@ -122,11 +151,12 @@ try
 
     if (processor->dispatch(invocation, fds))
     {
-        read_next_message();
+        return true;
     }
     else
     {
         connections->remove(id());
+        return false;
     }
 }
 catch (std::exception& e)
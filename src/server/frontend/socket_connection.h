@@ -55,12 +55,21 @@ private:
     void on_new_message(const boost::system::error_code& ec);
     void on_read_size(const boost::system::error_code& ec);
 
+    /// Handles messages already waiting on the socket, then waits for the next
+    void read_queued_messages();
+    /// \returns true if the message was handled (and the connection is still wanted)
+    bool read_body(boost::system::error_code const& ec);
+    /// \returns true if the message was handled (and the connection is still wanted)
+    bool handle_message(boost::system::error_code const& ec);
+
     std::shared_ptr<MessageReceiver> const message_receiver;
     int const id_;
     std::shared_ptr<Connections<SocketConnection>> const connections;
     std::shared_ptr<MessageProcessor> processor;
 
     static size_t const header_size = 2;
+    // Enough to catch up with a burst, but not to starve the other connections on our thread
+    static int const max_queued_messages = 16;
     char header[header_size];
     std::vector<char> body;
 
@@ -17,8 +17,6 @@
  */
 
 #include "socket_messenger.h"
-#include "mir/frontend/client_constants.h"
-#include "mir/variable_length_array.h"
 #include "mir/fd_socket_transmission.h"
 #include "mir/raii.h"
 
@@ -26,23 +24,277 @@
 
 #include <errno.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <deque>
+#include <mutex>
 #include <stdexcept>
+#include <system_error>
 
 namespace mf = mir::frontend;
 namespace mfd = mf::detail;
 namespace bs = boost::system;
 namespace ba = boost::asio;
 
+namespace
+{
+// A client this far behind isn't going to catch up, and we won't buffer for it forever
+size_t const max_queued_bytes{1024 * 1024};
+// Queued fds are held open in the server until sent, so they're bounded separately
+size_t const max_queued_fds{128};
+
+/// The caller may close its fds once send() returns, so a queued set needs its own
+std::vector<mir::Fd> duplicate(std::vector<mir::Fd> const& fds)
+{
+    std::vector<mir::Fd> duplicates;
+    duplicates.reserve(fds.size());
+    for (auto const& fd : fds)
+    {
+        auto const copy = dup(fd);
+        if (copy < 0)
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to duplicate fd to send"));
+        duplicates.emplace_back(copy);
+    }
+    return duplicates;
+}
+
+/// Bytes sent, which is fewer than asked for if the socket is full
+size_t send_without_blocking(int socket, iovec* iov, size_t iov_count)
+{
+    msghdr header{};
+    header.msg_iov = iov;
+    header.msg_iovlen = iov_count;
+
+    ssize_t sent;
+    do
+    {
+        sent = sendmsg(socket, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+    while (sent < 0 && mir::socket_error_is_transient(errno));
+
+    if (sent < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to send message"));
+    }
+
+    return sent;
+}
+
+/// False if the socket is full. The fds go with a byte of their own, as mir::send_fds() sends them
+bool send_fds_without_blocking(int socket, std::vector<mir::Fd> const& fds)
+{
+    if (fds.empty())
+        return true;
+
+    char dummy_iov_data = 'M';
+    iovec iov{&dummy_iov_data, 1};
+
+    auto const fds_bytes = fds.size() * sizeof(int);
+    std::vector<char> control(CMSG_SPACE(fds_bytes), 0);
+
+    msghdr header{};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_control = control.data();
+    header.msg_controllen = control.size();
+
+    auto const message = CMSG_FIRSTHDR(&header);
+    message->cmsg_len = CMSG_LEN(fds_bytes);
+    message->cmsg_level = SOL_SOCKET;
+    message->cmsg_type = SCM_RIGHTS;
+
+    auto data = reinterpret_cast<int*>(CMSG_DATA(message));
+    for (auto const& fd : fds)
+        *data++ = fd;
+
+    ssize_t sent;
+    do
+    {
+        sent = sendmsg(socket, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+    while (sent < 0 && mir::socket_error_is_transient(errno));
+
+    if (sent < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return false;
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to send fds"));
+    }
+
+    return true;
+}
+}
+
+/*
+ * Messages are sent straight away while the client keeps up. Once the
+ * socket fills, what's left of the message (and everything after it) is
+ * queued and sent in order from the io_service when the socket drains.
+ */
+class mfd::SocketMessenger::Outbox : public std::enable_shared_from_this<Outbox>
+{
+public:
+    Outbox(std::shared_ptr<ba::local::stream_protocol::socket> const& socket)
+        : socket{socket}
+    {
+    }
+
+    void send(char const* data, size_t length, FdSets const& fd_sets)
+    {
+        unsigned char header[] =
+        {
+            static_cast<unsigned char>((length >> 8) & 0xff),
+            static_cast<unsigned char>((length >> 0) & 0xff)
+        };
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        size_t sent{0};
+        if (queue.empty())
+        {
+            iovec iov[] = {{header, sizeof header}, {const_cast<char*>(data), length}};
+            sent = send_without_blocking(socket->native_handle(), iov, 2);
+        }
+
+        if (sent < sizeof header + length)
+        {
+            Item item;
+            item.bytes.reserve(sizeof header + length - sent);
+            if (sent < sizeof header)
+                item.bytes.insert(item.bytes.end(), header + sent, header + sizeof header);
+            auto const data_sent = sent > sizeof header ? sent - sizeof header : 0;
+            item.bytes.insert(item.bytes.end(), data + data_sent, data + length);
+            enqueue(std::move(item));
+        }
+
+        for (auto const& fds : fd_sets)
+        {
+            if (!queue.empty() || !send_fds_without_blocking(socket->native_handle(), fds))
+            {
+                Item item;
+                item.fds = duplicate(fds);
+                enqueue(std::move(item));
+            }
+        }
+
+        if (queued_bytes > max_queued_bytes || queued_fds > max_queued_fds)
+        {
+            queue.clear();
+            queued_bytes = 0;
+            queued_fds = 0;
+            bs::error_code ignored;
+            socket->shutdown(ba::socket_base::shutdown_both, ignored);
+            BOOST_THROW_EXCEPTION(std::runtime_error("Client is not reading its messages"));
+        }
+
+        if (!queue.empty() && !waiting)
+            wait_for_socket();
+    }
+
+private:
+    /// Either some bytes of a message or a set of fds
+    struct Item
+    {
+        std::vector<char> bytes;
+        size_t sent{0};
+        std::vector<mir::Fd> fds;
+    };
+
+    void enqueue(Item&& item)
+    {
+        queued_bytes += item.fds.empty() ? item.bytes.size() : 1;
+        queued_fds += item.fds.size();
+        queue.push_back(std::move(item));
+    }
+
+    void send_queued()
+    {
+        while (!queue.empty())
+        {
+            auto& item = queue.front();
+            if (item.fds.empty())
+            {
+                iovec iov{item.bytes.data() + item.sent, item.bytes.size() - item.sent};
+                auto const sent = send_without_blocking(socket->native_handle(), &iov, 1);
+                item.sent += sent;
+                queued_bytes -= sent;
+                if (item.sent < item.bytes.size())
+                    return;
+            }
+            else
+            {
+                if (!send_fds_without_blocking(socket->native_handle(), item.fds))
+                    return;
+                queued_bytes -= 1;
+                queued_fds -= item.fds.size();
+            }
+            queue.pop_front();
+        }
+    }
+
+    void wait_for_socket()
+    {
+        waiting = true;
+        std::weak_ptr<Outbox> const weak_this{shared_from_this()};
+        socket->async_write_some(ba::null_buffers(),
+            [weak_this](bs::error_code const& error, size_t)
+            {
+                if (auto const self = weak_this.lock())
+                    self->on_socket_ready(error);
+            });
+    }
+
+    void on_socket_ready(bs::error_code const& error)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        waiting = false;
+
+        bool client_gone = static_cast<bool>(error);
+        if (!client_gone)
+        {
+            try
+            {
+                send_queued();
+            }
+            catch (std::exception const&)
+            {
+                client_gone = true;
+            }
+        }
+
+        // The connection notices a departed client for itself, we just stop sending
+        if (client_gone)
+        {
+            queue.clear();
+            queued_bytes = 0;
+            queued_fds = 0;
+        }
+        else if (!queue.empty())
+        {
+            wait_for_socket();
+        }
+    }
+
+    std::shared_ptr<ba::local::stream_protocol::socket> const socket;
+
+    std::mutex mutex;
+    std::deque<Item> queue;
+    size_t queued_bytes{0};
+    size_t queued_fds{0};
+    bool waiting{false};
+};
+
 mfd::SocketMessenger::SocketMessenger(std::shared_ptr<ba::local::stream_protocol::socket> const& socket)
     : socket(socket),
-      socket_fd{IntOwnedFd{socket->native_handle()}}
+      socket_fd{IntOwnedFd{socket->native_handle()}},
+      outbox{std::make_shared<Outbox>(socket)}
 {
-    // Make the socket non-blocking to avoid hanging the server when a client
-    // is unresponsive. Also increase the send buffer size to 64KiB to allow
-    // more leeway for transient client freezes.
+    // Never block the server on a client: what the socket can't take yet
+    // waits in the outbox. A larger send buffer just means it waits less.
     // See https://bugs.launchpad.net/mir/+bug/1350207
-    // TODO: Rework the messenger to support asynchronous sends
     socket->non_blocking(true);
     boost::asio::socket_base::send_buffer_size option(64*1024);
     socket->set_option(option);
@@ -73,24 +325,9 @@ mf::SessionCredentials mfd::SocketMessenger::client_creds()
 
 void mfd::SocketMessenger::send(char const* data, size_t length, FdSets const& fd_set)
 {
-    static size_t const header_size{2};
-    mir::VariableLengthArray<mf::serialization_buffer_size> whole_message{header_size + length};
-
-    whole_message.data()[0] = static_cast<unsigned char>((length >> 8) & 0xff);
-    whole_message.data()[1] = static_cast<unsigned char>((length >> 0) & 0xff);
-    std::copy(data, data + length, whole_message.data() + header_size);
-
-    std::unique_lock<std::mutex> lg(message_lock);
-
-    // TODO: This should be asynchronous, but we are not making sure
-    // that a potential call to send_fds is executed _after_ this
-    // function has completed (if it would be executed asynchronously.
-    // NOTE: we rely on this synchronous behavior as per the comment in
-    // mf::SessionMediator::create_surface
-    ba::write(*socket, ba::buffer(whole_message.data(), whole_message.size()));
-
-    for (auto const& fds : fd_set)
-        mir::send_fds(socket_fd, fds);
+    // Everything goes through the outbox in order, so fds still follow
+    // their message (as mf::SessionMediator::create_surface relies on)
+    outbox->send(data, length, fd_set);
 }
 
 void mfd::SocketMessenger::async_receive_msg(
@@ -21,7 +21,7 @@
 #include "message_sender.h"
 #include "message_receiver.h"
 #include "mir/frontend/session_credentials.h"
-#include <mutex>
+#include <memory>
 
 namespace mir
 {
@@ -48,10 +48,13 @@ private:
     void update_session_creds();
     SessionCredentials creator_creds() const;
 
+    /// Holds whatever the client isn't ready for, and sends it when it is
+    class Outbox;
+
     std::shared_ptr<boost::asio::local::stream_protocol::socket> socket;
     mir::Fd socket_fd;
 
-    std::mutex message_lock;
+    std::shared_ptr<Outbox> const outbox;
     SessionCredentials session_creds{0, 0, 0};
 };
 }
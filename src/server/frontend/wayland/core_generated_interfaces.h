@@ -61,6 +61,8 @@ protected:
 
     virtual void create_surface(struct wl_client* client, struct wl_resource* resource, uint32_t id) = 0;
     virtual void create_region(struct wl_client* client, struct wl_resource* resource, uint32_t id) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
 
 private:
     static void create_surface_thunk(struct wl_client* client, struct wl_resource* resource, uint32_t id)
@@ -108,6 +110,7 @@ private:
             BOOST_THROW_EXCEPTION((std::bad_alloc{}));
         }
         wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
     }
 
     uint32_t const max_version;
@@ -225,6 +228,8 @@ protected:
     virtual ~Shm() = default;
 
     virtual void create_pool(struct wl_client* client, struct wl_resource* resource, uint32_t id, mir::Fd fd, int32_t size) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
 
 private:
     static void create_pool_thunk(struct wl_client* client, struct wl_resource* resource, uint32_t id, int fd, int32_t size)
@@ -256,6 +261,7 @@ private:
             BOOST_THROW_EXCEPTION((std::bad_alloc{}));
         }
         wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
     }
 
     uint32_t const max_version;
@@ -661,6 +667,8 @@ protected:
 
     virtual void create_data_source(struct wl_client* client, struct wl_resource* resource, uint32_t id) = 0;
     virtual void get_data_device(struct wl_client* client, struct wl_resource* resource, uint32_t id, struct wl_resource* seat) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
 
 private:
     static void create_data_source_thunk(struct wl_client* client, struct wl_resource* resource, uint32_t id)
@@ -708,6 +716,7 @@ private:
             BOOST_THROW_EXCEPTION((std::bad_alloc{}));
         }
         wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
     }
 
     uint32_t const max_version;
@@ -736,6 +745,8 @@ protected:
     virtual ~Shell() = default;
 
     virtual void get_shell_surface(struct wl_client* client, struct wl_resource* resource, uint32_t id, struct wl_resource* surface) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
 
 private:
     static void get_shell_surface_thunk(struct wl_client* client, struct wl_resource* resource, uint32_t id, struct wl_resource* surface)
@@ -766,6 +777,7 @@ private:
             BOOST_THROW_EXCEPTION((std::bad_alloc{}));
         }
         wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
     }
 
     uint32_t const max_version;
@@ -1265,6 +1277,8 @@ protected:
     virtual void get_keyboard(struct wl_client* client, struct wl_resource* resource, uint32_t id) = 0;
     virtual void get_touch(struct wl_client* client, struct wl_resource* resource, uint32_t id) = 0;
     virtual void release(struct wl_client* client, struct wl_resource* resource) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
 
 private:
     static void get_pointer_thunk(struct wl_client* client, struct wl_resource* resource, uint32_t id)
@@ -1346,6 +1360,7 @@ private:
             BOOST_THROW_EXCEPTION((std::bad_alloc{}));
         }
         wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
     }
 
     uint32_t const max_version;
@@ -1553,6 +1568,8 @@ protected:
     virtual ~Output() = default;
 
     virtual void release(struct wl_client* client, struct wl_resource* resource) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
 
 private:
     static void release_thunk(struct wl_client* client, struct wl_resource* resource)
@@ -1583,6 +1600,7 @@ private:
             BOOST_THROW_EXCEPTION((std::bad_alloc{}));
         }
         wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
     }
 
     uint32_t const max_version;
@@ -1700,6 +1718,8 @@ protected:
 
     virtual void destroy(struct wl_client* client, struct wl_resource* resource) = 0;
     virtual void get_subsurface(struct wl_client* client, struct wl_resource* resource, uint32_t id, struct wl_resource* surface, struct wl_resource* parent) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
 
 private:
     static void destroy_thunk(struct wl_client* client, struct wl_resource* resource)
@@ -1747,6 +1767,7 @@ private:
             BOOST_THROW_EXCEPTION((std::bad_alloc{}));
         }
         wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
     }
 
     uint32_t const max_version;
@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_clock.h"
+
+#include <iterator>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+
+clockid_t constexpr mf::PresentationClock::clock_id;
+size_t constexpr mf::PresentationClock::max_awaiting_frame;
+
+uint32_t mf::PresentationClock::callback_time() const
+{
+    auto const now = mir::time::PosixTimestamp::now(clock_id);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.nanoseconds).count();
+}
+
+void mf::PresentationClock::answer_after_next_frame(
+    std::experimental::optional<unsigned int> output_id,
+    std::vector<std::unique_ptr<Feedback>>&& feedback)
+{
+    auto& awaiting = output_id ? awaiting_output[*output_id] : awaiting_any_output;
+
+    // Not every platform reports its frames, and an output can go away, so
+    // some feedback would never be answered
+    if (awaiting.size() > max_awaiting_frame)
+        discard(awaiting);
+
+    awaiting.insert(
+        awaiting.end(),
+        std::make_move_iterator(feedback.begin()),
+        std::make_move_iterator(feedback.end()));
+}
+
+void mf::PresentationClock::frame_shown(unsigned int output_id, mg::Frame const& frame)
+{
+    auto time = frame.ust;
+    auto hardware_timestamp = frame.hardware_timestamp;
+    if (time.clock_id != clock_id)
+    {
+        // The offset between clocks is sampled now, so the result is an estimate
+        hardware_timestamp = false;
+        auto const offset = mir::time::PosixTimestamp::now(clock_id).nanoseconds -
+            mir::time::PosixTimestamp::now(time.clock_id).nanoseconds;
+        time = mir::time::PosixTimestamp{clock_id, time.nanoseconds + offset};
+    }
+
+    // The refresh interval is what this output has been managing lately
+    std::chrono::nanoseconds refresh{0};
+    auto const last = last_frames.find(output_id);
+    if (last != last_frames.end() && frame.msc > last->second.msc &&
+        frame.ust.clock_id == last->second.ust.clock_id)
+    {
+        refresh = (frame.ust - last->second.ust) / (frame.msc - last->second.msc);
+    }
+    last_frames[output_id] = frame;
+
+    auto const answer = [&](Awaiting& awaiting, bool hardware_timestamp)
+        {
+            for (auto const& feedback : awaiting)
+                feedback->presented(output_id, time, refresh, frame.msc, hardware_timestamp);
+            awaiting.clear();
+        };
+
+    auto const on_this_output = awaiting_output.find(output_id);
+    if (on_this_output != awaiting_output.end())
+        answer(on_this_output->second, hardware_timestamp);
+
+    // Their content may not have been on this output, so the time is a guess
+    answer(awaiting_any_output, false);
+}
+
+void mf::PresentationClock::discard(Awaiting& awaiting)
+{
+    for (auto const& feedback : awaiting)
+        feedback->discarded();
+    awaiting.clear();
+}
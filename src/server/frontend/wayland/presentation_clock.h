@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_PRESENTATION_CLOCK_H_
+#define MIR_FRONTEND_PRESENTATION_CLOCK_H_
+
+#include "mir/graphics/frame_observer.h"
+#include "mir/graphics/frame.h"
+
+#include <experimental/optional>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Timestamps for frame callbacks and presentation feedback, all in the
+ * presentation clock's domain. It hears of each frame shown on the
+ * wl_event_loop, after the compositor has finished with the buffers that
+ * went into it, so the next frame an output shows is the one to report.
+ */
+class PresentationClock : public graphics::FrameObserver
+{
+public:
+    static clockid_t constexpr clock_id{CLOCK_MONOTONIC};
+
+    /// A wp_presentation_feedback, or anything else waiting on a frame
+    class Feedback
+    {
+    public:
+        virtual ~Feedback() = default;
+
+        /**
+         * The content was shown on \a output_id at \a time, in frame \a msc.
+         * \a refresh is the output's recent frame interval, or zero if that
+         * isn't known yet. \a hardware_timestamp is set only if \a time is
+         * the display's own report of when this content was shown.
+         */
+        virtual void presented(
+            unsigned int output_id,
+            time::PosixTimestamp const& time,
+            std::chrono::nanoseconds refresh,
+            int64_t msc,
+            bool hardware_timestamp) = 0;
+
+        /// The content will never be shown
+        virtual void discarded() = 0;
+
+    protected:
+        Feedback() = default;
+        Feedback(Feedback const&) = delete;
+        Feedback& operator=(Feedback const&) = delete;
+    };
+
+    /// The time for wl_callback.done, in milliseconds
+    uint32_t callback_time() const;
+
+    /**
+     * Answers \a feedback with the next frame shown on \a output_id, or with
+     * the next frame shown anywhere if the surface's output isn't known.
+     */
+    void answer_after_next_frame(
+        std::experimental::optional<unsigned int> output_id,
+        std::vector<std::unique_ptr<Feedback>>&& feedback);
+
+    void frame_shown(unsigned int output_id, graphics::Frame const& frame) override;
+
+private:
+    using Awaiting = std::vector<std::unique_ptr<Feedback>>;
+
+    static size_t constexpr max_awaiting_frame{256};
+
+    static void discard(Awaiting& awaiting);
+
+    Awaiting awaiting_any_output;
+    std::unordered_map<unsigned int, Awaiting> awaiting_output;
+    std::unordered_map<unsigned int, graphics::Frame> last_frames;
+};
+}
+}
+
+#endif /* MIR_FRONTEND_PRESENTATION_CLOCK_H_ */
@@ -0,0 +1,128 @@
+/*
+ * AUTOGENERATED - DO NOT EDIT
+ *
+ * This header is generated by src/protocol/wrapper_generator.cpp
+ * To regenerate, run the “refresh-wayland-wrapper” target.
+ */
+
+#include <experimental/optional>
+#include <boost/throw_exception.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <wayland-server.h>
+#include <presentation-time-server-protocol.h>
+
+#include "mir/fd.h"
+#include "mir/log.h"
+
+namespace mir
+{
+namespace frontend
+{
+namespace wayland
+{
+class Presentation
+{
+protected:
+    Presentation(struct wl_display* display, uint32_t max_version)
+        : max_version{max_version}
+    {
+        if (!wl_global_create(display, 
+                              &wp_presentation_interface, max_version,
+                              this, &Presentation::bind))
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to export wp_presentation interface"}));
+        }
+    }
+    virtual ~Presentation() = default;
+
+    virtual void destroy(struct wl_client* client, struct wl_resource* resource) = 0;
+    virtual void feedback(struct wl_client* client, struct wl_resource* resource, struct wl_resource* surface, uint32_t callback) = 0;
+    /// Called once a client has bound the global, to send it any initial events
+    virtual void bound(struct wl_client* /*client*/, struct wl_resource* /*resource*/) {}
+
+private:
+    static void destroy_thunk(struct wl_client* client, struct wl_resource* resource)
+    {
+        auto me = static_cast<Presentation*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->destroy(client, resource);
+        }
+        catch(...)
+        {
+            ::mir::log(
+                ::mir::logging::Severity::critical,
+                "frontend:Wayland",
+                std::current_exception(),
+                "Exception processing Presentation::destroy() request");
+        }
+    }
+
+    static void feedback_thunk(struct wl_client* client, struct wl_resource* resource, struct wl_resource* surface, uint32_t callback)
+    {
+        auto me = static_cast<Presentation*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->feedback(client, resource, surface, callback);
+        }
+        catch(...)
+        {
+            ::mir::log(
+                ::mir::logging::Severity::critical,
+                "frontend:Wayland",
+                std::current_exception(),
+                "Exception processing Presentation::feedback() request");
+        }
+    }
+
+    static void bind(struct wl_client* client, void* data, uint32_t version, uint32_t id)
+    {
+        auto me = static_cast<Presentation*>(data);
+        auto resource = wl_resource_create(client, &wp_presentation_interface,
+                                           std::min(version, me->max_version), id);
+        if (resource == nullptr)
+        {
+            wl_client_post_no_memory(client);
+            BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+        }
+        wl_resource_set_implementation(resource, &vtable, me, nullptr);
+        me->bound(client, resource);
+    }
+
+    uint32_t const max_version;
+    static struct wp_presentation_interface const vtable;
+};
+
+struct wp_presentation_interface const Presentation::vtable = {
+    destroy_thunk,
+    feedback_thunk,
+};
+
+
+class PresentationFeedback
+{
+protected:
+    PresentationFeedback(struct wl_client* client, struct wl_resource* parent, uint32_t id)
+        : client{client},
+          resource{wl_resource_create(client, &wp_presentation_feedback_interface, wl_resource_get_version(parent), id)}
+    {
+        if (resource == nullptr)
+        {
+            wl_resource_post_no_memory(parent);
+            BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+        }
+    }
+    virtual ~PresentationFeedback() = default;
+
+
+    struct wl_client* const client;
+    struct wl_resource* const resource;
+
+};
+
+
+
+}
+}
+}
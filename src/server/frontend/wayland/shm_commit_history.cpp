@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_commit_history.h"
+
+#include "mir/geometry/rectangles.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+void mf::ShmCommitHistory::committed(
+    mg::BufferID id,
+    geom::Size size,
+    geom::Stride stride,
+    MirPixelFormat format,
+    std::experimental::optional<geom::Rectangle> const& damage)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    geom::Rectangle const everything{{0, 0}, size};
+
+    if (size != current_size || stride != current_stride || format != current_format)
+    {
+        current_size = size;
+        current_stride = stride;
+        current_format = format;
+        ++layout;
+        commits.clear();
+        spare_pixels.clear();
+    }
+
+    commits.push_back({id, damage ? damage->intersection_with(everything) : everything});
+    if (commits.size() > max_commits)
+        commits.pop_front();
+}
+
+void mf::ShmCommitHistory::forget()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    commits.clear();
+}
+
+auto mf::ShmCommitHistory::take_pixels() -> Pixels
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (!spare_pixels.empty())
+    {
+        auto pixels = std::move(spare_pixels.back());
+        spare_pixels.pop_back();
+        return pixels;
+    }
+
+    return {
+        std::make_unique<uint8_t[]>(current_size.height.as_int() * current_stride.as_int()),
+        {},
+        layout};
+}
+
+void mf::ShmCommitHistory::give_back(Pixels&& pixels)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (pixels.layout == layout && spare_pixels.size() < max_spare_pixels)
+        spare_pixels.push_back(std::move(pixels));
+}
+
+void mf::ShmCommitHistory::copy_into(Pixels& pixels, mg::BufferID id, uint8_t const* data) const
+{
+    /*
+     * Reused pixels hold an older buffer, which only differs in the rows
+     * damaged since. Otherwise everything must be copied.
+     */
+    geom::Rectangle copy;
+    geom::Stride stride;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        copy = {{0, 0}, current_size};
+        stride = current_stride;
+    }
+
+    if (pixels.contents)
+    {
+        if (auto const changed = damage_between(*pixels.contents, id))
+            copy = *changed;
+    }
+
+    auto const offset = copy.top().as_int() * stride.as_int();
+    auto const length = copy.size.height.as_int() * stride.as_int();
+
+    std::memcpy(pixels.data.get() + offset, data + offset, length);
+
+    pixels.contents = id;
+}
+
+auto mf::ShmCommitHistory::damage_between(mg::BufferID from, mg::BufferID to) const
+    -> std::experimental::optional<geom::Rectangle>
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const first = std::find_if(commits.begin(), commits.end(),
+        [from](Commit const& commit) { return commit.id == from; });
+    if (first == commits.end())
+        return {};
+
+    auto const last = std::find_if(first, commits.end(),
+        [to](Commit const& commit) { return commit.id == to; });
+    if (last == commits.end())
+        return {};
+
+    geom::Rectangles damage;
+    for (auto commit = std::next(first); commit != std::next(last); ++commit)
+    {
+        if (commit->damage.size.width > geom::Width{0} &&
+            commit->damage.size.height > geom::Height{0})
+            damage.add(commit->damage);
+    }
+
+    return damage.bounding_rectangle();
+}
+
+void mf::upload_rows(
+    uint8_t const* pixels,
+    geom::Size size,
+    geom::Stride stride,
+    MirPixelFormat format,
+    GLenum gl_format,
+    GLenum gl_type,
+    geom::Rectangle const& changed)
+{
+    auto const top = changed.top().as_int();
+    auto const rows = changed.size.height.as_int();
+    auto const width = size.width.as_int();
+
+    if (rows <= 0)
+        return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Whole rows are contiguous, so upload every row with damage in
+    if (stride.as_int() == width * MIR_BYTES_PER_PIXEL(format))
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, top, width, rows,
+                        gl_format, gl_type, pixels + top * stride.as_int());
+        return;
+    }
+
+    for (auto row = top; row != top + rows; ++row)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, width, 1,
+                        gl_format, gl_type, pixels + row * stride.as_int());
+    }
+}
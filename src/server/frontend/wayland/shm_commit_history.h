@@ -0,0 +1,128 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_SHM_COMMIT_HISTORY_H_
+#define MIR_FRONTEND_SHM_COMMIT_HISTORY_H_
+
+#include "mir/graphics/buffer_id.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/dimensions.h"
+#include "mir_toolkit/common.h"
+
+#include MIR_SERVER_GL_H
+
+#include <experimental/optional>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * The recent SHM buffer commits to a wl_surface, and spare allocations for
+ * their pixels. With these each commit need only copy, and each texture
+ * update only upload, the rows that the client has damaged.
+ *
+ * Commits arrive on the Wayland thread, but the buffers are uploaded and
+ * destroyed on compositor threads.
+ */
+class ShmCommitHistory
+{
+public:
+    struct Pixels
+    {
+        std::unique_ptr<uint8_t[]> data;
+        std::experimental::optional<graphics::BufferID> contents;  // The buffer these are a copy of
+        unsigned int layout;    // The buffer layout they were allocated for
+    };
+
+    /**
+     * Records a commit of buffer \a id. Unless the client said what it
+     * damaged, and the buffer layout is unchanged, everything is damaged.
+     */
+    void committed(
+        graphics::BufferID id,
+        geometry::Size size,
+        geometry::Stride stride,
+        MirPixelFormat format,
+        std::experimental::optional<geometry::Rectangle> const& damage);
+
+    /// Forget all commits, so damage is unknown until the next one
+    void forget();
+
+    /**
+     * Provides pixels for the current layout, reusing a released allocation
+     * if possible. It may still hold the contents of an older buffer.
+     */
+    Pixels take_pixels();
+
+    void give_back(Pixels&& pixels);
+
+    /**
+     * Copies \a data, the contents of the last committed buffer \a id, into
+     * \a pixels. Only the rows damaged since what \a pixels held are copied,
+     * if that is known.
+     */
+    void copy_into(Pixels& pixels, graphics::BufferID id, uint8_t const* data) const;
+
+    /**
+     * The area damaged by the commits after \a from, up to and including
+     * \a to, if known.
+     */
+    std::experimental::optional<geometry::Rectangle> damage_between(
+        graphics::BufferID from,
+        graphics::BufferID to) const;
+
+private:
+    struct Commit
+    {
+        graphics::BufferID id;
+        geometry::Rectangle damage;
+    };
+
+    static size_t const max_commits = 16;
+    static size_t const max_spare_pixels = 2;
+
+    std::mutex mutable mutex;
+    geometry::Size current_size;
+    geometry::Stride current_stride;
+    MirPixelFormat current_format{mir_pixel_format_invalid};
+    unsigned int layout{0};
+    std::deque<Commit> commits;
+    std::vector<Pixels> spare_pixels;
+};
+
+/**
+ * Uploads the rows of \a pixels (\a size pixels laid out \a stride bytes
+ * apart) that \a changed covers into the bound texture. GLES can't be told
+ * the row length, so rows with padding after them go up one at a time.
+ */
+void upload_rows(
+    uint8_t const* pixels,
+    geometry::Size size,
+    geometry::Stride stride,
+    MirPixelFormat format,
+    GLenum gl_format,
+    GLenum gl_type,
+    geometry::Rectangle const& changed);
+}
+}
+
+#endif /* MIR_FRONTEND_SHM_COMMIT_HISTORY_H_ */
@@ -17,8 +17,11 @@
  */
 
 #include "wayland_connector.h"
+#include "shm_commit_history.h"
+#include "presentation_clock.h"
 
 #include "core_generated_interfaces.h"
+#include "presentation_time_generated_interfaces.h"
 
 #include "mir/frontend/shell.h"
 #include "mir/frontend/surface.h"
@@ -32,14 +35,20 @@
 #include "mir/graphics/buffer_properties.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/display_configuration.h"
+#include "mir/graphics/frame.h"
+#include "mir/graphics/frame_observer.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/graphics/wayland_allocator.h"
 
 #include "mir/renderer/gl/texture_target.h"
+#include "mir/renderer/gl/incremental_texture_source.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/frontend/buffer_stream_id.h"
 #include "mir/frontend/display_changer.h"
 
 #include "mir/executor.h"
+#include "mir/observer_registrar.h"
+#include "mir/time/posix_timestamp.h"
 
 #include "mir/client/event.h"
 
@@ -65,6 +74,7 @@
 #include <mir/log.h>
 #include <cstring>
 #include <deque>
+#include <limits>
 #include MIR_SERVER_GL_H
 #include MIR_SERVER_GLEXT_H
 
@@ -344,11 +354,14 @@ class WlShmBuffer :
     public mg::BufferBasic,
     public mg::NativeBufferBase,
     public mir::renderer::gl::TextureSource,
+    public mir::renderer::gl::IncrementalTextureSource,
     public mir::renderer::software::PixelSource
 {
 public:
     ~WlShmBuffer()
     {
+        history->give_back(std::move(pixels));
+
         std::lock_guard<std::mutex> lock{*buffer_mutex};
         if (buffer)
         {
@@ -358,6 +371,8 @@ public:
 
     static std::shared_ptr<graphics::Buffer> mir_buffer_from_wl_buffer(
         wl_resource* buffer,
+        std::shared_ptr<ShmCommitHistory> const& history,
+        std::experimental::optional<geom::Rectangle> const& damage,
         std::function<void()>&& on_consumed)
     {
         std::shared_ptr<WlShmBuffer> mir_buffer;
@@ -376,13 +391,23 @@ public:
                  *
                  * Recreate a new WlShmBuffer to track the new compositor lifetime.
                  */
-                mir_buffer = std::shared_ptr<WlShmBuffer>{new WlShmBuffer{buffer, std::move(on_consumed)}};
+                mir_buffer = std::shared_ptr<WlShmBuffer>{
+                    new WlShmBuffer{buffer, history, damage, std::move(on_consumed)}};
                 shim->associated_buffer = mir_buffer;
             }
+            else
+            {
+                /*
+                 * The existing WlShmBuffer doesn't pick up whatever this commit
+                 * changed, so what any buffer differs by is no longer known.
+                 */
+                history->forget();
+            }
         }
         else
         {
-            mir_buffer = std::shared_ptr<WlShmBuffer>{new WlShmBuffer{buffer, std::move(on_consumed)}};
+            mir_buffer = std::shared_ptr<WlShmBuffer>{
+                new WlShmBuffer{buffer, history, damage, std::move(on_consumed)}};
             shim = new DestructionShim;
             shim->destruction_listener.notify = &on_buffer_destroyed;
             shim->associated_buffer = mir_buffer;
@@ -448,6 +473,25 @@ public:
         gl_bind_to_texture();
     }
 
+    void bind_changes_since(mg::BufferID previous) override
+    {
+        auto const changed = history->damage_between(previous, id());
+        GLenum format, type;
+
+        // Whatever can't be uploaded in part goes the way of a full upload
+        if (!changed || !get_gl_pixel_format(format_, format, type))
+        {
+            bind();
+            return;
+        }
+
+        read(
+            [this, &changed, format, type](unsigned char const* pixels)
+            {
+                upload_rows(pixels, size_, stride_, format_, format, type, *changed);
+            });
+    }
+
     void secure_for_render() override
     {
     }
@@ -476,7 +520,7 @@ public:
             consumed = true;
         }
 
-        do_with_pixels(static_cast<unsigned char const*>(data.get()));
+        do_with_pixels(static_cast<unsigned char const*>(pixels.data.get()));
     }
 
     geometry::Stride stride() const override
@@ -487,13 +531,15 @@ public:
 private:
     WlShmBuffer(
         wl_resource* buffer,
+        std::shared_ptr<ShmCommitHistory> const& history,
+        std::experimental::optional<geom::Rectangle> const& damage,
         std::function<void()>&& on_consumed)
         : buffer{shm_buffer_from_resource_checked(buffer)},
           resource{buffer},
           size_{wl_shm_buffer_get_width(this->buffer), wl_shm_buffer_get_height(this->buffer)},
           stride_{wl_shm_buffer_get_stride(this->buffer)},
           format_{wl_format_to_mir_format(wl_shm_buffer_get_format(this->buffer))},
-          data{std::make_unique<uint8_t[]>(size_.height.as_int() * stride_.as_int())},
+          history{history},
           consumed{false},
           on_consumed{std::move(on_consumed)}
     {
@@ -510,8 +556,11 @@ private:
                 std::runtime_error{"Buffer has invalid stride"}));
         }
 
+        history->committed(id(), size_, stride_, format_, damage);
+        pixels = history->take_pixels();
+
         wl_shm_buffer_begin_access(this->buffer);
-        std::memcpy(data.get(), wl_shm_buffer_get_data(this->buffer), size_.height.as_int() * stride_.as_int());
+        history->copy_into(pixels, id(), static_cast<uint8_t const*>(wl_shm_buffer_get_data(this->buffer)));
         wl_shm_buffer_end_access(this->buffer);
     }
 
@@ -551,12 +600,177 @@ private:
     geom::Stride const stride_;
     MirPixelFormat const format_;
 
-    std::unique_ptr<uint8_t[]> const data;
+    std::shared_ptr<ShmCommitHistory> const history;
+    ShmCommitHistory::Pixels pixels;
 
     bool consumed;
     std::function<void()> on_consumed;
 };
 
+namespace
+{
+/// The part of a surface-local rectangle that could lie on a buffer, or an
+/// empty rectangle. Clients commonly send INT32_MAX sized areas, which must
+/// not overflow.
+geom::Rectangle clamped_rectangle(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    auto const clamp = [](int64_t value)
+        {
+            int64_t const limit = std::numeric_limits<int16_t>::max();
+            return static_cast<int>(std::min(std::max(value, int64_t{0}), limit));
+        };
+
+    auto const left = clamp(x);
+    auto const top = clamp(y);
+    auto const right = clamp(int64_t{x} + std::max(width, 0));
+    auto const bottom = clamp(int64_t{y} + std::max(height, 0));
+
+    if (right > left && bottom > top)
+        return {{left, top}, {right - left, bottom - top}};
+    else
+        return {};
+}
+}
+
+class Region : public wayland::Region
+{
+public:
+    Region(wl_client* client, wl_resource* parent, uint32_t id)
+        : wayland::Region(client, parent, id)
+    {
+    }
+
+    static Region* from(wl_resource* resource)
+    {
+        return static_cast<Region*>(static_cast<wayland::Region*>(wl_resource_get_user_data(resource)));
+    }
+
+    std::vector<geom::Rectangle> rectangles() const
+    {
+        return rects;
+    }
+
+protected:
+
+    void destroy() override
+    {
+        wl_resource_destroy(resource);
+    }
+    void add(int32_t x, int32_t y, int32_t width, int32_t height) override
+    {
+        auto const rect = clamped_rectangle(x, y, width, height);
+        if (rect != geom::Rectangle{})
+            rects.push_back(rect);
+    }
+    void subtract(int32_t x, int32_t y, int32_t width, int32_t height) override
+    {
+        auto const hole = clamped_rectangle(x, y, width, height);
+
+        std::vector<geom::Rectangle> remaining;
+        auto const keep = [&remaining](int left, int top, int right, int bottom)
+            {
+                if (right > left && bottom > top)
+                    remaining.push_back({{left, top}, {right - left, bottom - top}});
+            };
+
+        for (auto const& rect : rects)
+        {
+            auto const cut = rect.intersection_with(hole);
+            if (cut == geom::Rectangle{})
+            {
+                remaining.push_back(rect);
+                continue;
+            }
+
+            // What is left is the bands above and below the cut, and the
+            // pieces either side of it
+            auto const left = rect.left().as_int();
+            auto const right = rect.right().as_int();
+            keep(left, rect.top().as_int(), right, cut.top().as_int());
+            keep(left, cut.bottom().as_int(), right, rect.bottom().as_int());
+            keep(left, cut.top().as_int(), cut.left().as_int(), cut.bottom().as_int());
+            keep(cut.right().as_int(), cut.top().as_int(), right, cut.bottom().as_int());
+        }
+
+        rects = std::move(remaining);
+    }
+
+private:
+    std::vector<geom::Rectangle> rects;
+};
+
+class OutputManager;
+
+/*
+ * A wp_presentation_feedback. The client can destroy it at any time (by
+ * disconnecting), in which case there's nobody left to answer.
+ */
+class WpPresentationFeedback : public wayland::PresentationFeedback, public PresentationClock::Feedback
+{
+public:
+    WpPresentationFeedback(wl_client* client, wl_resource* parent, uint32_t id, OutputManager const& outputs)
+        : PresentationFeedback(client, parent, id),
+          outputs{outputs},
+          destroyed{std::make_shared<bool>(false)}
+    {
+        wl_resource_set_implementation(resource, nullptr, new std::shared_ptr<bool>{destroyed}, &resource_destroyed);
+    }
+
+    void presented(
+        unsigned int output_id,
+        mir::time::PosixTimestamp const& time,
+        std::chrono::nanoseconds refresh,
+        int64_t msc,
+        bool hardware_timestamp) override;
+
+    void discarded() override
+    {
+        if (*destroyed)
+            return;
+
+        wp_presentation_feedback_send_discarded(resource);
+        wl_resource_destroy(resource);
+    }
+
+private:
+    static void resource_destroyed(wl_resource* resource)
+    {
+        std::unique_ptr<std::shared_ptr<bool>> const destroyed{
+            static_cast<std::shared_ptr<bool>*>(wl_resource_get_user_data(resource))};
+        **destroyed = true;
+    }
+
+    OutputManager const& outputs;
+    std::shared_ptr<bool> const destroyed;
+};
+
+class WpPresentation : public wayland::Presentation
+{
+public:
+    WpPresentation(wl_display* display, OutputManager const& outputs)
+        : Presentation(display, 1),
+          outputs{outputs}
+    {
+    }
+
+private:
+    OutputManager const& outputs;
+
+    void destroy(wl_client* client, wl_resource* resource) override;
+    void feedback(wl_client* client, wl_resource* resource, wl_resource* surface, uint32_t callback) override;
+    void bound(wl_client* client, wl_resource* resource) override;
+};
+
+void WpPresentation::destroy(wl_client* /*client*/, wl_resource* resource)
+{
+    wl_resource_destroy(resource);
+}
+
+void WpPresentation::bound(wl_client* /*client*/, wl_resource* resource)
+{
+    wp_presentation_send_clock_id(resource, PresentationClock::clock_id);
+}
+
 class WlSurface : public wayland::Surface
 {
 public:
@@ -565,12 +779,17 @@ public:
         wl_resource* parent,
         uint32_t id,
         std::shared_ptr<mir::Executor> const& executor,
-        std::shared_ptr<mg::WaylandAllocator> const& allocator)
+        std::shared_ptr<mg::WaylandAllocator> const& allocator,
+        std::shared_ptr<PresentationClock> const& presentation_clock)
         : Surface(client, parent, id),
+          output_id{std::make_shared<std::atomic<unsigned int>>(0)},
           allocator{allocator},
           executor{executor},
+          presentation_clock{presentation_clock},
           pending_buffer{nullptr},
           pending_frames{std::make_shared<std::vector<wl_resource*>>()},
+          committed_feedback{std::make_shared<Feedback>()},
+          shm_history{std::make_shared<ShmCommitHistory>()},
           destroyed{std::make_shared<bool>(false)}
     {
         auto session = session_for_client(client);
@@ -590,6 +809,8 @@ public:
     ~WlSurface()
     {
         *destroyed = true;
+        discard(pending_feedback);
+        discard(*committed_feedback);
         if (auto session = session_for_client(client))
             session->destroy_buffer_stream(stream_id);
     }
@@ -604,19 +825,38 @@ public:
         hide_handler = handler;
     }
 
+    void add_presentation_feedback(std::unique_ptr<PresentationClock::Feedback> feedback)
+    {
+        pending_feedback.push_back(std::move(feedback));
+    }
+
     mf::BufferStreamId stream_id;
     std::shared_ptr<mf::BufferStream> stream;
+    /// The output the shell last placed the surface on, or zero if it hasn't said
+    std::shared_ptr<std::atomic<unsigned int>> const output_id;
 private:
+    using Feedback = std::vector<std::unique_ptr<PresentationClock::Feedback>>;
+
     std::shared_ptr<mg::WaylandAllocator> const allocator;
     std::shared_ptr<mir::Executor> const executor;
+    std::shared_ptr<PresentationClock> const presentation_clock;
 
     std::function<void(geom::Size)> resize_handler;
     std::function<void()> hide_handler;
 
     wl_resource* pending_buffer;
     std::shared_ptr<std::vector<wl_resource*>> const pending_frames;
+    Feedback pending_feedback;
+    /// Feedback for the last buffer committed, until it is composited
+    std::shared_ptr<Feedback> committed_feedback;
+    geom::Rectangles pending_damage;
+    std::experimental::optional<std::vector<geom::Rectangle>> pending_opaque_region;
+    std::shared_ptr<ShmCommitHistory> const shm_history;
     std::shared_ptr<bool> const destroyed;
 
+    void add_pending_damage(int32_t x, int32_t y, int32_t width, int32_t height);
+    static void discard(Feedback& feedback);
+
     void destroy();
     void attach(std::experimental::optional<wl_resource*> const& buffer, int32_t x, int32_t y);
     void damage(int32_t x, int32_t y, int32_t width, int32_t height);
@@ -651,18 +891,27 @@ void WlSurface::attach(std::experimental::optional<wl_resource*> const& buffer,
 
 void WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
+    // Without buffer scale or transform support, surface and buffer coordinates are the same
+    add_pending_damage(x, y, width, height);
 }
 
 void WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
+    add_pending_damage(x, y, width, height);
+}
+
+void WlSurface::add_pending_damage(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    auto const rect = clamped_rectangle(x, y, width, height);
+    if (rect != geom::Rectangle{})
+        pending_damage.add(rect);
+}
+
+void WlSurface::discard(Feedback& feedback)
+{
+    for (auto const& item : feedback)
+        item->discarded();
+    feedback.clear();
 }
 
 void WlSurface::frame(uint32_t callback)
@@ -673,7 +922,11 @@ void WlSurface::frame(uint32_t callback)
 
 void WlSurface::set_opaque_region(const std::experimental::optional<wl_resource*>& region)
 {
-    (void)region;
+    // The region is copied now, as the client is free to change or destroy it
+    if (region)
+        pending_opaque_region = Region::from(*region)->rectangles();
+    else
+        pending_opaque_region = std::vector<geom::Rectangle>{};
 }
 
 void WlSurface::set_input_region(const std::experimental::optional<wl_resource*>& region)
@@ -683,14 +936,31 @@ void WlSurface::set_input_region(const std::experimental::optional<wl_resource*>
 
 void WlSurface::commit()
 {
+    // Set before the buffer below is submitted, so that it is latched with it
+    if (pending_opaque_region)
+    {
+        stream->set_opaque_region(*pending_opaque_region);
+        pending_opaque_region = std::experimental::nullopt;
+    }
+
     if (pending_buffer)
     {
+        // A buffer that was never composited won't be now, it has been replaced
+        discard(*committed_feedback);
+        committed_feedback = std::make_shared<Feedback>(std::move(pending_feedback));
+        pending_feedback.clear();
+
         auto send_frame_notifications =
-            [executor = executor, frames = pending_frames, destroyed = destroyed]()
+            [executor = executor,
+             frames = pending_frames,
+             feedback = committed_feedback,
+             clock = presentation_clock,
+             output_id = output_id,
+             destroyed = destroyed]()
             {
                 executor->spawn(run_unless(
                     destroyed,
-                    [frames]()
+                    [frames, feedback, clock, output_id]()
                     {
                         /*
                          * There is no synchronisation required here -
@@ -700,12 +970,19 @@ void WlSurface::commit()
                          * The only other accessors of WlSurface are also on the wl_event_loop,
                          * so this is guaranteed not to be reentrant.
                          */
+                        auto const time = clock->callback_time();
                         for (auto frame : *frames)
                         {
-                            wl_callback_send_done(frame, 0);
+                            wl_callback_send_done(frame, time);
                             wl_resource_destroy(frame);
                         }
                         frames->clear();
+
+                        std::experimental::optional<unsigned int> output;
+                        if (auto const id = output_id->load())
+                            output = id;
+                        clock->answer_after_next_frame(output, std::move(*feedback));
+                        feedback->clear();
                     }));
             };
 
@@ -713,8 +990,15 @@ void WlSurface::commit()
 
         if (wl_shm_buffer_get(pending_buffer))
         {
+            // A client that doesn't say what it damaged may have changed anything
+            std::experimental::optional<geom::Rectangle> damage;
+            if (pending_damage.size() > 0)
+                damage = pending_damage.bounding_rectangle();
+
             mir_buffer = WlShmBuffer::mir_buffer_from_wl_buffer(
                 pending_buffer,
+                shm_history,
+                damage,
                 std::move(send_frame_notifications));
         }
         else
@@ -755,6 +1039,13 @@ void WlSurface::commit()
 
         pending_buffer = nullptr;
     }
+    else
+    {
+        // Nothing new to show
+        discard(pending_feedback);
+    }
+
+    pending_damage.clear();
 }
 
 void WlSurface::set_buffer_transform(int32_t transform)
@@ -773,16 +1064,19 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& executor,
-        std::shared_ptr<mg::WaylandAllocator> const& allocator)
+        std::shared_ptr<mg::WaylandAllocator> const& allocator,
+        std::shared_ptr<PresentationClock> const& presentation_clock)
         : Compositor(display, 3),
           allocator{allocator},
-          executor{executor}
+          executor{executor},
+          presentation_clock{presentation_clock}
     {
     }
 
 private:
     std::shared_ptr<mg::WaylandAllocator> const allocator;
     std::shared_ptr<mir::Executor> const executor;
+    std::shared_ptr<PresentationClock> const presentation_clock;
 
     void create_surface(wl_client* client, wl_resource* resource, uint32_t id) override;
     void create_region(wl_client* client, wl_resource* resource, uint32_t id) override;
@@ -790,35 +1084,21 @@ private:
 
 void WlCompositor::create_surface(wl_client* client, wl_resource* resource, uint32_t id)
 {
-    new WlSurface{client, resource, id, executor, allocator};
+    new WlSurface{client, resource, id, executor, allocator, presentation_clock};
 }
 
-class Region : public wayland::Region
-{
-public:
-    Region(wl_client* client, wl_resource* parent, uint32_t id)
-        : wayland::Region(client, parent, id)
-    {
-    }
-protected:
-
-    void destroy() override
-    {
-    }
-    void add(int32_t /*x*/, int32_t /*y*/, int32_t /*width*/, int32_t /*height*/) override
-    {
-    }
-    void subtract(int32_t /*x*/, int32_t /*y*/, int32_t /*width*/, int32_t /*height*/) override
-    {
-    }
-
-};
-
 void WlCompositor::create_region(wl_client* client, wl_resource* resource, uint32_t id)
 {
     new Region{client, resource, id};
 }
 
+void WpPresentation::feedback(wl_client* client, wl_resource* resource, wl_resource* surface, uint32_t callback)
+{
+    auto const wl_surface = static_cast<wayland::Surface*>(wl_resource_get_user_data(surface));
+    static_cast<WlSurface*>(wl_surface)->add_presentation_feedback(
+        std::make_unique<WpPresentationFeedback>(client, resource, callback, outputs));
+}
+
 class WlPointer;
 class WlTouch;
 
@@ -1630,11 +1910,17 @@ void WaylandEventSink::send_ping(int32_t)
 class SurfaceEventSink : public mf::EventSink
 {
 public:
-    SurfaceEventSink(WlSeat* seat, wl_client* client, wl_resource* target, wl_resource* event_sink)
+    SurfaceEventSink(
+        WlSeat* seat,
+        wl_client* client,
+        wl_resource* target,
+        wl_resource* event_sink,
+        std::shared_ptr<std::atomic<unsigned int>> const& output_id)
         : seat{seat},
           client{client},
           target{target},
           event_sink{event_sink},
+          output_id{output_id},
           window_size{geometry::Size{0,0}}
     {
     }
@@ -1661,6 +1947,7 @@ private:
     wl_client* const client;
     wl_resource* const target;
     wl_resource* const event_sink;
+    std::shared_ptr<std::atomic<unsigned int>> const output_id;
     std::atomic<geometry::Size> window_size;
 };
 
@@ -1709,6 +1996,13 @@ void SurfaceEventSink::handle_event(MirEvent const& event)
         seat->acquire_keyboard_reference(client).handle_event(map_ev, target);
         break;
     }
+    case mir_event_type_window_output:
+    {
+        // Presentation feedback for the surface waits on this output's frames
+        auto const oev = mir_event_get_window_output_event(&event);
+        *output_id = mir_window_output_event_get_output_id(oev);
+        break;
+    }
     case mir_event_type_window:
     {
         auto const wev = mir_event_get_window_event(&event);
@@ -1741,6 +2035,15 @@ public:
 
     }
 
+    /// The wl_output resources \a client has bound to this output
+    std::vector<wl_resource*> resources_for(wl_client* client) const
+    {
+        auto const resources = resource_map.find(client);
+        if (resources == resource_map.end())
+            return {};
+        return resources->second;
+    }
+
 private:
     static void send_initial_config(
         wl_resource* client_resource,
@@ -1803,10 +2106,9 @@ private:
             wl_resource_get_user_data(resource));
 
         auto& client_resource_list = map[wl_resource_get_client(resource)];
-        std::remove_if(
-            client_resource_list.begin(),
-            client_resource_list.end(),
-            [resource](auto candidate) { return candidate == resource; });
+        client_resource_list.erase(
+            std::remove(client_resource_list.begin(), client_resource_list.end(), resource),
+            client_resource_list.end());
     }
 
 private:
@@ -1827,6 +2129,15 @@ public:
         display_config.base_configuration()->for_each_output(std::bind(&OutputManager::create_output, this, std::placeholders::_1));
     }
 
+    /// The wl_output resources \a client has bound to output \a id
+    std::vector<wl_resource*> resources_for(wl_client* client, mg::DisplayConfigurationOutputId id) const
+    {
+        auto const output = outputs.find(id);
+        if (output == outputs.end())
+            return {};
+        return output->second->resources_for(client);
+    }
+
 private:
     void create_output(mg::DisplayConfigurationOutput const& initial_config)
     {
@@ -1867,6 +2178,39 @@ private:
     std::unordered_map<mg::DisplayConfigurationOutputId, std::unique_ptr<Output>> outputs;
 };
 
+void WpPresentationFeedback::presented(
+    unsigned int output_id,
+    mir::time::PosixTimestamp const& time,
+    std::chrono::nanoseconds refresh,
+    int64_t msc,
+    bool hardware_timestamp)
+{
+    if (*destroyed)
+        return;
+
+    // The client learns which output by the wl_output objects it has bound
+    mg::DisplayConfigurationOutputId const id{static_cast<int>(output_id)};
+    for (auto const output : outputs.resources_for(client, id))
+        wp_presentation_feedback_send_sync_output(resource, output);
+
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(time.nanoseconds);
+    auto const nanoseconds = time.nanoseconds - seconds;
+    wp_presentation_feedback_send_presented(
+        resource,
+        static_cast<uint64_t>(seconds.count()) >> 32,
+        static_cast<uint32_t>(seconds.count()),
+        static_cast<uint32_t>(nanoseconds.count()),
+        static_cast<uint32_t>(refresh.count()),
+        static_cast<uint64_t>(msc) >> 32,
+        static_cast<uint32_t>(msc),
+        hardware_timestamp ?
+            WP_PRESENTATION_FEEDBACK_KIND_VSYNC |
+            WP_PRESENTATION_FEEDBACK_KIND_HW_CLOCK |
+            WP_PRESENTATION_FEEDBACK_KIND_HW_COMPLETION :
+            WP_PRESENTATION_FEEDBACK_KIND_VSYNC);
+    wl_resource_destroy(resource);
+}
+
 class WlShellSurface : public wayland::ShellSurface
 {
 public:
@@ -1891,7 +2235,7 @@ public:
             .of_size(geom::Size{640, 480})
             .with_buffer_stream(mir_surface.stream_id);
 
-        auto const sink = std::make_shared<SurfaceEventSink>(&seat, client, surface, resource);
+        auto const sink = std::make_shared<SurfaceEventSink>(&seat, client, surface, resource, mir_surface.output_id);
         surface_id = shell->create_surface(session, params, sink);
 
         {
@@ -2207,6 +2551,7 @@ mf::WaylandConnector::WaylandConnector(
     DisplayChanger& display_config,
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
+    std::shared_ptr<ObserverRegistrar<mg::FrameObserver>> const& frame_observers,
     bool arw_socket)
     : display{wl_display_create(), &cleanup_display},
       pause_signal{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE)},
@@ -2236,15 +2581,20 @@ mf::WaylandConnector::WaylandConnector(
      */
     auto const executor = WaylandExecutor::executor_for_event_loop(wl_display_get_event_loop(display.get()));
 
+    presentation_clock = std::make_shared<mf::PresentationClock>();
+    frame_observers->register_interest(presentation_clock, *executor);
+
     compositor_global = std::make_unique<mf::WlCompositor>(
         display.get(),
         executor,
-        this->allocator);
+        this->allocator,
+        presentation_clock);
     seat_global = std::make_unique<mf::WlSeat>(display.get(), input_hub, executor);
     output_manager = std::make_unique<mf::OutputManager>(
         display.get(),
         display_config);
     shell_global = std::make_unique<mf::WlShell>(display.get(), shell, *seat_global);
+    presentation_global = std::make_unique<mf::WpPresentation>(display.get(), *output_manager);
 
     wl_display_init_shm(display.get());
 
@@ -22,6 +22,7 @@
 #include "mir/frontend/connector.h"
 #include "mir/fd.h"
 #include "mir/optional_value.h"
+#include "mir/observer_registrar.h"
 
 #include <wayland-server-core.h>
 #include <thread>
@@ -37,6 +38,7 @@ namespace graphics
 {
 class GraphicBufferAllocator;
 class WaylandAllocator;
+class FrameObserver;
 }
 
 namespace frontend
@@ -46,6 +48,8 @@ class WlApplication;
 class WlShell;
 class WlSeat;
 class OutputManager;
+class PresentationClock;
+class WpPresentation;
 
 class Shell;
 class DisplayChanger;
@@ -59,6 +63,7 @@ public:
         DisplayChanger& display_config,
         std::shared_ptr<input::InputDeviceHub> const& input_hub,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+        std::shared_ptr<ObserverRegistrar<graphics::FrameObserver>> const& frame_observers,
         bool arw_socket);
 
     ~WaylandConnector() override;
@@ -80,6 +85,8 @@ private:
     std::unique_ptr<OutputManager> output_manager;
     std::shared_ptr<graphics::WaylandAllocator> const allocator;
     std::unique_ptr<WlShell> shell_global;
+    std::shared_ptr<PresentationClock> presentation_clock;
+    std::unique_ptr<WpPresentation> presentation_global;
     std::thread dispatch_thread;
     wl_event_source* pause_source;
 };
@@ -44,6 +44,7 @@ std::shared_ptr<mf::Connector>
                 *the_frontend_display_changer(),
                 the_input_device_hub(),
                 the_buffer_allocator(),
+                the_frame_observer_registrar(),
                 arw_socket);
         });
 }
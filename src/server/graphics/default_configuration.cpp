@@ -34,6 +34,7 @@
 #include "mir/graphics/cursor.h"
 #include "mir/graphics/platform_probe.h"
 #include "display_configuration_observer_multiplexer.h"
+#include "frame_observer_multiplexer.h"
 
 #include "mir/shared_library.h"
 #include "mir/shared_library_prober.h"
@@ -79,6 +80,10 @@ std::shared_ptr<mg::Platform> mir::DefaultServerConfiguration::the_graphics_plat
         {
             std::shared_ptr<mir::SharedLibrary> platform_library;
             std::stringstream error_report;
+            // Platforms report each frame shown to the display report, which passes it on to frame observers
+            auto const display_report = std::make_shared<mg::FrameObservingDisplayReport>(
+                the_display_report(),
+                the_frame_observer());
             try
             {
                 // if a host socket is set we should use the host graphics module to create a "guest" platform
@@ -88,11 +93,11 @@ std::shared_ptr<mg::Platform> mir::DefaultServerConfiguration::the_graphics_plat
 
                     platform_library = std::make_shared<mir::SharedLibrary>(host_connection->graphics_platform_library());
                     auto buffer_platform = std::make_shared<mgn::NestedBufferPlatform>(
-                        platform_library, host_connection, the_display_report(), the_options());
+                        platform_library, host_connection, display_report, the_options());
                     return std::make_shared<mgn::Platform>(
                         buffer_platform,
                         std::make_unique<mgn::NestedDisplayPlatform>(
-                            buffer_platform, host_connection, the_display_report(), *the_options()));
+                            buffer_platform, host_connection, display_report, *the_options()));
                 }
 
                 // fallback to standalone if host socket is unset
@@ -124,7 +129,7 @@ std::shared_ptr<mg::Platform> mir::DefaultServerConfiguration::the_graphics_plat
                               description->minor_version,
                               description->micro_version);
 
-                return create_host_platform(the_options(), the_emergency_cleanup(), the_display_report(), the_logger());
+                return create_host_platform(the_options(), the_emergency_cleanup(), display_report, the_logger());
             }
             catch(...)
             {
@@ -296,3 +301,23 @@ mir::DefaultServerConfiguration::the_display_configuration_observer()
             return std::make_shared<mg::DisplayConfigurationObserverMultiplexer>(default_executor);
         });
 }
+
+std::shared_ptr<mir::ObserverRegistrar<mg::FrameObserver>>
+mir::DefaultServerConfiguration::the_frame_observer_registrar()
+{
+    return frame_observer_multiplexer(
+        [default_executor = the_main_loop()]
+        {
+            return std::make_shared<mg::FrameObserverMultiplexer>(default_executor);
+        });
+}
+
+std::shared_ptr<mg::FrameObserver>
+mir::DefaultServerConfiguration::the_frame_observer()
+{
+    return frame_observer_multiplexer(
+        [default_executor = the_main_loop()]
+        {
+            return std::make_shared<mg::FrameObserverMultiplexer>(default_executor);
+        });
+}
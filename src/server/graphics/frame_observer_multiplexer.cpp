@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_observer_multiplexer.h"
+#include "mir/graphics/frame.h"
+
+namespace mg = mir::graphics;
+
+mg::FrameObserverMultiplexer::FrameObserverMultiplexer(std::shared_ptr<Executor> const& default_executor)
+    : ObserverMultiplexer(*default_executor)
+{
+}
+
+void mg::FrameObserverMultiplexer::frame_shown(unsigned int output_id, Frame const& frame)
+{
+    for_each_observer(&mg::FrameObserver::frame_shown, output_id, frame);
+}
+
+mg::FrameObservingDisplayReport::FrameObservingDisplayReport(
+    std::shared_ptr<DisplayReport> const& wrapped,
+    std::shared_ptr<FrameObserver> const& observer)
+    : wrapped{wrapped},
+      observer{observer}
+{
+}
+
+void mg::FrameObservingDisplayReport::report_successful_setup_of_native_resources()
+{
+    wrapped->report_successful_setup_of_native_resources();
+}
+
+void mg::FrameObservingDisplayReport::report_successful_egl_make_current_on_construction()
+{
+    wrapped->report_successful_egl_make_current_on_construction();
+}
+
+void mg::FrameObservingDisplayReport::report_successful_egl_buffer_swap_on_construction()
+{
+    wrapped->report_successful_egl_buffer_swap_on_construction();
+}
+
+void mg::FrameObservingDisplayReport::report_successful_display_construction()
+{
+    wrapped->report_successful_display_construction();
+}
+
+void mg::FrameObservingDisplayReport::report_egl_configuration(EGLDisplay disp, EGLConfig cfg)
+{
+    wrapped->report_egl_configuration(disp, cfg);
+}
+
+void mg::FrameObservingDisplayReport::report_vsync(unsigned int output_id, Frame const& frame)
+{
+    wrapped->report_vsync(output_id, frame);
+    observer->frame_shown(output_id, frame);
+}
+
+void mg::FrameObservingDisplayReport::report_successful_drm_mode_set_crtc_on_construction()
+{
+    wrapped->report_successful_drm_mode_set_crtc_on_construction();
+}
+
+void mg::FrameObservingDisplayReport::report_drm_master_failure(int error)
+{
+    wrapped->report_drm_master_failure(error);
+}
+
+void mg::FrameObservingDisplayReport::report_vt_switch_away_failure()
+{
+    wrapped->report_vt_switch_away_failure();
+}
+
+void mg::FrameObservingDisplayReport::report_vt_switch_back_failure()
+{
+    wrapped->report_vt_switch_back_failure();
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_GRAPHICS_FRAME_OBSERVER_MULTIPLEXER_H_
+#define MIR_GRAPHICS_FRAME_OBSERVER_MULTIPLEXER_H_
+
+#include "mir/observer_registrar.h"
+#include "mir/observer_multiplexer.h"
+#include "mir/graphics/frame_observer.h"
+#include "mir/graphics/display_report.h"
+
+namespace mir
+{
+namespace graphics
+{
+class FrameObserverMultiplexer : public ObserverMultiplexer<FrameObserver>
+{
+public:
+    FrameObserverMultiplexer(std::shared_ptr<Executor> const& default_executor);
+
+    void frame_shown(unsigned int output_id, Frame const& frame) override;
+};
+
+/**
+ * The platforms report each page flip to the DisplayReport, so that's where
+ * frame observers hear about them: everything is passed on to the report
+ * that was configured, and vsyncs to the observers too.
+ */
+class FrameObservingDisplayReport : public DisplayReport
+{
+public:
+    FrameObservingDisplayReport(
+        std::shared_ptr<DisplayReport> const& wrapped,
+        std::shared_ptr<FrameObserver> const& observer);
+
+    void report_successful_setup_of_native_resources() override;
+    void report_successful_egl_make_current_on_construction() override;
+    void report_successful_egl_buffer_swap_on_construction() override;
+    void report_successful_display_construction() override;
+    void report_egl_configuration(EGLDisplay disp, EGLConfig cfg) override;
+    void report_vsync(unsigned int output_id, Frame const& frame) override;
+    void report_successful_drm_mode_set_crtc_on_construction() override;
+    void report_drm_master_failure(int error) override;
+    void report_vt_switch_away_failure() override;
+    void report_vt_switch_back_failure() override;
+
+private:
+    std::shared_ptr<DisplayReport> const wrapped;
+    std::shared_ptr<FrameObserver> const observer;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_FRAME_OBSERVER_MULTIPLEXER_H_ */
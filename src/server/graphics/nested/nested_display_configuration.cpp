@@ -141,7 +141,9 @@ mg::DisplayConfigurationOutput mgn::NestedDisplayConfiguration::create_display_o
         local_config.gamma,
         local_config.gamma_supported,
         std::move(edid),
-        custom_logical_size
+        custom_logical_size,
+        false,
+        false
     };
 }
 
@@ -41,7 +41,9 @@ mgo::DisplayConfiguration::DisplayConfiguration(geom::Size const& display_size)
                  {},
                  mir_output_gamma_unsupported,
                  {},
-                 {}},
+                 {},
+                 false,
+                 false},
           card{mg::DisplayConfigurationCardId{0}, 1}
 {
 }
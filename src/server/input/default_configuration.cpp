@@ -30,6 +30,7 @@
 #include "default_input_device_hub.h"
 #include "default_input_manager.h"
 #include "surface_input_dispatcher.h"
+#include "motion_batcher.h"
 #include "basic_seat.h"
 #include "seat_observer_multiplexer.h"
 #include "../graphics/nested/input_platform.h"
@@ -49,6 +50,7 @@
 #include "mir/log.h"
 #include "mir/shared_library.h"
 #include "mir/dispatch/action_queue.h"
+#include "mir/observer_registrar.h"
 
 #include "mir_toolkit/cursors.h"
 
@@ -101,7 +103,24 @@ mir::DefaultServerConfiguration::the_surface_input_dispatcher()
     return surface_input_dispatcher(
         [this]()
         {
-            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene());
+            auto const batching = the_options()->get<std::string>(options::input_motion_batching_opt);
+
+            std::shared_ptr<mi::MotionBatcher> motion_batcher;
+            if (batching == "coalesce" || batching == "history")
+            {
+                motion_batcher = std::make_shared<mi::MotionBatcher>(
+                    batching == "coalesce" ? mi::MotionBatcher::Mode::coalesce : mi::MotionBatcher::Mode::history,
+                    the_main_loop());
+                the_frame_observer_registrar()->register_interest(motion_batcher);
+                the_display_configuration_observer_registrar()->register_interest(motion_batcher);
+            }
+            else if (batching != options::off_opt_value)
+            {
+                throw AbnormalExit(std::string("Invalid ") + options::input_motion_batching_opt + " option: " +
+                    batching + " (valid options are: \"off\", \"coalesce\" and \"history\")");
+            }
+
+            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene(), motion_batcher);
         });
 }
 
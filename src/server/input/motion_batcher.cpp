@@ -0,0 +1,412 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "motion_batcher.h"
+
+#include "mir/input/surface.h"
+#include "mir/events/event_builders.h"
+#include "mir/graphics/display_configuration.h"
+#include "mir/lockable_callback.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+
+#include <algorithm>
+
+namespace mi = mir::input;
+namespace mg = mir::graphics;
+namespace mev = mir::events;
+
+namespace
+{
+// Touches are extrapolated no further than this past the newest sample
+std::chrono::milliseconds const max_extrapolation{8};
+
+// Until frames have been measured, assume 60Hz
+std::chrono::nanoseconds const default_frame_interval{16666667};
+
+// Means "deliver the events as they are"
+std::chrono::nanoseconds const no_resampling{0};
+
+bool is_motion(MirEvent const& ev)
+{
+    if (mir_event_get_type(&ev) != mir_event_type_input)
+        return false;
+
+    auto const* input_ev = mir_event_get_input_event(&ev);
+    switch (mir_input_event_get_type(input_ev))
+    {
+    case mir_input_event_type_pointer:
+        return mir_pointer_event_action(mir_input_event_get_pointer_event(input_ev)) == mir_pointer_action_motion;
+
+    case mir_input_event_type_touch:
+    {
+        auto const* tev = mir_input_event_get_touch_event(input_ev);
+        for (auto i = 0u; i != mir_touch_event_point_count(tev); ++i)
+            if (mir_touch_event_action(tev, i) != mir_touch_action_change)
+                return false;
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool can_merge(MirEvent const& earlier, MirEvent const& later)
+{
+    auto const* earlier_input = mir_event_get_input_event(&earlier);
+    auto const* later_input = mir_event_get_input_event(&later);
+
+    if (mir_input_event_get_type(earlier_input) != mir_input_event_get_type(later_input) ||
+        mir_input_event_get_device_id(earlier_input) != mir_input_event_get_device_id(later_input))
+        return false;
+
+    if (mir_input_event_get_type(later_input) == mir_input_event_type_pointer)
+    {
+        auto const* earlier_pev = mir_input_event_get_pointer_event(earlier_input);
+        auto const* later_pev = mir_input_event_get_pointer_event(later_input);
+
+        return mir_pointer_event_buttons(earlier_pev) == mir_pointer_event_buttons(later_pev) &&
+               mir_pointer_event_modifiers(earlier_pev) == mir_pointer_event_modifiers(later_pev);
+    }
+
+    auto const* earlier_tev = mir_input_event_get_touch_event(earlier_input);
+    auto const* later_tev = mir_input_event_get_touch_event(later_input);
+
+    auto const point_count = mir_touch_event_point_count(later_tev);
+    if (mir_touch_event_point_count(earlier_tev) != point_count ||
+        mir_touch_event_modifiers(earlier_tev) != mir_touch_event_modifiers(later_tev))
+        return false;
+
+    for (auto i = 0u; i != point_count; ++i)
+        if (mir_touch_event_id(earlier_tev, i) != mir_touch_event_id(later_tev, i))
+            return false;
+
+    return true;
+}
+
+bool is_touch(MirEvent const& ev)
+{
+    return mir_input_event_get_type(mir_event_get_input_event(&ev)) == mir_input_event_type_touch;
+}
+
+/// Folds the relative motion of \a earlier into \a later, which supersedes it
+void merge_into(MirEvent& later, MirEvent const& earlier)
+{
+    if (is_touch(later))
+        return; // Touches only carry absolute positions
+
+    auto const* earlier_pev = mir_input_event_get_pointer_event(mir_event_get_input_event(&earlier));
+    auto const* later_pev = mir_input_event_get_pointer_event(mir_event_get_input_event(&later));
+
+    auto const sum = [&](MirPointerAxis axis)
+        {
+            return mir_pointer_event_axis_value(earlier_pev, axis) + mir_pointer_event_axis_value(later_pev, axis);
+        };
+
+    mev::set_relative_motion(later, sum(mir_pointer_axis_relative_x), sum(mir_pointer_axis_relative_y));
+    mev::set_scroll(later, sum(mir_pointer_axis_hscroll), sum(mir_pointer_axis_vscroll));
+}
+
+std::chrono::nanoseconds event_time(MirEvent const& ev)
+{
+    return std::chrono::nanoseconds{mir_input_event_get_event_time(mir_event_get_input_event(&ev))};
+}
+
+/**
+ * Moves the touches in \a latest along the line from \a previous to where
+ * they would be at \a target_time.
+ */
+void resample(MirEvent& latest, MirEvent const& previous, std::chrono::nanoseconds target_time)
+{
+    auto const t0 = event_time(previous);
+    auto const t1 = event_time(latest);
+    if (t1 <= t0 || target_time < t0)
+        return;
+
+    target_time = std::min<std::chrono::nanoseconds>(target_time, t1 + max_extrapolation);
+    auto const alpha = float((target_time - t0).count()) / (t1 - t0).count();
+
+    auto const* previous_tev = mir_input_event_get_touch_event(mir_event_get_input_event(&previous));
+    auto const* latest_tev = mir_input_event_get_touch_event(mir_event_get_input_event(&latest));
+
+    for (auto i = 0u; i != mir_touch_event_point_count(latest_tev); ++i)
+    {
+        auto const along = [&](MirTouchAxis axis)
+            {
+                auto const from = mir_touch_event_axis_value(previous_tev, i, axis);
+                return from + alpha * (mir_touch_event_axis_value(latest_tev, i, axis) - from);
+            };
+
+        mev::set_touch_position(latest, i, along(mir_touch_axis_x), along(mir_touch_axis_y));
+    }
+    mev::set_event_time(latest, target_time);
+}
+}
+
+mi::MotionBatcher::Held::Held(std::shared_ptr<Surface> const& surface)
+    : key{surface.get()},
+      surface{surface},
+      previous_touch{nullptr, [](MirEvent*){}}
+{
+}
+
+/// Takes the batcher's lock before the alarm takes its own, so the alarm
+/// can be cancelled and rescheduled with the batcher's lock held
+class mi::MotionBatcher::FallbackFlush : public LockableCallback
+{
+public:
+    FallbackFlush(MotionBatcher& batcher)
+        : batcher{batcher}
+    {
+    }
+
+    void operator()() override
+    {
+        batcher.flush_all(*lock_held, no_resampling);
+    }
+
+    void lock() override
+    {
+        lock_held = std::make_unique<std::lock_guard<std::mutex>>(batcher.mutex);
+    }
+
+    void unlock() override
+    {
+        lock_held.reset();
+    }
+
+private:
+    MotionBatcher& batcher;
+    std::unique_ptr<std::lock_guard<std::mutex>> lock_held;
+};
+
+mi::MotionBatcher::MotionBatcher(Mode mode, std::shared_ptr<time::AlarmFactory> const& alarm_factory)
+    : mode{mode},
+      fallback_alarm{alarm_factory->create_alarm(std::make_unique<FallbackFlush>(*this))}
+{
+}
+
+mi::MotionBatcher::~MotionBatcher()
+{
+    fallback_alarm->cancel();
+}
+
+void mi::MotionBatcher::deliver(std::shared_ptr<Surface> const& surface, EventUPtr event)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (is_motion(*event))
+    {
+        hold(lock, surface, std::move(event));
+        return;
+    }
+
+    auto const it = std::find_if(held.begin(), held.end(),
+        [&surface](Held const& h) { return h.key == surface.get(); });
+    if (it != held.end())
+    {
+        flush(lock, *it, no_resampling);
+        held.erase(it);
+    }
+
+    surface->consume(event.get());
+}
+
+void mi::MotionBatcher::surface_removed(Surface const* surface)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    held.erase(
+        std::remove_if(held.begin(), held.end(), [surface](Held const& h) { return h.key == surface; }),
+        held.end());
+}
+
+void mi::MotionBatcher::frame_shown(unsigned int output_id, mg::Frame const& frame)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& output = outputs.emplace(output_id, Output{{}, default_frame_interval, {}}).first->second;
+    if (output.last_frame.is_set())
+    {
+        auto const& last = output.last_frame.value();
+        if (last.ust.clock_id == frame.ust.clock_id &&
+            frame.msc > last.msc &&
+            frame.ust.nanoseconds > last.ust.nanoseconds)
+        {
+            output.frame_interval = (frame.ust - last.ust) / (frame.msc - last.msc);
+        }
+    }
+    output.last_frame = frame;
+
+    // Input timestamps are CLOCK_MONOTONIC, so frames timed otherwise can't be predicted against
+    auto const predicted_present = frame.ust.clock_id == CLOCK_MONOTONIC ?
+        frame.ust.nanoseconds + output.frame_interval : no_resampling;
+
+    // Without knowing where the output is, we can't tell who is on it
+    if (output.extents == geometry::Rectangle{})
+    {
+        flush_all(lock, predicted_present);
+    }
+    else
+    {
+        for (auto h = held.begin(); h != held.end();)
+        {
+            auto const surface = h->surface.lock();
+            if (surface && !surface->input_bounds().overlaps(output.extents))
+            {
+                ++h;
+                continue;
+            }
+
+            flush(lock, *h, predicted_present);
+            h = held.erase(h);
+        }
+    }
+
+    if (held.empty())
+        fallback_alarm->cancel();
+}
+
+void mi::MotionBatcher::initial_configuration(std::shared_ptr<mg::DisplayConfiguration const> const& config)
+{
+    update_outputs(*config);
+}
+
+void mi::MotionBatcher::configuration_applied(std::shared_ptr<mg::DisplayConfiguration const> const& config)
+{
+    update_outputs(*config);
+}
+
+void mi::MotionBatcher::base_configuration_updated(std::shared_ptr<mg::DisplayConfiguration const> const&)
+{
+}
+
+void mi::MotionBatcher::session_configuration_applied(
+    std::shared_ptr<frontend::Session> const&,
+    std::shared_ptr<mg::DisplayConfiguration> const&)
+{
+}
+
+void mi::MotionBatcher::session_configuration_removed(std::shared_ptr<frontend::Session> const&)
+{
+}
+
+void mi::MotionBatcher::configuration_failed(
+    std::shared_ptr<mg::DisplayConfiguration const> const&,
+    std::exception const&)
+{
+}
+
+void mi::MotionBatcher::catastrophic_configuration_error(
+    std::shared_ptr<mg::DisplayConfiguration const> const&,
+    std::exception const&)
+{
+}
+
+void mi::MotionBatcher::update_outputs(mg::DisplayConfiguration const& config)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    outputs.clear();
+    config.for_each_output(
+        [this](mg::DisplayConfigurationOutput const& output)
+        {
+            if (!output.used || !output.connected || !output.valid() ||
+                output.current_mode_index >= output.modes.size())
+                return;
+
+            // Until frames on the output have been measured, go by its mode
+            auto const vrefresh_hz = output.modes[output.current_mode_index].vrefresh_hz;
+            auto const frame_interval = vrefresh_hz > 0 ?
+                std::chrono::nanoseconds{static_cast<int64_t>(1e9 / vrefresh_hz)} : default_frame_interval;
+
+            outputs[output.id.as_value()] = Output{output.extents(), frame_interval, {}};
+        });
+}
+
+auto mi::MotionBatcher::frame_interval_for(std::lock_guard<std::mutex> const&, Surface const& surface) const
+    -> std::chrono::nanoseconds
+{
+    auto const bounds = surface.input_bounds();
+
+    auto result = std::chrono::nanoseconds::max();
+    for (auto const& output : outputs)
+    {
+        if (output.second.extents.overlaps(bounds))
+            result = std::min(result, output.second.frame_interval);
+    }
+
+    return result == std::chrono::nanoseconds::max() ? default_frame_interval : result;
+}
+
+void mi::MotionBatcher::hold(
+    std::lock_guard<std::mutex> const& lock,
+    std::shared_ptr<Surface> const& surface,
+    EventUPtr event)
+{
+    // Nothing may be composited for a while (a hardware cursor moving over
+    // an idle screen, say), so don't wait longer than a frame for one.
+    if (held.empty())
+    {
+        auto const fallback = std::chrono::duration_cast<std::chrono::milliseconds>(
+            frame_interval_for(lock, *surface) + std::chrono::milliseconds{1} - std::chrono::nanoseconds{1});
+        fallback_alarm->reschedule_in(fallback);
+    }
+
+    auto it = std::find_if(held.begin(), held.end(),
+        [&surface](Held const& h) { return h.key == surface.get(); });
+    if (it == held.end())
+        it = held.emplace(held.end(), surface);
+
+    auto& events = it->events;
+    if (mode == Mode::coalesce && !events.empty() && can_merge(*events.back(), *event))
+    {
+        merge_into(*event, *events.back());
+        if (is_touch(*event))
+            it->previous_touch = std::move(events.back());
+        events.back() = std::move(event);
+    }
+    else
+    {
+        it->previous_touch.reset();
+        events.push_back(std::move(event));
+    }
+}
+
+void mi::MotionBatcher::flush(
+    std::lock_guard<std::mutex> const&,
+    Held& held,
+    std::chrono::nanoseconds present_time)
+{
+    auto const surface = held.surface.lock();
+    if (!surface)
+        return;
+
+    if (present_time != no_resampling && held.previous_touch)
+        resample(*held.events.back(), *held.previous_touch, present_time);
+
+    for (auto const& event : held.events)
+        surface->consume(event.get());
+}
+
+void mi::MotionBatcher::flush_all(std::lock_guard<std::mutex> const& lock, std::chrono::nanoseconds present_time)
+{
+    for (auto& h : held)
+        flush(lock, h, present_time);
+
+    held.clear();
+}
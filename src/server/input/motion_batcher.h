@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_MOTION_BATCHER_H_
+#define MIR_INPUT_MOTION_BATCHER_H_
+
+#include "mir/graphics/frame_observer.h"
+#include "mir/graphics/display_configuration_observer.h"
+#include "mir/graphics/frame.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/optional_value.h"
+#include "mir_toolkit/event.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+using EventUPtr = std::unique_ptr<MirEvent, void(*)(MirEvent*)>;
+
+namespace time
+{
+class Alarm;
+class AlarmFactory;
+}
+namespace input
+{
+class Surface;
+
+/**
+ * Holds pointer and touch motion for each surface until the next frame is
+ * shown on an output the surface is on, so that a client hears about high
+ * rate devices about once a frame rather than once an event. Anything that
+ * isn't motion is delivered at once, after the motion held for the same
+ * surface.
+ */
+class MotionBatcher : public graphics::FrameObserver, public graphics::DisplayConfigurationObserver
+{
+public:
+    enum class Mode
+    {
+        coalesce,   ///< Merge held motion into one event, resampling touches
+        history     ///< Deliver every held event together
+    };
+
+    MotionBatcher(Mode mode, std::shared_ptr<time::AlarmFactory> const& alarm_factory);
+    ~MotionBatcher();
+
+    void deliver(std::shared_ptr<Surface> const& surface, EventUPtr event);
+
+    /// Drops what is held for \a surface, which is going away
+    void surface_removed(Surface const* surface);
+
+    void frame_shown(unsigned int output_id, graphics::Frame const& frame) override;
+
+    void initial_configuration(std::shared_ptr<graphics::DisplayConfiguration const> const& config) override;
+    void configuration_applied(std::shared_ptr<graphics::DisplayConfiguration const> const& config) override;
+    void base_configuration_updated(std::shared_ptr<graphics::DisplayConfiguration const> const&) override;
+    void session_configuration_applied(
+        std::shared_ptr<frontend::Session> const&,
+        std::shared_ptr<graphics::DisplayConfiguration> const&) override;
+    void session_configuration_removed(std::shared_ptr<frontend::Session> const&) override;
+    void configuration_failed(
+        std::shared_ptr<graphics::DisplayConfiguration const> const&,
+        std::exception const&) override;
+    void catastrophic_configuration_error(
+        std::shared_ptr<graphics::DisplayConfiguration const> const&,
+        std::exception const&) override;
+
+private:
+    class FallbackFlush;
+
+    struct Output
+    {
+        /// Empty for an output the display configuration hasn't told us about
+        geometry::Rectangle extents;
+        std::chrono::nanoseconds frame_interval;
+        optional_value<graphics::Frame> last_frame;
+    };
+
+    struct Held
+    {
+        Held(std::shared_ptr<Surface> const& surface);
+
+        Surface const* key;
+        std::weak_ptr<Surface> surface;
+        std::vector<EventUPtr> events;
+        /// The touch merged into the last held event, kept for resampling
+        EventUPtr previous_touch;
+    };
+
+    void hold(std::lock_guard<std::mutex> const&, std::shared_ptr<Surface> const& surface, EventUPtr event);
+    void flush(std::lock_guard<std::mutex> const&, Held& held, std::chrono::nanoseconds present_time);
+    void flush_all(std::lock_guard<std::mutex> const&, std::chrono::nanoseconds present_time);
+    void update_outputs(graphics::DisplayConfiguration const& config);
+    auto frame_interval_for(std::lock_guard<std::mutex> const&, Surface const& surface) const
+        -> std::chrono::nanoseconds;
+
+    Mode const mode;
+
+    std::mutex mutex;
+    std::vector<Held> held;
+    std::unordered_map<unsigned int, Output> outputs;
+    std::unique_ptr<time::Alarm> const fallback_alarm;
+};
+}
+}
+
+#endif /* MIR_INPUT_MOTION_BATCHER_H_ */
@@ -17,6 +17,7 @@
  */
 
 #include "surface_input_dispatcher.h"
+#include "motion_batcher.h"
 
 #include "mir/input/scene.h"
 #include "mir/input/surface.h"
@@ -70,7 +71,7 @@ struct InputDispatcherSceneObserver : public ms::Observer
     std::function<void(ms::Surface*)> const on_removed;
 };
 
-void deliver_without_relative_motion(
+mir::EventUPtr prepare_without_relative_motion(
     std::shared_ptr<mi::Surface> const& surface,
     MirEvent const* ev,
     std::vector<uint8_t> const& drag_and_drop_handle)
@@ -103,10 +104,10 @@ void deliver_without_relative_motion(
     mev::transform_positions(*to_deliver, geom::Displacement{bounds.top_left.x.as_int(), bounds.top_left.y.as_int()});
     if (!drag_and_drop_handle.empty())
         mev::set_drag_and_drop_handle(*to_deliver, drag_and_drop_handle);
-    surface->consume(to_deliver.get());
+    return to_deliver;
 }
 
-void deliver(
+mir::EventUPtr prepare(
     std::shared_ptr<mi::Surface> const& surface,
     MirEvent const* ev,
     std::vector<uint8_t> const& drag_and_drop_handle)
@@ -118,13 +119,21 @@ void deliver(
 
     auto const& bounds = surface->input_bounds();
     mev::transform_positions(*to_deliver, geom::Displacement{bounds.top_left.x.as_int(), bounds.top_left.y.as_int()});
-    surface->consume(to_deliver.get());
+    return to_deliver;
 }
 
 }
 
 mi::SurfaceInputDispatcher::SurfaceInputDispatcher(std::shared_ptr<mi::Scene> const& scene)
+    : SurfaceInputDispatcher(scene, nullptr)
+{
+}
+
+mi::SurfaceInputDispatcher::SurfaceInputDispatcher(
+    std::shared_ptr<mi::Scene> const& scene,
+    std::shared_ptr<MotionBatcher> const& motion_batcher)
     : scene(scene),
+      motion_batcher(motion_batcher),
       started(false)
 {
     scene_observer = std::make_shared<InputDispatcherSceneObserver>([this](ms::Surface* s){surface_removed(s);});
@@ -169,6 +178,9 @@ void mi::SurfaceInputDispatcher::surface_removed(ms::Surface *surface)
         if (compare_surfaces(state.gesture_owner, surface))
             state.gesture_owner.reset();
     }
+
+    if (motion_batcher)
+        motion_batcher->surface_removed(static_cast<mi::Surface*>(surface));
 }
 
 void mi::SurfaceInputDispatcher::device_reset(MirInputDeviceId reset_device_id, std::chrono::nanoseconds /* when */)
@@ -198,7 +210,10 @@ bool mi::SurfaceInputDispatcher::dispatch_key(MirEvent const* kev)
     if (!strong_focus)
         return false;
 
-    strong_focus->consume(kev);
+    if (motion_batcher)
+        motion_batcher->deliver(strong_focus, mev::clone_event(*kev));
+    else
+        strong_focus->consume(kev);
 
     return true;
 }
@@ -228,12 +243,7 @@ bool is_gesture_terminator(MirPointerEvent const* pev)
 
 std::shared_ptr<mi::Surface> mi::SurfaceInputDispatcher::find_target_surface(geom::Point const& point)
 {
-    std::shared_ptr<mi::Surface> top_target = nullptr;
-    scene->for_each([&top_target, &point](std::shared_ptr<mi::Surface> const& target) {
-            if (target->input_area_contains(point))
-                top_target = target;
-    });
-    return top_target;
+    return scene->top_surface_at(point);
 }
 
 void mi::SurfaceInputDispatcher::send_enter_exit_event(std::shared_ptr<mi::Surface> const& surface,
@@ -257,7 +267,15 @@ void mi::SurfaceInputDispatcher::send_enter_exit_event(std::shared_ptr<mi::Surfa
 
     if (!drag_and_drop_handle.empty())
         mev::set_drag_and_drop_handle(*event, drag_and_drop_handle);
-    surface->consume(event.get());
+    deliver(surface, std::move(event));
+}
+
+void mi::SurfaceInputDispatcher::deliver(std::shared_ptr<mi::Surface> const& surface, EventUPtr event)
+{
+    if (motion_batcher)
+        motion_batcher->deliver(surface, std::move(event));
+    else
+        surface->consume(event.get());
 }
 
 mi::SurfaceInputDispatcher::PointerInputState& mi::SurfaceInputDispatcher::ensure_pointer_state(MirInputDeviceId id)
@@ -284,7 +302,7 @@ bool mi::SurfaceInputDispatcher::dispatch_pointer(MirInputDeviceId id, MirEvent
 
     if (pointer_state.gesture_owner)
     {
-        deliver(pointer_state.gesture_owner, ev, drag_and_drop_handle);
+        deliver(pointer_state.gesture_owner, prepare(pointer_state.gesture_owner, ev, drag_and_drop_handle));
 
         auto const gesture_terminated = is_gesture_terminator(pev);
 
@@ -345,11 +363,11 @@ bool mi::SurfaceInputDispatcher::dispatch_pointer(MirInputDeviceId id, MirEvent
         if (sent_ev)
         {
             if (action != mir_pointer_action_motion)
-                deliver_without_relative_motion(target, ev, drag_and_drop_handle);
+                deliver(target, prepare_without_relative_motion(target, ev, drag_and_drop_handle));
         }
         else
         {
-            deliver(target, ev, drag_and_drop_handle);
+            deliver(target, prepare(target, ev, drag_and_drop_handle));
         }
         return true;
     }
@@ -405,7 +423,7 @@ bool mi::SurfaceInputDispatcher::dispatch_touch(MirInputDeviceId id, MirEvent co
 
     if (gesture_owner)
     {
-        deliver(gesture_owner, ev, drag_and_drop_handle);
+        deliver(gesture_owner, prepare(gesture_owner, ev, drag_and_drop_handle));
 
         if (is_gesture_end(tev))
             gesture_owner.reset();
@@ -30,6 +30,8 @@
 
 namespace mir
 {
+using EventUPtr = std::unique_ptr<MirEvent, void(*)(MirEvent*)>;
+
 namespace scene
 {
 class Observer;
@@ -39,11 +41,16 @@ namespace input
 {
 class Surface;
 class Scene;
+class MotionBatcher;
 
 class SurfaceInputDispatcher : public mir::input::InputDispatcher, public shell::InputTargeter
 {
 public:
     SurfaceInputDispatcher(std::shared_ptr<input::Scene> const& scene);
+    /// Motion goes through \a motion_batcher, if not null, on its way to surfaces
+    SurfaceInputDispatcher(
+        std::shared_ptr<input::Scene> const& scene,
+        std::shared_ptr<MotionBatcher> const& motion_batcher);
     ~SurfaceInputDispatcher();
 
     // mir::input::InputDispatcher
@@ -66,6 +73,7 @@ private:
 
     void send_enter_exit_event(std::shared_ptr<input::Surface> const& surface,
         MirPointerEvent const* triggering_ev, MirPointerAction action);
+    void deliver(std::shared_ptr<input::Surface> const& surface, EventUPtr event);
 
     std::shared_ptr<input::Surface> find_target_surface(geometry::Point const& target);
 
@@ -90,6 +98,7 @@ private:
     TouchInputState& ensure_touch_state(MirInputDeviceId id);
     
     std::shared_ptr<input::Scene> const scene;
+    std::shared_ptr<MotionBatcher> const motion_batcher;
 
     std::shared_ptr<scene::Observer> scene_observer;
 
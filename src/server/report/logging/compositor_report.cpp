@@ -166,6 +166,34 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::render_time_estimated(
+    SubCompositorId id,
+    std::chrono::microseconds last_frame,
+    std::chrono::microseconds predicted)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& inst = instance[id];
+
+    // Small wobbles in the prediction are routine and not worth a line each
+    auto const change = predicted - inst.last_reported_prediction;
+    if (change < std::chrono::milliseconds(1) && change > -std::chrono::milliseconds(1))
+        return;
+    inst.last_reported_prediction = predicted;
+
+    long long const last_usec = last_frame.count();
+    long long const predicted_usec = predicted.count();
+
+    char msg[128];
+    snprintf(msg, sizeof msg, "Display %p rendered in %lld.%03lld ms, "
+             "allowing %lld.%03lld ms for the next frame",
+             id,
+             last_usec / 1000,
+             last_usec % 1000,
+             predicted_usec / 1000,
+             predicted_usec % 1000);
+    logger->log(ml::Severity::informational, msg, component);
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
@@ -47,6 +47,10 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void render_time_estimated(
+        SubCompositorId id,
+        std::chrono::microseconds last_frame,
+        std::chrono::microseconds predicted) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -75,6 +79,7 @@ private:
         TimePoint last_reported_latency_sum;
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
+        std::chrono::microseconds last_reported_prediction{0};
 
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
@@ -62,3 +62,11 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::render_time_estimated(
+    SubCompositorId id,
+    std::chrono::microseconds last_frame,
+    std::chrono::microseconds predicted)
+{
+    mir_tracepoint(mir_server_compositor, render_time_estimated, id, last_frame.count(), predicted.count());
+}
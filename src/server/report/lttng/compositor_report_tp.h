@@ -77,6 +77,17 @@ TRACEPOINT_EVENT(
     )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    render_time_estimated,
+    TP_ARGS(void const*, id, int64_t, last_frame_us, int64_t, predicted_us),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int64_t, last_frame_us, last_frame_us)
+        ctf_integer(int64_t, predicted_us, predicted_us)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
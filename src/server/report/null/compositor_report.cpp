@@ -40,6 +40,11 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::render_time_estimated(
+    SubCompositorId, std::chrono::microseconds, std::chrono::microseconds)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
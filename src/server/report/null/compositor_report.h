@@ -36,6 +36,10 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void render_time_estimated(
+        SubCompositorId id,
+        std::chrono::microseconds last_frame,
+        std::chrono::microseconds predicted) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -47,6 +47,7 @@ namespace msh = mir::shell;
 namespace mg = mir::graphics;
 namespace mev = mir::events;
 namespace mc = mir::compositor;
+namespace geom = mir::geometry;
 
 ms::ApplicationSession::ApplicationSession(
     std::shared_ptr<msh::SurfaceStack> const& surface_stack,
@@ -240,6 +241,22 @@ std::shared_ptr<ms::Surface> ms::ApplicationSession::surface_after(std::shared_p
 }
 
 void ms::ApplicationSession::take_snapshot(SnapshotCallback const& snapshot_taken)
+{
+    if (auto const stream = default_content_stream())
+        snapshot_strategy->take_snapshot_of(stream, snapshot_taken);
+    else
+        snapshot_taken(Snapshot());
+}
+
+void ms::ApplicationSession::take_snapshot(geom::Size const& max_size, SnapshotCallback const& snapshot_taken)
+{
+    if (auto const stream = default_content_stream())
+        snapshot_strategy->take_snapshot_of(stream, max_size, snapshot_taken);
+    else
+        snapshot_taken(Snapshot());
+}
+
+std::shared_ptr<mc::BufferStream> ms::ApplicationSession::default_content_stream()
 {
     //TODO: taking a snapshot of a session doesn't make much sense. Snapshots can be on surfaces
     //or bufferstreams, as those represent some content. A multi-surface session doesn't have enough
@@ -249,12 +266,11 @@ void ms::ApplicationSession::take_snapshot(SnapshotCallback const& snapshot_take
         if (default_surface() == surface_it.second)
         {
             auto id = default_content_map[surface_it.first];
-            snapshot_strategy->take_snapshot_of(checked_find(id)->second, snapshot_taken);
-            return;
+            return checked_find(id)->second;
         }
     }
 
-    snapshot_taken(Snapshot());
+    return {};
 }
 
 std::shared_ptr<ms::Surface> ms::ApplicationSession::default_surface() const
@@ -76,6 +76,7 @@ public:
     std::shared_ptr<Surface> surface_after(std::shared_ptr<Surface> const&) const override;
 
     void take_snapshot(SnapshotCallback const& snapshot_taken) override;
+    void take_snapshot(geometry::Size const& max_size, SnapshotCallback const& snapshot_taken) override;
     std::shared_ptr<Surface> default_surface() const override;
 
     std::string name() const override;
@@ -125,6 +126,8 @@ private:
     typedef std::map<frontend::BufferStreamId, std::shared_ptr<compositor::BufferStream>> Streams;
     Surfaces::const_iterator checked_find(frontend::SurfaceId id) const;
     Streams::const_iterator checked_find(frontend::BufferStreamId id) const;
+    /// The stream holding the default surface's content, or null if there is none
+    std::shared_ptr<compositor::BufferStream> default_content_stream();
     std::mutex mutable surfaces_and_streams_mutex;
     Surfaces surfaces;
     Streams streams;
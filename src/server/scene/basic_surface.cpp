@@ -150,6 +150,12 @@ void ms::SurfaceObservers::start_drag_and_drop(std::vector<uint8_t> const& handl
                  { observer->start_drag_and_drop(handle); });
 }
 
+void ms::SurfaceObservers::input_region_set_to(std::vector<geometry::Rectangle> const& region)
+{
+    for_each([&](std::shared_ptr<SurfaceObserver> const& observer)
+                 { observer->input_region_set_to(region); });
+}
+
 
 struct ms::CursorStreamImageAdapter
 {
@@ -316,9 +322,18 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 }
 
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
+{
+    {
+        std::unique_lock<std::mutex> lock(guard);
+        custom_input_rectangles = input_rectangles;
+    }
+    observers.input_region_set_to(input_rectangles);
+}
+
+std::vector<geom::Rectangle> ms::BasicSurface::input_region() const
 {
     std::unique_lock<std::mutex> lock(guard);
-    custom_input_rectangles = input_rectangles;
+    return custom_input_rectangles;
 }
 
 void ms::BasicSurface::resize(geom::Size const& desired_size)
@@ -823,6 +838,32 @@ public:
     bool shaped() const override
     { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    {
+        std::vector<geom::Rectangle> region;
+
+        // The region the client gave with the buffer being composited, not
+        // whatever it has set since
+        auto const shown = buffer();
+        if (!shown)
+            return region;
+
+        // The client's region is in buffer coordinates, which only match
+        // ours while the buffer is shown unscaled.
+        if (shown->size() != screen_position_.size)
+            return region;
+
+        auto const offset = screen_position_.top_left - geom::Point{};
+        for (auto const& rect : underlying_buffer_stream->opaque_region(*shown))
+        {
+            auto const opaque = geom::Rectangle{rect.top_left + offset, rect.size}
+                .intersection_with(screen_position_);
+            if (opaque != geom::Rectangle{})
+                region.push_back(opaque);
+        }
+        return region;
+    }
+
     mg::Renderable::ID id() const override
     { return id_; }
 private:
@@ -53,6 +53,12 @@ namespace ms = mir::scene;
 namespace mg = mir::graphics;
 namespace msh = mir::shell;
 
+namespace
+{
+// Enough to snapshot a few windows at once, without a GL context per window
+size_t const snapshot_threads{3};
+}
+
 std::shared_ptr<mc::Scene>
 mir::DefaultServerConfiguration::the_scene()
 {
@@ -213,8 +219,15 @@ mir::DefaultServerConfiguration::the_snapshot_strategy()
     return snapshot_strategy(
         [this]()
         {
-            return std::make_shared<ms::ThreadedSnapshotStrategy>(
-                the_pixel_buffer());
+            // Each snapshotting thread needs a pixel buffer (and so a GL context) of its own
+            std::vector<std::shared_ptr<ms::PixelBuffer>> pixel_buffers{the_pixel_buffer()};
+            if (auto const ctx = dynamic_cast<renderer::gl::ContextSource*>(the_display()->native_display()))
+            {
+                while (pixel_buffers.size() < snapshot_threads)
+                    pixel_buffers.push_back(std::make_shared<ms::GLPixelBuffer>(ctx->create_gl_context()));
+            }
+
+            return std::make_shared<ms::ThreadedSnapshotStrategy>(pixel_buffers);
         });
 }
 
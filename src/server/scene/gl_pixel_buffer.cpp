@@ -20,6 +20,10 @@
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_source.h"
+#include "mir/gl/program.h"
+
+#include <algorithm>
+#include <cmath>
 
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
@@ -27,6 +31,7 @@
 #include MIR_SERVER_GLEXT_H
 
 namespace mg = mir::graphics;
+namespace mgl = mir::gl;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
 
@@ -47,11 +52,63 @@ inline uint32_t abgr_to_argb(uint32_t p)
            ((p) & 0xff000000);        /* A remains at same position */
 }
 
+
+/*
+ * Draws the whole source flipped vertically, averaging a 4x4 grid of
+ * (bilinear) taps over each destination pixel's footprint, and swaps red and
+ * blue so that reading back as RGBA yields argb_8888.
+ */
+GLchar const* const scaling_vertex_shader_src =
+{
+    "attribute vec2 position;\n"
+    "varying vec2 coord;\n"
+    "void main() {\n"
+    "   coord = vec2(position.x + 1.0, 1.0 - position.y) * 0.5;\n"
+    "   gl_Position = vec4(position, 0.0, 1.0);\n"
+    "}\n"
+};
+
+GLchar const* const scaling_fragment_shader_src =
+{
+    "precision mediump float;\n"
+    "uniform sampler2D tex;\n"
+    "uniform vec2 tap_spacing;\n"
+    "varying vec2 coord;\n"
+    "void main() {\n"
+    "   vec4 sum = vec4(0.0);\n"
+    "   for (int y = 0; y < 4; ++y)\n"
+    "       for (int x = 0; x < 4; ++x)\n"
+    "           sum += texture2D(tex, coord + (vec2(x, y) - 1.5) * tap_spacing);\n"
+    "   gl_FragColor = (sum / 16.0).bgra;\n"
+    "}\n"
+};
+
+GLfloat const quad_vertices[] =
+{
+    -1.0f, -1.0f,
+     1.0f, -1.0f,
+    -1.0f,  1.0f,
+     1.0f,  1.0f
+};
+
+/// The largest size with the aspect ratio of \a size that fits within \a max_size
+geom::Size scaled_to_fit(geom::Size const& size, geom::Size const& max_size)
+{
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+
+    auto const scale = std::min(
+        double(max_size.width.as_int()) / width,
+        double(max_size.height.as_int()) / height);
+
+    return {std::max(1, int(std::lround(width * scale))),
+            std::max(1, int(std::lround(height * scale)))};
+}
 }
 
 ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context)
     : gl_context{std::move(gl_context)},
-      tex{0}, fbo{0}, gl_pixel_format{0}, pixels_need_y_flip{false}
+      tex{0}, fbo{0}, scaled_tex{0}, gl_pixel_format{0}, pixels_need_y_flip{false}
 {
     /*
      * TODO: Handle systems that are big-endian, and therefore GL_BGRA doesn't
@@ -73,8 +130,12 @@ ms::GLPixelBuffer::~GLPixelBuffer() noexcept
     if (tex != 0 || fbo != 0)
         gl_context->make_current();
 
+    scaling_program.reset();
+
     if (tex != 0)
         glDeleteTextures(1, &tex);
+    if (scaled_tex != 0)
+        glDeleteTextures(1, &scaled_tex);
     if (fbo != 0)
         glDeleteFramebuffers(1, &fbo);
 }
@@ -129,6 +190,85 @@ void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
     pixels_need_y_flip = true;
 }
 
+void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer, geom::Size const& max_size)
+{
+    auto const buffer_size = buffer.size();
+
+    if (max_size.width.as_int() <= 0 || max_size.height.as_int() <= 0 ||
+        (buffer_size.width <= max_size.width && buffer_size.height <= max_size.height))
+    {
+        fill_from(buffer);
+        return;
+    }
+
+    auto const scaled_size = scaled_to_fit(buffer_size, max_size);
+    auto const width = scaled_size.width.as_int();
+    auto const height = scaled_size.height.as_int();
+
+    pixels.resize(width * height * 4);
+
+    prepare();
+    prepare_scaled_target(scaled_size);
+
+    auto const texture_source =
+        dynamic_cast<mir::renderer::gl::TextureSource*>(
+            buffer.native_buffer_base());
+    if (!texture_source)
+        BOOST_THROW_EXCEPTION(std::logic_error("Buffer does not support GL rendering"));
+
+    glBindTexture(GL_TEXTURE_2D, tex);
+    texture_source->gl_bind_to_texture();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    if (!scaling_program)
+        scaling_program = std::make_unique<mgl::SimpleProgram>(
+            scaling_vertex_shader_src, scaling_fragment_shader_src);
+
+    GLuint const program = *scaling_program;
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "tex"), 0);
+    glUniform2f(glGetUniformLocation(program, "tap_spacing"),
+        0.25f / width, 0.25f / height);
+
+    auto const position = glGetAttribLocation(program, "position");
+    glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, quad_vertices);
+    glEnableVertexAttribArray(position);
+
+    glViewport(0, 0, width, height);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisableVertexAttribArray(position);
+    glUseProgram(0);
+
+    gl_pixel_format = GL_RGBA;
+    glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+
+    size_ = scaled_size;
+    pixels_need_y_flip = false;
+}
+
+void ms::GLPixelBuffer::prepare_scaled_target(geom::Size const& scaled_size)
+{
+    if (scaled_tex == 0)
+        glGenTextures(1, &scaled_tex);
+
+    glBindTexture(GL_TEXTURE_2D, scaled_tex);
+
+    if (scaled_size != scaled_tex_size)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+            scaled_size.width.as_int(), scaled_size.height.as_int(),
+            0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        scaled_tex_size = scaled_size;
+    }
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scaled_tex, 0);
+}
+
 void const* ms::GLPixelBuffer::as_argb_8888()
 {
     if (pixels_need_y_flip)
@@ -32,6 +32,10 @@ namespace graphics
 {
 class Buffer;
 }
+namespace gl
+{
+class Program;
+}
 namespace renderer
 {
 namespace gl
@@ -42,7 +46,13 @@ class Context;
 
 namespace scene
 {
-/** Extracts the pixels from a graphics::Buffer using GL facilities. */
+/**
+ * Extracts the pixels from a graphics::Buffer using GL facilities.
+ *
+ * A scaled down fill is rendered (filtered, flipped and swizzled) on the GPU,
+ * so only the pixels of the smaller image are read back and nothing is left
+ * to convert on the CPU.
+ */
 class GLPixelBuffer : public PixelBuffer
 {
 public:
@@ -50,17 +60,22 @@ public:
     ~GLPixelBuffer() noexcept;
 
     void fill_from(graphics::Buffer& buffer);
+    void fill_from(graphics::Buffer& buffer, geometry::Size const& max_size);
     void const* as_argb_8888();
     geometry::Size size() const;
     geometry::Stride stride() const;
 
 private:
     void prepare();
+    void prepare_scaled_target(geometry::Size const& scaled_size);
     void copy_and_convert_pixel_line(char* src, char* dst);
 
     std::unique_ptr<renderer::gl::Context> const gl_context;
     GLuint tex;
     GLuint fbo;
+    GLuint scaled_tex;
+    geometry::Size scaled_tex_size;
+    std::unique_ptr<gl::Program> scaling_program;
     std::vector<char> pixels;
     GLuint gl_pixel_format;
     bool pixels_need_y_flip;
@@ -111,4 +111,8 @@ void ms::LegacySurfaceChangeNotification::input_consumed(MirEvent const*)
 
 void ms::LegacySurfaceChangeNotification::start_drag_and_drop(std::vector<uint8_t> const& /*handle*/)
 {
+}
+
+void ms::LegacySurfaceChangeNotification::input_region_set_to(std::vector<geometry::Rectangle> const& /*region*/)
+{
 }
\ No newline at end of file
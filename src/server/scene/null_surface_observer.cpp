@@ -42,3 +42,4 @@ void ms::NullSurfaceObserver::cursor_image_removed() {}
 void ms::NullSurfaceObserver::placed_relative(geometry::Rectangle const& /*placement*/)  {}
 void ms::NullSurfaceObserver::input_consumed(MirEvent const* /*event*/)  {}
 void ms::NullSurfaceObserver::start_drag_and_drop(std::vector<uint8_t> const& /*handle*/)  {}
+void ms::NullSurfaceObserver::input_region_set_to(std::vector<geometry::Rectangle> const& /*region*/) {}
@@ -45,6 +45,15 @@ public:
      */
     virtual void fill_from(graphics::Buffer& buffer) = 0;
 
+    /**
+     * Fills the PixelBuffer with the contents of a graphics::Buffer,
+     * scaled down (keeping their aspect ratio) to fit within \a max_size.
+     *
+     * \param [in] buffer   the buffer to get the pixels of
+     * \param [in] max_size the largest size to fill the PixelBuffer to
+     */
+    virtual void fill_from(graphics::Buffer& buffer, geometry::Size const& max_size) = 0;
+
     /**
      * The pixels in 0xAARRGGBB format.
      *
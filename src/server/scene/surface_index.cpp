@@ -0,0 +1,268 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_index.h"
+#include "mir/scene/surface.h"
+#include "mir/scene/null_surface_observer.h"
+#include "mir/geometry/rectangles.h"
+
+#include <algorithm>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+int const cell_size = 256;
+
+// Surfaces spanning more cells than this (fullscreen ones, typically) are
+// cheaper to check on every lookup than to file in every cell
+int const max_cells_per_surface = 64;
+
+int cell_of(int coordinate)
+{
+    // Round towards negative infinity, so cells don't straddle zero
+    return coordinate >= 0 ? coordinate / cell_size : (coordinate - cell_size + 1) / cell_size;
+}
+
+uint64_t key_of(int cell_x, int cell_y)
+{
+    return (uint64_t{static_cast<uint32_t>(cell_x)} << 32) | static_cast<uint32_t>(cell_y);
+}
+
+/// Calls \a f with the key of each cell \a bounds touches, unless there are too many
+template<typename Function>
+bool for_each_cell(geom::Rectangle const& bounds, Function const& f)
+{
+    if (bounds.size.width.as_int() <= 0 || bounds.size.height.as_int() <= 0)
+        return true;
+
+    auto const left = cell_of(bounds.left().as_int());
+    auto const right = cell_of(bounds.right().as_int() - 1);
+    auto const top = cell_of(bounds.top().as_int());
+    auto const bottom = cell_of(bounds.bottom().as_int() - 1);
+
+    if (int64_t{right - left + 1} * (bottom - top + 1) > max_cells_per_surface)
+        return false;
+
+    for (auto y = top; y <= bottom; ++y)
+        for (auto x = left; x <= right; ++x)
+            f(key_of(x, y));
+
+    return true;
+}
+
+void erase_from(std::vector<ms::Surface const*>& surfaces, ms::Surface const* surface)
+{
+    surfaces.erase(std::remove(surfaces.begin(), surfaces.end(), surface), surfaces.end());
+}
+
+/// Everywhere \a surface might take input: its custom input region isn't clipped to the surface
+geom::Rectangle input_extents_of(ms::Surface const& surface)
+{
+    auto const bounds = surface.input_bounds();
+    auto const region = surface.input_region();
+    if (region.empty())
+        return bounds;
+
+    geom::Rectangles extents;
+    for (auto const& rectangle : region)
+        extents.add({bounds.top_left + (rectangle.top_left - geom::Point{}), rectangle.size});
+
+    return extents.bounding_rectangle();
+}
+}
+
+class ms::SurfaceIndex::BoundsTracker : public ms::NullSurfaceObserver
+{
+public:
+    BoundsTracker(SurfaceIndex* index, Surface const* surface)
+        : index{index},
+          surface{surface}
+    {
+    }
+
+    // Another change may be notified concurrently, so the index reads the
+    // surface again rather than trusting what it was told
+    void moved_to(geom::Point const&) override
+    {
+        index->input_area_changed(surface);
+    }
+
+    void resized_to(geom::Size const&) override
+    {
+        index->input_area_changed(surface);
+    }
+
+    void input_region_set_to(std::vector<geom::Rectangle> const&) override
+    {
+        index->input_area_changed(surface);
+    }
+
+private:
+    SurfaceIndex* const index;
+    Surface const* const surface;
+};
+
+ms::SurfaceIndex::SurfaceIndex()
+    : next_z{0}
+{
+}
+
+ms::SurfaceIndex::~SurfaceIndex()
+{
+    for (auto const& entry : entries)
+        entry.second.surface->remove_observer(entry.second.tracker);
+}
+
+void ms::SurfaceIndex::add(std::shared_ptr<Surface> const& surface)
+{
+    // Track first, so that no move is missed between reading the bounds and indexing them
+    auto const tracker = std::make_shared<BoundsTracker>(this, surface.get());
+    surface->add_observer(tracker);
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& entry = entries[surface.get()];
+    entry = Entry{surface, tracker, input_extents_of(*surface), next_z++};
+    file(lock, entry);
+}
+
+void ms::SurfaceIndex::remove(Surface const* surface)
+{
+    std::shared_ptr<Surface> removed;
+    std::shared_ptr<BoundsTracker> tracker;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const entry = entries.find(surface);
+        if (entry == entries.end())
+            return;
+
+        unfile(lock, entry->second);
+        removed = std::move(entry->second.surface);
+        tracker = std::move(entry->second.tracker);
+        entries.erase(entry);
+    }
+
+    removed->remove_observer(tracker);
+}
+
+void ms::SurfaceIndex::raise(Surface const* surface)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const entry = entries.find(surface);
+    if (entry != entries.end())
+        entry->second.z = next_z++;
+}
+
+void ms::SurfaceIndex::restack(std::vector<std::shared_ptr<Surface>> const& surfaces)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (auto const& surface : surfaces)
+    {
+        auto const entry = entries.find(surface.get());
+        if (entry != entries.end())
+            entry->second.z = next_z++;
+    }
+}
+
+auto ms::SurfaceIndex::surface_at(geom::Point point) const -> std::shared_ptr<Surface>
+{
+    std::vector<Entry const*> candidates;
+    std::vector<std::shared_ptr<Surface>> topmost_first;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const add_candidates = [&](std::vector<Surface const*> const& surfaces)
+            {
+                for (auto const surface : surfaces)
+                {
+                    auto const& entry = entries.at(surface);
+                    if (entry.bounds.contains(point))
+                        candidates.push_back(&entry);
+                }
+            };
+
+        auto const cell = cells.find(key_of(cell_of(point.x.as_int()), cell_of(point.y.as_int())));
+        if (cell != cells.end())
+            add_candidates(cell->second);
+        add_candidates(too_large_to_file);
+
+        std::sort(candidates.begin(), candidates.end(),
+            [](Entry const* a, Entry const* b) { return a->z > b->z; });
+
+        topmost_first.reserve(candidates.size());
+        for (auto const entry : candidates)
+            topmost_first.push_back(entry->surface);
+    }
+
+    // Surfaces take their own lock to answer, so don't hold ours meanwhile
+    for (auto const& surface : topmost_first)
+    {
+        if (surface->input_area_contains(point))
+            return surface;
+    }
+
+    return {};
+}
+
+void ms::SurfaceIndex::input_area_changed(Surface const* surface)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const entry = entries.find(surface);
+    if (entry == entries.end())
+        return;
+
+    // Read under our lock: whichever of two concurrent changes refiles last sees both
+    auto const bounds = input_extents_of(*entry->second.surface);
+    if (bounds == entry->second.bounds)
+        return;
+
+    unfile(lock, entry->second);
+    entry->second.bounds = bounds;
+    file(lock, entry->second);
+}
+
+void ms::SurfaceIndex::file(std::lock_guard<std::mutex> const&, Entry const& entry)
+{
+    auto const surface = entry.surface.get();
+
+    if (!for_each_cell(entry.bounds, [&](uint64_t key) { cells[key].push_back(surface); }))
+        too_large_to_file.push_back(surface);
+}
+
+void ms::SurfaceIndex::unfile(std::lock_guard<std::mutex> const&, Entry const& entry)
+{
+    auto const surface = entry.surface.get();
+
+    auto const filed = for_each_cell(entry.bounds, [&](uint64_t key)
+        {
+            auto const cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+
+            erase_from(cell->second, surface);
+            if (cell->second.empty())
+                cells.erase(cell);
+        });
+
+    if (!filed)
+        erase_from(too_large_to_file, surface);
+}
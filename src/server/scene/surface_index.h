@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_INDEX_H_
+#define MIR_SCENE_SURFACE_INDEX_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class Surface;
+
+/**
+ * Finds the topmost surface under a point without visiting every surface.
+ *
+ * Surfaces are filed in a grid of fixed size cells by the extents of their
+ * input area (which a custom input region may take outside the surface),
+ * kept up to date by observing each surface. A lookup only asks
+ * the surfaces filed in the cell under the point (and any too large to
+ * file) whether their input area contains it. The index has its own lock,
+ * so lookups don't wait on whoever holds the scene's.
+ */
+class SurfaceIndex
+{
+public:
+    SurfaceIndex();
+    ~SurfaceIndex();
+
+    /// Indexes \a surface above everything already indexed
+    void add(std::shared_ptr<Surface> const& surface);
+    void remove(Surface const* surface);
+
+    void raise(Surface const* surface);
+    /// Restacks everything to match \a surfaces, which are bottom to top
+    void restack(std::vector<std::shared_ptr<Surface>> const& surfaces);
+
+    /// The topmost surface whose input area contains \a point, or null
+    auto surface_at(geometry::Point point) const -> std::shared_ptr<Surface>;
+
+private:
+    SurfaceIndex(SurfaceIndex const&) = delete;
+    SurfaceIndex& operator=(SurfaceIndex const&) = delete;
+
+    class BoundsTracker;
+
+    struct Entry
+    {
+        std::shared_ptr<Surface> surface;
+        std::shared_ptr<BoundsTracker> tracker;
+        /// What the surface is filed under
+        geometry::Rectangle bounds;
+        uint64_t z;
+    };
+
+    /// Refiles \a surface under wherever it takes input now
+    void input_area_changed(Surface const* surface);
+
+    void file(std::lock_guard<std::mutex> const&, Entry const& entry);
+    void unfile(std::lock_guard<std::mutex> const&, Entry const& entry);
+
+    std::mutex mutable mutex;
+    std::unordered_map<Surface const*, Entry> entries;
+    std::unordered_map<uint64_t, std::vector<Surface const*>> cells;
+    std::vector<Surface const*> too_large_to_file;
+    uint64_t next_z;
+};
+}
+}
+
+#endif /* MIR_SCENE_SURFACE_INDEX_H_ */
@@ -24,6 +24,7 @@
 #include "mir/scene/scene_report.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
+#include "mir/thread_safe_list.h"
 
 #include <boost/throw_exception.hpp>
 
@@ -45,16 +46,17 @@ namespace
 class SurfaceSceneElement : public mc::SceneElement
 {
 public:
-    SurfaceSceneElement(
-        std::string name,
-        std::shared_ptr<mg::Renderable> const& renderable,
-        std::shared_ptr<ms::RenderingTracker> const& tracker,
+    SurfaceSceneElement() = default;
+
+    /// \a tracker is null for elements that aren't surfaces (i.e. overlays)
+    void assign(
+        std::shared_ptr<mg::Renderable> renderable,
+        std::shared_ptr<ms::RenderingTracker> tracker,
         mc::CompositorID id)
-        : renderable_{renderable},
-          tracker{tracker},
-          cid{id},
-          surface_name(name)
     {
+        this->renderable_ = std::move(renderable);
+        this->tracker = std::move(tracker);
+        this->cid = id;
     }
 
     std::shared_ptr<mg::Renderable> renderable() const override
@@ -64,46 +66,30 @@ public:
 
     void rendered() override
     {
-        tracker->rendered_in(cid);
+        if (tracker)
+            tracker->rendered_in(cid);
     }
 
     void occluded() override
     {
-        tracker->occluded_in(cid);
+        if (tracker)
+            tracker->occluded_in(cid);
     }
 
 private:
-    std::shared_ptr<mg::Renderable> const renderable_;
-    std::shared_ptr<ms::RenderingTracker> const tracker;
-    mc::CompositorID cid;
-    std::string const surface_name;
+    std::shared_ptr<mg::Renderable> renderable_;
+    std::shared_ptr<ms::RenderingTracker> tracker;
+    mc::CompositorID cid{nullptr};
 };
 
-//note: something different than a 2D/HWC overlay
-class OverlaySceneElement : public mc::SceneElement
+/**
+ * One allocation holding all of a frame's scene elements, which share
+ * ownership of it. They don't keep the snapshot they were taken from (and
+ * so the surfaces in it) alive, only their renderables and trackers.
+ */
+struct FrameElements
 {
-public:
-    OverlaySceneElement(
-        std::shared_ptr<mg::Renderable> renderable)
-        : renderable_{renderable}
-    {
-    }
-
-    std::shared_ptr<mg::Renderable> renderable() const override
-    {
-        return renderable_;
-    }
-
-    void rendered() override
-    {
-    }
-
-    void occluded() override
-    {
-    }
-
-private:
-    std::shared_ptr<mg::Renderable> const renderable_;
+    std::unique_ptr<SurfaceSceneElement[]> elements;
 };
 
 }
@@ -111,49 +97,67 @@ private:
 ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
-    scene_changed{false}
+    scene_changed{false},
+    published{new Snapshot},
+    snapshot{published.get()}
 {
 }
 
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
 {
-    RecursiveReadLock lg(guard);
+    using Reading = mir::detail::ThreadSafeListReaders::Reading;
+
+    auto const frame = std::make_shared<FrameElements>();
+    std::vector<std::pair<std::shared_ptr<mg::Renderable>, std::shared_ptr<ms::RenderingTracker>>> drawn;
 
-    scene_changed = false;
-    mc::SceneElementSequence elements;
-    for (auto const& surface : surfaces)
     {
-        if (surface->visible())
+        // The snapshot won't be freed until we're done reading it
+        Reading reading;
+        auto const& scene = *snapshot.load();
+
+        scene_changed = false;
+        drawn.reserve(scene.surfaces.size() + scene.overlays.size());
+        for (auto const& entry : scene.surfaces)
         {
-            for (auto& renderable : surface->generate_renderables(id))
+            // Gone if it has been removed since the snapshot was taken
+            auto const surface = entry.surface.lock();
+            if (surface && surface->visible())
             {
-                elements.emplace_back(
-                    std::make_shared<SurfaceSceneElement>(
-                        surface->name(),
-                        renderable,
-                        rendering_trackers[surface.get()],
-                        id));
+                for (auto& renderable : surface->generate_renderables(id))
+                    drawn.emplace_back(std::move(renderable), entry.tracker);
             }
         }
+        for (auto const& overlay : scene.overlays)
+        {
+            if (auto const renderable = overlay.lock())
+                drawn.emplace_back(renderable, nullptr);
+        }
     }
-    for (auto const& renderable : overlays)
+
+    frame->elements.reset(new SurfaceSceneElement[drawn.size()]);
+    mc::SceneElementSequence elements;
+    elements.reserve(drawn.size());
+    for (size_t i = 0; i != drawn.size(); ++i)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        auto const element = &frame->elements[i];
+        element->assign(std::move(drawn[i].first), std::move(drawn[i].second), id);
+        elements.emplace_back(frame, element);
     }
     return elements;
 }
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 {
-    RecursiveReadLock lg(guard);
+    mir::detail::ThreadSafeListReaders::Reading reading;
+    auto const scene = snapshot.load();
 
     int result = scene_changed ? 1 : 0;
-    for (auto const& surface : surfaces)
+    for (auto const& entry : scene->surfaces)
     {
-        if (surface->visible())
+        auto const surface = entry.surface.lock();
+        if (surface && surface->visible())
         {
-            auto const tracker = rendering_trackers.find(surface.get());
-            if (tracker != rendering_trackers.end() && tracker->second->is_exposed_in(id))
+            if (entry.tracker->is_exposed_in(id))
             {
                 // Note that we ask the surface and not a Renderable.
                 // This is because we don't want to waste time and resources
@@ -188,9 +192,11 @@ void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
 void ms::SurfaceStack::add_input_visualization(
     std::shared_ptr<mg::Renderable> const& overlay)
 {
+    Snapshots reclaimed;
     {
         RecursiveWriteLock lg(guard);
         overlays.push_back(overlay);
+        reclaimed = publish_snapshot(lg);
     }
     emit_scene_changed();
 }
@@ -199,6 +205,7 @@ void ms::SurfaceStack::remove_input_visualization(
     std::weak_ptr<mg::Renderable> const& weak_overlay)
 {
     auto overlay = weak_overlay.lock();
+    Snapshots reclaimed;
     {
         RecursiveWriteLock lg(guard);
         auto const p = std::find(overlays.begin(), overlays.end(), overlay);
@@ -207,6 +214,7 @@ void ms::SurfaceStack::remove_input_visualization(
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
         overlays.erase(p);
+        reclaimed = publish_snapshot(lg);
     }
     
     emit_scene_changed();
@@ -225,10 +233,13 @@ void ms::SurfaceStack::add_surface(
     std::shared_ptr<Surface> const& surface,
     mi::InputReceptionMode input_mode)
 {
+    Snapshots reclaimed;
     {
         RecursiveWriteLock lg(guard);
         surfaces.push_back(surface);
+        surface_index.add(surface);
         create_rendering_tracker_for(surface);
+        reclaimed = publish_snapshot(lg);
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface.get());
@@ -241,6 +252,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     auto const keep_alive = surface.lock();
 
     bool found_surface = false;
+    Snapshots reclaimed;
     {
         RecursiveWriteLock lg(guard);
 
@@ -249,7 +261,9 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
         if (surface != surfaces.end())
         {
             surfaces.erase(surface);
+            surface_index.remove(keep_alive.get());
             rendering_trackers.erase(keep_alive.get());
+            reclaimed = publish_snapshot(lg);
             found_surface = true;
         }
     }
@@ -263,34 +277,19 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
-{
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
-
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
-}
-
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& surface : in_reverse(surfaces))
-    {
-        // TODO There's a lack of clarity about how the input area will
-        // TODO be maintained and whether this test will detect clicks on
-        // TODO decorations (it should) as these may be outside the area
-        // TODO known to the client.  But it works for now.
-        if (surface->input_area_contains(cursor))
-                return surface;
-    }
+    // TODO There's a lack of clarity about how the input area will
+    // TODO be maintained and whether this test will detect clicks on
+    // TODO decorations (it should) as these may be outside the area
+    // TODO known to the client.  But it works for now.
+    return surface_index.surface_at(cursor);
+}
 
-    return {};
+auto ms::SurfaceStack::top_surface_at(geometry::Point point) -> std::shared_ptr<mi::Surface>
+{
+    return surface_index.surface_at(point);
 }
 
 void ms::SurfaceStack::for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& callback)
@@ -305,6 +304,7 @@ void ms::SurfaceStack::for_each(std::function<void(std::shared_ptr<mi::Surface>
 void ms::SurfaceStack::raise(std::weak_ptr<Surface> const& s)
 {
     bool surfaces_reordered{false};
+    Snapshots reclaimed;
 
     {
         auto const surface = s.lock();
@@ -316,6 +316,8 @@ void ms::SurfaceStack::raise(std::weak_ptr<Surface> const& s)
         {
             surfaces.erase(p);
             surfaces.push_back(surface);
+            surface_index.raise(surface.get());
+            reclaimed = publish_snapshot(ul);
             surfaces_reordered = true;
         }
     }
@@ -330,6 +332,7 @@ void ms::SurfaceStack::raise(std::weak_ptr<Surface> const& s)
 void ms::SurfaceStack::raise(SurfaceSet const& ss)
 {
     bool surfaces_reordered{false};
+    Snapshots reclaimed;
     {
         RecursiveWriteLock ul(guard);
 
@@ -339,7 +342,11 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             [&](std::weak_ptr<Surface> const& s) { return !ss.count(s); });
 
         if (old_surfaces != surfaces)
+        {
+            surface_index.restack(surfaces);
+            reclaimed = publish_snapshot(ul);
             surfaces_reordered = true;
+        }
     }
 
     if (surfaces_reordered)
@@ -355,6 +362,36 @@ void ms::SurfaceStack::create_rendering_tracker_for(std::shared_ptr<Surface> con
     rendering_trackers[surface.get()] = tracker;
 }
 
+auto ms::SurfaceStack::publish_snapshot(RecursiveWriteLock const&) -> Snapshots
+{
+    using Readers = mir::detail::ThreadSafeListReaders;
+
+    std::unique_ptr<Snapshot> next{new Snapshot};
+
+    next->surfaces.reserve(surfaces.size());
+    for (auto const& surface : surfaces)
+        next->surfaces.push_back({surface, rendering_trackers.at(surface.get())});
+    next->overlays.assign(overlays.begin(), overlays.end());
+
+    retired_snapshots.reserve(retired_snapshots.size() + 1);
+    snapshot.store(next.get());
+    std::unique_ptr<Snapshot const> replaced{std::move(published)};
+    published = std::move(next);
+    retired_snapshots.push_back({Readers::end_epoch(), std::move(replaced)});
+
+    // Epochs only go up, so whatever can be freed is at the front
+    auto const oldest_read = Readers::oldest_epoch_read();
+    auto over = retired_snapshots.begin();
+    while (over != retired_snapshots.end() && over->epoch < oldest_read)
+        ++over;
+
+    Snapshots reclaimed;
+    for (auto r = retired_snapshots.begin(); r != over; ++r)
+        reclaimed.push_back(std::move(r->snapshot));
+    retired_snapshots.erase(retired_snapshots.begin(), over);
+    return reclaimed;
+}
+
 void ms::SurfaceStack::update_rendering_tracker_compositors()
 {
     RecursiveReadLock ul(guard);
@@ -28,7 +28,10 @@
 
 #include "mir/basic_observers.h"
 
+#include "surface_index.h"
+
 #include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -79,6 +82,7 @@ public:
 
     // From Scene
     void for_each(std::function<void(std::shared_ptr<input::Surface> const&)> const& callback) override;
+    auto top_surface_at(geometry::Point point) -> std::shared_ptr<input::Surface> override;
 
     virtual void remove_surface(std::weak_ptr<Surface> const& surface) override;
 
@@ -107,11 +111,18 @@ private:
     void create_rendering_tracker_for(std::shared_ptr<Surface> const&);
     void update_rendering_tracker_compositors();
 
+    struct Snapshot;
+    using Snapshots = std::vector<std::unique_ptr<Snapshot const>>;
+    /// Publishes the stack as it is now, returning the earlier snapshots no
+    /// compositor can still be reading, to be freed once the guard is released
+    Snapshots publish_snapshot(RecursiveWriteLock const&);
+
     RecursiveReadWriteMutex mutable guard;
 
     std::shared_ptr<SceneReport> const report;
 
     std::vector<std::shared_ptr<Surface>> surfaces;
+    SurfaceIndex surface_index;
     std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
     std::set<compositor::CompositorID> registered_compositors;
     
@@ -119,6 +130,38 @@ private:
 
     Observers observers;
     std::atomic<bool> scene_changed;
+
+    /**
+     * What the compositors see: an immutable copy of the stack, replaced
+     * whenever it changes. It only refers to what it shows, so that what is
+     * removed from the stack isn't kept alive by a snapshot awaiting reclaim.
+     */
+    struct Snapshot
+    {
+        struct Entry
+        {
+            std::weak_ptr<Surface> surface;
+            std::shared_ptr<RenderingTracker> tracker;
+        };
+
+        std::vector<Entry> surfaces;
+        std::vector<std::weak_ptr<graphics::Renderable>> overlays;
+    };
+    /**
+     * Compositors read the published snapshot without locks, marking
+     * themselves as reading (as ThreadSafeList::for_each() does) while they
+     * do. A replaced snapshot is kept until no compositor can still be
+     * reading it, then freed by the change replacing it or a later one.
+     */
+    std::unique_ptr<Snapshot const> published;
+    std::atomic<Snapshot const*> snapshot;
+
+    struct RetiredSnapshot
+    {
+        uint64_t epoch;
+        std::unique_ptr<Snapshot const> snapshot;
+    };
+    std::vector<RetiredSnapshot> retired_snapshots;
 };
 
 }
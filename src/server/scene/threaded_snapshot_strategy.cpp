@@ -22,6 +22,7 @@
 #include "mir/thread_name.h"
 
 #include <deque>
+#include <list>
 #include <mutex>
 #include <condition_variable>
 
@@ -36,18 +37,115 @@ namespace scene
 struct WorkItem
 {
     std::shared_ptr<compositor::BufferStream> const stream;
+    geometry::Size const max_size;  ///< Empty for a full size snapshot
     ms::SnapshotCallback const snapshot_taken;
 };
 
+/// Copies of recent scaled snapshots, most recently used first
+class SnapshotCache
+{
+public:
+    struct Entry
+    {
+        std::weak_ptr<compositor::BufferStream> stream;
+        uint64_t frame;
+        geometry::Size max_size;
+        geometry::Size size;
+        geometry::Stride stride;
+        std::vector<char> pixels;
+    };
+
+    std::shared_ptr<Entry const> find(
+        std::shared_ptr<compositor::BufferStream> const& stream,
+        uint64_t frame,
+        geometry::Size const& max_size)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const entry = find_locked(lock, stream, max_size);
+        if (entry == entries.end())
+            return {};
+
+        if ((*entry)->frame != frame)
+        {
+            drop_locked(lock, entry);
+            return {};
+        }
+
+        entries.splice(entries.begin(), entries, entry);
+        return entries.front();
+    }
+
+    void store(
+        std::shared_ptr<compositor::BufferStream> const& stream,
+        uint64_t frame,
+        geometry::Size const& max_size,
+        Snapshot const& snapshot)
+    {
+        auto const bytes = snapshot.stride.as_uint32_t() * snapshot.size.height.as_uint32_t();
+        if (bytes > max_entry_bytes)
+            return;
+
+        auto const pixels = static_cast<char const*>(snapshot.pixels);
+        auto const entry = std::make_shared<Entry const>(
+            Entry{stream, frame, max_size, snapshot.size, snapshot.stride, {pixels, pixels + bytes}});
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const old = find_locked(lock, stream, max_size);
+        if (old != entries.end())
+            drop_locked(lock, old);
+
+        entries.push_front(entry);
+        total_bytes += bytes;
+
+        while (total_bytes > max_total_bytes)
+            drop_locked(lock, std::prev(entries.end()));
+    }
+
+private:
+    using Entries = std::list<std::shared_ptr<Entry const>>;
+
+    // Thumbnails are small: anything bigger isn't worth keeping a copy of
+    static size_t const max_entry_bytes{4*1024*1024};
+    static size_t const max_total_bytes{32*1024*1024};
+
+    Entries::iterator find_locked(
+        std::lock_guard<std::mutex> const&,
+        std::shared_ptr<compositor::BufferStream> const& stream,
+        geometry::Size const& max_size)
+    {
+        for (auto i = entries.begin(); i != entries.end(); ++i)
+        {
+            auto const& entry = **i;
+            if (!entry.stream.owner_before(stream) && !stream.owner_before(entry.stream) &&
+                entry.max_size == max_size)
+                return i;
+        }
+
+        return entries.end();
+    }
+
+    void drop_locked(std::lock_guard<std::mutex> const&, Entries::iterator entry)
+    {
+        total_bytes -= (*entry)->pixels.size();
+        entries.erase(entry);
+    }
+
+    std::mutex mutex;
+    Entries entries;
+    size_t total_bytes{0};
+};
+
 class SnapshottingFunctor
 {
 public:
-    SnapshottingFunctor(std::shared_ptr<PixelBuffer> const& pixels)
-        : running{true}, pixels{pixels}
+    SnapshottingFunctor()
+        : running{true}
     {
     }
 
-    void operator()()
+    void operator()(PixelBuffer& pixels)
     {
         mir::set_thread_name("Mir/Snapshot");
         std::unique_lock<std::mutex> lock{work_mutex};
@@ -64,23 +162,48 @@ public:
 
                 lock.unlock();
 
-                take_snapshot(wi);
+                take_snapshot(pixels, wi);
 
                 lock.lock();
             }
         }
     }
 
-    void take_snapshot(WorkItem const& wi)
+    void take_snapshot(PixelBuffer& pixels, WorkItem const& wi)
     {
-        wi.stream->with_most_recent_buffer_do([this](mir::graphics::Buffer& buffer) {
-            pixels->fill_from(buffer);
+        if (wi.max_size == geometry::Size{})
+        {
+            wi.stream->with_most_recent_buffer_do([&pixels](mir::graphics::Buffer& buffer) {
+                pixels.fill_from(buffer);
+            });
+
+            wi.snapshot_taken(
+                ms::Snapshot{pixels.size(),
+                         pixels.stride(),
+                         pixels.as_argb_8888()});
+            return;
+        }
+
+        std::shared_ptr<SnapshotCache::Entry const> cached;
+        uint64_t frame{0};
+
+        // The stream can't have a frame submitted while we hold its buffer
+        wi.stream->with_most_recent_buffer_do([&](mir::graphics::Buffer& buffer) {
+            frame = wi.stream->frames_submitted();
+            cached = cache.find(wi.stream, frame, wi.max_size);
+            if (!cached)
+                pixels.fill_from(buffer, wi.max_size);
         });
 
-        wi.snapshot_taken(
-            ms::Snapshot{pixels->size(),
-                     pixels->stride(),
-                     pixels->as_argb_8888()});
+        if (cached)
+        {
+            wi.snapshot_taken(ms::Snapshot{cached->size, cached->stride, cached->pixels.data()});
+            return;
+        }
+
+        ms::Snapshot const snapshot{pixels.size(), pixels.stride(), pixels.as_argb_8888()};
+        cache.store(wi.stream, frame, wi.max_size, snapshot);
+        wi.snapshot_taken(snapshot);
     }
 
     void schedule_snapshot(WorkItem const& wi)
@@ -94,15 +217,15 @@ public:
     {
         std::lock_guard<std::mutex> lg{work_mutex};
         running = false;
-        work_cv.notify_one();
+        work_cv.notify_all();
     }
 
 private:
     bool running;
-    std::shared_ptr<PixelBuffer> const pixels;
     std::mutex work_mutex;
     std::condition_variable work_cv;
     std::deque<WorkItem> work;
+    SnapshotCache cache;
 };
 
 }
@@ -110,21 +233,37 @@ private:
 
 ms::ThreadedSnapshotStrategy::ThreadedSnapshotStrategy(
     std::shared_ptr<PixelBuffer> const& pixels)
+    : ThreadedSnapshotStrategy{std::vector<std::shared_ptr<PixelBuffer>>{pixels}}
+{
+}
+
+ms::ThreadedSnapshotStrategy::ThreadedSnapshotStrategy(
+    std::vector<std::shared_ptr<PixelBuffer>> const& pixels)
     : pixels{pixels},
-      functor{new SnapshottingFunctor{pixels}},
-      thread{std::ref(*functor)}
+      functor{new SnapshottingFunctor}
 {
+    for (auto const& pixel_buffer : pixels)
+        threads.emplace_back([this, pixel_buffer] { (*functor)(*pixel_buffer); });
 }
 
 ms::ThreadedSnapshotStrategy::~ThreadedSnapshotStrategy() noexcept
 {
     functor->stop();
-    thread.join();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void ms::ThreadedSnapshotStrategy::take_snapshot_of(
+    std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+    SnapshotCallback const& snapshot_taken)
+{
+    functor->schedule_snapshot(WorkItem{surface_buffer_access, geom::Size{}, snapshot_taken});
 }
 
 void ms::ThreadedSnapshotStrategy::take_snapshot_of(
     std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+    geom::Size const& max_size,
     SnapshotCallback const& snapshot_taken)
 {
-    functor->schedule_snapshot(WorkItem{surface_buffer_access, snapshot_taken});
+    functor->schedule_snapshot(WorkItem{surface_buffer_access, max_size, snapshot_taken});
 }
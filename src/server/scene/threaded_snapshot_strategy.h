@@ -24,6 +24,7 @@
 #include <memory>
 #include <thread>
 #include <functional>
+#include <vector>
 
 namespace mir
 {
@@ -32,20 +33,33 @@ namespace scene
 class PixelBuffer;
 class SnapshottingFunctor;
 
+/**
+ * Takes snapshots on threads of its own, one per PixelBuffer it is given.
+ *
+ * Scaled snapshots are small, and often asked for again (by a switcher
+ * redrawing, say) while the content hasn't changed, so they are kept
+ * until the stream they came from has a new frame submitted.
+ */
 class ThreadedSnapshotStrategy : public SnapshotStrategy
 {
 public:
     ThreadedSnapshotStrategy(std::shared_ptr<PixelBuffer> const& pixels);
+    ThreadedSnapshotStrategy(std::vector<std::shared_ptr<PixelBuffer>> const& pixels);
     ~ThreadedSnapshotStrategy() noexcept;
 
     void take_snapshot_of(
         std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
         SnapshotCallback const& snapshot_taken);
 
+    void take_snapshot_of(
+        std::shared_ptr<compositor::BufferStream> const& surface_buffer_access,
+        geometry::Size const& max_size,
+        SnapshotCallback const& snapshot_taken);
+
 private:
-    std::shared_ptr<PixelBuffer> const pixels;
+    std::vector<std::shared_ptr<PixelBuffer>> const pixels;
     std::unique_ptr<SnapshottingFunctor> functor;
-    std::thread thread;
+    std::vector<std::thread> threads;
 };
 
 }
@@ -19,240 +19,354 @@
 #include "mir/thread/basic_thread_pool.h"
 #include "mir/terminate_with_current_exception.h"
 
+#include <atomic>
 #include <deque>
 #include <algorithm>
 #include <condition_variable>
+#include <thread>
 
 namespace mt = mir::thread;
 
-namespace
+namespace mir
 {
-
-class Task
+namespace thread
+{
+class WorkerThread
 {
 public:
-    Task(std::function<void()> const& task) : task{task} {}
-
-    void execute()
+    using Task = std::unique_ptr<BasicThreadPool::QueuedTask>;
+
+    WorkerThread(BasicThreadPool* pool)
+        : pool{pool},
+          has_last_id{false},
+          last_id{nullptr},
+          exiting{false},
+          woken{false}
     {
-        try
-        {
-            task();
-        }
-        catch (...)
-        {
-            task_exception = std::current_exception();
-        }
     }
 
-    void notify_done()
+    ~WorkerThread()
     {
-        if (task_exception)
-            promise.set_exception(task_exception);
-        else
-            promise.set_value();
+        exit();
+        if (thread.joinable())
+            thread.join();
     }
 
-    std::future<void> get_future()
+    void start()
     {
-        return promise.get_future();
+        thread = std::thread{[this] { pool->work(*this); }};
     }
 
-private:
-    std::function<void()> const task;
-    std::promise<void> promise;
-    std::exception_ptr task_exception;
-};
-
-class Worker
-{
-public:
-    Worker() : exiting{false}
+    /// Wakes the thread, which has been claimed while idle, with \a task to run if given
+    void wake(Task task = nullptr)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (task)
+            tasks.push_back(std::move(task));
+        woken = true;
+        task_available_cv.notify_one();
     }
 
-    ~Worker()
+    /// Queues \a task for the thread to get to once it's done with what it has
+    void queue_task(Task task)
     {
-        exit();
+        std::lock_guard<std::mutex> lock{mutex};
+        tasks.push_back(std::move(task));
+        task_available_cv.notify_one();
     }
 
-    void operator()() noexcept
-    try
+    void exit()
     {
-       std::unique_lock<std::mutex> lock{state_mutex};
-       while (!exiting)
-       {
-           task_available_cv.wait(lock, [&]{ return exiting || !tasks.empty(); });
-
-           if (!exiting)
-           {
-               auto task = std::move(tasks.front());
-               lock.unlock();
-               task.execute();
-               lock.lock();
-               tasks.pop_front();
-               task.notify_done();
-           }
-       }
+        std::lock_guard<std::mutex> lock{mutex};
+        exiting = true;
+        task_available_cv.notify_one();
     }
-    catch(...)
+
+    bool is_exiting() const
     {
-        mir::terminate_with_current_exception();
+        return exiting;
     }
 
-    void queue_task(Task task)
+    /// Waits to be woken; returns the first task queued, if any
+    Task wait_until_woken()
     {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        tasks.push_back(std::move(task));
-        task_available_cv.notify_one();
+        std::unique_lock<std::mutex> lock{mutex};
+        task_available_cv.wait(lock, [&] { return exiting || woken || !tasks.empty(); });
+        woken = false;
+        return exiting ? nullptr : take_locked();
     }
 
-    void exit()
+    Task take()
     {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        exiting = true;
-        task_available_cv.notify_one();
+        std::lock_guard<std::mutex> lock{mutex};
+        return take_locked();
     }
 
-    bool is_idle() const
+    /// Takes the newest task queued here for any thread to run, if any
+    Task steal()
     {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        return tasks.empty();
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const task = std::find_if(tasks.rbegin(), tasks.rend(),
+            [](Task const& task) { return task->may_be_stolen; });
+        if (task == tasks.rend())
+            return nullptr;
+
+        auto stolen = std::move(*task);
+        tasks.erase(std::next(task).base());
+        return stolen;
     }
 
+    BasicThreadPool* const pool;
+    // Guarded by the pool's mutex
+    bool has_last_id;
+    BasicThreadPool::TaskId last_id;
+
 private:
-    std::deque<Task> tasks;
-    bool exiting;
-    std::mutex mutable state_mutex;
+    Task take_locked()
+    {
+        if (tasks.empty())
+            return nullptr;
+
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        return task;
+    }
+
+    std::mutex mutex;
     std::condition_variable task_available_cv;
+    std::deque<Task> tasks;
+    std::atomic<bool> exiting;
+    bool woken;
+    std::thread thread;
 };
+}
+}
 
+namespace
+{
+thread_local mt::WorkerThread* this_thread_worker{nullptr};
 }
 
-namespace mir
+void mt::BasicThreadPool::QueuedTask::execute() noexcept
 {
-namespace thread
+    try
+    {
+        call();
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+}
+
+void mt::BasicThreadPool::QueuedTask::notify_done()
 {
-class WorkerThread
+    if (exception)
+        done.set_exception(exception);
+    else
+        done.set_value();
+}
+
+mt::BasicThreadPool::BasicThreadPool(int min_threads)
+    : min_threads{min_threads}
 {
-public:
-    WorkerThread(mt::BasicThreadPool::TaskId an_id)
-        : thread{std::ref(worker)},
-          id_{an_id}
-    {}
+}
+
+mt::BasicThreadPool::~BasicThreadPool()
+{
+    decltype(threads) exiting;
 
-    ~WorkerThread()
     {
-        worker.exit();
-        if (thread.joinable())
-            thread.join();
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        for (auto const& thread : threads)
+            thread->exit();
+        exiting.swap(threads);
     }
 
-    void queue_task(Task task, mt::BasicThreadPool::TaskId the_id)
+    // Joined without the lock, as a thread may be taking it to look for work
+}
+
+std::future<void> mt::BasicThreadPool::schedule(std::unique_ptr<QueuedTask> task)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+
+    auto future = task->done.get_future();
+
+    if (task->has_id)
     {
-        worker.queue_task(std::move(task));
-        id_ = the_id;
+        auto const owner = owners.find(task->id);
+        if (owner != owners.end())
+        {
+            // Queue it after the others, however busy their thread is
+            ++owner->second.outstanding;
+            owner->second.thread->queue_task(std::move(task));
+            return future;
+        }
     }
-
-    bool is_idle() const
+    else if (this_thread_worker && this_thread_worker->pool == this)
     {
-        return worker.is_idle();
+        // Keep it here, in case this thread gets to it first, and have another steal it
+        auto thread = claim_idle_thread(lock, *task);
+        if (!thread)
+            thread = start_thread(lock);
+
+        task->may_be_stolen = true;
+        this_thread_worker->queue_task(std::move(task));
+        thread->wake();
+        return future;
     }
 
-    mt::BasicThreadPool::TaskId current_id() const
+    auto thread = claim_idle_thread(lock, *task);
+    if (!thread)
+        thread = start_thread(lock);
+
+    if (task->has_id)
     {
-        return id_;
+        owners[task->id] = Owner{thread, 1};
+        thread->has_last_id = true;
+        thread->last_id = task->id;
     }
 
-private:
-    ::Worker worker;
-    std::thread thread;
-    mt::BasicThreadPool::TaskId id_;
-};
-}
+    thread->wake(std::move(task));
+    return future;
 }
 
-mt::BasicThreadPool::BasicThreadPool(int min_threads)
-    : min_threads{min_threads}
+void mt::BasicThreadPool::shrink()
 {
-}
+    std::vector<std::unique_ptr<WorkerThread>> removed;
 
-mt::BasicThreadPool::~BasicThreadPool() = default;
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
 
-std::future<void> mt::BasicThreadPool::run(std::function<void()> const& task)
-{
-    std::lock_guard<decltype(mutex)> lock{mutex};
+        int max_threads_to_remove = threads.size() - min_threads;
+        while (max_threads_to_remove-- > 0 && !idle.empty())
+        {
+            auto const thread = idle.front();
+            idle.erase(idle.begin());
+
+            auto const it = std::find_if(threads.begin(), threads.end(),
+                [thread](std::unique_ptr<WorkerThread> const& t) { return t.get() == thread; });
+            removed.push_back(std::move(*it));
+            threads.erase(it);
+        }
+    }
 
-    TaskId const generic_id = nullptr;
-    WorkerThread* no_preferred_thread = nullptr;
-    return run(no_preferred_thread, task, generic_id);
+    // Joined without the lock, as a thread may be taking it to go idle
 }
 
-std::future<void> mt::BasicThreadPool::run(std::function<void()> const& task, TaskId id)
+void mt::BasicThreadPool::work(WorkerThread& self)
+try
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    return run(find_thread_by(id), task, id);
-}
+    this_thread_worker = &self;
+
+    std::unique_ptr<QueuedTask> task;
+    while (!self.is_exiting())
+    {
+        if (!task)
+            task = wait_for_work(self);
 
-std::future<void> mt::BasicThreadPool::run(WorkerThread* worker_thread,
-                                           std::function<void()> const& task, TaskId id)
+        if (!task)
+            break;
+
+        task->execute();
+
+        // Be seen to be idle before anyone waiting on the task carries on
+        auto next = finish(self, *task);
+        task->notify_done();
+        task = std::move(next);
+    }
+}
+catch(...)
 {
-    // No pre-selected thread to execute task, find an idle thread
-    if (worker_thread == nullptr)
-        worker_thread = find_idle_thread();
+    mir::terminate_with_current_exception();
+}
 
-    if (worker_thread == nullptr)
+auto mt::BasicThreadPool::wait_for_work(WorkerThread& self) -> std::unique_ptr<QueuedTask>
+{
+    while (!self.is_exiting())
     {
-        // No idle threads available so create a new one
-        auto new_worker_thread = std::make_unique<WorkerThread>(id);
-        threads.push_back(std::move(new_worker_thread));
-        worker_thread = threads.back().get();
+        if (auto task = self.wait_until_woken())
+            return task;
+
+        if (self.is_exiting())
+            break;
+
+        // Woken to steal, or newly started
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        if (auto task = find_work(lock, self))
+            return task;
     }
 
-    Task a_task{task};
-    auto future = a_task.get_future();
-    worker_thread->queue_task(std::move(a_task), id);
-    return future;
+    return nullptr;
 }
 
-
-void mt::BasicThreadPool::shrink()
+auto mt::BasicThreadPool::finish(WorkerThread& self, QueuedTask const& task) -> std::unique_ptr<QueuedTask>
 {
+    if (!task.has_id)
+    {
+        if (auto next = self.take())
+            return next;
+    }
+
     std::lock_guard<decltype(mutex)> lock{mutex};
 
-    int max_threads_to_remove = threads.size() - min_threads;
-    auto it = std::remove_if(threads.begin(), threads.end(),
-        [&max_threads_to_remove](std::unique_ptr<WorkerThread> const& worker_thread)
-        {
-            bool remove = worker_thread->is_idle() && max_threads_to_remove > 0;
-            if (remove)
-                max_threads_to_remove--;
-            return remove;
-        }
-    );
-    threads.erase(it, threads.end());
+    if (task.has_id)
+    {
+        auto const owner = owners.find(task.id);
+        if (--owner->second.outstanding == 0)
+            owners.erase(owner);
+    }
+
+    return find_work(lock, self);
 }
 
-mt::WorkerThread* mt::BasicThreadPool::find_thread_by(TaskId id)
+auto mt::BasicThreadPool::find_work(std::lock_guard<std::mutex> const&, WorkerThread& self)
+    -> std::unique_ptr<QueuedTask>
 {
-    auto it = std::find_if(threads.begin(), threads.end(),
-        [id](std::unique_ptr<WorkerThread> const& worker_thread)
-        {
-            return worker_thread->current_id() == id;
-        }
-    );
+    // Tasks are only queued with the lock held, so an empty queue stays empty until we're idle
+    if (auto task = self.take())
+        return task;
+
+    for (auto const& thread : threads)
+    {
+        if (thread.get() == &self)
+            continue;
+
+        if (auto task = thread->steal())
+            return task;
+    }
 
-    return it == threads.end() ? nullptr : it->get();
+    idle.push_back(&self);
+    return nullptr;
 }
 
-mt::WorkerThread *mt::BasicThreadPool::find_idle_thread()
+mt::WorkerThread* mt::BasicThreadPool::claim_idle_thread(
+    std::lock_guard<std::mutex> const&,
+    QueuedTask const& task)
 {
-    auto it = std::find_if(threads.begin(), threads.end(),
-        [](std::unique_ptr<WorkerThread> const& worker_thread)
-        {
-            return worker_thread->is_idle();
-        }
-    );
+    if (idle.empty())
+        return nullptr;
+
+    // A thread that ran the id before has what it used to hand, otherwise the
+    // most recently busy one is likeliest to
+    auto it = idle.end() - 1;
+    if (task.has_id)
+    {
+        auto const previous = std::find_if(idle.begin(), idle.end(),
+            [&task](WorkerThread const* thread) { return thread->has_last_id && thread->last_id == task.id; });
+        if (previous != idle.end())
+            it = previous;
+    }
+
+    auto const thread = *it;
+    idle.erase(it);
+    return thread;
+}
 
-    return it == threads.end() ? nullptr : it->get();
+mt::WorkerThread* mt::BasicThreadPool::start_thread(std::lock_guard<std::mutex> const&)
+{
+    threads.push_back(std::make_unique<WorkerThread>(this));
+    threads.back()->start();
+    return threads.back().get();
 }
@@ -31,13 +31,20 @@
 #include <boost/program_options.hpp>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <thread>
 #include <iostream>
 #include <stdexcept>
-#include <future>
 #include <vector>
 #include <utility>
 #include <chrono>
@@ -45,6 +52,17 @@
 
 namespace po = boost::program_options;
 
+// GLES 3 values, not in the GLES2 headers
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+
 namespace
 {
 
@@ -262,10 +280,15 @@ public:
 
             std::this_thread::sleep_until(time_point);
         }
+
+        finish();
     }
 
     virtual void capture_to(std::ostream& stream) = 0;
 
+    /// Writes out any frames still on their way to the stream
+    virtual void finish() {}
+
 protected:
     Screencast(int number_of_captures, double capture_fps)
         : number_of_captures{number_of_captures},
@@ -320,12 +343,317 @@ private:
     std::string const pixel_format_;
 };
 
+/// Writes frames out on a thread of its own, so capturing never waits on the stream
+class FrameWriter
+{
+public:
+    FrameWriter(std::ostream& stream)
+        : stream(stream),
+          thread{[this] { write_frames(); }}
+    {
+    }
+
+    ~FrameWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            done = true;
+        }
+        frame_ready.notify_one();
+        thread.join();
+    }
+
+    /// Storage for a frame, reusing that of one already written out when possible
+    std::vector<char> spare_frame(size_t size)
+    {
+        std::vector<char> frame;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!written.empty())
+            {
+                frame = std::move(written.back());
+                written.pop_back();
+            }
+        }
+        frame.resize(size);
+        return frame;
+    }
+
+    void write(std::vector<char>&& frame)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+
+        // If the stream can't keep up, slow capturing down rather than
+        // queueing up the whole recording
+        space_free.wait(lock, [this] { return pending.size() < max_pending; });
+
+        pending.push_back(std::move(frame));
+        frame_ready.notify_one();
+    }
+
+private:
+    static size_t const max_pending{4};
+
+    void write_frames()
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+
+        while (true)
+        {
+            frame_ready.wait(lock, [this] { return done || !pending.empty(); });
+            if (pending.empty())
+                return;
+
+            auto frame = std::move(pending.front());
+            pending.pop_front();
+            space_free.notify_one();
+
+            lock.unlock();
+            stream.write(frame.data(), frame.size());
+            lock.lock();
+
+            written.push_back(std::move(frame));
+        }
+    }
+
+    std::ostream& stream;
+    std::mutex mutex;
+    std::condition_variable frame_ready;
+    std::condition_variable space_free;
+    std::deque<std::vector<char>> pending;
+    std::vector<std::vector<char>> written;
+    bool done{false};
+    std::thread thread;
+};
+
+/// The entry points for reading back into buffer objects, which GLES2 lacks
+struct PackBufferFunctions
+{
+    /// Null unless the current context is GLES 3 or later
+    static std::unique_ptr<PackBufferFunctions> for_current_context()
+    {
+        auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+        static char const es_prefix[] = "OpenGL ES ";
+        if (!version ||
+            strncmp(version, es_prefix, sizeof es_prefix - 1) != 0 ||
+            atoi(version + sizeof es_prefix - 1) < 3)
+        {
+            return nullptr;
+        }
+
+        auto functions = std::make_unique<PackBufferFunctions>();
+        functions->map_buffer_range = reinterpret_cast<decltype(map_buffer_range)>(
+            eglGetProcAddress("glMapBufferRange"));
+        functions->unmap_buffer = reinterpret_cast<decltype(unmap_buffer)>(
+            eglGetProcAddress("glUnmapBuffer"));
+
+        if (!functions->map_buffer_range || !functions->unmap_buffer)
+            return nullptr;
+
+        return functions;
+    }
+
+    void* (*map_buffer_range)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    GLboolean (*unmap_buffer)(GLenum target);
+};
+
+GLuint compile_shader(GLenum type, char const* source)
+{
+    auto const shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        GLchar log[1024];
+        glGetShaderInfoLog(shader, sizeof log, nullptr, log);
+        glDeleteShader(shader);
+        throw std::runtime_error(std::string("Failed to compile screencast shader: ") + log);
+    }
+
+    return shader;
+}
+
+/**
+ * Converts captured frames to I420 (BT.601, limited range) on the GPU.
+ *
+ * The result is rendered a quarter of the frame's width across, so each
+ * RGBA texel carries four bytes and each row a row of the frame's width.
+ * That lays out the luma plane and then the two quarter-size chroma planes
+ * just as I420 does, so reading it back gives the finished frame.
+ */
+class I420Converter
+{
+public:
+    I420Converter(unsigned int width, unsigned int height)
+        : width{width},
+          height{height}
+    {
+        if (width % 8 != 0 || height % 4 != 0)
+            throw std::runtime_error("I420 conversion needs a width divisible by 8 and a height divisible by 4");
+
+        static char const vertex_shader_src[] =
+            "attribute vec2 position;\n"
+            "void main()\n"
+            "{\n"
+            "    gl_Position = vec4(position, 0.0, 1.0);\n"
+            "}\n";
+
+        static char const fragment_shader_src[] =
+            "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+            "precision highp float;\n"
+            "#else\n"
+            "precision mediump float;\n"
+            "#endif\n"
+            "uniform sampler2D frame;\n"
+            "uniform vec2 size;\n"
+            "vec3 at(vec2 pixel)\n"
+            "{\n"
+            "    return texture2D(frame, pixel / size).rgb;\n"
+            "}\n"
+            "float luma(vec2 pixel)\n"
+            "{\n"
+            "    return (16.0 + dot(at(pixel), vec3(65.481, 128.553, 24.966))) / 255.0;\n"
+            "}\n"
+            "// Sampling between four pixels averages them\n"
+            "float chroma(vec2 block, vec3 weights)\n"
+            "{\n"
+            "    return (128.0 + dot(at(block * 2.0 + 1.0), weights)) / 255.0;\n"
+            "}\n"
+            "void main()\n"
+            "{\n"
+            "    vec2 texel = floor(gl_FragCoord.xy);\n"
+            "    float x = texel.x * 4.0;\n"
+            "    if (texel.y < size.y)\n"
+            "    {\n"
+            "        float y = texel.y + 0.5;\n"
+            "        gl_FragColor = vec4(\n"
+            "            luma(vec2(x + 0.5, y)), luma(vec2(x + 1.5, y)),\n"
+            "            luma(vec2(x + 2.5, y)), luma(vec2(x + 3.5, y)));\n"
+            "        return;\n"
+            "    }\n"
+            "    // Each row below the luma plane holds two rows of a chroma plane\n"
+            "    float row = texel.y - size.y;\n"
+            "    vec3 weights = vec3(-37.797, -74.203, 112.0);\n"
+            "    if (row >= size.y / 4.0)\n"
+            "    {\n"
+            "        row -= size.y / 4.0;\n"
+            "        weights = vec3(112.0, -93.786, -18.214);\n"
+            "    }\n"
+            "    float y = row * 2.0;\n"
+            "    if (x >= size.x / 2.0)\n"
+            "    {\n"
+            "        x -= size.x / 2.0;\n"
+            "        y += 1.0;\n"
+            "    }\n"
+            "    gl_FragColor = vec4(\n"
+            "        chroma(vec2(x, y), weights), chroma(vec2(x + 1.0, y), weights),\n"
+            "        chroma(vec2(x + 2.0, y), weights), chroma(vec2(x + 3.0, y), weights));\n"
+            "}\n";
+
+        auto const vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_src);
+        auto const fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
+
+        program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        glBindAttribLocation(program, position_attrib, "position");
+        glLinkProgram(program);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint linked;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            throw std::runtime_error("Failed to link screencast shader");
+        }
+
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "frame"), 0);
+        glUniform2f(glGetUniformLocation(program, "size"), width, height);
+
+        glGenTextures(1, &frame);
+        glBindTexture(GL_TEXTURE_2D, frame);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+
+        glGenTextures(1, &planes);
+        glBindTexture(GL_TEXTURE_2D, planes);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, read_width(), read_height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, planes, 0);
+        auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            release();
+            throw std::runtime_error("Failed to create framebuffer for I420 conversion");
+        }
+    }
+
+    ~I420Converter()
+    {
+        release();
+    }
+
+    /// Converts what was last captured, leaving the result bound to be read
+    void convert()
+    {
+        static GLfloat const quad[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, frame);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, read_width(), read_height());
+        glUseProgram(program);
+        glVertexAttribPointer(position_attrib, 2, GL_FLOAT, GL_FALSE, 0, quad);
+        glEnableVertexAttribArray(position_attrib);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glDisableVertexAttribArray(position_attrib);
+    }
+
+    unsigned int read_width() const { return width / 4; }
+    unsigned int read_height() const { return height * 3 / 2; }
+
+private:
+    static GLuint const position_attrib{0};
+
+    void release()
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &planes);
+        glDeleteTextures(1, &frame);
+        glDeleteProgram(program);
+    }
+
+    unsigned int const width;
+    unsigned int const height;
+    GLuint program{0};
+    GLuint frame{0};
+    GLuint planes{0};
+    GLuint framebuffer{0};
+};
+
 class EGLScreencast : public Screencast
 {
 public:
     EGLScreencast(int num_captures, double capture_fps,
                   MirConnection* connection, ScreencastConfiguration* config,
-                  MirBufferStream* buffer_stream)
+                  MirBufferStream* buffer_stream, bool convert_to_i420)
         : Screencast(num_captures, capture_fps),
           width{config->width},
           height{config->height}
@@ -373,20 +701,51 @@ public:
             throw std::runtime_error("Failed to make screencast surface current");
         }
 
-        uint32_t a_pixel;
-        glReadPixels(0, 0, 1, 1, GL_BGRA_EXT, GL_UNSIGNED_BYTE, &a_pixel);
-        if (glGetError() == GL_NO_ERROR)
-            read_pixel_format = GL_BGRA_EXT;
-        else
+        if (convert_to_i420)
+        {
+            converter = std::make_unique<I420Converter>(width, height);
             read_pixel_format = GL_RGBA;
+            read_width = converter->read_width();
+            read_height = converter->read_height();
+        }
+        else
+        {
+            uint32_t a_pixel;
+            glReadPixels(0, 0, 1, 1, GL_BGRA_EXT, GL_UNSIGNED_BYTE, &a_pixel);
+            if (glGetError() == GL_NO_ERROR)
+                read_pixel_format = GL_BGRA_EXT;
+            else
+                read_pixel_format = GL_RGBA;
+
+            read_width = width;
+            read_height = height;
+        }
 
         int const rgba_pixel_size{4};
-        auto const frame_size_bytes = rgba_pixel_size * width * height;
-        buffer.resize(frame_size_bytes);
+        frame_size_bytes = rgba_pixel_size * read_width * read_height;
+
+        pack_buffers = PackBufferFunctions::for_current_context();
+        if (pack_buffers)
+        {
+            for (auto& readback : readbacks)
+            {
+                glGenBuffers(1, &readback.buffer);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+                glBufferData(GL_PIXEL_PACK_BUFFER, frame_size_bytes, nullptr, GL_STREAM_READ);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
     }
 
     ~EGLScreencast()
     {
+        if (pack_buffers)
+        {
+            for (auto& readback : readbacks)
+                glDeleteBuffers(1, &readback.buffer);
+        }
+        converter.reset();
+
         eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         eglDestroySurface(egl_display, egl_surface);
         eglDestroyContext(egl_display, egl_context);
@@ -395,51 +754,126 @@ public:
 
     void capture_to(std::ostream& stream) override
     {
-        void* data = buffer.data();
-        glReadPixels(0, 0, width, height, read_pixel_format, GL_UNSIGNED_BYTE, data);
+        if (!writer)
+            writer = std::make_unique<FrameWriter>(stream);
+
+        if (converter)
+            converter->convert();
 
-        auto write_out_future = std::async(
-            std::launch::async,
-            [this, &stream] {
-            stream.write(buffer.data(), buffer.size());
-            });
+        if (pack_buffers)
+        {
+            // The GPU copies the frame into a buffer object while we carry
+            // on, and we only map it once the buffers have come round
+            // again. By then the copy has long finished, so nothing waits.
+            auto& readback = readbacks[next_readback];
+            next_readback = (next_readback + 1) % readbacks.size();
+
+            hand_on(readback);
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            glReadPixels(0, 0, read_width, read_height, read_pixel_format, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            readback.filled = true;
+        }
+        else
+        {
+            auto frame = writer->spare_frame(frame_size_bytes);
+            glReadPixels(0, 0, read_width, read_height, read_pixel_format, GL_UNSIGNED_BYTE, frame.data());
+            writer->write(std::move(frame));
+        }
 
         if (eglSwapBuffers(egl_display, egl_surface) != EGL_TRUE)
             throw std::runtime_error("Failed to swap screencast surface buffers");
+    }
 
-        write_out_future.wait();
+    void finish() override
+    {
+        // Oldest first
+        for (auto i = 0u; i != readbacks.size(); ++i)
+        {
+            hand_on(readbacks[next_readback]);
+            next_readback = (next_readback + 1) % readbacks.size();
+        }
+
+        writer.reset();
     }
 
     std::string pixel_format() override
     {
+        if (converter)
+            return "I420";
         return read_pixel_format == GL_BGRA_EXT ? "BGRA" : "RGBA";
     }
 
 private:
+    struct Readback
+    {
+        GLuint buffer{0};
+        bool filled{false};
+    };
+
+    /// Passes the frame read into \a readback, if any, on to be written out
+    void hand_on(Readback& readback)
+    {
+        if (!readback.filled)
+            return;
+
+        auto frame = writer->spare_frame(frame_size_bytes);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        auto const pixels = pack_buffers->map_buffer_range(GL_PIXEL_PACK_BUFFER, 0, frame_size_bytes, GL_MAP_READ_BIT);
+        if (pixels)
+        {
+            memcpy(frame.data(), pixels, frame_size_bytes);
+            pack_buffers->unmap_buffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        readback.filled = false;
+
+        if (!pixels)
+            throw std::runtime_error("Failed to map screencast frame");
+
+        writer->write(std::move(frame));
+    }
+
     unsigned int const width;
     unsigned int const height;
-    std::vector<char> buffer;
+    unsigned int read_width;
+    unsigned int read_height;
+    size_t frame_size_bytes;
     EGLDisplay egl_display;
     EGLContext egl_context;
     EGLSurface egl_surface;
     EGLConfig egl_config;
     GLenum read_pixel_format;
+    std::unique_ptr<I420Converter> converter;
+    std::unique_ptr<PackBufferFunctions> pack_buffers;
+    std::array<Readback, 3> readbacks;
+    size_t next_readback{0};
+    std::unique_ptr<FrameWriter> writer;
 };
 
 std::unique_ptr<Screencast> create_screencast(int num_captures, double capture_fps,
                                               MirConnection* connection,
                                               ScreencastConfiguration* config,
-                                              MirBufferStream* buffer_stream)
+                                              MirBufferStream* buffer_stream,
+                                              bool convert_to_i420)
 {
-    try
-    {
-        return std::make_unique<BufferStreamScreencast>(num_captures, capture_fps, config, buffer_stream);
-    }
-    catch(...)
+    // Only EGL can convert on the GPU
+    if (!convert_to_i420)
     {
+        try
+        {
+            return std::make_unique<BufferStreamScreencast>(num_captures, capture_fps, config, buffer_stream);
+        }
+        catch(...)
+        {
+        }
     }
     // Fallback to EGL if MirBufferStream can't be used directly
-    return std::make_unique<EGLScreencast>(num_captures, capture_fps, connection, config, buffer_stream);
+    return std::make_unique<EGLScreencast>(
+        num_captures, capture_fps, connection, config, buffer_stream, convert_to_i420);
 }
 }
 
@@ -454,6 +888,7 @@ try
     std::vector<int> requested_size;
     bool use_std_out = false;
     bool query_params_only = false;
+    bool convert_to_i420 = false;
     int capture_interval = 1;
 
     po::options_description desc("Usage");
@@ -466,7 +901,7 @@ try
         ("mir-socket-file,m",
             po::value<std::string>(&socket_filename), "mir server socket filename")
         ("file,f",
-            po::value<std::string>(&output_filename), "output filename (default is /tmp/mir_screencast_<w>x<h>.<rgba|bgra>")
+            po::value<std::string>(&output_filename), "output filename (default is /tmp/mir_screencast_<w>x<h>.<rgba|bgra|i420>")
         ("size,s",
             po::value<std::vector<int>>(&requested_size)->multitoken(),
             "screencast size [width height]")
@@ -477,6 +912,9 @@ try
         ("query",
             po::value<bool>(&query_params_only)->zero_tokens(),
             "only queries the colorspace and output size used but does not start screencast")
+        ("i420",
+            po::value<bool>(&convert_to_i420)->zero_tokens(),
+            "convert frames to I420 on the GPU, ready for a video encoder")
         ("cap-interval",
             po::value<int>(&capture_interval),
             "adjusts the capture rate to <arg> display refresh intervals\n"
@@ -566,7 +1004,8 @@ try
     if (buffer_stream == nullptr)
         throw std::runtime_error("Failed to obtain buffer stream from screencast");
 
-    auto screencast = create_screencast(number_of_captures, capture_fps, connection.get(), &screencast_config, buffer_stream);
+    auto screencast = create_screencast(
+        number_of_captures, capture_fps, connection.get(), &screencast_config, buffer_stream, convert_to_i420);
 
     if (output_filename.empty() && !use_std_out)
     {
@@ -60,6 +60,13 @@ public:
     {
     }
 
+    FakeRenderable(geometry::Rectangle display_area,
+                   std::vector<geometry::Rectangle> const& opaque)
+        : FakeRenderable{display_area, 1.0f, false}
+    {
+        opaque_rects = opaque;
+    }
+
     ID id() const override
     {
         return this;
@@ -80,6 +87,11 @@ public:
         return !rectangular;
     }
 
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return opaque_rects;
+    }
+
     void set_buffer(std::shared_ptr<graphics::Buffer> b)
     {
         buf = b;
@@ -105,6 +117,7 @@ private:
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    std::vector<geometry::Rectangle> opaque_rects;
 };
 
 } // namespace doubles
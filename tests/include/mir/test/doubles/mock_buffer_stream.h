@@ -77,9 +77,12 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD1(with_most_recent_buffer_do, void(std::function<void(graphics::Buffer&)> const&));
     MOCK_CONST_METHOD0(pixel_format, MirPixelFormat());
     MOCK_CONST_METHOD0(has_submitted_buffer, bool());
+    MOCK_CONST_METHOD0(frames_submitted, uint64_t());
     MOCK_METHOD1(disassociate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(associate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(set_scale, void(float));
+    MOCK_METHOD1(set_opaque_region, void(std::vector<geometry::Rectangle> const&));
+    MOCK_CONST_METHOD1(opaque_region, std::vector<geometry::Rectangle>(graphics::Buffer const&));
 
 };
 }
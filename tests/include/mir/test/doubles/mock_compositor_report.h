@@ -43,6 +43,9 @@ public:
                  void(compositor::CompositorReport::SubCompositorId));
     MOCK_METHOD1(finished_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD3(render_time_estimated,
+                 void(compositor::CompositorReport::SubCompositorId,
+                      std::chrono::microseconds, std::chrono::microseconds));
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
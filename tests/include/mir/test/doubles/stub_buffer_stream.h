@@ -68,7 +68,11 @@ public:
     void drop_old_buffers() override {}
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& b) override
     {
-        if (b) ++nready;
+        if (b)
+        {
+            ++nready;
+            ++nsubmitted;
+        }
     }
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& fn) override
     {
@@ -79,10 +83,14 @@ public:
     void add_observer(std::shared_ptr<scene::SurfaceObserver> const&) override {}
     void remove_observer(std::weak_ptr<scene::SurfaceObserver> const&) override {}
     bool has_submitted_buffer() const override { return true; }
+    uint64_t frames_submitted() const override { return nsubmitted; }
     void set_scale(float) override {}
+    void set_opaque_region(std::vector<geometry::Rectangle> const&) override {}
+    std::vector<geometry::Rectangle> opaque_region(graphics::Buffer const&) const override { return {}; }
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
+    uint64_t nsubmitted = 0;
     std::string thread_name;
 };
 
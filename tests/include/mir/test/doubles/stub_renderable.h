@@ -85,6 +85,10 @@ public:
     {
         return false;
     }
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return {};
+    }
     unsigned int swap_interval() const override
     {
         return 1;
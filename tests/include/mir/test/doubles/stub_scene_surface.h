@@ -61,6 +61,7 @@ public:
     bool visible() const override { return true; }
     void move_to(geometry::Point const&) override {}
     void set_input_region(std::vector<geometry::Rectangle> const&) override {}
+    std::vector<geometry::Rectangle> input_region() const override { return {}; }
     void resize(geometry::Size const&) override {}
     void set_transformation(glm::mat4 const&) override {}
     void set_alpha(float) override {}
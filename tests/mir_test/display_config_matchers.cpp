@@ -87,7 +87,9 @@ public:
                 {},
                 mir_output_gamma_unsupported,
                 {},
-                custom_logical_size
+                custom_logical_size,
+                false,
+                false
             };
 
             /* Modes */
@@ -147,7 +149,9 @@ public:
                 {},
                 mir_output_gamma_unsupported,
                 {},
-                {}
+                {},
+                false,
+                false
             };
 
             /* Modes */
@@ -217,7 +221,9 @@ public:
                     {},
                     mir_output_gamma_unsupported,
                     {},
-                    custom_logical_size
+                    custom_logical_size,
+                    false,
+                    false
                 };
 
             /* Modes */
@@ -94,7 +94,9 @@ mtd::StubDisplayConfigurationOutput::StubDisplayConfigurationOutput(
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            false
         }
 {
 }
@@ -124,7 +126,9 @@ mtd::StubDisplayConfigurationOutput::StubDisplayConfigurationOutput(
         {},
         mir_output_gamma_unsupported,
         {},
-        {}
+        {},
+        false,
+        false
     }
 {
     if (modes.empty())
@@ -227,7 +231,9 @@ mtd::StubDisplayConfig::StubDisplayConfig(unsigned int num_displays, std::vector
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            false
         };
 
         outputs.push_back(output);
@@ -255,7 +261,9 @@ mtd::StubDisplayConfig::StubDisplayConfig(std::vector<geometry::Rectangle> const
                 {},
                 mir_output_gamma_unsupported,
                 {},
-                {}
+                {},
+                false,
+                false
             };
 
         outputs.push_back(output);
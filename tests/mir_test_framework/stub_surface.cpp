@@ -61,6 +61,11 @@ void mtd::StubSurface::set_input_region(std::vector<mir::geometry::Rectangle> co
 {
 }
 
+std::vector<mir::geometry::Rectangle> mtd::StubSurface::input_region() const
+{
+    return {};
+}
+
 void mtd::StubSurface::resize(mir::geometry::Size const& /*size*/)
 {
 }
@@ -256,7 +256,9 @@ struct TimeTrackingDisplay : mtd::NullDisplay
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            false
         };
         outputs.push_back(output);
     }
@@ -125,6 +125,34 @@ TEST_F(OcclusionFilterTest, shaped_window_occludes_nothing)
     EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
 }
 
+TEST_F(OcclusionFilterTest, shaped_window_occludes_within_its_opaque_region)
+{
+    Rectangle const top_rect{{10, 10}, {20, 20}};
+    auto top = std::make_shared<mtd::FakeRenderable>(
+        top_rect, std::vector<Rectangle>{Rectangle{{12, 12}, {10, 10}}});
+    auto beneath = std::make_shared<mtd::FakeRenderable>(14, 14, 5, 5);
+    auto peeking = std::make_shared<mtd::FakeRenderable>(20, 20, 5, 5);
+    auto elements = scene_elements_from({peeking, beneath, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(beneath));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(peeking, top));
+}
+
+TEST_F(OcclusionFilterTest, window_hidden_by_two_others_together_is_occluded)
+{
+    auto left = std::make_shared<mtd::FakeRenderable>(0, 0, 50, 100);
+    auto right = std::make_shared<mtd::FakeRenderable>(50, 0, 50, 100);
+    auto beneath = std::make_shared<mtd::FakeRenderable>(25, 25, 50, 50);
+    auto elements = scene_elements_from({beneath, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(beneath));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
 TEST_F(OcclusionFilterTest, identical_window_occluded)
 {
     auto top = std::make_shared<mtd::FakeRenderable>(10, 10, 10, 10);
@@ -234,3 +234,21 @@ TEST_F(Stream, returns_buffers_to_client_when_told_to_bring_queue_up_to_date)
     EXPECT_THAT(buffers[1].use_count(), Eq(1));
     EXPECT_THAT(buffers[2].use_count(), Eq(2));
 }
+
+TEST_F(Stream, opaque_region_is_the_one_set_when_the_buffer_was_submitted)
+{
+    std::vector<geom::Rectangle> const first_region{{{0, 0}, {44, 1}}};
+    std::vector<geom::Rectangle> const second_region{{{0, 1}, {44, 1}}};
+
+    stream.set_opaque_region(first_region);
+    stream.submit_buffer(buffers[0]);
+    stream.set_opaque_region(second_region);
+
+    EXPECT_THAT(stream.opaque_region(*buffers[0]), ContainerEq(first_region));
+
+    stream.submit_buffer(buffers[1]);
+
+    EXPECT_THAT(stream.opaque_region(*buffers[0]), ContainerEq(first_region));
+    EXPECT_THAT(stream.opaque_region(*buffers[1]), ContainerEq(second_region));
+    EXPECT_THAT(stream.opaque_region(*buffers[2]), IsEmpty());
+}
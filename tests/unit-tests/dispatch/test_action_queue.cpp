@@ -23,6 +23,13 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 namespace mt = mir::test;
 namespace md = mir::dispatch;
 using namespace ::testing;
@@ -79,3 +86,170 @@ TEST(ActionQueue, executes_action_only_once)
 }
 
 
+
+TEST(ActionQueue, executes_every_queued_action_in_order_on_one_dispatch)
+{
+    md::ActionQueue queue;
+
+    std::vector<int> executed;
+
+    queue.enqueue([&](){executed.push_back(1);});
+    queue.enqueue([&](){executed.push_back(2);});
+    queue.enqueue([&](){executed.push_back(3);});
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(executed, ElementsAre(1, 2, 3));
+    EXPECT_FALSE(mt::fd_is_readable(queue.watch_fd()));
+}
+
+TEST(ActionQueue, action_queued_by_an_action_waits_for_next_dispatch)
+{
+    md::ActionQueue queue;
+
+    auto inner_executed = false;
+
+    queue.enqueue([&](){ queue.enqueue([&](){inner_executed = true;}); });
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_FALSE(inner_executed);
+    ASSERT_TRUE(mt::fd_is_readable(queue.watch_fd()));
+
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_TRUE(inner_executed);
+}
+
+TEST(ActionQueue, executes_move_only_action)
+{
+    md::ActionQueue queue;
+
+    auto value = std::make_unique<int>(42);
+    auto seen = 0;
+
+    queue.enqueue([&seen, value = std::move(value)](){seen = *value;});
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(seen, Eq(42));
+}
+
+TEST(ActionQueue, actions_after_one_that_throws_are_kept_for_later)
+{
+    md::ActionQueue queue;
+
+    std::vector<int> executed;
+
+    queue.enqueue(
+        [&]()
+        {
+            queue.enqueue([&](){executed.push_back(3);});
+            throw std::runtime_error{"Oops"};
+        });
+    queue.enqueue([&](){executed.push_back(1);});
+    queue.enqueue([&](){executed.push_back(2);});
+
+    EXPECT_THROW(queue.dispatch(md::FdEvent::readable), std::runtime_error);
+    EXPECT_THAT(executed, IsEmpty());
+    ASSERT_TRUE(mt::fd_is_readable(queue.watch_fd()));
+
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(executed, ElementsAre(1, 2, 3));
+}
+
+TEST(ActionQueue, destroys_actions_never_dispatched)
+{
+    auto const value = std::make_shared<int>(0);
+
+    {
+        md::ActionQueue queue;
+        queue.enqueue([value](){});
+    }
+
+    EXPECT_THAT(value.use_count(), Eq(1));
+}
+
+TEST(ActionQueue, releases_what_an_action_captures_once_it_has_run)
+{
+    md::ActionQueue queue;
+    auto const value = std::make_shared<int>(0);
+
+    queue.enqueue([value](){});
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(value.use_count(), Eq(1));
+}
+
+TEST(ActionQueue, executes_actions_too_big_to_share_storage)
+{
+    md::ActionQueue queue;
+
+    std::array<int, 256> big;
+    big.fill(7);
+    auto seen = 0;
+
+    queue.enqueue([&seen, big](){ seen = big.back(); });
+    queue.enqueue(std::function<void()>{[&seen](){ seen += 1; }});
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(seen, Eq(8));
+}
+
+TEST(ActionQueue, executes_more_actions_at_once_than_it_keeps_storage_for)
+{
+    md::ActionQueue queue;
+
+    // More than the pool holds, so some are allocated on their own
+    int const actions{64 * 64 + 100};
+    std::vector<int> executed;
+    executed.reserve(actions);
+
+    for (int round = 0; round != 2; ++round)
+    {
+        executed.clear();
+        for (int i = 0; i != actions; ++i)
+            queue.enqueue([&executed, i](){ executed.push_back(i); });
+        queue.dispatch(md::FdEvent::readable);
+
+        ASSERT_THAT(executed.size(), Eq(static_cast<size_t>(actions)));
+        for (int i = 0; i != actions; ++i)
+            EXPECT_THAT(executed[i], Eq(i));
+    }
+}
+
+TEST(ActionQueue, actions_queued_from_many_threads_are_all_executed_once)
+{
+    md::ActionQueue queue;
+
+    int const threads{4};
+    int const actions_per_thread{10000};
+    std::atomic<int> executed{0};
+    std::atomic<bool> done{false};
+
+    std::thread dispatcher{[&]
+        {
+            while (!done || mt::fd_is_readable(queue.watch_fd()))
+            {
+                if (mt::fd_is_readable(queue.watch_fd()))
+                    queue.dispatch(md::FdEvent::readable);
+                else
+                    std::this_thread::yield();
+            }
+        }};
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t != threads; ++t)
+    {
+        producers.emplace_back([&]
+            {
+                for (int i = 0; i != actions_per_thread; ++i)
+                    queue.enqueue([&executed](){ ++executed; });
+            });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+    done = true;
+    dispatcher.join();
+
+    EXPECT_THAT(executed, Eq(threads * actions_per_thread));
+}
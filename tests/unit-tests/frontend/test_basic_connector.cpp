@@ -21,6 +21,9 @@
 #include "mir/test/current_thread_name.h"
 #include "mir/test/fake_shared.h"
 
+#include <mutex>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
@@ -33,10 +36,14 @@ struct StubConnectorReport : mir::report::null::ConnectorReport
 {
     void thread_start()
     {
+        std::lock_guard<std::mutex> lock{mutex};
         thread_name = mt::current_thread_name();
+        thread_names.push_back(thread_name);
     }
 
+    std::mutex mutex;
     std::string thread_name;
+    std::vector<std::string> thread_names;
 };
 
 }
@@ -54,3 +61,17 @@ TEST(BasicConnector, names_ipc_threads)
 
     EXPECT_THAT(report.thread_name, Eq("Mir/IPC"));
 }
+
+TEST(BasicConnector, runs_each_ipc_thread_asked_for)
+{
+    using namespace testing;
+
+    StubConnectorReport report;
+
+    mir::frontend::BasicConnector connector{{}, 3, mt::fake_shared(report)};
+
+    connector.start();
+    connector.stop();
+
+    EXPECT_THAT(report.thread_names, ElementsAre("Mir/IPC", "Mir/IPC", "Mir/IPC"));
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/wayland/presentation_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct MockFeedback : mf::PresentationClock::Feedback
+{
+    MOCK_METHOD5(presented, void(unsigned int, mir::time::PosixTimestamp const&, std::chrono::nanoseconds, int64_t, bool));
+    MOCK_METHOD0(discarded, void());
+};
+
+struct PresentationClock : Test
+{
+    mf::PresentationClock clock;
+
+    std::experimental::optional<unsigned int> const unknown_output;
+    unsigned int const left{1};
+    unsigned int const right{2};
+
+    /// Hands the clock a feedback for \a output, keeping a pointer to set expectations on
+    MockFeedback& await_frame(std::experimental::optional<unsigned int> output)
+    {
+        auto feedback = std::make_unique<NiceMock<MockFeedback>>();
+        auto& result = *feedback;
+        std::vector<std::unique_ptr<mf::PresentationClock::Feedback>> list;
+        list.push_back(std::move(feedback));
+        clock.answer_after_next_frame(output, std::move(list));
+        return result;
+    }
+
+    static mg::Frame frame(int64_t msc, std::chrono::nanoseconds ust, clockid_t clock_id = CLOCK_MONOTONIC)
+    {
+        mg::Frame frame;
+        frame.msc = msc;
+        frame.ust = {clock_id, ust};
+        return frame;
+    }
+
+    static mg::Frame flip(int64_t msc, std::chrono::nanoseconds ust, clockid_t clock_id = CLOCK_MONOTONIC)
+    {
+        auto result = frame(msc, ust, clock_id);
+        result.hardware_timestamp = true;
+        return result;
+    }
+};
+}
+
+TEST_F(PresentationClock, answers_feedback_with_the_next_frame_on_its_output)
+{
+    auto& feedback = await_frame(left);
+
+    EXPECT_CALL(feedback, presented(_, _, _, _, _)).Times(0);
+    clock.frame_shown(right, frame(5, 100ms));
+    Mock::VerifyAndClearExpectations(&feedback);
+
+    EXPECT_CALL(feedback, presented(left, mir::time::PosixTimestamp{CLOCK_MONOTONIC, 200ms}, _, 8, _));
+    clock.frame_shown(left, frame(8, 200ms));
+}
+
+TEST_F(PresentationClock, answers_feedback_for_an_unknown_output_with_any_frame)
+{
+    auto& feedback = await_frame(unknown_output);
+
+    EXPECT_CALL(feedback, presented(right, _, _, 5, _));
+    clock.frame_shown(right, frame(5, 100ms));
+}
+
+TEST_F(PresentationClock, answers_feedback_only_once)
+{
+    int answers{0};
+    auto& feedback = await_frame(left);
+    ON_CALL(feedback, presented(_, _, _, _, _)).WillByDefault(InvokeWithoutArgs([&]{ ++answers; }));
+
+    clock.frame_shown(left, frame(8, 200ms));
+    clock.frame_shown(left, frame(9, 216ms));
+
+    EXPECT_THAT(answers, Eq(1));
+}
+
+TEST_F(PresentationClock, measures_refresh_on_each_output_separately)
+{
+    clock.frame_shown(left, frame(10, 1000ms));
+    clock.frame_shown(right, frame(100, 1005ms));
+    clock.frame_shown(right, frame(101, 1012ms));
+
+    auto& on_left = await_frame(left);
+    auto& on_right = await_frame(right);
+
+    // Two frames on the left took 40ms, and one on the right took 7ms
+    EXPECT_CALL(on_left, presented(left, _, std::chrono::nanoseconds{20ms}, 12, _));
+    EXPECT_CALL(on_right, presented(right, _, std::chrono::nanoseconds{7ms}, 102, _));
+    clock.frame_shown(left, frame(12, 1040ms));
+    clock.frame_shown(right, frame(102, 1019ms));
+}
+
+TEST_F(PresentationClock, does_not_guess_refresh_from_an_outputs_first_frame)
+{
+    clock.frame_shown(right, frame(100, 1005ms));
+
+    auto& feedback = await_frame(left);
+
+    EXPECT_CALL(feedback, presented(left, _, 0ns, _, _));
+    clock.frame_shown(left, frame(12, 1040ms));
+}
+
+TEST_F(PresentationClock, converts_frame_times_to_its_own_clock)
+{
+    auto const now = mir::time::PosixTimestamp::now(CLOCK_REALTIME);
+    auto& feedback = await_frame(left);
+
+    mir::time::PosixTimestamp time;
+    EXPECT_CALL(feedback, presented(left, _, _, _, _)).WillOnce(SaveArg<1>(&time));
+    clock.frame_shown(left, frame(1, now.nanoseconds, CLOCK_REALTIME));
+
+    auto const monotonic_now = mir::time::PosixTimestamp::now(mf::PresentationClock::clock_id);
+    EXPECT_THAT(time.clock_id, Eq(mf::PresentationClock::clock_id));
+    EXPECT_THAT(time.nanoseconds, Le(monotonic_now.nanoseconds));
+    EXPECT_THAT(time.nanoseconds, Ge(monotonic_now.nanoseconds - 1s));
+}
+
+TEST_F(PresentationClock, discards_feedback_that_piles_up_for_an_output_showing_nothing)
+{
+    std::vector<MockFeedback*> piled_up;
+    for (auto i = 0; i != 257; ++i)
+        piled_up.push_back(&await_frame(right));
+
+    for (auto const feedback : piled_up)
+        EXPECT_CALL(*feedback, discarded());
+
+    auto& latest = await_frame(right);
+
+    EXPECT_CALL(latest, discarded()).Times(0);
+    EXPECT_CALL(latest, presented(right, _, _, 1, _));
+    clock.frame_shown(right, frame(1, 100ms));
+}
+
+TEST_F(PresentationClock, passes_on_a_hardware_timestamp)
+{
+    auto& feedback = await_frame(left);
+
+    EXPECT_CALL(feedback, presented(left, _, _, 8, true));
+    clock.frame_shown(left, flip(8, 200ms));
+}
+
+TEST_F(PresentationClock, does_not_claim_an_estimated_timestamp_came_from_hardware)
+{
+    auto& feedback = await_frame(left);
+
+    EXPECT_CALL(feedback, presented(left, _, _, 8, false));
+    clock.frame_shown(left, frame(8, 200ms));
+}
+
+TEST_F(PresentationClock, does_not_claim_a_converted_timestamp_came_from_hardware)
+{
+    auto const now = mir::time::PosixTimestamp::now(CLOCK_REALTIME);
+    auto& feedback = await_frame(left);
+
+    EXPECT_CALL(feedback, presented(left, _, _, 1, false));
+    clock.frame_shown(left, flip(1, now.nanoseconds, CLOCK_REALTIME));
+}
+
+TEST_F(PresentationClock, does_not_claim_a_frame_on_any_output_came_from_hardware)
+{
+    auto& feedback = await_frame(unknown_output);
+
+    EXPECT_CALL(feedback, presented(right, _, _, 5, false));
+    clock.frame_shown(right, flip(5, 100ms));
+}
@@ -22,6 +22,7 @@
 #include "src/server/frontend/protobuf_message_processor.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/stub_display_server.h"
+#include "mir/protobuf/method_ids.h"
 #include "mir_protobuf_wire.pb.h"
 
 #include <gtest/gtest.h>
@@ -62,8 +63,27 @@ struct StubMessageProcessorReport : mf::MessageProcessorReport
     }
 };
 
+struct ConnectionRecordingSender : mfd::ProtobufMessageSender
+{
+    void send_response(gp::uint32, gp::MessageLite* response, mf::FdSets const&) override
+    {
+        if (response->GetTypeName() == "mir.protobuf.Connection")
+            connection = *static_cast<mp::Connection*>(response);
+    }
+
+    mp::Connection connection;
+};
+
 struct StubDisplayServer : mtd::StubDisplayServer
 {
+    void connect(
+        mp::ConnectParameters const*,
+        mp::Connection*,
+        google::protobuf::Closure* closure) override
+    {
+        closure->Run();
+    }
+
     void create_surface(
         mp::SurfaceParameters const*,
         mp::Surface* response,
@@ -85,10 +105,12 @@ struct StubDisplayServer : mtd::StubDisplayServer
         closure->Run();
         auto after = response->has_buffer();
         changed_during_create_bstream_closure = before != after;
+        ++create_bstream_calls;
     }
 
     bool changed_during_create_surface_closure;
     bool changed_during_create_bstream_closure;
+    int create_bstream_calls{0};
 };
 }
 
@@ -151,3 +173,73 @@ TEST(ProtobufMessageProcessor, doesnt_inject_buffers_when_creating_bstream)
     mp->dispatch(invocation, fds);
     EXPECT_FALSE(stub_display_server.changed_during_create_bstream_closure);
 }
+
+TEST(ProtobufMessageProcessor, tells_clients_it_accepts_method_ids)
+{
+    ConnectionRecordingSender sender;
+    StubMessageProcessorReport stub_report;
+    StubDisplayServer stub_display_server;
+    mfd::ProtobufMessageProcessor pb_message_processor(
+        mt::fake_shared(sender),
+        mt::fake_shared(stub_display_server),
+        mt::fake_shared(stub_report));
+    std::shared_ptr<mfd::MessageProcessor> mp = mt::fake_shared(pb_message_processor);
+
+    mp::ConnectParameters request;
+    request.set_application_name("test");
+    mpw::Invocation raw_invocation;
+    raw_invocation.set_parameters(request.SerializeAsString());
+    raw_invocation.set_method_name("connect");
+    mfd::Invocation invocation(raw_invocation);
+
+    std::vector<mir::Fd> fds;
+    mp->dispatch(invocation, fds);
+    EXPECT_TRUE(sender.connection.accepts_method_ids());
+}
+
+TEST(ProtobufMessageProcessor, dispatches_methods_given_by_id)
+{
+    StubProtobufMessageSender stub_msg_sender;
+    StubMessageProcessorReport stub_report;
+    StubDisplayServer stub_display_server;
+    mfd::ProtobufMessageProcessor pb_message_processor(
+        mt::fake_shared(stub_msg_sender),
+        mt::fake_shared(stub_display_server),
+        mt::fake_shared(stub_report));
+    std::shared_ptr<mfd::MessageProcessor> mp = mt::fake_shared(pb_message_processor);
+
+    mp::BufferStreamParameters request;
+    request.set_width(1);
+    request.set_height(1);
+    request.set_pixel_format(1);
+    request.set_buffer_usage(1);
+    mpw::Invocation raw_invocation;
+    raw_invocation.set_parameters(request.SerializeAsString());
+    raw_invocation.set_method_id(static_cast<uint32_t>(mp::MethodId::create_buffer_stream));
+    mfd::Invocation invocation(raw_invocation);
+
+    std::vector<mir::Fd> fds;
+    EXPECT_TRUE(mp->dispatch(invocation, fds));
+    EXPECT_EQ(1, stub_display_server.create_bstream_calls);
+    EXPECT_EQ("create_buffer_stream", invocation.method_name());
+}
+
+TEST(ProtobufMessageProcessor, rejects_unknown_method_ids)
+{
+    StubProtobufMessageSender stub_msg_sender;
+    StubMessageProcessorReport stub_report;
+    StubDisplayServer stub_display_server;
+    mfd::ProtobufMessageProcessor pb_message_processor(
+        mt::fake_shared(stub_msg_sender),
+        mt::fake_shared(stub_display_server),
+        mt::fake_shared(stub_report));
+    std::shared_ptr<mfd::MessageProcessor> mp = mt::fake_shared(pb_message_processor);
+
+    mpw::Invocation raw_invocation;
+    raw_invocation.set_parameters("");
+    raw_invocation.set_method_id(static_cast<uint32_t>(mp::MethodId::end));
+    mfd::Invocation invocation(raw_invocation);
+
+    std::vector<mir::Fd> fds;
+    EXPECT_FALSE(mp->dispatch(invocation, fds));
+}
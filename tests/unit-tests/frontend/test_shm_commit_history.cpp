@@ -0,0 +1,175 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/wayland/shm_commit_history.h"
+
+#include "mir/test/doubles/mock_gl.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <numeric>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct ShmCommitHistory : Test
+{
+    geom::Size const size{4, 8};
+    geom::Stride const stride{16};
+    MirPixelFormat const format{mir_pixel_format_argb_8888};
+
+    mg::BufferID const first{1};
+    mg::BufferID const second{2};
+
+    std::vector<uint8_t> buffer_filled_with(uint8_t value)
+    {
+        return std::vector<uint8_t>(size.height.as_int() * stride.as_int(), value);
+    }
+
+    std::vector<uint8_t> contents_of(mf::ShmCommitHistory::Pixels const& pixels)
+    {
+        return {pixels.data.get(), pixels.data.get() + size.height.as_int() * stride.as_int()};
+    }
+
+    /// What copying \a buffer over \a older should give, if only \a rows are copied
+    std::vector<uint8_t> rows_copied(std::vector<uint8_t> older, std::vector<uint8_t> const& buffer, int top, int rows)
+    {
+        std::copy_n(buffer.begin() + top * stride.as_int(), rows * stride.as_int(), older.begin() + top * stride.as_int());
+        return older;
+    }
+
+    mf::ShmCommitHistory history;
+};
+
+struct UploadRows : Test
+{
+    NiceMock<mtd::MockGL> mock_gl;
+    uint8_t const pixels[256 * 32]{};
+};
+}
+
+TEST_F(ShmCommitHistory, copies_only_the_damaged_rows_into_reused_pixels)
+{
+    auto const first_buffer = buffer_filled_with(1);
+    history.committed(first, size, stride, format, {});
+    auto pixels = history.take_pixels();
+    history.copy_into(pixels, first, first_buffer.data());
+    history.give_back(std::move(pixels));
+
+    auto const second_buffer = buffer_filled_with(2);
+    history.committed(second, size, stride, format, geom::Rectangle{{1, 2}, {2, 3}});
+    pixels = history.take_pixels();
+    history.copy_into(pixels, second, second_buffer.data());
+
+    EXPECT_THAT(contents_of(pixels), Eq(rows_copied(first_buffer, second_buffer, 2, 3)));
+    EXPECT_THAT(*pixels.contents, Eq(second));
+}
+
+TEST_F(ShmCommitHistory, copies_everything_when_the_client_gives_no_damage)
+{
+    auto const first_buffer = buffer_filled_with(1);
+    history.committed(first, size, stride, format, {});
+    auto pixels = history.take_pixels();
+    history.copy_into(pixels, first, first_buffer.data());
+    history.give_back(std::move(pixels));
+
+    auto const second_buffer = buffer_filled_with(2);
+    history.committed(second, size, stride, format, {});
+    pixels = history.take_pixels();
+    history.copy_into(pixels, second, second_buffer.data());
+
+    EXPECT_THAT(contents_of(pixels), Eq(second_buffer));
+}
+
+TEST_F(ShmCommitHistory, copies_everything_into_new_pixels)
+{
+    auto const buffer = buffer_filled_with(3);
+    history.committed(first, size, stride, format, geom::Rectangle{{0, 0}, {1, 1}});
+    auto pixels = history.take_pixels();
+    history.copy_into(pixels, first, buffer.data());
+
+    EXPECT_THAT(contents_of(pixels), Eq(buffer));
+}
+
+TEST_F(ShmCommitHistory, damage_between_commits_covers_every_commit_since)
+{
+    history.committed(first, size, stride, format, {});
+    history.committed(second, size, stride, format, geom::Rectangle{{0, 1}, {1, 1}});
+    history.committed(mg::BufferID{3}, size, stride, format, geom::Rectangle{{2, 5}, {1, 2}});
+
+    EXPECT_THAT(history.damage_between(first, mg::BufferID{3}), Eq(geom::Rectangle{{0, 1}, {3, 6}}));
+    EXPECT_THAT(history.damage_between(second, mg::BufferID{3}), Eq(geom::Rectangle{{2, 5}, {1, 2}}));
+}
+
+TEST_F(ShmCommitHistory, damage_is_unknown_across_a_layout_change)
+{
+    history.committed(first, size, stride, format, {});
+    history.committed(second, size, geom::Stride{32}, format, geom::Rectangle{{0, 1}, {1, 1}});
+
+    EXPECT_FALSE(history.damage_between(first, second));
+}
+
+TEST_F(UploadRows, uploads_the_damaged_rows_of_tightly_packed_pixels_at_once)
+{
+    geom::Size const size{64, 32};
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 10, 64, 5, GL_RGBA, GL_UNSIGNED_BYTE,
+                                         pixels + 10 * 256));
+
+    mf::upload_rows(pixels, size, geom::Stride{256}, mir_pixel_format_abgr_8888, GL_RGBA, GL_UNSIGNED_BYTE,
+                    geom::Rectangle{{3, 10}, {4, 5}});
+}
+
+TEST_F(UploadRows, uploads_everything_for_full_damage)
+{
+    geom::Size const size{64, 32};
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 64, 32, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+
+    mf::upload_rows(pixels, size, geom::Stride{256}, mir_pixel_format_abgr_8888, GL_RGBA, GL_UNSIGNED_BYTE,
+                    geom::Rectangle{{0, 0}, size});
+}
+
+TEST_F(UploadRows, uploads_padded_rows_one_at_a_time)
+{
+    geom::Size const size{16, 32};
+    geom::Stride const stride{80};
+
+    InSequence seq;
+    for (auto row = 4; row != 7; ++row)
+    {
+        EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, 16, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                                             pixels + row * stride.as_int()));
+    }
+
+    mf::upload_rows(pixels, size, stride, mir_pixel_format_abgr_8888, GL_RGBA, GL_UNSIGNED_BYTE,
+                    geom::Rectangle{{0, 4}, {16, 3}});
+}
+
+TEST_F(UploadRows, uploads_nothing_without_damage)
+{
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    mf::upload_rows(pixels, geom::Size{64, 32}, geom::Stride{256}, mir_pixel_format_abgr_8888,
+                    GL_RGBA, GL_UNSIGNED_BYTE, geom::Rectangle{});
+}
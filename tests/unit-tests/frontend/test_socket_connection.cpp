@@ -67,12 +67,14 @@ struct StubReceiver : mfd::MessageReceiver
     {
         if (ba::buffer_cast<void*>(buffer) == nullptr)
             throw std::runtime_error("StubReceiver::receive_msg got null buffer");
-        if (ba::buffer_size(buffer) != message.size())
-            throw std::runtime_error("StubReceiver::receive_msg buffer size not equal to message size");
+        if (ba::buffer_size(buffer) > message.size())
+            throw std::runtime_error("StubReceiver::receive_msg buffer size greater than message size");
 
         memcpy(ba::buffer_cast<void*>(buffer),
                message.data(), ba::buffer_size(buffer));
 
+        message.erase(message.begin(), message.begin() + ba::buffer_size(buffer));
+
         return boost::system::error_code();
     }
 
@@ -139,6 +141,12 @@ struct SocketConnection : public Test
     }
 
     void fake_receiving_message()
+    {
+        auto message = serialized_message();
+        stub_receiver.fake_receive_msg(message.data(), message.size());
+    }
+
+    std::vector<char> serialized_message()
     {
         int const header_size = 2;
         char buffer[512];
@@ -153,7 +161,7 @@ struct SocketConnection : public Test
         buffer[1] = body_size % 0x100;
         invocation.SerializeToArray(buffer + header_size, sizeof buffer - header_size);
 
-        stub_receiver.fake_receive_msg(buffer, header_size + body_size);
+        return {buffer, buffer + header_size + body_size};
     }
 };
 
@@ -206,3 +214,21 @@ TEST_F(SocketConnection, receives_and_dispatches_fds)
     EXPECT_CALL(mock_processor, dispatch(_, ContainerEq(fds)));
     fake_receiving_message();
 }
+
+TEST_F(SocketConnection, dispatches_messages_received_together_without_waiting_for_each)
+{
+    auto const arbitary_no_of_messages = 5;
+
+    std::vector<char> messages;
+    for (int i = 0; i != arbitary_no_of_messages; ++i)
+    {
+        auto const message = serialized_message();
+        messages.insert(messages.end(), message.begin(), message.end());
+    }
+
+    EXPECT_CALL(mock_processor, dispatch(_,_)).Times(arbitary_no_of_messages);
+
+    stub_receiver.fake_receive_msg(messages.data(), messages.size());
+
+    EXPECT_THAT(stub_receiver.message, IsEmpty());
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/socket_messenger.h"
+#include "mir/fd_socket_transmission.h"
+
+#include <boost/asio.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace mfd = mir::frontend::detail;
+namespace ba = boost::asio;
+using namespace testing;
+
+namespace
+{
+struct SocketMessenger : Test
+{
+    SocketMessenger()
+    {
+        ba::local::connect_pair(*server_socket, client_socket);
+    }
+
+    std::vector<char> receive(size_t size)
+    {
+        std::vector<char> received(size);
+        ba::read(client_socket, ba::buffer(received));
+        return received;
+    }
+
+    ba::io_service io_service;
+    std::shared_ptr<ba::local::stream_protocol::socket> const server_socket{
+        std::make_shared<ba::local::stream_protocol::socket>(io_service)};
+    ba::local::stream_protocol::socket client_socket{io_service};
+    std::vector<char> message = std::vector<char>(16 * 1024);
+};
+}
+
+TEST_F(SocketMessenger, prefixes_messages_with_their_length)
+{
+    mfd::SocketMessenger messenger{server_socket};
+    std::string const hello{"hello"};
+
+    messenger.send(hello.data(), hello.size(), {});
+
+    EXPECT_THAT(receive(2 + hello.size()), ElementsAre(0, 5, 'h', 'e', 'l', 'l', 'o'));
+}
+
+TEST_F(SocketMessenger, sends_fds_after_their_message)
+{
+    mfd::SocketMessenger messenger{server_socket};
+    int pipe_fds[2];
+    ASSERT_THAT(pipe(pipe_fds), Eq(0));
+    mir::Fd const read_end{pipe_fds[0]};
+    mir::Fd const write_end{pipe_fds[1]};
+
+    messenger.send(message.data(), message.size(), {{read_end}});
+
+    EXPECT_THAT(receive(2 + message.size()).size(), Eq(2 + message.size()));
+    std::vector<mir::Fd> fds(1);
+    char dummy;
+    mir::receive_data(mir::Fd{mir::IntOwnedFd{client_socket.native_handle()}}, &dummy, 1, fds);
+    EXPECT_THAT(static_cast<int>(fds[0]), Ne(-1));
+}
+
+TEST_F(SocketMessenger, queues_what_a_slow_client_is_not_ready_for)
+{
+    mfd::SocketMessenger messenger{server_socket};
+
+    // Much more than the socket holds, but not more than we keep for a client
+    int const message_count{32};
+    for (int i = 0; i != message_count; ++i)
+    {
+        std::fill(message.begin(), message.end(), static_cast<char>(i));
+        EXPECT_NO_THROW(messenger.send(message.data(), message.size(), {}));
+    }
+
+    std::thread sending{[this] { io_service.run(); }};
+    for (int i = 0; i != message_count; ++i)
+    {
+        auto const received = receive(2 + message.size());
+        EXPECT_THAT(std::vector<char>(received.begin() + 2, received.end()), Each(static_cast<char>(i)));
+    }
+    sending.join();
+}
+
+TEST_F(SocketMessenger, gives_up_on_a_client_that_stops_reading)
+{
+    mfd::SocketMessenger messenger{server_socket};
+
+    EXPECT_THROW(
+        for (int i = 0; i != 100; ++i)
+            messenger.send(message.data(), message.size(), {}),
+        std::runtime_error);
+}
+
+TEST_F(SocketMessenger, queued_fds_outlive_the_callers_copies)
+{
+    mfd::SocketMessenger messenger{server_socket};
+    int const message_count{32};
+    for (int i = 0; i != message_count; ++i)
+        messenger.send(message.data(), message.size(), {});
+
+    int pipe_fds[2];
+    ASSERT_THAT(pipe(pipe_fds), Eq(0));
+    mir::Fd const write_end{pipe_fds[1]};
+    // As mfd::EventSender sends a buffer's fds, without a reference of its own
+    messenger.send(message.data(), message.size(), {{mir::Fd{mir::IntOwnedFd{pipe_fds[0]}}}});
+    close(pipe_fds[0]);
+    // Whatever reuses the number mustn't be what the client gets
+    mir::Fd const reuse{dup(write_end)};
+
+    std::thread sending{[this] { io_service.run(); }};
+    for (int i = 0; i != message_count + 1; ++i)
+        receive(2 + message.size());
+    std::vector<mir::Fd> fds(1);
+    char dummy;
+    mir::receive_data(mir::Fd{mir::IntOwnedFd{client_socket.native_handle()}}, &dummy, 1, fds);
+    sending.join();
+
+    char const sent{'!'};
+    char received{0};
+    ASSERT_THAT(write(write_end, &sent, 1), Eq(1));
+    EXPECT_THAT(read(fds[0], &received, 1), Eq(1));
+    EXPECT_THAT(received, Eq(sent));
+}
+
+TEST_F(SocketMessenger, gives_up_on_a_client_that_leaves_too_many_fds_queued)
+{
+    mfd::SocketMessenger messenger{server_socket};
+    for (int i = 0; i != 32; ++i)
+        messenger.send(message.data(), message.size(), {});
+
+    int pipe_fds[2];
+    ASSERT_THAT(pipe(pipe_fds), Eq(0));
+    mir::Fd const read_end{pipe_fds[0]};
+    mir::Fd const write_end{pipe_fds[1]};
+
+    // Only a few bytes each, so it's the fds that run out
+    EXPECT_THROW(
+        for (int i = 0; i != 1000; ++i)
+            messenger.send(nullptr, 0, {{read_end}}),
+        std::runtime_error);
+}
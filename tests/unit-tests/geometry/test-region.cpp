@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace mir::geometry;
+using namespace testing;
+
+TEST(Region, default_is_empty)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.rectangles(), IsEmpty());
+    EXPECT_EQ(Rectangle(), region.bounding_rectangle());
+}
+
+TEST(Region, empty_rectangle_makes_empty_region)
+{
+    EXPECT_TRUE(Region{Rectangle({10, 10}, {0, 5})}.empty());
+    EXPECT_TRUE(Region{Rectangle({10, 10}, {5, 0})}.empty());
+}
+
+TEST(Region, single_rectangle_round_trips)
+{
+    Rectangle const rect{{3, 4}, {10, 20}};
+    Region const region{rect};
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(rect));
+    EXPECT_EQ(rect, region.bounding_rectangle());
+}
+
+TEST(Region, overlapping_rectangles_are_split_into_bands)
+{
+    Region region{Rectangle{{0, 0}, {10, 10}}};
+    region.add(Rectangle{{5, 5}, {10, 10}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {10, 5}},
+        Rectangle{{0, 5}, {15, 5}},
+        Rectangle{{5, 10}, {10, 5}}));
+    EXPECT_EQ(Rectangle({0, 0}, {15, 15}), region.bounding_rectangle());
+}
+
+TEST(Region, adjacent_rectangles_coalesce)
+{
+    Region side_by_side{Rectangle{{0, 0}, {10, 10}}};
+    side_by_side.add(Rectangle{{10, 0}, {10, 10}});
+
+    Region stacked{Rectangle{{0, 0}, {10, 10}}};
+    stacked.add(Rectangle{{0, 10}, {10, 10}});
+
+    EXPECT_THAT(side_by_side.rectangles(), ElementsAre(Rectangle{{0, 0}, {20, 10}}));
+    EXPECT_THAT(stacked.rectangles(), ElementsAre(Rectangle{{0, 0}, {10, 20}}));
+}
+
+TEST(Region, subtracting_a_hole_leaves_a_frame)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {30, 10}},
+        Rectangle{{0, 10}, {10, 10}},
+        Rectangle{{20, 10}, {10, 10}},
+        Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_FALSE(region.contains(Rectangle{{5, 5}, {10, 10}}));
+    EXPECT_TRUE(region.contains(Rectangle{{0, 0}, {30, 10}}));
+    EXPECT_FALSE(region.overlaps(Rectangle{{12, 12}, {5, 5}}));
+    EXPECT_TRUE(region.overlaps(Rectangle{{5, 5}, {10, 10}}));
+}
+
+TEST(Region, intersection_keeps_only_common_area)
+{
+    Region region{Rectangle{{0, 0}, {20, 20}}};
+    region.add(Rectangle{{40, 0}, {20, 20}});
+    region.intersect(Rectangle{{10, 10}, {40, 40}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{10, 10}, {10, 10}},
+        Rectangle{{40, 10}, {10, 10}}));
+}
+
+TEST(Region, union_of_rectangles_contains_what_none_does_alone)
+{
+    Region region{Rectangle{{0, 0}, {10, 20}}};
+    region.add(Rectangle{{10, 0}, {10, 20}});
+
+    EXPECT_TRUE(region.contains(Rectangle{{5, 5}, {10, 10}}));
+}
+
+TEST(Region, equal_point_sets_compare_equal)
+{
+    Region by_rows{Rectangle{{0, 0}, {20, 10}}};
+    by_rows.add(Rectangle{{0, 10}, {20, 10}});
+
+    Region by_columns{Rectangle{{0, 0}, {10, 20}}};
+    by_columns.add(Rectangle{{10, 0}, {10, 20}});
+
+    EXPECT_EQ(by_rows, by_columns);
+    EXPECT_NE(by_rows, Region{Rectangle({0, 0}, {20, 19})});
+}
+
+TEST(Region, subtracting_everything_empties)
+{
+    Region region{Rectangle{{0, 0}, {10, 10}}};
+    region.add(Rectangle{{20, 20}, {10, 10}});
+    region.subtract(Region{Rectangle{{-5, -5}, {50, 50}}});
+
+    EXPECT_TRUE(region.empty());
+}
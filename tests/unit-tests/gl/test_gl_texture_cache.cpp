@@ -21,11 +21,15 @@
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_renderable.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
+#include "mir/renderer/gl/incremental_texture_source.h"
+#include "mir/renderer/gl/streaming_texture_source.h"
 #include <gtest/gtest.h>
 
 namespace mtd=mir::test::doubles;
 namespace mgl=mir::gl;
 namespace mg=mir::graphics;
+namespace geom=mir::geometry;
 
 namespace
 {
@@ -49,6 +53,37 @@ public:
     std::shared_ptr<testing::NiceMock<mtd::MockRenderable>> renderable;
     GLuint const stub_texture{1};
 };
+
+struct MockIncrementalGLBuffer : mtd::MockGLBuffer,
+                                 mir::renderer::gl::IncrementalTextureSource
+{
+    MOCK_METHOD1(bind_changes_since, void(mg::BufferID));
+};
+
+struct MockStreamingGLBuffer : mtd::MockGLBuffer,
+                               mir::renderer::gl::StreamingTextureSource
+{
+    using mtd::MockGLBuffer::MockGLBuffer;
+
+    geom::Size size() const override { return MockGLBuffer::size(); }
+    MirPixelFormat pixel_format() const override { return MockGLBuffer::pixel_format(); }
+
+    MOCK_METHOD0(prefers_streaming, bool());
+    MOCK_METHOD1(copy_packed_pixels, void(unsigned char*));
+};
+
+GLenum const pixel_unpack_buffer{0x88EC};
+unsigned char pixel_buffer_memory[4 * 2 * 4];
+
+void* fake_map_buffer_range(GLenum, GLintptr, GLsizeiptr, GLbitfield)
+{
+    return pixel_buffer_memory;
+}
+
+GLboolean fake_unmap_buffer(GLenum)
+{
+    return GL_TRUE;
+}
 }
 
 TEST_F(RecentlyUsedCache, caches_and_uploads_texture_only_on_buffer_changes)
@@ -140,3 +175,154 @@ TEST_F(RecentlyUsedCache, invalidated_buffers_are_reloaded)
     cache.invalidate();
     cache.load(*renderable);
 }
+
+TEST_F(RecentlyUsedCache, uploads_only_changes_since_the_buffer_the_texture_holds)
+{
+    using namespace testing;
+    auto const incremental_buffer = std::make_shared<NiceMock<MockIncrementalGLBuffer>>();
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(incremental_buffer));
+
+    InSequence seq;
+    EXPECT_CALL(*incremental_buffer, id())
+        .WillOnce(Return(mg::BufferID(123)));
+    EXPECT_CALL(*incremental_buffer, bind());
+    EXPECT_CALL(*incremental_buffer, id())
+        .WillOnce(Return(mg::BufferID(456)));
+    EXPECT_CALL(*incremental_buffer, bind_changes_since(mg::BufferID(123)));
+    EXPECT_CALL(*incremental_buffer, id())
+        .WillOnce(Return(mg::BufferID(456)));
+    EXPECT_CALL(*incremental_buffer, bind());
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+
+    cache.load(*renderable);
+    cache.drop_unused();
+
+    // The texture holding anything in particular can't be relied on after invalidation
+    cache.invalidate();
+    cache.load(*renderable);
+}
+
+TEST_F(RecentlyUsedCache, streams_software_buffers_through_alternating_pixel_buffers)
+{
+    using namespace testing;
+    NiceMock<mtd::MockEGL> mock_egl;
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_fence_sync"));
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.0")));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glMapBufferRange")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_map_buffer_range)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glUnmapBuffer")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_unmap_buffer)));
+
+    auto const streaming_buffer = std::make_shared<NiceMock<MockStreamingGLBuffer>>(
+        geom::Size{4, 2}, geom::Stride{16}, mir_pixel_format_abgr_8888);
+    ON_CALL(*streaming_buffer, prefers_streaming())
+        .WillByDefault(Return(true));
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(streaming_buffer));
+
+    EXPECT_CALL(*streaming_buffer, id())
+        .WillOnce(Return(mg::BufferID(1)))
+        .WillOnce(Return(mg::BufferID(2)))
+        .WillOnce(Return(mg::BufferID(3)));
+    EXPECT_CALL(*streaming_buffer, copy_packed_pixels(pixel_buffer_memory))
+        .Times(3);
+    EXPECT_CALL(*streaming_buffer, bind())
+        .Times(0);
+
+    GLuint const pixel_buffers[] = {7, 8};
+    EGLSyncKHR const fences[] = {reinterpret_cast<EGLSyncKHR>(0xf1), reinterpret_cast<EGLSyncKHR>(0xf2)};
+    // Outstanding fences are destroyed along with the cache
+    EXPECT_CALL(mock_egl, eglDestroySyncKHR(_, _))
+        .Times(AnyNumber());
+    {
+        InSequence seq;
+
+        // Frame 1: the first pixel buffer is created and the texture specified from it
+        EXPECT_CALL(mock_gl, glGenBuffers(1, _))
+            .WillOnce(SetArgPointee<1>(pixel_buffers[0]));
+        EXPECT_CALL(mock_gl, glBindBuffer(pixel_unpack_buffer, pixel_buffers[0]));
+        EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, 4, 2, 0, _, _, IsNull()));
+        EXPECT_CALL(mock_gl, glBindBuffer(pixel_unpack_buffer, 0));
+        EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+            .WillOnce(Return(fences[0]));
+
+        // Frame 2: the second pixel buffer updates the texture in place
+        EXPECT_CALL(mock_gl, glGenBuffers(1, _))
+            .WillOnce(SetArgPointee<1>(pixel_buffers[1]));
+        EXPECT_CALL(mock_gl, glBindBuffer(pixel_unpack_buffer, pixel_buffers[1]));
+        EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 4, 2, _, _, IsNull()));
+        EXPECT_CALL(mock_gl, glBindBuffer(pixel_unpack_buffer, 0));
+        EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+            .WillOnce(Return(fences[1]));
+
+        // Frame 3: the first pixel buffer is reused once the GPU is done with it
+        EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, fences[0], _, 0))
+            .WillOnce(Return(EGL_CONDITION_SATISFIED_KHR));
+        EXPECT_CALL(mock_egl, eglDestroySyncKHR(_, fences[0]));
+        EXPECT_CALL(mock_gl, glBindBuffer(pixel_unpack_buffer, pixel_buffers[0]));
+        EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 4, 2, _, _, IsNull()));
+        EXPECT_CALL(mock_gl, glBindBuffer(pixel_unpack_buffer, 0));
+        EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+            .WillOnce(Return(fences[0]));
+    }
+
+    mgl::RecentlyUsedCache cache;
+    for (int frame = 0; frame != 3; ++frame)
+    {
+        cache.load(*renderable);
+        cache.drop_unused();
+    }
+}
+
+TEST_F(RecentlyUsedCache, uploads_directly_rather_than_wait_for_a_busy_pixel_buffer)
+{
+    using namespace testing;
+    NiceMock<mtd::MockEGL> mock_egl;
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_fence_sync"));
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.0")));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glMapBufferRange")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_map_buffer_range)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glUnmapBuffer")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_unmap_buffer)));
+    ON_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+        .WillByDefault(Return(reinterpret_cast<EGLSyncKHR>(0xf1)));
+
+    auto const streaming_buffer = std::make_shared<NiceMock<MockStreamingGLBuffer>>(
+        geom::Size{4, 2}, geom::Stride{16}, mir_pixel_format_abgr_8888);
+    ON_CALL(*streaming_buffer, prefers_streaming())
+        .WillByDefault(Return(true));
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(streaming_buffer));
+
+    EXPECT_CALL(*streaming_buffer, id())
+        .WillOnce(Return(mg::BufferID(1)))
+        .WillOnce(Return(mg::BufferID(2)))
+        .WillOnce(Return(mg::BufferID(3)));
+
+    // The GPU never finishes with the first pixel buffer
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, _, _, 0))
+        .WillRepeatedly(Return(EGL_TIMEOUT_EXPIRED_KHR));
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, _, _, EGL_FOREVER_KHR))
+        .Times(0);
+
+    // ...so the third frame is bound directly, not copied into it
+    EXPECT_CALL(*streaming_buffer, copy_packed_pixels(_))
+        .Times(2);
+    EXPECT_CALL(*streaming_buffer, bind())
+        .Times(1);
+
+    mgl::RecentlyUsedCache cache;
+    for (int frame = 0; frame != 3; ++frame)
+    {
+        cache.load(*renderable);
+        cache.drop_unused();
+    }
+}
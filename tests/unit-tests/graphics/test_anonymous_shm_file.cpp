@@ -19,6 +19,38 @@
 #include "mir/anonymous_shm_file.h"
 #include <gtest/gtest.h>
 
+#include <string>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+
+namespace
+{
+bool kernel_has_sealable_memfds()
+{
+#if defined(__NR_memfd_create) && defined(F_ADD_SEALS)
+    auto const fd = syscall(__NR_memfd_create, "probe", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1)
+        return false;
+    close(fd);
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string path_of(int fd)
+{
+    char path[256] = {};
+    auto const link = "/proc/self/fd/" + std::to_string(fd);
+    readlink(link.c_str(), path, sizeof path - 1);
+    return path;
+}
+}
+
 TEST(AnonymousShmFile, is_created)
 {
     size_t const file_size{100};
@@ -63,3 +95,40 @@ TEST(AnonymousShmFile, writing_to_base_ptr_writes_to_file)
         EXPECT_EQ(base_ptr[i], buffer[i]) << "i=" << i;
     }
 }
+
+TEST(AnonymousShmFile, is_a_sealed_memfd_where_the_kernel_has_them)
+{
+    if (!kernel_has_sealable_memfds())
+        return;
+
+    size_t const file_size{4096};
+
+    mir::AnonymousShmFile shm_file{file_size};
+
+    EXPECT_EQ(0u, path_of(shm_file.fd()).find("/memfd:mir-buffer"));
+#ifdef F_GET_SEALS
+    auto const seals = fcntl(shm_file.fd(), F_GET_SEALS);
+    EXPECT_EQ(F_SEAL_SHRINK | F_SEAL_SEAL, seals);
+#endif
+}
+
+TEST(AnonymousShmFile, seals_stop_it_being_shrunk_or_resealed)
+{
+    if (!kernel_has_sealable_memfds())
+        return;
+
+    size_t const file_size{4096};
+
+    mir::AnonymousShmFile shm_file{file_size};
+
+    EXPECT_EQ(-1, ftruncate(shm_file.fd(), file_size / 2));
+    EXPECT_EQ(EPERM, errno);
+#ifdef F_ADD_SEALS
+    EXPECT_EQ(-1, fcntl(shm_file.fd(), F_ADD_SEALS, F_SEAL_WRITE));
+    EXPECT_EQ(EPERM, errno);
+#endif
+
+    struct stat stat;
+    fstat(shm_file.fd(), &stat);
+    EXPECT_EQ(static_cast<off_t>(file_size), stat.st_size);
+}
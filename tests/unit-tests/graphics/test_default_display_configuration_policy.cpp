@@ -67,7 +67,9 @@ DisplayConfigurationOutput default_output(DisplayConfigurationOutputId id)
         {},
         mir_output_gamma_unsupported,
         {},
-        {}
+        {},
+        false,
+        false
     };
     return ret;
 }
@@ -54,7 +54,9 @@ mg::DisplayConfigurationOutput const tmpl_output
     {},
     mir_output_gamma_unsupported,
     {},
-    {}
+    {},
+    false,
+    false
 };
 
 }
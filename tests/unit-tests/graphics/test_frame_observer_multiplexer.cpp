@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/graphics/frame_observer_multiplexer.h"
+#include "mir/graphics/frame.h"
+#include "mir/executor.h"
+
+#include "mir/test/doubles/mock_display_report.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <functional>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+class QueueingExecutor : public mir::Executor
+{
+public:
+    void spawn(std::function<void()>&& work) override
+    {
+        queue.push_back(std::move(work));
+    }
+
+    void run_queued()
+    {
+        auto const work = std::move(queue);
+        queue.clear();
+        for (auto const& item : work)
+            item();
+    }
+
+private:
+    std::vector<std::function<void()>> queue;
+};
+
+struct MockFrameObserver : mg::FrameObserver
+{
+    MOCK_METHOD2(frame_shown, void(unsigned int, mg::Frame const&));
+};
+
+mg::Frame frame_number(int64_t msc)
+{
+    mg::Frame frame;
+    frame.msc = msc;
+    frame.ust = {CLOCK_MONOTONIC, std::chrono::milliseconds{16} * msc};
+    return frame;
+}
+
+struct FrameObserverMultiplexer : Test
+{
+    std::shared_ptr<QueueingExecutor> const default_executor{std::make_shared<QueueingExecutor>()};
+    mg::FrameObserverMultiplexer multiplexer{default_executor};
+    std::shared_ptr<MockFrameObserver> const observer{std::make_shared<MockFrameObserver>()};
+};
+
+struct FrameObservingDisplayReport : Test
+{
+    std::shared_ptr<NiceMock<mtd::MockDisplayReport>> const wrapped{
+        std::make_shared<NiceMock<mtd::MockDisplayReport>>()};
+    std::shared_ptr<MockFrameObserver> const observer{std::make_shared<MockFrameObserver>()};
+    mg::FrameObservingDisplayReport report{wrapped, observer};
+};
+}
+
+TEST_F(FrameObserverMultiplexer, tells_observers_of_frames_shown_on_their_executor)
+{
+    multiplexer.register_interest(observer);
+
+    EXPECT_CALL(*observer, frame_shown(_, _)).Times(0);
+    multiplexer.frame_shown(2, frame_number(7));
+    Mock::VerifyAndClearExpectations(observer.get());
+
+    EXPECT_CALL(*observer, frame_shown(2, Field(&mg::Frame::msc, 7)));
+    default_executor->run_queued();
+}
+
+TEST_F(FrameObserverMultiplexer, uses_the_executor_an_observer_registered_with)
+{
+    QueueingExecutor own_executor;
+    multiplexer.register_interest(observer, own_executor);
+
+    multiplexer.frame_shown(2, frame_number(7));
+
+    EXPECT_CALL(*observer, frame_shown(_, _)).Times(0);
+    default_executor->run_queued();
+    Mock::VerifyAndClearExpectations(observer.get());
+
+    EXPECT_CALL(*observer, frame_shown(2, Field(&mg::Frame::msc, 7)));
+    own_executor.run_queued();
+}
+
+TEST_F(FrameObserverMultiplexer, stops_telling_observers_that_unregister)
+{
+    multiplexer.register_interest(observer);
+    multiplexer.unregister_interest(*observer);
+
+    EXPECT_CALL(*observer, frame_shown(_, _)).Times(0);
+    multiplexer.frame_shown(2, frame_number(7));
+    default_executor->run_queued();
+}
+
+TEST_F(FrameObservingDisplayReport, reports_vsyncs_and_tells_the_observer)
+{
+    InSequence seq;
+    EXPECT_CALL(*wrapped, report_vsync(3, Field(&mg::Frame::msc, 11)));
+    EXPECT_CALL(*observer, frame_shown(3, Field(&mg::Frame::msc, 11)));
+
+    report.report_vsync(3, frame_number(11));
+}
+
+TEST_F(FrameObservingDisplayReport, passes_other_reports_on_only)
+{
+    EXPECT_CALL(*observer, frame_shown(_, _)).Times(0);
+    EXPECT_CALL(*wrapped, report_successful_display_construction());
+    EXPECT_CALL(*wrapped, report_drm_master_failure(13));
+    EXPECT_CALL(*wrapped, report_vt_switch_away_failure());
+
+    report.report_successful_display_construction();
+    report.report_drm_master_failure(13);
+    report.report_vt_switch_away_failure();
+}
@@ -101,7 +101,9 @@ public:
                 {},
                 mir_output_gamma_unsupported,
                 {},
-                {}
+                {},
+                false,
+                false
             };
 
             f(output);
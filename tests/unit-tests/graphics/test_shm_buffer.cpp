@@ -18,13 +18,18 @@
 
 #include "src/platforms/common/server/shm_buffer.h"
 #include "mir/shm_file.h"
+#include "mir/anonymous_shm_file.h"
+#include "mir/fd.h"
 
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <GLES2/gl2ext.h>
 #include <endian.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace mg = mir::graphics;
 namespace mgc = mir::graphics::common;
@@ -44,6 +49,24 @@ struct StubShmFile : public mir::ShmFile
     int const fake_fd = 17;
 };
 
+/// A file in /dev/shm, which can't be sealed the way a memfd can
+struct UnsealedShmFile : public mir::ShmFile
+{
+    UnsealedShmFile(size_t size)
+        : fd_{open("/dev/shm", O_TMPFILE | O_RDWR | O_EXCL | O_CLOEXEC, S_IRWXU)},
+          mapping(size)
+    {
+        if (fd_ != mir::Fd::invalid && ftruncate(fd_, size) == -1)
+            throw std::runtime_error{"Failed to resize test file"};
+    }
+
+    void* base_ptr() const { return const_cast<char*>(mapping.data()); }
+    int fd() const { return fd_; }
+
+    mir::Fd const fd_;
+    std::vector<char> const mapping;
+};
+
 struct PlatformlessShmBuffer : mgc::ShmBuffer
 {
     PlatformlessShmBuffer(
@@ -199,3 +222,70 @@ TEST_F(ShmBufferTest, uploads_abgr_8888_correctly)
     PlatformlessShmBuffer buf(std::make_unique<StubShmFile>(), size, mir_pixel_format_abgr_8888);
     buf.gl_bind_to_texture();
 }
+
+namespace
+{
+struct ShmBufferImportTest : ShmBufferTest
+{
+    ShmBufferImportTest()
+    {
+        mock_egl.provide_egl_extensions();
+    }
+
+    /// Whole pages, as udmabuf needs
+    geom::Size const import_size{sysconf(_SC_PAGESIZE) / 4, 8};
+    testing::NiceMock<mtd::MockEGL> mock_egl;
+};
+}
+
+TEST_F(ShmBufferImportTest, uploads_when_the_dma_buf_import_fails)
+{
+    ON_CALL(mock_egl, eglCreateImageKHR(_,_,_,_,_)).WillByDefault(Return(EGL_NO_IMAGE_KHR));
+
+    auto shm_file = std::make_unique<mir::AnonymousShmFile>(
+        MIR_BYTES_PER_PIXEL(mir_pixel_format_xbgr_8888) * import_size.width.as_int() * import_size.height.as_int());
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    auto const pixels = shm_file->base_ptr();
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _,
+                                      import_size.width.as_int(), import_size.height.as_int(),
+                                      0, _, _, pixels))
+        .Times(2);
+#endif
+
+    PlatformlessShmBuffer buf(std::move(shm_file), import_size, mir_pixel_format_xbgr_8888);
+    buf.gl_bind_to_texture();
+    buf.gl_bind_to_texture();
+}
+
+TEST_F(ShmBufferImportTest, does_not_retry_a_failed_dma_buf_import)
+{
+    ON_CALL(mock_egl, eglCreateImageKHR(_,_,_,_,_)).WillByDefault(Return(EGL_NO_IMAGE_KHR));
+    EXPECT_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS)).Times(AtMost(1));
+
+    PlatformlessShmBuffer buf(
+        std::make_unique<mir::AnonymousShmFile>(
+            MIR_BYTES_PER_PIXEL(mir_pixel_format_xbgr_8888) * import_size.width.as_int() * import_size.height.as_int()),
+        import_size,
+        mir_pixel_format_xbgr_8888);
+    buf.gl_bind_to_texture();
+    buf.gl_bind_to_texture();
+}
+
+TEST_F(ShmBufferImportTest, does_not_import_an_unsealed_file)
+{
+    EXPECT_CALL(mock_egl, eglCreateImageKHR(_,_,_,_,_)).Times(0);
+
+    auto shm_file = std::make_unique<UnsealedShmFile>(
+        MIR_BYTES_PER_PIXEL(mir_pixel_format_xbgr_8888) * import_size.width.as_int() * import_size.height.as_int());
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    auto const pixels = shm_file->base_ptr();
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _,
+                                      import_size.width.as_int(), import_size.height.as_int(),
+                                      0, _, _, pixels));
+#endif
+
+    PlatformlessShmBuffer buf(std::move(shm_file), import_size, mir_pixel_format_xbgr_8888);
+    buf.gl_bind_to_texture();
+}
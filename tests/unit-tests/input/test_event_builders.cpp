@@ -283,3 +283,26 @@ TEST_F(InputEventBuilder, when_deserialized_input_device_state_event_has_supplie
         EXPECT_THAT(mir_input_device_state_event_device_pressed_keys_for_index(ids_event, 2, i), Eq(pressed_keys[i]));
     }
 }
+
+TEST_F(InputEventBuilder, serializing_into_a_string_matches_serializing_to_a_new_one)
+{
+    auto ev = mev::make_event(device_id, timestamp, cookie, mir_keyboard_action_down, 34, 17, modifiers);
+
+    std::string reused{"leftovers from a previous, longer, event"};
+    MirEvent::serialize(ev.get(), reused);
+
+    EXPECT_THAT(reused, Eq(MirEvent::serialize(ev.get())));
+}
+
+TEST_F(InputEventBuilder, event_too_large_for_its_first_segment_copies_and_round_trips)
+{
+    std::vector<uint8_t> const large_cookie(4096, 0x5a);
+    auto ev = mev::make_event(device_id, timestamp, large_cookie, mir_keyboard_action_down, 34, 17, modifiers);
+
+    auto copy = mev::clone_event(*ev);
+    auto deserialized_event = MirEvent::deserialize(MirEvent::serialize(copy.get()));
+
+    EXPECT_THAT(copy->to_input()->cookie(), ContainerEq(large_cookie));
+    EXPECT_THAT(deserialized_event->to_input()->cookie(), ContainerEq(large_cookie));
+    EXPECT_THAT(deserialized_event->to_input()->to_keyboard()->scan_code(), Eq(17));
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/motion_batcher.h"
+
+#include "mir/events/event_builders.h"
+#include "mir/graphics/frame.h"
+
+#include "mir/test/fake_shared.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/doubles/mock_input_surface.h"
+#include "mir/test/doubles/stub_display_configuration.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mi = mir::input;
+namespace mg = mir::graphics;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+namespace mt = mir::test;
+namespace mtd = mt::doubles;
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct RecordingSurface : mtd::MockInputSurface
+{
+    RecordingSurface()
+    {
+        ON_CALL(*this, consume(_)).WillByDefault(Invoke(
+            [this](MirEvent const* ev) { received.push_back(mev::clone_event(*ev)); }));
+    }
+
+    MirPointerEvent const* pointer(size_t index) const
+    {
+        return mir_input_event_get_pointer_event(mir_event_get_input_event(received.at(index).get()));
+    }
+
+    MirTouchEvent const* touch(size_t index) const
+    {
+        return mir_input_event_get_touch_event(mir_event_get_input_event(received.at(index).get()));
+    }
+
+    std::vector<mir::EventUPtr> received;
+};
+
+mir::EventUPtr pointer_motion(float x, float dx, MirPointerButtons buttons = 0)
+{
+    return mev::make_event(MirInputDeviceId{1}, 0ns, std::vector<uint8_t>{},
+        0, mir_pointer_action_motion, buttons, x, 0, 0, 0, dx, 0);
+}
+
+mir::EventUPtr pointer_press(float x)
+{
+    return mev::make_event(MirInputDeviceId{1}, 0ns, std::vector<uint8_t>{},
+        0, mir_pointer_action_button_down, mir_pointer_button_primary, x, 0, 0, 0, 0, 0);
+}
+
+mir::EventUPtr touch(MirTouchAction action, std::chrono::nanoseconds time, float x)
+{
+    auto ev = mev::make_event(MirInputDeviceId{2}, time, std::vector<uint8_t>{}, 0);
+    mev::add_touch(*ev, 0, action, mir_touch_tooltype_finger, x, 0, 1, 1, 1, 1);
+    return ev;
+}
+
+mg::Frame frame_at(int64_t msc, std::chrono::nanoseconds ust)
+{
+    mg::Frame frame;
+    frame.msc = msc;
+    frame.ust = {CLOCK_MONOTONIC, ust};
+    return frame;
+}
+
+struct MotionBatcher : Test
+{
+    mtd::FakeAlarmFactory alarm_factory;
+    std::shared_ptr<RecordingSurface> const surface{std::make_shared<NiceMock<RecordingSurface>>()};
+
+    // Side by side outputs, with ids 1 and 2
+    geom::Rectangle const left_output{{0, 0}, {100, 100}};
+    geom::Rectangle const right_output{{100, 0}, {100, 100}};
+    std::shared_ptr<mtd::StubDisplayConfig> const two_outputs{
+        std::make_shared<mtd::StubDisplayConfig>(std::vector<geom::Rectangle>{left_output, right_output})};
+};
+}
+
+TEST_F(MotionBatcher, holds_pointer_motion_until_a_frame_is_shown)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    batcher.deliver(surface, pointer_motion(3, 2));
+    batcher.deliver(surface, pointer_motion(6, 3));
+
+    EXPECT_THAT(surface->received, IsEmpty());
+
+    batcher.frame_shown(0, frame_at(1, 1ms));
+
+    ASSERT_THAT(surface->received, SizeIs(1));
+    EXPECT_THAT(mir_pointer_event_axis_value(surface->pointer(0), mir_pointer_axis_x), Eq(6));
+    EXPECT_THAT(mir_pointer_event_axis_value(surface->pointer(0), mir_pointer_axis_relative_x), Eq(6));
+}
+
+TEST_F(MotionBatcher, motion_with_different_buttons_is_not_merged)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    batcher.deliver(surface, pointer_motion(2, 1, mir_pointer_button_secondary));
+    batcher.frame_shown(0, frame_at(1, 1ms));
+
+    EXPECT_THAT(surface->received, SizeIs(2));
+}
+
+TEST_F(MotionBatcher, button_press_is_delivered_at_once_after_held_motion)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    batcher.deliver(surface, pointer_press(1));
+
+    ASSERT_THAT(surface->received, SizeIs(2));
+    EXPECT_THAT(mir_pointer_event_action(surface->pointer(0)), Eq(mir_pointer_action_motion));
+    EXPECT_THAT(mir_pointer_event_action(surface->pointer(1)), Eq(mir_pointer_action_button_down));
+}
+
+TEST_F(MotionBatcher, history_mode_delivers_every_held_event_at_the_frame)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::history, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    batcher.deliver(surface, pointer_motion(2, 1));
+    batcher.deliver(surface, pointer_motion(3, 1));
+
+    EXPECT_THAT(surface->received, IsEmpty());
+
+    batcher.frame_shown(0, frame_at(1, 1ms));
+
+    ASSERT_THAT(surface->received, SizeIs(3));
+    EXPECT_THAT(mir_pointer_event_axis_value(surface->pointer(2), mir_pointer_axis_x), Eq(3));
+}
+
+TEST_F(MotionBatcher, touch_motion_is_resampled_to_the_predicted_present_time)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.frame_shown(0, frame_at(1, 0ms));
+    batcher.deliver(surface, touch(mir_touch_action_change, 14ms, 10));
+    batcher.deliver(surface, touch(mir_touch_action_change, 16ms, 20));
+
+    // A 10ms frame interval predicts the next frame at 20ms
+    batcher.frame_shown(0, frame_at(2, 10ms));
+
+    ASSERT_THAT(surface->received, SizeIs(1));
+    EXPECT_THAT(mir_touch_event_axis_value(surface->touch(0), 0, mir_touch_axis_x), FloatEq(40));
+}
+
+TEST_F(MotionBatcher, touch_extrapolation_is_limited)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, touch(mir_touch_action_change, 10ms, 10));
+    batcher.deliver(surface, touch(mir_touch_action_change, 12ms, 20));
+    batcher.frame_shown(0, frame_at(1, 100ms));
+
+    ASSERT_THAT(surface->received, SizeIs(1));
+    EXPECT_THAT(mir_touch_event_axis_value(surface->touch(0), 0, mir_touch_axis_x), FloatEq(60));
+}
+
+TEST_F(MotionBatcher, touch_down_and_up_are_not_held)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, touch(mir_touch_action_down, 1ms, 10));
+    batcher.deliver(surface, touch(mir_touch_action_change, 2ms, 11));
+    batcher.deliver(surface, touch(mir_touch_action_up, 3ms, 12));
+
+    ASSERT_THAT(surface->received, SizeIs(3));
+    EXPECT_THAT(mir_touch_event_axis_value(surface->touch(1), 0, mir_touch_axis_x), FloatEq(11));
+}
+
+TEST_F(MotionBatcher, held_motion_is_delivered_without_a_frame_after_a_frame_interval)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    alarm_factory.advance_by(10ms);
+
+    EXPECT_THAT(surface->received, IsEmpty());
+
+    alarm_factory.advance_by(10ms);
+
+    EXPECT_THAT(surface->received, SizeIs(1));
+}
+
+TEST_F(MotionBatcher, motion_held_for_a_removed_surface_is_dropped)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    batcher.surface_removed(surface.get());
+    batcher.frame_shown(0, frame_at(1, 1ms));
+
+    EXPECT_THAT(surface->received, IsEmpty());
+}
+
+TEST_F(MotionBatcher, motion_is_held_until_a_frame_is_shown_on_an_output_the_surface_is_on)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+    batcher.initial_configuration(two_outputs);
+    ON_CALL(*surface, input_bounds()).WillByDefault(Return(geom::Rectangle{{120, 10}, {50, 50}}));
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    batcher.frame_shown(1, frame_at(1, 1ms));
+
+    EXPECT_THAT(surface->received, IsEmpty());
+
+    batcher.frame_shown(2, frame_at(1, 1ms));
+
+    EXPECT_THAT(surface->received, SizeIs(1));
+}
+
+TEST_F(MotionBatcher, frame_interval_is_measured_per_output)
+{
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+    batcher.initial_configuration(two_outputs);
+    ON_CALL(*surface, input_bounds()).WillByDefault(Return(geom::Rectangle{{10, 10}, {50, 50}}));
+
+    batcher.frame_shown(1, frame_at(1, 0ms));
+    batcher.frame_shown(2, frame_at(1, 0ms));
+    batcher.frame_shown(2, frame_at(2, 20ms));
+    batcher.deliver(surface, touch(mir_touch_action_change, 14ms, 10));
+    batcher.deliver(surface, touch(mir_touch_action_change, 16ms, 20));
+
+    // The left output's 10ms frame interval predicts its next frame at 20ms
+    batcher.frame_shown(1, frame_at(2, 10ms));
+
+    ASSERT_THAT(surface->received, SizeIs(1));
+    EXPECT_THAT(mir_touch_event_axis_value(surface->touch(0), 0, mir_touch_axis_x), FloatEq(40));
+}
+
+TEST_F(MotionBatcher, held_motion_is_delivered_without_a_frame_after_the_surface_outputs_frame_interval)
+{
+    two_outputs->outputs[1].modes[0].vrefresh_hz = 30;
+    mi::MotionBatcher batcher{mi::MotionBatcher::Mode::coalesce, mt::fake_shared(alarm_factory)};
+    batcher.initial_configuration(two_outputs);
+    ON_CALL(*surface, input_bounds()).WillByDefault(Return(geom::Rectangle{{120, 10}, {50, 50}}));
+
+    batcher.deliver(surface, pointer_motion(1, 1));
+    alarm_factory.advance_by(20ms);
+
+    EXPECT_THAT(surface->received, IsEmpty());
+
+    alarm_factory.advance_by(15ms);
+
+    EXPECT_THAT(surface->received, SizeIs(1));
+}
@@ -41,6 +41,7 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     MOCK_CONST_METHOD0(id, uint32_t());
     MOCK_METHOD0(reset, void());
     MOCK_METHOD2(configure, void(geometry::Displacement, size_t));
+    MOCK_METHOD1(report_frames_as, void(uint32_t));
     MOCK_CONST_METHOD0(size, geometry::Size());
     MOCK_CONST_METHOD0(max_refresh_rate, int());
 
@@ -59,6 +60,12 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::mesa::FBHandle const*));
     MOCK_METHOD0(wait_for_page_flip, void());
 
+    MOCK_METHOD0(overlay_plane_count, size_t());
+    MOCK_METHOD1(set_overlays, bool(std::vector<graphics::mesa::OverlayPlacement> const&));
+
+    MOCK_METHOD1(allow_variable_refresh, void(bool));
+    MOCK_METHOD1(set_variable_refresh, bool(bool));
+
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
     MOCK_METHOD1(set_cursor, bool(gbm_bo*));
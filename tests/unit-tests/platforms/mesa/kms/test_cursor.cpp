@@ -121,7 +121,9 @@ struct StubKMSDisplayConfiguration : public mgm::KMSDisplayConfiguration
                 {},
                 mir_output_gamma_unsupported,
                 {},
-                {}
+                {},
+                false,
+                false
             },
             {
                 mg::DisplayConfigurationOutputId{1},
@@ -147,7 +149,9 @@ struct StubKMSDisplayConfiguration : public mgm::KMSDisplayConfiguration
                 {},
                 mir_output_gamma_unsupported,
                 {},
-                {}
+                {},
+                false,
+                false
             },
             {
                 mg::DisplayConfigurationOutputId{2},
@@ -173,7 +177,9 @@ struct StubKMSDisplayConfiguration : public mgm::KMSDisplayConfiguration
                 {},
                 mir_output_gamma_unsupported,
                 {},
-                {}
+                {},
+                false,
+                false
             }}}
     {
         update();
@@ -806,3 +812,74 @@ TEST_F(MesaCursorTest, show_cursor_sets_cursor_with_hotspot)
     cursor.move_to(cursor_location_2);
 }
 
+
+namespace
+{
+struct SolidCursorImage : public StubCursorImage
+{
+    SolidCursorImage(uint32_t colour)
+        : pixels(64*64, colour)
+    {
+    }
+
+    void const* as_argb_8888() const override
+    {
+        return pixels.data();
+    }
+
+    std::vector<uint32_t> const pixels;
+};
+}
+
+TEST_F(MesaCursorTest, showing_an_image_again_does_not_rewrite_it)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(2);
+
+    cursor.show(stub_image);
+    cursor.show(SinglePixelCursorImage());
+    cursor.show(stub_image);
+}
+
+TEST_F(MesaCursorTest, animated_cursor_frames_are_only_written_the_first_time_round)
+{
+    using namespace testing;
+
+    std::vector<SolidCursorImage> const frames{{0xff000000}, {0xff0000ff}, {0xff00ff00}, {0xffff0000}};
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(frames.size());
+
+    for (auto loop = 0; loop != 3; ++loop)
+    {
+        for (auto const& frame : frames)
+            cursor.show(frame);
+    }
+}
+
+TEST_F(MesaCursorTest, image_rotated_for_an_output_is_reused_on_returning_to_it)
+{
+    using namespace testing;
+
+    cursor.show(stub_image);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(1);
+
+    cursor.move_to({766, 112});
+    cursor.move_to({10, 10});
+    cursor.move_to({766, 112});
+}
+
+TEST_F(MesaCursorTest, move_to_the_same_place_does_not_move_hardware_cursor_again)
+{
+    using namespace testing;
+
+    cursor.show(stub_image);
+
+    EXPECT_CALL(*output_container.outputs[0], move_cursor(geom::Point{10,10})).Times(1);
+
+    cursor.move_to({10, 10});
+    cursor.move_to({10, 10});
+
+    output_container.verify_and_clear_expectations();
+}
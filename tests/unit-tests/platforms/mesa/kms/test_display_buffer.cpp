@@ -231,6 +231,54 @@ TEST_F(MesaDisplayBufferTest, frames_requiring_gl_are_not_throttled)
     }
 }
 
+TEST_F(MesaDisplayBufferTest, variable_refresh_is_only_on_for_bypassed_frames)
+{
+    graphics::RenderableList non_bypassable_list{
+        std::make_shared<FakeRenderable>(geometry::Rectangle{{12, 34}, {1, 1}})
+    };
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    InSequence seq;
+    EXPECT_CALL(*mock_kms_output, set_variable_refresh(true));
+    EXPECT_CALL(*mock_kms_output, set_variable_refresh(false));
+
+    ASSERT_TRUE(db.overlay(bypassable_list));
+    db.post();
+
+    ASSERT_FALSE(db.overlay(non_bypassable_list));
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, bypass_with_variable_refresh_is_not_throttled)
+{
+    ON_CALL(*mock_kms_output, set_variable_refresh(true)).WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        ASSERT_TRUE(db.overlay(bypassable_list));
+        db.post();
+
+        ASSERT_EQ(0, db.recommended_sleep().count());
+    }
+}
+
 TEST_F(MesaDisplayBufferTest, bypass_buffer_only_referenced_once_by_db)
 {
     graphics::mesa::DisplayBuffer db(
@@ -503,3 +551,220 @@ TEST_F(MesaDisplayBufferTest, buffer_requiring_migration_is_ineligable_for_bypas
 
     EXPECT_FALSE(db.overlay(bypassable_list));
 }
+
+namespace
+{
+std::shared_ptr<FakeRenderable> scanout_renderable(
+    geometry::Rectangle const& position,
+    std::shared_ptr<MockBuffer>& buffer)
+{
+    buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*buffer, size()).WillByDefault(Return(position.size));
+    ON_CALL(*buffer, native_buffer_handle())
+        .WillByDefault(Return(std::make_shared<StubGBMNativeBuffer>(position.size)));
+
+    auto const renderable = std::make_shared<FakeRenderable>(position);
+    renderable->set_buffer(buffer);
+    return renderable;
+}
+}
+
+TEST_F(MesaDisplayBufferTest, scanout_buffer_above_composition_goes_on_overlay_plane)
+{
+    geometry::Rectangle const video_area{{22, 44}, {20, 10}};
+    std::shared_ptr<MockBuffer> video_buffer;
+    auto const video = scanout_renderable(video_area, video_buffer);
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(2));
+    EXPECT_CALL(*mock_kms_output, set_overlays(ElementsAre(
+        AllOf(
+            Field(&OverlayPlacement::source_size, Eq(video_area.size)),
+            Field(&OverlayPlacement::destination, Eq(geometry::Rectangle{{10, 10}, {20, 10}}))))))
+        .WillOnce(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    graphics::RenderableList const list{fake_software_renderable, video};
+    ASSERT_FALSE(db.overlay(list));
+    EXPECT_THAT(db.assign_overlay_planes(list), ElementsAre(fake_software_renderable));
+}
+
+TEST_F(MesaDisplayBufferTest, scanout_buffer_under_composited_content_is_composited)
+{
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(2));
+    EXPECT_CALL(*mock_kms_output, set_overlays(_)).Times(0);
+
+    auto const popup = std::make_shared<FakeRenderable>(geometry::Rectangle{{20, 40}, {5, 5}});
+    popup->set_buffer(mock_software_buffer);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    graphics::RenderableList const list{fake_bypassable_renderable, popup};
+    ASSERT_FALSE(db.overlay(list));
+    EXPECT_THAT(db.assign_overlay_planes(list), ContainerEq(list));
+}
+
+TEST_F(MesaDisplayBufferTest, overlays_the_hardware_rejects_are_composited)
+{
+    std::shared_ptr<MockBuffer> video_buffer;
+    auto const video = scanout_renderable({{22, 44}, {20, 10}}, video_buffer);
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(2));
+    EXPECT_CALL(*mock_kms_output, set_overlays(_)).WillRepeatedly(Return(false));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    graphics::RenderableList const list{fake_software_renderable, video};
+    ASSERT_FALSE(db.overlay(list));
+    EXPECT_THAT(db.assign_overlay_planes(list), ContainerEq(list));
+}
+
+TEST_F(MesaDisplayBufferTest, overlay_buffer_is_held_until_replaced_on_screen)
+{
+    std::shared_ptr<MockBuffer> video_buffer;
+    auto const video = scanout_renderable({{22, 44}, {20, 10}}, video_buffer);
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, set_overlays(_)).WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    auto const original_count = video_buffer.use_count();
+
+    graphics::RenderableList const list{fake_software_renderable, video};
+    ASSERT_FALSE(db.overlay(list));
+    ASSERT_THAT(db.assign_overlay_planes(list), ElementsAre(fake_software_renderable));
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+
+    EXPECT_THAT(video_buffer.use_count(), Gt(original_count));
+
+    // The next frame takes it off the overlay plane
+    EXPECT_CALL(*mock_kms_output, set_overlays(IsEmpty())).WillOnce(Return(true));
+    ASSERT_FALSE(db.overlay({fake_software_renderable}));
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+
+    EXPECT_THAT(video_buffer.use_count(), Eq(original_count));
+}
+
+TEST_F(MesaDisplayBufferTest, overlay_buffer_is_held_when_a_failed_flip_falls_back_to_set_crtc)
+{
+    std::shared_ptr<MockBuffer> video_buffer;
+    auto const video = scanout_renderable({{22, 44}, {20, 10}}, video_buffer);
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, set_overlays(_)).WillByDefault(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_)).WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, set_crtc_thunk(_)).WillOnce(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    auto const original_count = video_buffer.use_count();
+
+    graphics::RenderableList const list{fake_software_renderable, video};
+    ASSERT_FALSE(db.overlay(list));
+    ASSERT_THAT(db.assign_overlay_planes(list), ElementsAre(fake_software_renderable));
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+
+    // set_crtc() put it on the overlay plane in place of the flip
+    EXPECT_THAT(video_buffer.use_count(), Gt(original_count));
+}
+
+TEST_F(MesaDisplayBufferTest, overlays_are_composited_after_a_failed_flip)
+{
+    std::shared_ptr<MockBuffer> video_buffer;
+    auto const video = scanout_renderable({{22, 44}, {20, 10}}, video_buffer);
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, set_overlays(_)).WillByDefault(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .WillOnce(Return(false))
+        .WillRepeatedly(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    graphics::RenderableList const list{fake_software_renderable, video};
+    ASSERT_FALSE(db.overlay(list));
+    ASSERT_THAT(db.assign_overlay_planes(list), ElementsAre(fake_software_renderable));
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+
+    EXPECT_CALL(*mock_kms_output, set_overlays(IsEmpty())).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mock_kms_output, set_overlays(Not(IsEmpty()))).Times(0);
+    ASSERT_FALSE(db.overlay(list));
+    EXPECT_THAT(db.assign_overlay_planes(list), ContainerEq(list));
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+
+    // Once flips work again so do overlays
+    Mock::VerifyAndClearExpectations(mock_kms_output.get());
+    EXPECT_CALL(*mock_kms_output, set_overlays(Not(IsEmpty()))).WillOnce(Return(true));
+    ASSERT_FALSE(db.overlay(list));
+    EXPECT_THAT(db.assign_overlay_planes(list), ElementsAre(fake_software_renderable));
+}
+
+TEST_F(MesaDisplayBufferTest, overlays_are_composited_while_a_set_crtc_is_pending)
+{
+    std::shared_ptr<MockBuffer> video_buffer;
+    auto const video = scanout_renderable({{22, 44}, {20, 10}}, video_buffer);
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    EXPECT_CALL(*mock_kms_output, set_overlays(_)).Times(0);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        {});
+
+    db.schedule_set_crtc();
+
+    graphics::RenderableList const list{fake_software_renderable, video};
+    ASSERT_FALSE(db.overlay(list));
+    EXPECT_THAT(db.assign_overlay_planes(list), ContainerEq(list));
+}
@@ -301,7 +301,9 @@ TEST_F(MesaDisplayConfigurationTest, configuration_is_read_correctly)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
         {
             mg::DisplayConfigurationOutputId{0},
@@ -324,7 +326,9 @@ TEST_F(MesaDisplayConfigurationTest, configuration_is_read_correctly)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
         {
             mg::DisplayConfigurationOutputId{0},
@@ -347,7 +351,9 @@ TEST_F(MesaDisplayConfigurationTest, configuration_is_read_correctly)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         }
     };
 
@@ -581,7 +587,9 @@ TEST_F(MesaDisplayConfigurationTest, returns_updated_configuration)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
         {
             mg::DisplayConfigurationOutputId{0},
@@ -604,7 +612,9 @@ TEST_F(MesaDisplayConfigurationTest, returns_updated_configuration)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
     };
 
@@ -631,7 +641,9 @@ TEST_F(MesaDisplayConfigurationTest, returns_updated_configuration)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
         {
             mg::DisplayConfigurationOutputId{0},
@@ -654,7 +666,9 @@ TEST_F(MesaDisplayConfigurationTest, returns_updated_configuration)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
     };
 
@@ -802,7 +816,9 @@ TEST_F(MesaDisplayConfigurationTest, new_monitor_matches_hardware_state)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
     };
 
@@ -831,7 +847,9 @@ TEST_F(MesaDisplayConfigurationTest, new_monitor_matches_hardware_state)
             {},
             mir_output_gamma_unsupported,
             {},
-            {}
+            {},
+            false,
+            true
         },
     };
 
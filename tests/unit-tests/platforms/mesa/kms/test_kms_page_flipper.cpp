@@ -149,6 +149,25 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_reports_vsync)
     page_flipper.wait_for_flip(crtc_id);
 }
 
+TEST_F(KMSPageFlipperTest, frames_from_page_flip_events_have_hardware_timestamps)
+{
+    using namespace testing;
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+    ON_CALL(mock_drm, drmModePageFlip(_, _, _, _, _))
+        .WillByDefault(DoAll(SaveArg<4>(&user_data), Return(0)));
+    ON_CALL(mock_drm, drmHandleEvent(_, _))
+        .WillByDefault(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
+
+    EXPECT_CALL(report, report_vsync(connector_id, Field(&mg::Frame::hardware_timestamp, true)));
+
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    mock_drm.generate_event_on(drm_device);
+    EXPECT_TRUE(page_flipper.wait_for_flip(crtc_id).hardware_timestamp);
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_non_scheduled_page_flip_doesnt_block)
 {
     using namespace testing;
@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/mesa/server/kms/render_time_predictor.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mgm = mir::graphics::mesa;
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+auto const fallback = std::chrono::microseconds{50ms};
+}
+
+TEST(RenderTimePredictor, predicts_fallback_without_enough_samples)
+{
+    mgm::RenderTimePredictor predictor{fallback};
+
+    EXPECT_THAT(predictor.prediction(), Eq(fallback));
+
+    for (int i = 0; i != 7; ++i)
+        predictor.add_sample(3ms);
+
+    EXPECT_THAT(predictor.prediction(), Eq(fallback));
+}
+
+TEST(RenderTimePredictor, steady_render_times_give_a_tight_prediction)
+{
+    mgm::RenderTimePredictor predictor{fallback};
+
+    for (int i = 0; i != 64; ++i)
+        predictor.add_sample(4ms);
+
+    EXPECT_THAT(predictor.prediction(), Ge(std::chrono::microseconds{4ms}));
+    EXPECT_THAT(predictor.prediction(), Le(std::chrono::microseconds{6ms}));
+}
+
+TEST(RenderTimePredictor, plans_for_occasional_slow_frames)
+{
+    mgm::RenderTimePredictor predictor{fallback};
+
+    for (int i = 0; i != 64; ++i)
+        predictor.add_sample(i % 10 == 0 ? 12ms : 2ms);
+
+    EXPECT_THAT(predictor.prediction(), Ge(std::chrono::microseconds{12ms}));
+}
+
+TEST(RenderTimePredictor, ignores_a_single_outlier)
+{
+    mgm::RenderTimePredictor predictor{fallback};
+
+    predictor.add_sample(40ms);
+    for (int i = 0; i != 63; ++i)
+        predictor.add_sample(2ms);
+
+    EXPECT_THAT(predictor.prediction(), Lt(std::chrono::microseconds{10ms}));
+}
+
+TEST(RenderTimePredictor, forgets_old_samples)
+{
+    mgm::RenderTimePredictor predictor{fallback};
+
+    for (int i = 0; i != 64; ++i)
+        predictor.add_sample(20ms);
+    for (int i = 0; i != 64; ++i)
+        predictor.add_sample(2ms);
+
+    EXPECT_THAT(predictor.prediction(), Lt(std::chrono::microseconds{5ms}));
+}
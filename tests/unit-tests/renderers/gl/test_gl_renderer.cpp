@@ -24,10 +24,12 @@
 #include <mir/test/fake_shared.h>
 #include <mir/test/doubles/mock_gl_buffer.h>
 #include <mir/test/doubles/mock_renderable.h>
+#include <mir/test/doubles/stub_renderable.h>
 #include <mir/test/doubles/mock_buffer_stream.h>
 #include <mir/compositor/buffer_stream.h>
 #include <mir/test/doubles/mock_gl.h>
 #include <mir/test/doubles/mock_egl.h>
+#include <EGL/eglext.h>
 #include <src/renderers/gl/renderer.h>
 #include <mir/test/doubles/stub_gl_display_buffer.h>
 #include <mir/test/doubles/mock_gl_display_buffer.h>
@@ -39,6 +41,9 @@ using testing::ReturnRef;
 using testing::Pointee;
 using testing::AnyNumber;
 using testing::AtLeast;
+using testing::AllOf;
+using testing::Ge;
+using testing::Le;
 using testing::DoAll;
 using testing::_;
 
@@ -249,6 +254,30 @@ TEST_F(GLRenderer, binds_for_every_primitive_when_tessellate_is_overridden)
     renderer.render(renderable_list);
 }
 
+TEST_F(GLRenderer, uploads_vertices_once_per_frame_and_draws_from_them)
+{
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{10,10}, {20,20}}));
+
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(8 * sizeof(mgl::Vertex)), _, GL_STREAM_DRAW));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLE_STRIP, 4, 4));
+
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, does_not_repeat_unchanged_blend_state)
+{
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{10,10}, {20,20}}));
+
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND)).Times(1);
+
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, clears_all_channels_zero)
 {
     InSequence seq;
@@ -466,3 +495,289 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
 
     mrg::Renderer renderer(mock_display_buffer);
 }
+
+TEST_F(GLRenderer, repaints_everything_without_buffer_age)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST)).Times(0);
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+}
+
+class GLRendererWithBufferAge : public GLRenderer
+{
+public:
+    GLRendererWithBufferAge()
+    {
+        ON_CALL(mock_egl, eglQueryString(_,EGL_EXTENSIONS))
+            .WillByDefault(Return("EGL_KHR_image EGL_EXT_buffer_age"));
+        ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+            .WillByDefault(DoAll(SetArgPointee<3>(screen_width),
+                                 Return(EGL_TRUE)));
+        ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+            .WillByDefault(DoAll(SetArgPointee<3>(screen_height),
+                                 Return(EGL_TRUE)));
+        ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_BUFFER_AGE_EXT,_))
+            .WillByDefault(DoAll(SetArgPointee<3>(1),
+                                 Return(EGL_TRUE)));
+        ON_CALL(mock_display_buffer, view_area())
+            .WillByDefault(Return(view_area));
+    }
+
+    int const screen_width = 1920;
+    int const screen_height = 1080;
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+};
+
+TEST_F(GLRendererWithBufferAge, repaints_everything_on_first_frame)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, repaints_nothing_if_nothing_changed)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(0, 0, 0, 0));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, repaints_only_renderable_with_new_buffer)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(*mock_buffer, id())
+        .WillRepeatedly(Return(mir::graphics::BufferID(790)));
+
+    // The renderable is at {1,2},{3,4}, and GL window coordinates are bottom-up
+    EXPECT_CALL(mock_gl, glScissor(AllOf(Ge(0), Le(1)), AllOf(Ge(1073), Le(1074)),
+                                   AllOf(Ge(3), Le(5)), AllOf(Ge(4), Le(6))));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, repaints_everything_after_being_suspended)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    renderer.suspend();
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, repaints_everything_for_buffers_older_than_tracked)
+{
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_BUFFER_AGE_EXT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(3),
+                             Return(EGL_TRUE)));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, draws_only_what_opaque_renderables_above_leave_visible)
+{
+    // Hides the left part of the renderable at {1,2},{3,4}
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{0,0}, {2,1080}}));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    // What's left is {2,2},{2,4}, and GL window coordinates are bottom-up
+    EXPECT_CALL(mock_gl, glScissor(AllOf(Ge(1), Le(2)), AllOf(Ge(1073), Le(1074)),
+                                   AllOf(Ge(2), Le(3)), AllOf(Ge(4), Le(5))));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, draws_a_partly_hidden_renderable_once_however_fragmented_the_screen)
+{
+    // The first hides the left part of the renderable at {1,2},{3,4}; the
+    // second only splits up the rest of the screen
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{0,0}, {2,1080}}));
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{1000,0}, {2,1080}}));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(1);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, sets_up_a_partly_hidden_renderable_once_for_all_its_visible_parts)
+{
+    // Hides the middle of the renderable at {1,2},{3,4}, leaving two parts
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{2,0}, {1,1080}}));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glUniform2f(_, 2.5f, 4.0f)).Times(1);
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(2);
+    EXPECT_CALL(mock_gl, glDrawArrays(_,_,_)).Times(3);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, carries_on_if_a_hidden_renderable_cannot_be_loaded)
+{
+    // lp:1629275 for a renderable that isn't drawn, but is still loaded
+    EXPECT_CALL(*renderable, buffer())
+        .WillRepeatedly(testing::Throw(std::runtime_error("bad client buffer")));
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{0,0}, {10,1080}}));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_NO_THROW(renderer.render(renderable_list));
+}
+
+TEST_F(GLRendererWithBufferAge, draws_a_partly_hidden_transformed_renderable_unclipped)
+{
+    // Rotated, it may appear anywhere, not just at {1,2},{3,4}
+    renderable_list.clear();
+    renderable_list.push_back(std::make_shared<mtd::StubTransformedRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{1,2}, {3,4}}));
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{0,0}, {2,1080}}));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glDrawArrays(_,_,_)).Times(2);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, draws_a_transformed_renderable_whose_screen_position_is_hidden)
+{
+    renderable_list.clear();
+    renderable_list.push_back(std::make_shared<mtd::StubTransformedRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{1,2}, {3,4}}));
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{0,0}, {10,1080}}));
+
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glDrawArrays(_,_,_)).Times(2);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, draws_a_partly_hidden_renderable_unclipped_if_tessellated_beyond_it)
+{
+    // Like a shell drawing a shadow around the renderable
+    struct ShadowingRenderer : mrg::Renderer
+    {
+        using Renderer::Renderer;
+
+        void tessellate(std::vector<mgl::Primitive>& primitives,
+                        mg::Renderable const& renderable) const override
+        {
+            Renderer::tessellate(primitives, renderable);
+
+            auto shadow = primitives[0];
+            for (auto& vertex : shadow.vertices)
+            {
+                vertex.position[0] += 10.0f;
+                vertex.position[1] += 10.0f;
+            }
+            primitives.push_back(shadow);
+        }
+    };
+
+    // Hides the left part of the renderable at {1,2},{3,4}
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{0,0}, {2,1080}}));
+
+    ShadowingRenderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, does_not_hide_renderables_beneath_what_a_tessellation_leaves_uncovered)
+{
+    // Like a wobbly window, drawn narrower than its screen_position()
+    struct NarrowingRenderer : mrg::Renderer
+    {
+        using Renderer::Renderer;
+
+        void tessellate(std::vector<mgl::Primitive>& primitives,
+                        mg::Renderable const& renderable) const override
+        {
+            Renderer::tessellate(primitives, renderable);
+
+            auto& vertices = primitives[0].vertices;
+            auto const middle = (vertices[0].position[0] + vertices[2].position[0]) / 2.0f;
+            vertices[2].position[0] = middle;
+            vertices[3].position[0] = middle;
+        }
+    };
+
+    // Would hide the left part of the renderable at {1,2},{3,4}
+    renderable_list.push_back(std::make_shared<mtd::StubRenderable>(
+        mock_buffer, mir::geometry::Rectangle{{0,0}, {2,1080}}));
+
+    NarrowingRenderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithBufferAge, repaints_all_a_renderable_drew_beyond_its_screen_position_when_it_moves)
+{
+    // Like a shell drawing a shadow below and right of the renderable
+    struct ShadowingRenderer : mrg::Renderer
+    {
+        using Renderer::Renderer;
+
+        void tessellate(std::vector<mgl::Primitive>& primitives,
+                        mg::Renderable const& renderable) const override
+        {
+            Renderer::tessellate(primitives, renderable);
+
+            auto shadow = primitives[0];
+            for (auto& vertex : shadow.vertices)
+            {
+                vertex.position[0] += 10.0f;
+                vertex.position[1] += 10.0f;
+            }
+            primitives.push_back(shadow);
+        }
+    };
+
+    ShadowingRenderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(Return(mir::geometry::Rectangle{{100,100},{3,4}}));
+
+    // From {1,2},{3,4} and its shadow to {100,100},{3,4} and its shadow is
+    // {1,2},{112,112}, and GL window coordinates are bottom-up
+    EXPECT_CALL(mock_gl, glScissor(AllOf(Ge(0), Le(1)), AllOf(Ge(965), Le(966)),
+                                   AllOf(Ge(112), Le(114)), AllOf(Ge(112), Le(114))));
+
+    renderer.render(renderable_list);
+}
@@ -225,3 +225,48 @@ TEST_F(GLPixelBufferTest, returns_data_from_rgba_buffer_texture)
     EXPECT_EQ(width - 1,
               static_cast<uint32_t const*>(data)[width * height - 1]);
 }
+
+TEST_F(GLPixelBufferTest, scaled_fill_renders_to_fit_and_reads_back_only_the_scaled_pixels)
+{
+    using namespace testing;
+
+    geom::Size const max_size{20, 20};
+    /* 51x71 scaled to fit 20x20 */
+    geom::Size const scaled_size{14, 20};
+
+    EXPECT_CALL(mock_buffer, gl_bind_to_texture());
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, scaled_size.width.as_int(), scaled_size.height.as_int(),
+                                      GL_RGBA, GL_UNSIGNED_BYTE, _))
+        .WillOnce(FillPixels());
+    EXPECT_CALL(mock_gl, glReadPixels(_, _, _, _, GL_BGRA_EXT, _, _)).Times(0);
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer, max_size);
+    auto data = pixels.as_argb_8888();
+
+    EXPECT_EQ(scaled_size, pixels.size());
+    EXPECT_EQ(geom::Stride{scaled_size.width.as_uint32_t() * 4}, pixels.stride());
+
+    /* Flipping and swizzling were done on the GPU, so nothing is left to convert */
+    EXPECT_EQ(0u, static_cast<uint32_t const*>(data)[0]);
+    EXPECT_EQ(15u, static_cast<uint32_t const*>(data)[15]);
+}
+
+TEST_F(GLPixelBufferTest, scaled_fill_of_a_buffer_that_already_fits_reads_it_whole)
+{
+    using namespace testing;
+
+    uint32_t const width{mock_buffer.size().width.as_uint32_t()};
+    uint32_t const height{mock_buffer.size().height.as_uint32_t()};
+
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, _));
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer, geom::Size{100, 100});
+
+    EXPECT_EQ(mock_buffer.size(), pixels.size());
+}
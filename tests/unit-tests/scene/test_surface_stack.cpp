@@ -30,6 +30,7 @@
 #include "mir/test/doubles/stub_buffer_stream_factory.h"
 #include "mir/test/doubles/stub_renderable.h"
 #include "mir/test/doubles/mock_buffer_stream.h"
+#include "mir/thread_safe_list.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -734,6 +735,68 @@ TEST_F(SurfaceStack, exposes_rendered_surface)
     elements2.back()->rendered();
 }
 
+TEST_F(SurfaceStack, scene_elements_outlive_removal_of_their_surface)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+
+    auto const mock_surface = std::make_shared<NiceMock<MockConfigureSurface>>();
+    stack.add_surface(mock_surface, default_params.input_mode);
+
+    auto const elements = stack.scene_elements_for(compositor_id);
+    ASSERT_THAT(elements.size(), Eq(1u));
+
+    stack.remove_surface(mock_surface);
+
+    EXPECT_THAT(stack.scene_elements_for(compositor_id), IsEmpty());
+    EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed));
+
+    elements.back()->rendered();
+}
+
+TEST_F(SurfaceStack, scene_elements_do_not_keep_a_removed_surface_alive)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+
+    auto mock_surface = std::make_shared<NiceMock<MockConfigureSurface>>();
+    std::weak_ptr<ms::Surface> const weak_surface = mock_surface;
+    stack.add_surface(mock_surface, default_params.input_mode);
+
+    auto const elements = stack.scene_elements_for(compositor_id);
+    ASSERT_THAT(elements.size(), Eq(1u));
+
+    stack.remove_surface(mock_surface);
+    mock_surface.reset();
+
+    EXPECT_TRUE(weak_surface.expired());
+
+    elements.back()->rendered();
+}
+
+TEST_F(SurfaceStack, a_surface_removed_while_the_scene_is_read_is_not_kept_alive)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+
+    auto mock_surface = std::make_shared<NiceMock<MockConfigureSurface>>();
+    std::weak_ptr<ms::Surface> const weak_surface = mock_surface;
+    stack.add_surface(mock_surface, default_params.input_mode);
+
+    {
+        // As a compositor would be, so the replaced snapshot can't be freed yet
+        mir::detail::ThreadSafeListReaders::Reading reading;
+
+        stack.remove_surface(mock_surface);
+        mock_surface.reset();
+
+        EXPECT_TRUE(weak_surface.expired());
+    }
+}
+
 TEST_F(SurfaceStack, occludes_surface_when_unregistering_all_compositors_that_rendered_it)
 {
     using namespace testing;
@@ -986,6 +1049,84 @@ TEST_F(SurfaceStack, returns_top_visible_surface_under_cursor)
     EXPECT_THAT(stack.surface_at(cursor_over_none).get(), IsNull());
 }
 
+TEST_F(SurfaceStack, surface_under_cursor_follows_moves_and_raises)
+{
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface1->resize({100, 100});
+    stub_surface2->resize({100, 100});
+    stub_surface2->move_to({1000, 1000});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({1050, 1050}), Eq(stub_surface2));
+
+    stub_surface2->move_to({20, 20});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({1050, 1050}).get(), IsNull());
+
+    stack.raise(stub_surface1);
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+
+    stack.raise(ms::SurfaceStack::SurfaceSet{stub_surface2});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+}
+
+TEST_F(SurfaceStack, finds_large_surfaces_and_those_at_negative_coordinates)
+{
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface1->resize({10000, 10000});
+    stub_surface2->move_to({-300, -300});
+    stub_surface2->resize({200, 200});
+
+    EXPECT_THAT(stack.surface_at({-150, -150}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({5000, 5000}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({-50, -50}).get(), IsNull());
+}
+
+TEST_F(SurfaceStack, removed_surface_is_not_under_cursor)
+{
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stub_surface1->resize({100, 100});
+
+    stack.remove_surface(stub_surface1);
+    stub_surface1->move_to({10, 10});
+
+    EXPECT_THAT(stack.surface_at({50, 50}).get(), IsNull());
+}
+
+TEST_F(SurfaceStack, finds_surface_by_custom_input_region_outside_its_rectangle)
+{
+    stub_surface1->resize({100, 100});
+    stub_surface1->set_input_region({{{-600, 0}, {50, 50}}});
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface2->resize({100, 100});
+    stub_surface2->move_to({1000, 1000});
+    stub_surface2->set_input_region({{{500, 500}, {50, 50}}});
+
+    EXPECT_THAT(stack.surface_at({-575, 25}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({50, 50}).get(), IsNull());
+    EXPECT_THAT(stack.surface_at({1525, 1525}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({1050, 1050}).get(), IsNull());
+
+    stub_surface2->move_to({0, 0});
+
+    EXPECT_THAT(stack.surface_at({525, 525}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({1525, 1525}).get(), IsNull());
+
+    stub_surface2->set_input_region({});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({525, 525}).get(), IsNull());
+}
+
 TEST_F(SurfaceStack, raise_surfaces_to_top)
 {
     stack.add_surface(stub_surface1, default_params.input_mode);
@@ -23,6 +23,7 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/doubles/null_pixel_buffer.h"
 #include "mir/test/doubles/stub_buffer_stream.h"
+#include "mir/test/doubles/mock_buffer_stream.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/signal.h"
 #include "mir/test/current_thread_name.h"
@@ -49,6 +50,7 @@ public:
     ~MockPixelBuffer() noexcept {}
 
     MOCK_METHOD1(fill_from, void(mg::Buffer& buffer));
+    MOCK_METHOD2(fill_from, void(mg::Buffer& buffer, geom::Size const& max_size));
     MOCK_METHOD0(as_argb_8888, void const*());
     MOCK_CONST_METHOD0(size, geom::Size());
     MOCK_CONST_METHOD0(stride, geom::Stride());
@@ -59,6 +61,47 @@ struct ThreadedSnapshotStrategyTest : testing::Test
     mtd::StubBufferStream buffer_access;
 };
 
+struct ScaledPixelBuffer : testing::NiceMock<MockPixelBuffer>
+{
+    ScaledPixelBuffer()
+    {
+        using namespace testing;
+
+        ON_CALL(*this, as_argb_8888())
+            .WillByDefault(Return(pixels.data()));
+        ON_CALL(*this, size())
+            .WillByDefault(Return(geom::Size{2, 2}));
+        ON_CALL(*this, stride())
+            .WillByDefault(Return(geom::Stride{8}));
+    }
+
+    std::vector<uint32_t> pixels{0xff000001, 0xff000002, 0xff000003, 0xff000004};
+};
+
+ms::Snapshot take_snapshot_and_wait(
+    ms::ThreadedSnapshotStrategy& strategy,
+    std::shared_ptr<mir::compositor::BufferStream> const& stream,
+    geom::Size const& max_size,
+    std::vector<uint32_t>& pixels)
+{
+    mt::Signal snapshot_taken;
+    ms::Snapshot snapshot;
+
+    strategy.take_snapshot_of(
+        stream,
+        max_size,
+        [&](ms::Snapshot const& s)
+        {
+            snapshot = s;
+            auto const begin = static_cast<uint32_t const*>(s.pixels);
+            pixels.assign(begin, begin + s.size.width.as_int() * s.size.height.as_int());
+            snapshot_taken.raise();
+        });
+
+    snapshot_taken.wait_for(std::chrono::seconds{5});
+    return snapshot;
+}
+
 }
 
 TEST_F(ThreadedSnapshotStrategyTest, takes_snapshot)
@@ -121,3 +164,69 @@ TEST_F(ThreadedSnapshotStrategyTest, names_snapshot_thread)
 
     EXPECT_THAT(buffer_access.thread_name, Eq("Mir/Snapshot"));
 }
+
+TEST_F(ThreadedSnapshotStrategyTest, takes_scaled_snapshot_to_fit_the_size_asked_for)
+{
+    using namespace testing;
+
+    geom::Size const max_size{32, 32};
+    ScaledPixelBuffer pixel_buffer;
+
+    EXPECT_CALL(pixel_buffer, fill_from(Ref(*buffer_access.stub_compositor_buffer), max_size));
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    std::vector<uint32_t> pixels;
+    auto const snapshot = take_snapshot_and_wait(strategy, mt::fake_shared(buffer_access), max_size, pixels);
+
+    EXPECT_THAT(snapshot.size, Eq(geom::Size{2, 2}));
+    EXPECT_THAT(pixels, ContainerEq(pixel_buffer.pixels));
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, scaled_snapshot_is_only_taken_again_once_content_changes)
+{
+    using namespace testing;
+
+    geom::Size const max_size{32, 32};
+    ScaledPixelBuffer pixel_buffer;
+
+    EXPECT_CALL(pixel_buffer, fill_from(_, max_size)).Times(2);
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+    auto const stream = mt::fake_shared(buffer_access);
+
+    std::vector<uint32_t> first, second, third;
+    take_snapshot_and_wait(strategy, stream, max_size, first);
+    take_snapshot_and_wait(strategy, stream, max_size, second);
+
+    EXPECT_THAT(second, ContainerEq(first));
+
+    buffer_access.submit_buffer(buffer_access.stub_compositor_buffer);
+    take_snapshot_and_wait(strategy, stream, max_size, third);
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, takes_every_snapshot_with_a_thread_per_pixel_buffer)
+{
+    using namespace testing;
+
+    NiceMock<mtd::MockBufferStream> stream;
+    mtd::NullPixelBuffer pixel_buffer;
+    std::vector<std::shared_ptr<ms::PixelBuffer>> const pixel_buffers(3, mt::fake_shared(pixel_buffer));
+
+    ms::ThreadedSnapshotStrategy strategy{pixel_buffers};
+
+    std::atomic<int> snapshots{0};
+    mt::Signal all_taken;
+    for (auto i = 0; i != 10; ++i)
+    {
+        strategy.take_snapshot_of(
+            mt::fake_shared(stream),
+            [&](ms::Snapshot const&)
+            {
+                if (++snapshots == 10)
+                    all_taken.raise();
+            });
+    }
+
+    EXPECT_TRUE(all_taken.wait_for(std::chrono::seconds{5}));
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/extension_list.h"
+#include <gtest/gtest.h>
+
+using mir::graphics::has_extension;
+
+TEST(ExtensionList, finds_names_anywhere_in_the_list)
+{
+    auto const extensions = "EGL_KHR_image EGL_EXT_buffer_age EGL_KHR_fence_sync";
+
+    EXPECT_TRUE(has_extension(extensions, "EGL_KHR_image"));
+    EXPECT_TRUE(has_extension(extensions, "EGL_EXT_buffer_age"));
+    EXPECT_TRUE(has_extension(extensions, "EGL_KHR_fence_sync"));
+}
+
+TEST(ExtensionList, does_not_match_part_of_a_name)
+{
+    auto const extensions = "EGL_KHR_image_base EGL_MESA_EGL_EXT_buffer_age";
+
+    EXPECT_FALSE(has_extension(extensions, "EGL_KHR_image"));
+    EXPECT_FALSE(has_extension(extensions, "EGL_EXT_buffer_age"));
+    EXPECT_FALSE(has_extension(extensions, "image_base"));
+}
+
+TEST(ExtensionList, finds_a_name_after_a_longer_one_containing_it)
+{
+    EXPECT_TRUE(has_extension("EGL_KHR_image_base EGL_KHR_image", "EGL_KHR_image"));
+}
+
+TEST(ExtensionList, null_or_empty_lists_have_nothing)
+{
+    EXPECT_FALSE(has_extension(nullptr, "EGL_KHR_image"));
+    EXPECT_FALSE(has_extension("", "EGL_KHR_image"));
+    EXPECT_FALSE(has_extension("EGL_KHR_image", ""));
+}
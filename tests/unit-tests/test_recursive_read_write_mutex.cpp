@@ -174,3 +174,129 @@ TEST_F(RecursiveReadWriteMutex, read_lock_waits_for_write_locks_on_other_threads
 
     threads.push_back(std::thread{writer_function});
 }
+
+TEST_F(RecursiveReadWriteMutex, readers_never_see_a_write_in_progress)
+{
+    int first{0};
+    int second{0};
+    std::atomic<bool> mismatch{false};
+
+    auto const reader_function =
+        [&]{
+            for (int i = 0; i != recursion_depth; ++i)
+            {
+                mir::RecursiveReadLock outer{mutex};
+                mir::RecursiveReadLock inner{mutex};
+                if (first != second)
+                    mismatch = true;
+            }
+        };
+
+    auto const writer_function =
+        [&]{
+            for (int i = 0; i != recursion_depth; ++i)
+            {
+                mir::RecursiveWriteLock lock{mutex};
+                ++first;
+                std::this_thread::yield();
+                ++second;
+            }
+        };
+
+    for (auto i = 0U; i != 4; ++i)
+        threads.push_back(std::thread{reader_function});
+
+    threads.push_back(std::thread{writer_function});
+
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_FALSE(mismatch);
+    EXPECT_THAT(second, Eq(recursion_depth));
+}
+
+TEST_F(RecursiveReadWriteMutex, thread_with_read_lock_can_write_lock_while_another_thread_waits_to)
+{
+    mt::Barrier read_locked{2};
+    std::atomic<bool> writer_waiting{false};
+
+    auto const upgrader_function =
+        [&]{
+            mir::RecursiveReadLock read{mutex};
+            read_locked.ready();
+
+            // Give the writer time to start waiting for our read lock
+            while (!writer_waiting)
+                std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+            mir::RecursiveWriteLock write{mutex};
+            notify_write_locked();
+            notify_write_unlocking();
+        };
+
+    auto const writer_function =
+        [&]{
+            read_locked.ready();
+
+            writer_waiting = true;
+            mir::RecursiveWriteLock write{mutex};
+            notify_write_locked();
+            notify_write_unlocking();
+        };
+
+    InSequence seq;
+
+    EXPECT_CALL(*this, notify_write_locked());
+    EXPECT_CALL(*this, notify_write_unlocking());
+    EXPECT_CALL(*this, notify_write_locked());
+    EXPECT_CALL(*this, notify_write_unlocking());
+
+    threads.push_back(std::thread{upgrader_function});
+    threads.push_back(std::thread{writer_function});
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+TEST_F(RecursiveReadWriteMutex, writes_under_read_locks_and_on_their_own_exclude_each_other)
+{
+    int first{0};
+    int second{0};
+    std::atomic<bool> mismatch{false};
+
+    auto const write = [&]
+        {
+            mir::RecursiveWriteLock lock{mutex};
+            if (first != second)
+                mismatch = true;
+            ++first;
+            std::this_thread::yield();
+            ++second;
+        };
+
+    auto const upgrader_function =
+        [&]{
+            for (int i = 0; i != recursion_depth; ++i)
+            {
+                mir::RecursiveReadLock lock{mutex};
+                write();
+            }
+        };
+
+    auto const writer_function =
+        [&]{
+            for (int i = 0; i != recursion_depth; ++i)
+                write();
+        };
+
+    threads.push_back(std::thread{upgrader_function});
+    for (auto i = 0U; i != 3; ++i)
+        threads.push_back(std::thread{writer_function});
+
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_FALSE(mismatch);
+    EXPECT_THAT(second, Eq(4 * recursion_depth));
+}
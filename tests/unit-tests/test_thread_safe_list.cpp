@@ -19,6 +19,9 @@
 #include "mir/thread_safe_list.h"
 #include "mir/test/signal.h"
 
+#include <atomic>
+#include <thread>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
@@ -157,3 +160,79 @@ TEST_F(ThreadSafeListTest, clears_all_elements)
 
     EXPECT_THAT(elements_seen, Eq(0));
 }
+
+TEST_F(ThreadSafeListTest, remove_waits_for_element_in_use_in_different_thread)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    mir::test::Signal element_in_use;
+    std::atomic<bool> element_released{false};
+
+    std::thread t{
+        [&]
+        {
+            list.for_each(
+                [&] (Element const&)
+                {
+                    element_in_use.raise();
+                    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+                    element_released = true;
+                });
+        }};
+
+    element_in_use.wait_for(std::chrono::seconds{3});
+    list.remove(element1);
+
+    EXPECT_TRUE(element_released);
+
+    t.join();
+}
+
+TEST_F(ThreadSafeListTest, element_removed_from_within_its_own_call_is_dropped_when_the_call_returns)
+{
+    auto element = std::make_shared<Dummy>();
+    std::weak_ptr<Dummy> const weak_element = element;
+
+    list.add(element);
+    element.reset();
+
+    list.for_each(
+        [&] (Element const& element)
+        {
+            list.remove(element);
+            EXPECT_FALSE(weak_element.expired());
+        });
+
+    EXPECT_TRUE(weak_element.expired());
+}
+
+TEST_F(ThreadSafeListTest, destroying_a_removed_element_can_change_the_list)
+{
+    using namespace testing;
+
+    list.add(element2);
+    list.add(Element{new Dummy, [this] (Dummy* dummy)
+        {
+            list.remove(element2);
+            delete dummy;
+        }});
+
+    list.for_each(
+        [&] (Element const& element)
+        {
+            if (element != element2)
+                list.remove(element);
+        });
+
+    int elements_seen = 0;
+
+    list.for_each(
+        [&] (Element const&)
+        {
+            ++elements_seen;
+        });
+
+    EXPECT_THAT(elements_seen, Eq(0));
+}
@@ -24,6 +24,8 @@
 
 #include <atomic>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -220,3 +222,69 @@ TEST_F(BasicThreadPool, can_shrink)
     EXPECT_TRUE(task2.was_called());
     EXPECT_THAT(task2.thread_name(), Ne(expected_name));
 }
+
+TEST_F(BasicThreadPool, runs_tasks_with_the_same_id_in_order)
+{
+    using namespace testing;
+    mth::BasicThreadPool p{default_num_threads};
+
+    TestTask first;
+    first.block_on_execution();
+    std::vector<int> order;
+
+    auto future1 = p.run([&] { first(); order.push_back(1); }, default_task_id);
+    auto future2 = p.run([&] { order.push_back(2); }, default_task_id);
+    auto future3 = p.run([&] { order.push_back(3); }, default_task_id);
+
+    first.unblock();
+    future1.wait();
+    future2.wait();
+    future3.wait();
+
+    EXPECT_THAT(order, ElementsAre(1, 2, 3));
+}
+
+TEST_F(BasicThreadPool, task_run_by_a_busy_task_is_run_by_another_thread)
+{
+    using namespace testing;
+    mth::BasicThreadPool p{default_num_threads};
+
+    mt::Signal inner_done;
+    std::future<void> inner_future;
+
+    // The outer task waits for the inner one, so it must not be left queued behind it
+    auto outer_future = p.run(
+        [&]
+        {
+            inner_future = p.run([&] { inner_done.raise(); });
+            inner_done.wait_for(std::chrono::seconds{3});
+        });
+
+    outer_future.wait();
+    inner_future.wait();
+
+    EXPECT_TRUE(inner_done.raised());
+}
+
+TEST_F(BasicThreadPool, runs_move_only_task)
+{
+    using namespace testing;
+    mth::BasicThreadPool p{default_num_threads};
+
+    auto value = std::make_unique<int>(42);
+    auto seen = 0;
+
+    p.run([&seen, value = std::move(value)] { seen = *value; }).wait();
+
+    EXPECT_THAT(seen, Eq(42));
+}
+
+TEST_F(BasicThreadPool, reports_exception_from_task)
+{
+    using namespace testing;
+    mth::BasicThreadPool p{default_num_threads};
+
+    auto future = p.run([] { throw std::runtime_error{"Oops"}; });
+
+    EXPECT_THROW(future.get(), std::runtime_error);
+}